@@ -0,0 +1,112 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// This file measures the ALME codec ("parse_1905_ALME_from_packet()",
+// "forge_1905_ALME_from_structure()", ...) on the test vectors of
+// "tests/1905_alme_test_vectors.c".
+//
+
+#include "platform.h"
+#include "utils.h"
+
+#include "1905_alme.h"
+#include "1905_alme_test_vectors.h"
+#include "benchmark.h"
+
+#include <stdlib.h> // free()
+
+static void *_parse(const struct benchmark_case *c)
+{
+    return parse_1905_ALME_from_packet(c->stream, c->stream_len);
+}
+
+static void *_forge(const struct benchmark_case *c)
+{
+    uint16_t len;
+
+    return forge_1905_ALME_from_structure(c->structure, &len);
+}
+
+static uint8_t _compare(const struct benchmark_case *c, void *parsed)
+{
+    return compare_1905_ALME_structures(parsed, c->structure);
+}
+
+static void _freeParsed(void *parsed)
+{
+    free_1905_ALME_structure(parsed);
+}
+
+#define ALME_CASE(description, nr)                             \
+    {                                                          \
+        .codec       = "1905_alme",                            \
+        .name        = description " (x1905_alme_" #nr ")",    \
+        .stream      = x1905_alme_stream_##nr,                 \
+        .stream_len  = x1905_alme_stream_len_##nr,             \
+        .structure   = &x1905_alme_structure_##nr,             \
+        .parse       = _parse,                                 \
+        .forge       = _forge,                                 \
+        .free_forged = free,                                   \
+        .compare     = _compare,                               \
+        .free_parsed = _freeParsed,                            \
+    }
+
+int main(int argc, char *argv[])
+{
+    const struct benchmark_case cases[] = {
+        ALME_CASE("ALME-GET-INTF-LIST.request",          001),
+        ALME_CASE("ALME-GET-INTF-LIST.response",         002),
+        ALME_CASE("ALME-GET-INTF-LIST.response",         003),
+        ALME_CASE("ALME-GET-INTF-LIST.response",         004),
+        ALME_CASE("ALME-SET-INTF-PWR-STATE.request",     005),
+        ALME_CASE("ALME-SET-INTF-PWR-STATE.request",     006),
+        ALME_CASE("ALME-SET-INTF-PWR-STATE.confirm",     007),
+        ALME_CASE("ALME-SET-INTF-PWR-STATE.confirm",     008),
+        ALME_CASE("ALME-GET-INTF-PWR-STATE.request",     009),
+        ALME_CASE("ALME-GET-INTF-PWR-STATE.response",    010),
+        ALME_CASE("ALME-SET-FWD-RULE.request",           011),
+        ALME_CASE("ALME-SET-FWD-RULE.request",           012),
+        ALME_CASE("ALME-SET-FWD-RULE.confirm",           013),
+        ALME_CASE("ALME-GET-FWD-RULES.request",          014),
+        ALME_CASE("ALME-GET-FWD-RULES.response",         015),
+        ALME_CASE("ALME-GET-FWD-RULES.response",         016),
+        ALME_CASE("ALME-GET-FWD-RULES.response",         017),
+        ALME_CASE("ALME-MODIFY-FWD-RULE.request",        018),
+        ALME_CASE("ALME-MODIFY-FWD-RULE.confirm",        019),
+        ALME_CASE("ALME-MODIFY-FWD-RULE.confirm",        020),
+        ALME_CASE("ALME-REMOVE-FWD-RULE.request",        021),
+        ALME_CASE("ALME-REMOVE-FWD-RULE.confirm",        022),
+        ALME_CASE("ALME-GET-METRIC.request",             023),
+        ALME_CASE("ALME-GET-METRIC.response",            024),
+        ALME_CASE("ALME-GET-METRIC.response",            025),
+    };
+    unsigned i;
+
+    if (!benchmark_init(argc, argv, "1905_alme_benchmark"))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(cases); i++)
+    {
+        benchmark_run(&cases[i]);
+    }
+
+    return benchmark_done();
+}
@@ -0,0 +1,263 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// This file measures the CMDU codec ("parse_1905_CMDU_from_packets()",
+// "forge_1905_CMDU_from_structure()", ...) on the test vectors of
+// "tests/1905_cmdu_test_vectors.c", and on synthetic topology responses of a
+// large network, which are the biggest CMDUs an AL entity has to deal with.
+//
+// The lazily decoded view ("parse_1905_CMDU_view_from_packets()") is measured
+// on the same streams, as codec "1905_cmdu_view".
+//
+
+#include "platform.h"
+#include "utils.h"
+
+#include "1905_cmdus.h"
+#include "1905_tlvs.h"
+#include "1905_cmdu_test_vectors.h"
+#include "benchmark.h"
+
+#include <stdio.h>  // snprintf()
+#include <stdlib.h> // free()
+#include <string.h> // memcpy()
+
+static void *_parse(const struct benchmark_case *c)
+{
+    return parse_1905_CMDU_from_packets((uint8_t **)c->stream);
+}
+
+static void *_parseView(const struct benchmark_case *c)
+{
+    return parse_1905_CMDU_view_from_packets((uint8_t **)c->stream);
+}
+
+static void *_forge(const struct benchmark_case *c)
+{
+    uint8_t  **streams;
+    uint16_t  *lens;
+
+    streams = forge_1905_CMDU_from_structure(c->structure, &lens);
+    free(lens);
+
+    return streams;
+}
+
+static void _freeForged(void *forged)
+{
+    free_1905_CMDU_packets(forged);
+}
+
+static uint8_t _compare(const struct benchmark_case *c, void *parsed)
+{
+    return compare_1905_CMDU_structures(parsed, c->structure);
+}
+
+static void _freeParsed(void *parsed)
+{
+    free_1905_CMDU_structure(parsed);
+}
+
+static void _freeView(void *parsed)
+{
+    free_1905_CMDU_view(parsed);
+}
+
+// Measure the CMDU codec and the view parser on the same streams. 'streams' or
+// 'structure' can be NULL for test vectors that are only used in one direction.
+//
+static void _run(const char *name, uint8_t **streams, struct CMDU *structure)
+{
+    struct benchmark_case c = {
+        .codec       = "1905_cmdu",
+        .name        = name,
+        .stream      = streams,
+        .structure   = structure,
+        .parse       = NULL != streams && NULL != structure ? _parse : NULL,
+        .forge       = NULL != structure ? _forge : NULL,
+        .free_forged = _freeForged,
+        .compare     = _compare,
+        .free_parsed = _freeParsed,
+    };
+
+    benchmark_run(&c);
+
+    if (NULL != streams)
+    {
+        struct benchmark_case v = {
+            .codec       = "1905_cmdu_view",
+            .name        = name,
+            .stream      = streams,
+            .parse       = _parseView,
+            .free_parsed = _freeView,
+        };
+
+        benchmark_run(&v);
+    }
+}
+
+// Build the topology response of a device with 'interfaces_nr' interfaces, each
+// of them with 'neighbors_nr' 1905 neighbors and as many non-1905 neighbors.
+//
+static struct CMDU *_topologyResponse(uint8_t interfaces_nr, uint8_t neighbors_nr)
+{
+    struct CMDU                          *c;
+    struct deviceInformationTypeTLV      *device_info;
+    struct deviceBridgingCapabilityTLV   *bridge_info;
+    uint8_t                               i, j;
+    unsigned                              tlvs_nr = 0;
+
+    c = zmemalloc(sizeof(*c));
+    c->message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
+    c->message_type    = CMDU_TYPE_TOPOLOGY_RESPONSE;
+    c->message_id      = 0x1234;
+    c->relay_indicator = 0;
+    c->list_of_TLVs    = zmemalloc(sizeof(struct tlv *) * (2 + 2 * interfaces_nr + 1));
+
+    device_info = zmemalloc(sizeof(*device_info));
+    device_info->tlv.type            = TLV_TYPE_DEVICE_INFORMATION_TYPE;
+    device_info->al_mac_address[0]   = 0x02;
+    device_info->local_interfaces_nr = interfaces_nr;
+    device_info->local_interfaces    = zmemalloc(sizeof(struct _localInterfaceEntries) * interfaces_nr);
+    for (i = 0; i < interfaces_nr; i++)
+    {
+        struct _localInterfaceEntries *e = &device_info->local_interfaces[i];
+
+        e->mac_address[0]           = 0x02;
+        e->mac_address[5]           = i;
+        e->media_type               = MEDIA_TYPE_IEEE_802_11AC_5_GHZ;
+        e->media_specific_data_size = 10;
+        memcpy(e->media_specific_data.ieee80211.network_membership, e->mac_address, 6);
+        e->media_specific_data.ieee80211.role                                = IEEE80211_SPECIFIC_INFO_ROLE_AP;
+        e->media_specific_data.ieee80211.ap_channel_band                     = 0x02;
+        e->media_specific_data.ieee80211.ap_channel_center_frequency_index_1 = 42;
+    }
+    c->list_of_TLVs[tlvs_nr++] = &device_info->tlv;
+
+    bridge_info = zmemalloc(sizeof(*bridge_info));
+    bridge_info->tlv.type           = TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES;
+    bridge_info->bridging_tuples_nr = 1;
+    bridge_info->bridging_tuples    = zmemalloc(sizeof(struct _bridgingTupleEntries));
+    bridge_info->bridging_tuples[0].bridging_tuple_macs_nr = interfaces_nr;
+    bridge_info->bridging_tuples[0].bridging_tuple_macs    =
+        zmemalloc(sizeof(struct _bridgingTupleMacEntries) * interfaces_nr);
+    for (i = 0; i < interfaces_nr; i++)
+    {
+        memcpy(bridge_info->bridging_tuples[0].bridging_tuple_macs[i].mac_address,
+               device_info->local_interfaces[i].mac_address, 6);
+    }
+    c->list_of_TLVs[tlvs_nr++] = &bridge_info->tlv;
+
+    for (i = 0; i < interfaces_nr; i++)
+    {
+        struct non1905NeighborDeviceListTLV *non_1905_neighbors;
+        struct neighborDeviceListTLV        *neighbors;
+
+        non_1905_neighbors = zmemalloc(sizeof(*non_1905_neighbors));
+        non_1905_neighbors->tlv.type              = TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST;
+        non_1905_neighbors->non_1905_neighbors_nr = neighbors_nr;
+        non_1905_neighbors->non_1905_neighbors    = zmemalloc(sizeof(struct _non1905neighborEntries) * neighbors_nr);
+        memcpy(non_1905_neighbors->local_mac_address, device_info->local_interfaces[i].mac_address, 6);
+
+        neighbors = zmemalloc(sizeof(*neighbors));
+        neighbors->tlv.type     = TLV_TYPE_NEIGHBOR_DEVICE_LIST;
+        neighbors->neighbors_nr = neighbors_nr;
+        neighbors->neighbors    = zmemalloc(sizeof(struct _neighborEntries) * neighbors_nr);
+        memcpy(neighbors->local_mac_address, device_info->local_interfaces[i].mac_address, 6);
+
+        for (j = 0; j < neighbors_nr; j++)
+        {
+            non_1905_neighbors->non_1905_neighbors[j].mac_address[0] = 0x04;
+            non_1905_neighbors->non_1905_neighbors[j].mac_address[4] = i;
+            non_1905_neighbors->non_1905_neighbors[j].mac_address[5] = j;
+
+            neighbors->neighbors[j].mac_address[0] = 0x06;
+            neighbors->neighbors[j].mac_address[4] = i;
+            neighbors->neighbors[j].mac_address[5] = j;
+            neighbors->neighbors[j].bridge_flag    = j & 1;
+        }
+
+        c->list_of_TLVs[tlvs_nr++] = &non_1905_neighbors->tlv;
+        c->list_of_TLVs[tlvs_nr++] = &neighbors->tlv;
+    }
+
+    return c;
+}
+
+// Returns "0" if the topology response could not be forged (e.g. because a
+// TLV doesn't fit in a fragment).
+//
+static uint8_t _runTopologyResponse(uint8_t interfaces_nr, uint8_t neighbors_nr)
+{
+    struct CMDU  *structure;
+    uint8_t     **streams;
+    uint16_t     *lens;
+    char          name[100];
+    unsigned      fragments_nr = 0;
+
+    structure = _topologyResponse(interfaces_nr, neighbors_nr);
+    streams   = forge_1905_CMDU_from_structure(structure, &lens);
+    if (NULL == streams)
+    {
+        PLATFORM_PRINTF("Could not forge the synthetic topology response\n");
+        free_1905_CMDU_structure(structure);
+        return 0;
+    }
+    while (NULL != streams[fragments_nr])
+    {
+        fragments_nr++;
+    }
+
+    snprintf(name, sizeof(name), "topology response, %u interfaces x %u neighbors (%u fragments)",
+             interfaces_nr, neighbors_nr, fragments_nr);
+    _run(name, streams, structure);
+
+    free_1905_CMDU_packets(streams);
+    free(lens);
+    free_1905_CMDU_structure(structure);
+
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int result;
+
+    if (!benchmark_init(argc, argv, "1905_cmdu_benchmark"))
+    {
+        return 1;
+    }
+
+    init_1905_cmdu_test_vectors();
+
+    _run("link metric query CMDU (x1905_cmdu_001)", x1905_cmdu_streams_001, &x1905_cmdu_structure_001);
+    _run("link metric query CMDU (x1905_cmdu_002)", x1905_cmdu_streams_002, &x1905_cmdu_structure_002);
+    _run("link metric query CMDU (x1905_cmdu_003)", NULL,                   &x1905_cmdu_structure_003);
+    _run("link metric query CMDU (x1905_cmdu_004)", x1905_cmdu_streams_004, &x1905_cmdu_structure_004);
+    _run("topology query CMDU (x1905_cmdu_005)",    x1905_cmdu_streams_005, &x1905_cmdu_structure_005);
+
+    // Neighbor lists of more than ~200 entries don't fit in a single fragment
+    //
+    result  = !_runTopologyResponse(2,  4);
+    result += !_runTopologyResponse(8,  16);
+    result += !_runTopologyResponse(16, 64);
+    result += !_runTopologyResponse(32, 128);
+
+    return result + benchmark_done();
+}
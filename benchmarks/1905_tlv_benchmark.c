@@ -0,0 +1,95 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// This file measures the 1905 TLV codec ("parse_1905_TLV_from_packet()",
+// "forge_1905_TLV_from_structure()", ...) on the test vectors of
+// "tests/1905_tlv_test_vectors.c".
+//
+
+#include "platform.h"
+#include "utils.h"
+
+#include "1905_tlvs.h"
+#include "1905_tlv_test_vectors.h"
+#include "benchmark.h"
+
+#include <stdlib.h> // free()
+
+static void *_parse(const struct benchmark_case *c)
+{
+    return parse_1905_TLV_from_packet(c->stream, c->stream_len);
+}
+
+static void *_forge(const struct benchmark_case *c)
+{
+    uint16_t len;
+
+    return forge_1905_TLV_from_structure(c->structure, &len);
+}
+
+static uint8_t _compare(const struct benchmark_case *c, void *parsed)
+{
+    return compare_1905_TLV_structures(parsed, c->structure);
+}
+
+static void _freeParsed(void *parsed)
+{
+    free_1905_TLV_structure(parsed);
+}
+
+int main(int argc, char *argv[])
+{
+    struct x1905_tlv_test_vector *t;
+    dlist_head                    test_vectors;
+
+    if (!benchmark_init(argc, argv, "1905_tlv_benchmark"))
+    {
+        return 1;
+    }
+
+    dlist_head_init(&test_vectors);
+    get_1905_tlv_test_vectors(&test_vectors);
+
+    hlist_for_each(t, test_vectors, struct x1905_tlv_test_vector, h)
+    {
+        if (dlist_empty(&t->h.children[0]))
+        {
+            // Malformed stream, only used to check that parsing fails
+            //
+            continue;
+        }
+
+        struct benchmark_case c = {
+            .codec       = "1905_tlv",
+            .name        = t->description,
+            .stream      = t->stream,
+            .stream_len  = t->stream_len,
+            .structure   = container_of(t->h.children[0].next, struct tlv, s.h.l),
+            .parse       = t->parse ? _parse : NULL,
+            .forge       = t->forge ? _forge : NULL,
+            .free_forged = free,
+            .compare     = _compare,
+            .free_parsed = _freeParsed,
+        };
+
+        benchmark_run(&c);
+    }
+
+    return benchmark_done();
+}
@@ -0,0 +1,97 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// This file measures the BBF TLV codec ("parse_bbf_TLV_from_packet()",
+// "forge_bbf_TLV_from_structure()", ...) on the test vectors of
+// "tests/bbf_tlv_test_vectors.c".
+//
+
+#include "platform.h"
+#include "utils.h"
+
+#include "1905_tlvs.h"
+#include "bbf_tlvs.h"
+#include "bbf_tlv_test_vectors.h"
+#include "benchmark.h"
+
+#include <stdlib.h> // free()
+
+static void *_parse(const struct benchmark_case *c)
+{
+    return parse_bbf_TLV_from_packet(c->stream);
+}
+
+static void *_forge(const struct benchmark_case *c)
+{
+    uint16_t len;
+
+    return forge_bbf_TLV_from_structure(c->structure, &len);
+}
+
+static uint8_t _compare(const struct benchmark_case *c, void *parsed)
+{
+    return compare_bbf_TLV_structures(parsed, c->structure);
+}
+
+static void _freeParsed(void *parsed)
+{
+    free_bbf_TLV_structure(parsed);
+}
+
+// Vectors 002, 004 and 006 are only valid for forging: their "b" streams are
+// the malformed versions, which are not interesting to measure.
+//
+#define BBF_TLV_CASE(description, nr, parseable)               \
+    {                                                          \
+        .codec       = "bbf_tlv",                              \
+        .name        = description " (bbf_tlv_" #nr ")",       \
+        .stream      = bbf_tlv_stream_##nr,                    \
+        .structure   = &bbf_tlv_structure_##nr.tlv,            \
+        .parse       = parseable ? _parse : NULL,              \
+        .forge       = _forge,                                 \
+        .free_forged = free,                                   \
+        .compare     = _compare,                               \
+        .free_parsed = _freeParsed,                            \
+    }
+
+int main(int argc, char *argv[])
+{
+    const struct benchmark_case cases[] = {
+        BBF_TLV_CASE("non-1905 link metric query TLV",        001, true),
+        BBF_TLV_CASE("non-1905 link metric query TLV",        002, false),
+        BBF_TLV_CASE("non-1905 link metric query TLV",        003, true),
+        BBF_TLV_CASE("non-1905 transmitter link metric TLV",  004, false),
+        BBF_TLV_CASE("non-1905 transmitter link metric TLV",  005, true),
+        BBF_TLV_CASE("non-1905 receiver link metric TLV",     006, false),
+        BBF_TLV_CASE("non-1905 receiver link metric TLV",     007, true),
+    };
+    unsigned i;
+
+    if (!benchmark_init(argc, argv, "bbf_tlv_benchmark"))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(cases); i++)
+    {
+        benchmark_run(&cases[i]);
+    }
+
+    return benchmark_done();
+}
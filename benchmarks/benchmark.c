@@ -0,0 +1,334 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>      // fopen(), fprintf()
+#include <stdlib.h>     // strtod()
+#include <string.h>     // strcmp()
+#include <time.h>       // clock_gettime()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// Number of structures parsed (or forged) in a row before they are compared
+// and released.
+//
+#define BATCH_SIZE (256)
+
+enum _operation
+{
+    OPERATION_PARSE,
+    OPERATION_FORGE,
+    OPERATION_COMPARE,
+    OPERATION_FREE,
+    OPERATION_NR,
+};
+
+static const char *operation_names[OPERATION_NR] = {"parse", "forge", "compare", "free"};
+
+struct _measurement
+{
+    uint64_t ops;
+    uint64_t allocations;
+    double   seconds;
+};
+
+static const char *suite_name;
+static double      min_time = 0.2;
+static FILE       *results_file;
+static int         failures;
+
+// Heap allocations are counted by wrapping the allocator at link time (see
+// "-Wl,--wrap" in "CMakeLists.txt"). This covers every allocation done by the
+// library, including the ones done through "memalloc()" and friends.
+//
+static uint64_t allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    allocations++;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+static double _now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void _start(double *start, uint64_t *start_allocations)
+{
+    *start_allocations = allocations;
+    *start             = _now();
+}
+
+static void _stop(struct _measurement *m, unsigned ops, double start, uint64_t start_allocations)
+{
+    m->seconds     += _now() - start;
+    m->ops         += ops;
+    m->allocations += allocations - start_allocations;
+}
+
+// Write 's' as a JSON string
+//
+static void _printJsonString(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++)
+    {
+        if ('"' == *s || '\\' == *s)
+        {
+            fputc('\\', f);
+        }
+        fputc((unsigned char)*s < 0x20 ? ' ' : *s, f);
+    }
+    fputc('"', f);
+}
+
+static void _report(const struct benchmark_case *c, enum _operation op, const struct _measurement *m)
+{
+    double ns_per_op;
+    double ops_per_s;
+    double allocations_per_op;
+
+    if (0 == m->ops)
+    {
+        return;
+    }
+
+    ns_per_op          = m->seconds * 1e9 / m->ops;
+    ops_per_s          = m->seconds > 0 ? m->ops / m->seconds : 0;
+    allocations_per_op = (double)m->allocations / m->ops;
+
+    PLATFORM_PRINTF("%-14s %-7s %-64.64s %12.0f ops/s %10.1f ns/op %7.2f allocs/op\n",
+                    c->codec, operation_names[op], c->name, ops_per_s, ns_per_op, allocations_per_op);
+
+    if (NULL != results_file)
+    {
+        fprintf(results_file, "{\"suite\": ");
+        _printJsonString(results_file, suite_name);
+        fprintf(results_file, ", \"codec\": ");
+        _printJsonString(results_file, c->codec);
+        fprintf(results_file, ", \"case\": ");
+        _printJsonString(results_file, c->name);
+        fprintf(results_file, ", \"operation\": \"%s\", \"ops\": %llu, \"ops_per_s\": %.1f, \"ns_per_op\": %.1f, "
+                              "\"allocs_per_op\": %.2f}\n",
+                operation_names[op], (unsigned long long)m->ops, ops_per_s, ns_per_op, allocations_per_op);
+    }
+}
+
+// Parse, compare and release 'n' structures. Returns "0" on error.
+//
+static uint8_t _parseBatch(const struct benchmark_case *c, unsigned n, struct _measurement *m)
+{
+    void     *parsed[BATCH_SIZE];
+    double    start;
+    uint64_t  start_allocations;
+    uint8_t   ret = 1;
+    unsigned  i;
+
+    _start(&start, &start_allocations);
+    for (i = 0; i < n; i++)
+    {
+        parsed[i] = c->parse(c);
+    }
+    _stop(&m[OPERATION_PARSE], n, start, start_allocations);
+
+    for (i = 0; i < n; i++)
+    {
+        if (NULL == parsed[i])
+        {
+            PLATFORM_PRINTF("%-14s %-7s %-64.64s: KO !!!\n", c->codec, "parse", c->name);
+            ret = 0;
+            goto out;
+        }
+    }
+
+    if (NULL != c->compare)
+    {
+        uint8_t differences = 0;
+
+        _start(&start, &start_allocations);
+        for (i = 0; i < n; i++)
+        {
+            differences |= c->compare(c, parsed[i]);
+        }
+        _stop(&m[OPERATION_COMPARE], n, start, start_allocations);
+
+        if (0 != differences)
+        {
+            PLATFORM_PRINTF("%-14s %-7s %-64.64s: KO !!!\n", c->codec, "compare", c->name);
+            ret = 0;
+        }
+    }
+
+out:
+    _start(&start, &start_allocations);
+    for (i = 0; i < n; i++)
+    {
+        if (NULL != parsed[i])
+        {
+            c->free_parsed(parsed[i]);
+        }
+    }
+    _stop(&m[OPERATION_FREE], n, start, start_allocations);
+
+    return ret;
+}
+
+// Forge and release 'n' bit streams. Returns "0" on error.
+//
+static uint8_t _forgeBatch(const struct benchmark_case *c, unsigned n, struct _measurement *m)
+{
+    void     *forged[BATCH_SIZE];
+    double    start;
+    uint64_t  start_allocations;
+    uint8_t   ret = 1;
+    unsigned  i;
+
+    _start(&start, &start_allocations);
+    for (i = 0; i < n; i++)
+    {
+        forged[i] = c->forge(c);
+    }
+    _stop(&m[OPERATION_FORGE], n, start, start_allocations);
+
+    for (i = 0; i < n; i++)
+    {
+        if (NULL == forged[i])
+        {
+            ret = 0;
+        }
+        else
+        {
+            c->free_forged(forged[i]);
+        }
+    }
+    if (0 == ret)
+    {
+        PLATFORM_PRINTF("%-14s %-7s %-64.64s: KO !!!\n", c->codec, "forge", c->name);
+    }
+
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t benchmark_init(int argc, char *argv[], const char *suite)
+{
+    int i;
+
+    suite_name = suite;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            min_time = strtod(argv[++i], NULL);
+        }
+        else if (0 == strcmp(argv[i], "-o") && i + 1 < argc)
+        {
+            results_file = fopen(argv[++i], "a");
+            if (NULL == results_file)
+            {
+                PLATFORM_PRINTF("Could not open %s\n", argv[i]);
+                return 0;
+            }
+        }
+        else
+        {
+            PLATFORM_PRINTF("Usage: %s [-t <seconds>] [-o <results file>]\n", argv[0]);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+uint8_t benchmark_run(const struct benchmark_case *c)
+{
+    struct _measurement  m[OPERATION_NR];
+    unsigned             n;
+    unsigned             op;
+    uint8_t              ret = 1;
+
+    memset(m, 0, sizeof(m));
+
+    // With a minimum time of 0, each operation is done exactly once
+    //
+    n = min_time > 0 ? BATCH_SIZE : 1;
+
+    do
+    {
+        if (NULL != c->parse)
+        {
+            ret &= _parseBatch(c, n, m);
+        }
+        if (NULL != c->forge)
+        {
+            ret &= _forgeBatch(c, n, m);
+        }
+    }
+    while (ret && m[NULL != c->parse ? OPERATION_PARSE : OPERATION_FORGE].seconds < min_time);
+
+    if (!ret)
+    {
+        failures++;
+        return 0;
+    }
+
+    for (op = 0; op < OPERATION_NR; op++)
+    {
+        _report(c, op, &m[op]);
+    }
+
+    return 1;
+}
+
+int benchmark_done(void)
+{
+    if (NULL != results_file)
+    {
+        fclose(results_file);
+        results_file = NULL;
+    }
+
+    return failures;
+}
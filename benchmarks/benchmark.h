@@ -0,0 +1,95 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <platform.h>
+
+// Codec benchmarks.
+//
+// Every benchmark program registers a number of "cases" (typically one per
+// test vector of the corresponding "tests/*_test_vectors.c" file) and each of
+// them is measured for four operations:
+//
+//   - "parse"  : bit stream -> memory structure
+//   - "forge"  : memory structure -> bit stream
+//   - "compare": parsed structure vs. reference structure
+//   - "free"   : release of the parsed structure
+//
+// For each operation the number of operations per second, the time per
+// operation and the number of heap allocations per operation are reported.
+//
+// The programs accept these arguments:
+//
+//   -t <seconds>  Minimum time spent parsing each case (default 0.2). With
+//                 "-t 0" every case is run exactly once, which is what the
+//                 "ctest" smoke runs do.
+//
+//   -o <file>     Append the results to <file>, one JSON object per line, so
+//                 that runs can be compared by a script.
+//
+
+struct benchmark_case
+{
+    const char *codec;       // Family of the case (ex: "1905_tlv")
+    const char *name;        // Description of the case (ex: the test vector)
+
+    const void *stream;      // Input of 'parse'
+    uint16_t    stream_len;  // Length of 'stream' (codecs which need it)
+    void       *structure;   // Input of 'forge' and reference of 'compare'
+
+    // Parse 'c->stream'. Return NULL on error.
+    //
+    void     *(*parse)(const struct benchmark_case *c);
+
+    // Forge 'c->structure'. Return NULL on error. The result is released with
+    // 'free_forged' (outside of the measurement).
+    //
+    void     *(*forge)(const struct benchmark_case *c);
+    void      (*free_forged)(void *forged);
+
+    // Return "0" if 'parsed' is the same as 'c->structure'.
+    //
+    uint8_t   (*compare)(const struct benchmark_case *c, void *parsed);
+
+    // Release the output of 'parse'.
+    //
+    void      (*free_parsed)(void *parsed);
+};
+
+// Parse the command line arguments (see above). 'suite' is the name of the
+// benchmark program, as reported in the machine readable results.
+//
+// Returns "0" if the arguments are not valid.
+//
+uint8_t benchmark_init(int argc, char *argv[], const char *suite);
+
+// Measure all operations of 'c' and report the results.
+//
+// Returns "0" if one of the operations failed (or the parsed structure is not
+// the expected one), "1" otherwise.
+//
+uint8_t benchmark_run(const struct benchmark_case *c);
+
+// Flush the results. Returns the exit code of the program: the number of cases
+// that failed.
+//
+int benchmark_done(void);
+
+#endif
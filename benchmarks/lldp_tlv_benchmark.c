@@ -0,0 +1,90 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// This file measures the LLDP TLV codec ("parse_lldp_TLV_from_packet()",
+// "forge_lldp_TLV_from_structure()", ...) on the test vectors of
+// "tests/lldp_tlv_test_vectors.c".
+//
+
+#include "platform.h"
+#include "utils.h"
+
+#include "lldp_tlvs.h"
+#include "lldp_tlv_test_vectors.h"
+#include "benchmark.h"
+
+#include <stdlib.h> // free()
+
+static void *_parse(const struct benchmark_case *c)
+{
+    return parse_lldp_TLV_from_packet(c->stream);
+}
+
+static void *_forge(const struct benchmark_case *c)
+{
+    uint16_t len;
+
+    return forge_lldp_TLV_from_structure(c->structure, &len);
+}
+
+static uint8_t _compare(const struct benchmark_case *c, void *parsed)
+{
+    return compare_lldp_TLV_structures(parsed, c->structure);
+}
+
+static void _freeParsed(void *parsed)
+{
+    free_lldp_TLV_structure(parsed);
+}
+
+#define LLDP_TLV_CASE(description, nr)                         \
+    {                                                          \
+        .codec       = "lldp_tlv",                             \
+        .name        = description " (lldp_tlv_" #nr ")",      \
+        .stream      = lldp_tlv_stream_##nr,                   \
+        .structure   = &lldp_tlv_structure_##nr.tlv,           \
+        .parse       = _parse,                                 \
+        .forge       = _forge,                                 \
+        .free_forged = free,                                   \
+        .compare     = _compare,                               \
+        .free_parsed = _freeParsed,                            \
+    }
+
+int main(int argc, char *argv[])
+{
+    const struct benchmark_case cases[] = {
+        LLDP_TLV_CASE("end of LLDP TLV",    001),
+        LLDP_TLV_CASE("chassis ID TLV",     002),
+        LLDP_TLV_CASE("port ID TLV",        003),
+        LLDP_TLV_CASE("time to live TLV",   004),
+    };
+    unsigned i;
+
+    if (!benchmark_init(argc, argv, "lldp_tlv_benchmark"))
+    {
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(cases); i++)
+    {
+        benchmark_run(&cases[i]);
+    }
+
+    return benchmark_done();
+}
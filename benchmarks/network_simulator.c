@@ -0,0 +1,941 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// In-process network simulator.
+//
+// One AL entity (the "device under test", which maps the whole network, as a
+// controller does) is run against a network of simulated agents connected by
+// a virtual L2 fabric, all in this same process and in virtual time:
+//
+//   - The DUT is made of the real data model and receive path of the AL
+//     ("process1905CmduView()" and everything behind it). Its transmissions
+//     are captured by wrapping "PLATFORM_SEND_RAW_PACKET()" at link time, and
+//     its clock is the simulation clock (by wrapping "PLATFORM_GET_TIMESTAMP()").
+//
+//   - The agents are not full AL entities (the AL keeps its state in globals,
+//     so there can only be one per process). Instead, they are modelled with
+//     the CMDUs a real agent sends: a "topology notification" when they join,
+//     a "topology discovery" every 60 seconds (only seen by the DUT if it is
+//     a direct neighbor) and a "topology response" for every "topology
+//     query". All of them are forged with the regular 1905 codec.
+//
+//   - The fabric delivers every CMDU after 'latency' milliseconds per hop, and
+//     drops it with probability 'loss' at each hop.
+//
+// The simulation runs until the DUT knows all agents ("converged") or until
+// the virtual time limit is reached. It then reports the time to convergence,
+// and the cost of getting there for the DUT: CMDUs per second of CPU time, CPU
+// time per agent and heap memory per agent.
+//
+// The traffic seen by the DUT can also be captured, in the same format as the
+// AL entity does (see "platform_capture_priv.h"), to be replayed later with
+// "pcap_replay.c".
+//
+
+#include "platform.h"
+#include "utils.h"
+#include "datamodel.h"
+
+#include "1905_cmdus.h"
+#include "1905_l2.h"
+#include "1905_tlvs.h"
+#include "../src/al.h"
+#include "../src/al_cmdu_stats.h"
+#include "../src/al_datamodel.h"
+#include "../src/al_recv.h"
+#include "../src/al_requests.h"
+#include "../src/al_tx_scheduler.h"
+#include "../src/linux/platform_capture_priv.h"
+
+#include <malloc.h>     // mallinfo2()
+#include <stdio.h>      // fopen(), fprintf()
+#include <stdlib.h>     // atoi(), atof()
+#include <string.h>     // memcpy(), strcmp()
+#include <time.h>       // clock_gettime()
+#include <unistd.h>     // getopt()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// The AL data model uses 8 bits counters for the number of known devices
+// (including the local one)
+//
+#define MAX_AGENTS                 (254)
+
+// Period of the "topology discovery" messages (see "TIMER_TOKEN_DISCOVERY")
+//
+#define DISCOVERY_PERIOD_MS        (60000)
+
+enum simTopology
+{
+    SIM_TOPOLOGY_STAR,   // All agents are direct neighbors of the DUT
+    SIM_TOPOLOGY_CHAIN,  // Each agent is the neighbor of the previous one
+    SIM_TOPOLOGY_TREE,   // Each node has 'fanout' children
+};
+
+static const char *topology_names[] = {"star", "chain", "tree"};
+
+// Each simulated agent has an "uplink" interface (towards the DUT) and a
+// "wlan" interface where its children and its (non-1905) clients are
+// connected.
+//
+struct simAgent
+{
+    mac_address  al_mac;
+    mac_address  uplink_mac;
+    mac_address  wlan_mac;
+    int          parent;          // Index of the parent agent, -1 for the DUT
+    unsigned     hops;            // Number of links between the agent and the DUT
+
+    uint8_t    **discovery;       // Pre-forged CMDUs. The MID is patched in a
+    uint8_t    **notification;    // copy of them every time they are sent.
+    uint8_t    **response;
+    uint16_t    *discovery_lens;
+    uint16_t    *notification_lens;
+    uint16_t    *response_lens;
+
+    bool         converged;
+};
+
+enum simEventType
+{
+    SIM_EVENT_JOIN,              // The agent boots
+    SIM_EVENT_DISCOVERY,         // Periodic topology discovery of the agent
+    SIM_EVENT_TO_DUT,            // 'streams' is delivered to the DUT
+    SIM_EVENT_TO_AGENT,          // A CMDU of the DUT is delivered to the agent
+    SIM_EVENT_TX_SCHEDULER,      // The DUT transmits its pending CMDUs
+    SIM_EVENT_REQUESTS,          // Deadline of a query of the DUT
+};
+
+struct simEvent
+{
+    uint32_t     time;
+    uint32_t     seq;             // Events of the same time are delivered in order
+    uint8_t      type;
+    uint16_t     agent;
+    uint16_t     message_type;    // SIM_EVENT_TO_AGENT only
+    uint16_t     mid;             // SIM_EVENT_TO_AGENT only
+    uint8_t    **streams;         // SIM_EVENT_TO_DUT only
+    uint16_t    *lens;            // SIM_EVENT_TO_DUT only (not owned)
+};
+
+// Simulation parameters
+//
+static unsigned          agents_nr    = 32;
+static enum simTopology  topology     = SIM_TOPOLOGY_TREE;
+static unsigned          fanout       = 4;
+static unsigned          clients_nr   = 4;
+static double            loss         = 0;
+static uint32_t          latency      = 1;
+static uint32_t          join_spacing = 0;
+static uint32_t          time_limit   = 600000;
+static uint32_t          seed         = 1;
+
+static const mac_address dut_al_mac   = {0x02, 0x0d, 0x00, 0x00, 0x00, 0x01};
+static const mac_address dut_if_mac   = {0x02, 0x0d, 0x00, 0x00, 0x01, 0x01};
+
+static struct simAgent  *agents;
+static unsigned          converged_nr;
+
+// Event queue (binary heap ordered by time and sequence number)
+//
+static struct simEvent  *events;
+static unsigned          events_nr;
+static unsigned          events_size;
+static uint32_t          events_seq;
+
+static uint32_t          now_ms;
+
+// Statistics
+//
+static uint64_t          cmdus_rx;
+static uint64_t          cmdus_tx;
+static uint64_t          cmdus_lost;
+static double            dut_cpu;
+
+static uint16_t          agents_mid;
+static bool              tx_scheduled;
+static uint32_t          requests_deadline;
+
+static bool              capture;
+
+static uint32_t _random(void)
+{
+    // xorshift32: simulations are reproducible for a given seed
+    //
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static double _cpuTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool _eventBefore(const struct simEvent *a, const struct simEvent *b)
+{
+    return (int32_t)(a->time - b->time) < 0 || (a->time == b->time && a->seq < b->seq);
+}
+
+static void _eventPush(struct simEvent *e)
+{
+    unsigned i;
+
+    if (events_nr == events_size)
+    {
+        events_size = events_size ? 2 * events_size : 256;
+        events      = memrealloc(events, events_size * sizeof(struct simEvent));
+    }
+
+    e->seq = events_seq++;
+    i = events_nr++;
+    while (i > 0 && _eventBefore(e, &events[(i - 1) / 2]))
+    {
+        events[i] = events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    events[i] = *e;
+}
+
+static struct simEvent _eventPop(void)
+{
+    struct simEvent first = events[0];
+    struct simEvent last  = events[--events_nr];
+    unsigned        i     = 0;
+
+    while (2 * i + 1 < events_nr)
+    {
+        unsigned child = 2 * i + 1;
+
+        if (child + 1 < events_nr && _eventBefore(&events[child + 1], &events[child]))
+        {
+            child++;
+        }
+        if (!_eventBefore(&events[child], &last))
+        {
+            break;
+        }
+        events[i] = events[child];
+        i = child;
+    }
+    events[i] = last;
+
+    return first;
+}
+
+// Return true if a CMDU going through 'hops' links is lost
+//
+static bool _lost(unsigned hops)
+{
+    unsigned i;
+
+    for (i = 0; i < hops; i++)
+    {
+        if (_random() % 1000000 < loss * 10000)
+        {
+            cmdus_lost++;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _setMac(mac_address mac, uint8_t kind, unsigned index)
+{
+    mac[0] = 0x02;
+    mac[1] = kind;
+    mac[2] = 0x00;
+    mac[3] = 0x00;
+    mac[4] = (uint8_t)(index >> 8);
+    mac[5] = (uint8_t)(index);
+}
+
+static const uint8_t *_parentAlMac(const struct simAgent *a)
+{
+    return a->parent < 0 ? dut_al_mac : agents[a->parent].al_mac;
+}
+
+static void _forge(struct CMDU *c, uint8_t ***streams, uint16_t **lens)
+{
+    *streams = forge_1905_CMDU_from_structure(c, lens);
+    if (NULL == *streams)
+    {
+        PLATFORM_PRINTF("Could not forge a CMDU of type 0x%04x\n", c->message_type);
+        exit(1);
+    }
+}
+
+// Forge the CMDUs that agent 'index' will send during the simulation
+//
+static void _agentForgeCmdus(unsigned index)
+{
+    struct simAgent                       *a = &agents[index];
+    struct alMacAddressTypeTLV            *al_mac_tlv;
+    struct macAddressTypeTLV              *mac_tlv;
+    struct tlv                            *tlvs[3];
+    struct CMDU                            cmdu;
+    struct CMDU                           *response;
+    struct deviceInformationTypeTLV       *info;
+    struct neighborDeviceListTLV          *uplink_neighbors;
+    struct neighborDeviceListTLV          *wlan_neighbors;
+    struct non1905NeighborDeviceListTLV   *clients;
+    unsigned                               children_nr = 0;
+    unsigned                               tlvs_nr     = 0;
+    unsigned                               i;
+
+    memset(&cmdu, 0, sizeof(cmdu));
+    cmdu.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
+    cmdu.list_of_TLVs    = tlvs;
+
+    al_mac_tlv = X1905_TLV_ALLOC(alMacAddressType, TLV_TYPE_AL_MAC_ADDRESS_TYPE, NULL);
+    memcpy(al_mac_tlv->al_mac_address, a->al_mac, 6);
+    mac_tlv    = X1905_TLV_ALLOC(macAddressType, TLV_TYPE_MAC_ADDRESS_TYPE, NULL);
+    memcpy(mac_tlv->mac_address, a->uplink_mac, 6);
+
+    cmdu.message_type    = CMDU_TYPE_TOPOLOGY_DISCOVERY;
+    cmdu.relay_indicator = 0;
+    tlvs[0] = &al_mac_tlv->tlv;
+    tlvs[1] = &mac_tlv->tlv;
+    tlvs[2] = NULL;
+    _forge(&cmdu, &a->discovery, &a->discovery_lens);
+
+    cmdu.message_type    = CMDU_TYPE_TOPOLOGY_NOTIFICATION;
+    cmdu.relay_indicator = 1;
+    tlvs[1] = NULL;
+    _forge(&cmdu, &a->notification, &a->notification_lens);
+
+    free_1905_TLV_structure(&al_mac_tlv->tlv);
+    free_1905_TLV_structure(&mac_tlv->tlv);
+
+    // Topology response: device information, the parent on the uplink, the
+    // children and the clients on the wlan interface.
+    //
+    for (i = 0; i < agents_nr; i++)
+    {
+        if (agents[i].parent == (int)index)
+        {
+            children_nr++;
+        }
+    }
+
+    response = zmemalloc(sizeof(*response));
+    response->message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
+    response->message_type    = CMDU_TYPE_TOPOLOGY_RESPONSE;
+    response->list_of_TLVs    = zmemalloc(5 * sizeof(struct tlv *));
+
+    info = zmemalloc(sizeof(*info));
+    info->tlv.type            = TLV_TYPE_DEVICE_INFORMATION_TYPE;
+    memcpy(info->al_mac_address, a->al_mac, 6);
+    info->local_interfaces_nr = 2;
+    info->local_interfaces    = zmemalloc(2 * sizeof(struct _localInterfaceEntries));
+    memcpy(info->local_interfaces[0].mac_address, a->uplink_mac, 6);
+    info->local_interfaces[0].media_type = MEDIA_TYPE_IEEE_802_3AB_GIGABIT_ETHERNET;
+    memcpy(info->local_interfaces[1].mac_address, a->wlan_mac, 6);
+    info->local_interfaces[1].media_type               = MEDIA_TYPE_IEEE_802_11AC_5_GHZ;
+    info->local_interfaces[1].media_specific_data_size = 10;
+    memcpy(info->local_interfaces[1].media_specific_data.ieee80211.network_membership, a->wlan_mac, 6);
+    info->local_interfaces[1].media_specific_data.ieee80211.role = IEEE80211_SPECIFIC_INFO_ROLE_AP;
+    response->list_of_TLVs[tlvs_nr++] = &info->tlv;
+
+    uplink_neighbors = zmemalloc(sizeof(*uplink_neighbors));
+    uplink_neighbors->tlv.type     = TLV_TYPE_NEIGHBOR_DEVICE_LIST;
+    memcpy(uplink_neighbors->local_mac_address, a->uplink_mac, 6);
+    uplink_neighbors->neighbors_nr = 1;
+    uplink_neighbors->neighbors    = zmemalloc(sizeof(struct _neighborEntries));
+    memcpy(uplink_neighbors->neighbors[0].mac_address, _parentAlMac(a), 6);
+    response->list_of_TLVs[tlvs_nr++] = &uplink_neighbors->tlv;
+
+    if (children_nr > 0)
+    {
+        wlan_neighbors = zmemalloc(sizeof(*wlan_neighbors));
+        wlan_neighbors->tlv.type     = TLV_TYPE_NEIGHBOR_DEVICE_LIST;
+        memcpy(wlan_neighbors->local_mac_address, a->wlan_mac, 6);
+        wlan_neighbors->neighbors    = zmemalloc(children_nr * sizeof(struct _neighborEntries));
+        for (i = 0; i < agents_nr; i++)
+        {
+            if (agents[i].parent == (int)index)
+            {
+                memcpy(wlan_neighbors->neighbors[wlan_neighbors->neighbors_nr++].mac_address, agents[i].al_mac, 6);
+            }
+        }
+        response->list_of_TLVs[tlvs_nr++] = &wlan_neighbors->tlv;
+    }
+
+    if (clients_nr > 0)
+    {
+        clients = zmemalloc(sizeof(*clients));
+        clients->tlv.type              = TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST;
+        memcpy(clients->local_mac_address, a->wlan_mac, 6);
+        clients->non_1905_neighbors_nr = clients_nr;
+        clients->non_1905_neighbors    = zmemalloc(clients_nr * sizeof(struct _non1905neighborEntries));
+        for (i = 0; i < clients_nr; i++)
+        {
+            _setMac(clients->non_1905_neighbors[i].mac_address, 0x0c, index * 256 + i);
+        }
+        response->list_of_TLVs[tlvs_nr++] = &clients->tlv;
+    }
+
+    _forge(response, &a->response, &a->response_lens);
+    free_1905_CMDU_structure(response);
+}
+
+static void _agentFreeCmdus(struct simAgent *a)
+{
+    free_1905_CMDU_packets(a->discovery);
+    free_1905_CMDU_packets(a->notification);
+    free_1905_CMDU_packets(a->response);
+    free(a->discovery_lens);
+    free(a->notification_lens);
+    free(a->response_lens);
+}
+
+static void _createNetwork(void)
+{
+    unsigned i;
+
+    agents = zmemalloc(agents_nr * sizeof(struct simAgent));
+
+    for (i = 0; i < agents_nr; i++)
+    {
+        struct simAgent *a = &agents[i];
+
+        _setMac(a->al_mac,     0x0a, i);
+        _setMac(a->uplink_mac, 0x0e, i);
+        _setMac(a->wlan_mac,   0x0f, i);
+
+        switch (topology)
+        {
+            case SIM_TOPOLOGY_STAR:
+                a->parent = -1;
+                break;
+            case SIM_TOPOLOGY_CHAIN:
+                a->parent = (int)i - 1;
+                break;
+            case SIM_TOPOLOGY_TREE:
+                // Nodes are numbered breadth first, the DUT being node "0"
+                //
+                a->parent = (int)(i / fanout) - 1;
+                break;
+        }
+        a->hops = a->parent < 0 ? 1 : agents[a->parent].hops + 1;
+    }
+
+    for (i = 0; i < agents_nr; i++)
+    {
+        _agentForgeCmdus(i);
+    }
+}
+
+// Send a copy of 'streams' (with MID 'mid') from agent 'index' to the DUT
+//
+static void _agentSend(unsigned index, uint8_t **streams, uint16_t *lens, uint16_t mid, unsigned hops)
+{
+    struct simEvent e;
+    unsigned        streams_nr = 0;
+    unsigned        i;
+
+    if (_lost(hops))
+    {
+        return;
+    }
+
+    while (NULL != streams[streams_nr])
+    {
+        streams_nr++;
+    }
+
+    memset(&e, 0, sizeof(e));
+    e.time    = now_ms + hops * latency;
+    e.type    = SIM_EVENT_TO_DUT;
+    e.agent   = index;
+    e.lens    = lens;
+    e.streams = memalloc((streams_nr + 1) * sizeof(uint8_t *));
+    for (i = 0; i < streams_nr; i++)
+    {
+        e.streams[i] = memalloc(lens[i]);
+        memcpy(e.streams[i], streams[i], lens[i]);
+        // Bytes 4 and 5 of the CMDU header are the MID
+        //
+        e.streams[i][4] = (uint8_t)(mid >> 8);
+        e.streams[i][5] = (uint8_t)(mid);
+    }
+    e.streams[streams_nr] = NULL;
+
+    _eventPush(&e);
+}
+
+// Add a frame to the capture (see "-p")
+//
+static void _capture(const uint8_t *dst_mac, const uint8_t *src_mac, uint16_t eth_type,
+                     const uint8_t *payload, uint16_t payload_len)
+{
+    uint8_t frame[6 + 6 + 2 + MAX_NETWORK_SEGMENT_SIZE];
+
+    if (!capture || payload_len > MAX_NETWORK_SEGMENT_SIZE)
+    {
+        return;
+    }
+
+    memcpy(frame,     dst_mac, 6);
+    memcpy(frame + 6, src_mac, 6);
+    frame[12] = (uint8_t)(eth_type >> 8);
+    frame[13] = (uint8_t)(eth_type);
+    memcpy(frame + 14, payload, payload_len);
+
+    captureFrame(frame, 14 + payload_len);
+}
+
+static void _agentSchedule(unsigned index, uint8_t type, uint32_t time)
+{
+    struct simEvent e;
+
+    memset(&e, 0, sizeof(e));
+    e.time  = time;
+    e.type  = type;
+    e.agent = index;
+    _eventPush(&e);
+}
+
+// Retransmit the unanswered queries of the DUT and transmit the CMDUs that the
+// TX scheduler held back, as the AL entity does after processing each event
+//
+static void _dutRunTimers(void)
+{
+    struct simEvent e;
+    uint32_t        wait;
+
+    wait = requestTimeoutsRun();
+    if (0 != wait && (0 == requests_deadline || now_ms + wait < requests_deadline))
+    {
+        memset(&e, 0, sizeof(e));
+        e.time = now_ms + wait;
+        e.type = SIM_EVENT_REQUESTS;
+        _eventPush(&e);
+        requests_deadline = e.time;
+    }
+
+    wait = txSchedulerRun();
+    if (0 != wait && !tx_scheduled)
+    {
+        memset(&e, 0, sizeof(e));
+        e.time = now_ms + wait;
+        e.type = SIM_EVENT_TX_SCHEDULER;
+        _eventPush(&e);
+        tx_scheduled = true;
+    }
+}
+
+static void _processEvent(struct simEvent *e)
+{
+    struct simAgent *a = &agents[e->agent];
+
+    switch (e->type)
+    {
+        case SIM_EVENT_JOIN:
+        {
+            // Topology notifications are relayed multicast: they reach the DUT
+            // wherever the agent is. Topology discoveries are not relayed.
+            //
+            _agentSend(e->agent, a->notification, a->notification_lens, agents_mid++, a->hops);
+            if (a->parent < 0)
+            {
+                _agentSend(e->agent, a->discovery, a->discovery_lens, agents_mid++, 1);
+                _agentSchedule(e->agent, SIM_EVENT_DISCOVERY, now_ms + DISCOVERY_PERIOD_MS);
+            }
+            break;
+        }
+        case SIM_EVENT_DISCOVERY:
+        {
+            _agentSend(e->agent, a->discovery, a->discovery_lens, agents_mid++, 1);
+            _agentSchedule(e->agent, SIM_EVENT_DISCOVERY, now_ms + DISCOVERY_PERIOD_MS);
+            break;
+        }
+        case SIM_EVENT_TO_AGENT:
+        {
+            // Other queries (link metrics, higher layer...) are not answered:
+            // they are not needed for the DUT to learn the topology. The DUT
+            // retransmits them a few times and then gives up, which shows up
+            // in the "DUT queries" statistics.
+            //
+            if (CMDU_TYPE_TOPOLOGY_QUERY == e->message_type)
+            {
+                _agentSend(e->agent, a->response, a->response_lens, e->mid, a->hops);
+            }
+            break;
+        }
+        case SIM_EVENT_TO_DUT:
+        {
+            struct CMDU_view *v;
+            uint16_t          message_type = 0;
+            double            start;
+            uint32_t          stage_start;
+            unsigned long     allocations;
+            unsigned          i;
+
+            cmdus_rx++;
+
+            if (capture)
+            {
+                static const uint8_t mcast_address[] = MCAST_1905;
+
+                for (i = 0; NULL != e->streams[i]; i++)
+                {
+                    // Bytes 2 and 3 of the CMDU header are the message type
+                    //
+                    message_type = (e->streams[i][2] << 8) | e->streams[i][3];
+                    _capture(CMDU_TYPE_TOPOLOGY_RESPONSE == message_type ? dut_al_mac : mcast_address, a->al_mac,
+                             ETHERTYPE_1905, e->streams[i], e->lens[i]);
+                }
+                message_type = 0;
+            }
+
+            // Same instrumentation as the receive path of the AL entity
+            // (there is no platform queue nor reassembly here)
+            //
+            for (i = 0; NULL != e->streams[i]; i++)
+            {
+                cmduStatsFrame((e->streams[i][2] << 8) | e->streams[i][3], CMDU_STATS_RX, e->lens[i]);
+            }
+            allocations = memalloc_count;
+
+            start = _cpuTime();
+            stage_start = cmduStatsClock();
+            v = parse_1905_CMDU_view_from_packets(e->streams);
+            if (NULL != v)
+            {
+                cmduStatsElapsed(v->message_type, CMDU_STATS_STAGE_PARSE, stage_start);
+                if (0 == _checkDuplicates(a->al_mac, v))
+                {
+                    message_type = v->message_type;
+                    stage_start = cmduStatsClock();
+                    process1905CmduView(v, (uint8_t *)dut_if_mac, a->al_mac, 0);
+                    cmduStatsElapsed(v->message_type, CMDU_STATS_STAGE_PROCESS, stage_start);
+                }
+                cmduStatsAllocations(v->message_type, memalloc_count - allocations);
+                free_1905_CMDU_view(v);
+            }
+            _dutRunTimers();
+            dut_cpu += _cpuTime() - start;
+
+            for (i = 0; NULL != e->streams[i]; i++)
+            {
+                free(e->streams[i]);
+            }
+            free(e->streams);
+
+            if (CMDU_TYPE_TOPOLOGY_RESPONSE == message_type && !a->converged &&
+                0 == DMnetworkDeviceInfoNeedsUpdate(a->al_mac))
+            {
+                a->converged = true;
+                converged_nr++;
+            }
+            break;
+        }
+        case SIM_EVENT_TX_SCHEDULER:
+        case SIM_EVENT_REQUESTS:
+        {
+            double start = _cpuTime();
+
+            if (SIM_EVENT_TX_SCHEDULER == e->type)
+            {
+                tx_scheduled = false;
+            }
+            else if (e->time == requests_deadline)
+            {
+                requests_deadline = 0;
+            }
+            _dutRunTimers();
+            dut_cpu += _cpuTime() - start;
+            break;
+        }
+    }
+}
+
+static void _freeEvents(void)
+{
+    while (events_nr > 0)
+    {
+        struct simEvent e = _eventPop();
+        unsigned        i;
+
+        if (NULL != e.streams)
+        {
+            for (i = 0; NULL != e.streams[i]; i++)
+            {
+                free(e.streams[i]);
+            }
+            free(e.streams);
+        }
+    }
+    free(events);
+    events      = NULL;
+    events_size = 0;
+}
+
+static void _createDut(void)
+{
+    struct interface *interface;
+
+    DMinit();
+    DMalMacSet((uint8_t *)dut_al_mac);
+    DMmapWholeNetworkSet(1);
+
+    interface = interfaceAlloc(dut_if_mac, local_device);
+    interface->name = "sim0";
+    interface->type = interface_type_ethernet;
+}
+
+static void _printUsage(char *program_name)
+{
+    printf("Usage: %s [-n <agents>] [-t star|chain|tree] [-f <fanout>] [-c <clients>] [-l <loss>] [-d <latency>]\n"
+           "          [-j <join spacing>] [-T <time limit>] [-s <seed>] [-o <results file>] [-p <capture file>] [-v]\n", program_name);
+    printf("\n");
+    printf("  -n  number of simulated agents (max %u, default %u)\n", MAX_AGENTS, agents_nr);
+    printf("  -t  topology of the network (default %s)\n", topology_names[topology]);
+    printf("  -f  number of children of each node in the 'tree' topology (default %u)\n", fanout);
+    printf("  -c  number of non-1905 clients of each agent (default %u)\n", clients_nr);
+    printf("  -l  percentage of CMDUs lost on each hop (default %.1f)\n", loss);
+    printf("  -d  latency of each hop, in milliseconds (default %u)\n", latency);
+    printf("  -j  time between the boot of two consecutive agents, in milliseconds (default %u)\n", join_spacing);
+    printf("  -T  virtual time after which the simulation is stopped, in milliseconds (default %u)\n", time_limit);
+    printf("  -s  seed of the random number generator (default %u)\n", seed);
+    printf("  -o  append the results to this file, as a JSON object\n");
+    printf("  -p  capture the traffic of the DUT to this file (with wall clock timestamps)\n");
+    printf("  -v  increase the verbosity of the DUT\n");
+    printf("  -S  print the per message type statistics of the DUT (see al_cmdu_stats.h)\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Platform functions replaced at link time (see "-Wl,--wrap")
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t __wrap_PLATFORM_GET_TIMESTAMP(void)
+{
+    return now_ms;
+}
+
+// CMDUs sent by the DUT. Unicast ones (sent to the AL MAC address of an agent)
+// are routed to the agent, the rest (topology discoveries, LLDP...) are only
+// counted.
+//
+uint8_t __wrap_PLATFORM_SEND_RAW_PACKET(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                                        uint16_t eth_type, const uint8_t *payload, uint16_t payload_len)
+{
+    struct simEvent e;
+    unsigned        index;
+
+    (void)interface_name;
+
+    cmdus_tx++;
+
+    _capture(dst_mac, src_mac, eth_type, payload, payload_len);
+
+    if (ETHERTYPE_1905 != eth_type || payload_len < 6)
+    {
+        return 1;
+    }
+
+    index = (dst_mac[4] << 8) | dst_mac[5];
+    if (0x02 != dst_mac[0] || 0x0a != dst_mac[1] || index >= agents_nr)
+    {
+        return 1;
+    }
+
+    if (_lost(agents[index].hops))
+    {
+        return 1;
+    }
+
+    memset(&e, 0, sizeof(e));
+    e.time         = now_ms + agents[index].hops * latency;
+    e.type         = SIM_EVENT_TO_AGENT;
+    e.agent        = index;
+    e.message_type = (payload[2] << 8) | payload[3];
+    e.mid          = (payload[4] << 8) | payload[5];
+    _eventPush(&e);
+
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// External public functions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const char *results = NULL;
+    size_t      memory_before;
+    size_t      memory_after;
+    double      total_start;
+    double      total_cpu;
+    unsigned    i;
+    int         verbosity = 0;
+    int         c;
+
+    struct txSchedulerStats tx_stats;
+    struct requestStats     requests_stats;
+
+    while ((c = getopt(argc, argv, "n:t:f:c:l:d:j:T:s:o:p:vSh")) != -1)
+    {
+        switch (c)
+        {
+            case 'n': agents_nr    = atoi(optarg); break;
+            case 'f': fanout       = atoi(optarg); break;
+            case 'c': clients_nr   = atoi(optarg); break;
+            case 'l': loss         = atof(optarg); break;
+            case 'd': latency      = atoi(optarg); break;
+            case 'j': join_spacing = atoi(optarg); break;
+            case 'T': time_limit   = atoi(optarg); break;
+            case 's': seed         = atoi(optarg); break;
+            case 'o': results      = optarg;       break;
+            case 'v': verbosity++;                 break;
+            case 'S': cmduStatsPeriodSet(1);       break;
+            case 'p':
+            {
+                capturePathSet(optarg);
+                capture = true;
+                break;
+            }
+            case 't':
+            {
+                for (i = 0; i < ARRAY_SIZE(topology_names); i++)
+                {
+                    if (0 == strcmp(optarg, topology_names[i]))
+                    {
+                        topology = i;
+                        break;
+                    }
+                }
+                if (i == ARRAY_SIZE(topology_names))
+                {
+                    _printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            }
+            default:
+            {
+                _printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    if (0 == agents_nr || agents_nr > MAX_AGENTS || 0 == fanout || clients_nr > 255 || 0 == seed)
+    {
+        _printUsage(argv[0]);
+        return 1;
+    }
+
+    PLATFORM_PRINTF_DEBUG_SET_VERBOSITY_LEVEL(verbosity);
+
+    _createDut();
+    _createNetwork();
+    for (i = 0; i < agents_nr; i++)
+    {
+        _agentSchedule(i, SIM_EVENT_JOIN, i * join_spacing);
+    }
+
+    memory_before = mallinfo2().uordblks;
+    total_start   = _cpuTime();
+
+    while (events_nr > 0 && converged_nr < agents_nr)
+    {
+        struct simEvent e = _eventPop();
+
+        if (e.time > time_limit)
+        {
+            _eventPush(&e);
+            break;
+        }
+        now_ms = e.time;
+        _processEvent(&e);
+    }
+
+    total_cpu = _cpuTime() - total_start;
+
+    // Whatever is still in flight is not part of the DUT
+    //
+    _freeEvents();
+    memory_after = mallinfo2().uordblks;
+
+    PLATFORM_PRINTF("Agents             : %u (%s", agents_nr, topology_names[topology]);
+    if (SIM_TOPOLOGY_TREE == topology)
+    {
+        PLATFORM_PRINTF(", fanout %u", fanout);
+    }
+    PLATFORM_PRINTF(", %u clients each)\n", clients_nr);
+    PLATFORM_PRINTF("Loss / latency     : %.1f%% / %u ms per hop\n", loss, latency);
+    if (converged_nr == agents_nr)
+    {
+        PLATFORM_PRINTF("Converged          : after %u ms\n", now_ms);
+    }
+    else
+    {
+        PLATFORM_PRINTF("Converged          : NO, %u of %u agents known after %u ms\n", converged_nr, agents_nr, now_ms);
+    }
+    PLATFORM_PRINTF("CMDUs              : %llu received, %llu sent, %llu lost\n",
+                    (unsigned long long)cmdus_rx, (unsigned long long)cmdus_tx, (unsigned long long)cmdus_lost);
+    PLATFORM_PRINTF("DUT throughput     : %.0f CMDUs/s of CPU time\n", dut_cpu > 0 ? cmdus_rx / dut_cpu : 0);
+    PLATFORM_PRINTF("DUT CPU per agent  : %.1f us (simulation total %.3f s)\n", dut_cpu * 1e6 / agents_nr, total_cpu);
+    PLATFORM_PRINTF("DUT heap per agent : %ld bytes\n", ((long)memory_after - (long)memory_before) / (long)agents_nr);
+    txSchedulerStatsGet(&tx_stats);
+    PLATFORM_PRINTF("DUT TX scheduler   : %u deferred, %u coalesced, %u dropped, peak queue %u\n",
+                    tx_stats.deferred, tx_stats.coalesced, tx_stats.dropped, tx_stats.peak_pending);
+    requestStatsGet(&requests_stats);
+    PLATFORM_PRINTF("DUT queries        : %u sent, %u merged, %u answered, %u retransmitted, %u timed out\n",
+                    requests_stats.sent, requests_stats.merged, requests_stats.answered, requests_stats.retries, requests_stats.timeouts);
+    if (0 != cmduStatsPeriodGet())
+    {
+        cmduStatsDump(PLATFORM_PRINTF);
+    }
+
+    if (NULL != results)
+    {
+        FILE *f = fopen(results, "a");
+
+        if (NULL == f)
+        {
+            PLATFORM_PRINTF("Could not open %s\n", results);
+            return 1;
+        }
+        fprintf(f, "{\"suite\": \"network_simulator\", \"agents\": %u, \"topology\": \"%s\", \"fanout\": %u, "
+                   "\"clients\": %u, \"loss\": %.2f, \"latency_ms\": %u, \"converged\": %s, \"convergence_ms\": %u, "
+                   "\"cmdus_rx\": %llu, \"cmdus_tx\": %llu, \"cmdus_per_s\": %.0f, \"cpu_per_agent_us\": %.1f, "
+                   "\"heap_per_agent\": %ld}\n",
+                agents_nr, topology_names[topology], fanout, clients_nr, loss, latency,
+                converged_nr == agents_nr ? "true" : "false", now_ms,
+                (unsigned long long)cmdus_rx, (unsigned long long)cmdus_tx, dut_cpu > 0 ? cmdus_rx / dut_cpu : 0,
+                dut_cpu * 1e6 / agents_nr, ((long)memory_after - (long)memory_before) / (long)agents_nr);
+        fclose(f);
+    }
+
+    for (i = 0; i < agents_nr; i++)
+    {
+        _agentFreeCmdus(&agents[i]);
+    }
+    free(agents);
+
+    return converged_nr == agents_nr ? 0 : 1;
+}
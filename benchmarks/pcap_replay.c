@@ -0,0 +1,619 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+//
+// Replay of captured 1905 traffic.
+//
+// The frames of one or more pcap files (such as the ones written by the AL
+// entity with "-c <capture_file>") are fed, in order and as fast as possible,
+// through the same receive path as in "start1905AL()":
+//
+//   - 1905 frames go through "_reAssembleFragmentedCMDUs()",
+//     "_checkDuplicates()" and "process1905CmduView()".
+//
+//   - LLDP frames go through "parse_lldp_PAYLOAD_from_packet()" and
+//     "processLlpdPayload()".
+//
+// Frames sent by the AL entity that made the capture (those whose source
+// address is its AL MAC address or the MAC address of one of its interfaces)
+// are skipped. Everything the replayed AL sends in response is discarded.
+//
+// The clock of the AL is the time of the capture ("virtual time"), so timers
+// and ages behave as they did on the device, regardless of the replay speed.
+//
+// The time it takes to process each CMDU is measured and reported as a
+// histogram per message type, which makes it possible to reproduce (and
+// measure the fix of) CPU spikes seen in the field.
+//
+
+#include "platform.h"
+#include "utils.h"
+#include "datamodel.h"
+
+#include "1905_cmdus.h"
+#include "1905_l2.h"
+#include "lldp_payload.h"
+#include "../src/al.h"
+#include "../src/al_datamodel.h"
+#include "../src/al_recv.h"
+#include "../src/al_tx_scheduler.h"
+
+#include <stdio.h>      // fopen(), fread(), fprintf()
+#include <stdlib.h>     // free()
+#include <string.h>     // memcmp(), strtok_r()
+#include <time.h>       // clock_gettime()
+#include <unistd.h>     // getopt()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+#define PCAP_MAGIC           (0xa1b2c3d4)
+#define PCAP_MAGIC_NSEC      (0xa1b23c4d)
+#define PCAP_LINKTYPE_ETHER  (1)
+
+#define MAX_INTERFACES       (16)
+
+// Bucket 'i' of the histograms counts the CMDUs that took less than 2^i
+// microseconds to be processed (and at least 2^(i-1)). The last one also
+// counts everything slower.
+//
+#define HISTOGRAM_BUCKETS    (24)
+
+// Key used for LLDP frames in the statistics (CMDU message types are 16 bits)
+//
+#define STATS_KEY_LLDP       (0x10000)
+
+struct _messageStats
+{
+    uint32_t key;                            // Message type or STATS_KEY_LLDP
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t histogram[HISTOGRAM_BUCKETS];
+};
+
+static struct _messageStats *stats;
+static unsigned              stats_nr;
+
+static mac_address           al_mac_address;
+static mac_address           interface_addresses[MAX_INTERFACES];
+static unsigned              interfaces_nr;
+
+static uint32_t              now_ms;
+
+static uint64_t              frames_rx;
+static uint64_t              frames_tx;
+static uint64_t              frames_skipped;
+static uint64_t              duplicates;
+static uint64_t              sent;
+
+static uint64_t _now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct _messageStats *_stats(uint32_t key)
+{
+    unsigned i;
+
+    for (i = 0; i < stats_nr; i++)
+    {
+        if (stats[i].key == key)
+        {
+            return &stats[i];
+        }
+    }
+
+    // Keep them sorted by key, so that the report is too
+    //
+    stats = memrealloc(stats, (stats_nr + 1) * sizeof(struct _messageStats));
+    for (i = stats_nr; i > 0 && stats[i - 1].key > key; i--)
+    {
+        stats[i] = stats[i - 1];
+    }
+    memset(&stats[i], 0, sizeof(struct _messageStats));
+    stats[i].key = key;
+    stats_nr++;
+
+    return &stats[i];
+}
+
+static void _record(uint32_t key, uint64_t ns)
+{
+    struct _messageStats *s = _stats(key);
+    uint64_t              us;
+    unsigned              bucket = 0;
+
+    for (us = ns / 1000; us > 0 && bucket < HISTOGRAM_BUCKETS - 1; us >>= 1)
+    {
+        bucket++;
+    }
+
+    s->count++;
+    s->total_ns += ns;
+    s->histogram[bucket]++;
+    if (ns > s->max_ns)
+    {
+        s->max_ns = ns;
+    }
+}
+
+// Return the upper bound (in microseconds) of the bucket that contains the
+// given 'percentile' of the samples of 's'.
+//
+static uint64_t _percentile(const struct _messageStats *s, unsigned percentile)
+{
+    uint64_t seen = 0;
+    unsigned i;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += s->histogram[i];
+        if (seen * 100 >= s->count * percentile)
+        {
+            break;
+        }
+    }
+    return (uint64_t)1 << i;
+}
+
+static const char *_name(uint32_t key)
+{
+    if (STATS_KEY_LLDP == key)
+    {
+        return "LLDP";
+    }
+    return key <= 0xff ? convert_1905_CMDU_type_to_string(key) : "Unknown";
+}
+
+static bool _isLocalAddress(const uint8_t *mac)
+{
+    unsigned i;
+
+    if (0 == memcmp(mac, al_mac_address, 6))
+    {
+        return true;
+    }
+    for (i = 0; i < interfaces_nr; i++)
+    {
+        if (0 == memcmp(mac, interface_addresses[i], 6))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Process one captured Ethernet frame the way "start1905AL()" does
+//
+static void _replayFrame(const uint8_t *frame, uint16_t len)
+{
+    uint8_t          *receiving_interface_addr = interface_addresses[0];
+    uint8_t           src_addr[6];
+    uint16_t          ether_type;
+    uint64_t          start;
+
+    if (len < 6 + 6 + 2)
+    {
+        frames_skipped++;
+        return;
+    }
+
+    memcpy(src_addr, frame + 6, 6);
+    ether_type = (frame[12] << 8) | frame[13];
+
+    if (_isLocalAddress(src_addr))
+    {
+        frames_tx++;
+        return;
+    }
+    frames_rx++;
+
+    switch (ether_type)
+    {
+        case ETHERTYPE_LLDP:
+        {
+            struct PAYLOAD *payload;
+
+            start   = _now();
+            payload = parse_lldp_PAYLOAD_from_packet(frame + 6 + 6 + 2);
+            if (NULL != payload)
+            {
+                processLlpdPayload(payload, receiving_interface_addr);
+                free_lldp_PAYLOAD_structure(payload);
+            }
+            _record(STATS_KEY_LLDP, _now() - start);
+            break;
+        }
+
+        case ETHERTYPE_1905:
+        {
+            struct CMDU_view *c;
+
+            // Only the processing of the last fragment of a CMDU is measured
+            //
+            start = _now();
+            c = _reAssembleFragmentedCMDUs(frame, len);
+            if (NULL == c)
+            {
+                break;
+            }
+
+            if (1 == _checkDuplicates(src_addr, c))
+            {
+                duplicates++;
+            }
+            else
+            {
+                process1905CmduView(c, receiving_interface_addr, src_addr, 0);
+            }
+            txSchedulerRun();
+            _record(c->message_type, _now() - start);
+
+            free_1905_CMDU_view(c);
+            break;
+        }
+
+        default:
+        {
+            frames_skipped++;
+            break;
+        }
+    }
+}
+
+static uint32_t _swap32(uint32_t x)
+{
+    return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | (x << 24);
+}
+
+// Replay all the frames of the pcap file 'path'. Returns "0" on error.
+//
+static uint8_t _replayFile(const char *path)
+{
+    static bool      first_frame = true;
+    static uint64_t  first_ms;
+
+    FILE     *f;
+    uint32_t  header[6];
+    uint32_t  record[4];
+    uint8_t   frame[MAX_NETWORK_SEGMENT_SIZE];
+    bool      swapped;
+    bool      nsec;
+    uint8_t   ret = 1;
+
+    f = fopen(path, "rb");
+    if (NULL == f)
+    {
+        PLATFORM_PRINTF("Could not open %s\n", path);
+        return 0;
+    }
+
+    // Files written on a device with a different endianness (which is the
+    // common case for captures from the field) are supported.
+    //
+    if (1 != fread(header, sizeof(header), 1, f))
+    {
+        PLATFORM_PRINTF("%s: not a pcap file\n", path);
+        fclose(f);
+        return 0;
+    }
+    swapped = PCAP_MAGIC != header[0] && PCAP_MAGIC_NSEC != header[0];
+    if (swapped)
+    {
+        header[0] = _swap32(header[0]);
+        header[5] = _swap32(header[5]);
+    }
+    nsec = PCAP_MAGIC_NSEC == header[0];
+    if ((PCAP_MAGIC != header[0] && !nsec) || PCAP_LINKTYPE_ETHER != header[5])
+    {
+        PLATFORM_PRINTF("%s: not a pcap file of Ethernet frames\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    while (1 == fread(record, sizeof(record), 1, f))
+    {
+        uint64_t ms;
+        uint32_t i;
+
+        if (swapped)
+        {
+            for (i = 0; i < ARRAY_SIZE(record); i++)
+            {
+                record[i] = _swap32(record[i]);
+            }
+        }
+
+        if (record[2] > sizeof(frame))
+        {
+            // Frames longer than this can't be 1905 or LLDP frames
+            //
+            if (0 != fseek(f, record[2], SEEK_CUR))
+            {
+                ret = 0;
+                break;
+            }
+            frames_skipped++;
+            continue;
+        }
+        if (1 != fread(frame, record[2], 1, f) && 0 != record[2])
+        {
+            PLATFORM_PRINTF("%s: truncated\n", path);
+            ret = 0;
+            break;
+        }
+
+        // Virtual time starts at 1 second (as if the AL had just started)
+        // with the first frame of the first file.
+        //
+        ms = (uint64_t)record[0] * 1000 + (nsec ? record[1] / 1000000 : record[1] / 1000);
+        if (first_frame)
+        {
+            first_frame = false;
+            first_ms    = ms;
+        }
+        now_ms = (uint32_t)(ms - first_ms) + 1000;
+
+        _replayFrame(frame, (uint16_t)record[2]);
+    }
+
+    fclose(f);
+    return ret;
+}
+
+static void _report(FILE *results, const char *capture)
+{
+    unsigned i, j;
+
+    PLATFORM_PRINTF("Frames             : %llu received, %llu sent by the capturing AL, %llu skipped\n",
+                    (unsigned long long)frames_rx, (unsigned long long)frames_tx, (unsigned long long)frames_skipped);
+    PLATFORM_PRINTF("CMDUs              : %llu duplicates discarded, %llu frames sent by the replayed AL\n",
+                    (unsigned long long)duplicates, (unsigned long long)sent);
+    PLATFORM_PRINTF("\n");
+    PLATFORM_PRINTF("%-6s %-42s %8s %10s %8s %8s %8s %10s\n",
+                    "type", "name", "count", "mean us", "p50 us", "p90 us", "p99 us", "max us");
+
+    for (i = 0; i < stats_nr; i++)
+    {
+        const struct _messageStats *s = &stats[i];
+
+        PLATFORM_PRINTF("0x%04x %-42s %8llu %10.1f %8llu %8llu %8llu %10.1f\n",
+                        s->key & 0xffff, _name(s->key), (unsigned long long)s->count,
+                        s->total_ns / 1000.0 / s->count, (unsigned long long)_percentile(s, 50),
+                        (unsigned long long)_percentile(s, 90), (unsigned long long)_percentile(s, 99),
+                        s->max_ns / 1000.0);
+    }
+
+    for (i = 0; i < stats_nr; i++)
+    {
+        const struct _messageStats *s = &stats[i];
+
+        PLATFORM_PRINTF("\n%s:\n", _name(s->key));
+        for (j = 0; j < HISTOGRAM_BUCKETS; j++)
+        {
+            unsigned bar;
+
+            if (0 == s->histogram[j])
+            {
+                continue;
+            }
+            bar = (unsigned)((s->histogram[j] * 50 + s->count - 1) / s->count);
+            PLATFORM_PRINTF("  %s %8llu us: %8llu %.*s\n", j == HISTOGRAM_BUCKETS - 1 ? ">=" : "< ",
+                            (unsigned long long)((uint64_t)1 << (j == HISTOGRAM_BUCKETS - 1 ? j - 1 : j)),
+                            (unsigned long long)s->histogram[j], (int)bar,
+                            "##################################################");
+        }
+    }
+
+    if (NULL == results)
+    {
+        return;
+    }
+
+    for (i = 0; i < stats_nr; i++)
+    {
+        const struct _messageStats *s = &stats[i];
+
+        fprintf(results, "{\"suite\": \"pcap_replay\", \"capture\": \"%s\", \"message_type\": %u, \"name\": \"%s\", "
+                         "\"count\": %llu, \"mean_us\": %.1f, \"p50_us\": %llu, \"p90_us\": %llu, \"p99_us\": %llu, "
+                         "\"max_us\": %.1f, \"histogram\": [",
+                capture, s->key & 0xffff, _name(s->key), (unsigned long long)s->count, s->total_ns / 1000.0 / s->count,
+                (unsigned long long)_percentile(s, 50), (unsigned long long)_percentile(s, 90),
+                (unsigned long long)_percentile(s, 99), s->max_ns / 1000.0);
+        for (j = 0; j < HISTOGRAM_BUCKETS; j++)
+        {
+            fprintf(results, "%s%llu", j ? ", " : "", (unsigned long long)s->histogram[j]);
+        }
+        fprintf(results, "]}\n");
+    }
+}
+
+// Parse a comma separated list of MAC addresses into 'interface_addresses'.
+// Returns "0" on error.
+//
+static uint8_t _parseInterfacesList(const char *str)
+{
+    char    *aux;
+    char    *mac;
+    char    *save_ptr;
+    uint8_t  ret = 1;
+
+    aux = strdup(str);
+
+    for (mac = strtok_r(aux, ",", &save_ptr); NULL != mac; mac = strtok_r(NULL, ",", &save_ptr))
+    {
+        if (MAX_INTERFACES == interfaces_nr)
+        {
+            ret = 0;
+            break;
+        }
+        asciiToMac(mac, &interface_addresses[interfaces_nr++]);
+    }
+
+    free(aux);
+    return ret;
+}
+
+static void _createAl(uint8_t map_whole_network)
+{
+    unsigned i;
+
+    DMinit();
+    DMalMacSet(al_mac_address);
+    DMmapWholeNetworkSet(map_whole_network);
+
+    // Without interfaces, frames are received on one with the AL MAC address
+    //
+    if (0 == interfaces_nr)
+    {
+        memcpy(interface_addresses[0], al_mac_address, 6);
+        interfaces_nr = 1;
+    }
+
+    for (i = 0; i < interfaces_nr; i++)
+    {
+        struct interface *interface = interfaceAlloc(interface_addresses[i], local_device);
+        char              name[20];  // "replay" plus any "%u"
+
+        snprintf(name, sizeof(name), "replay%u", i);
+        interface->name = strdup(name);
+        interface->type = interface_type_ethernet;
+    }
+}
+
+static void _printUsage(char *program_name)
+{
+    printf("Usage: %s -m <al_mac_address> [-i <interface_macs>] [-w] [-o <results file>] [-v] <capture file>...\n",
+           program_name);
+    printf("\n");
+    printf("  -m  AL MAC address of the AL entity that made the capture\n");
+    printf("  -i  comma separated list of the MAC addresses of its interfaces. Frames are replayed as if\n");
+    printf("      received on the first one.\n");
+    printf("  -w  map the whole network (as with the '-w' option of the AL entity)\n");
+    printf("  -o  append the results to this file, as JSON objects (one per message type)\n");
+    printf("  -v  increase the verbosity of the replayed AL\n");
+    printf("\n");
+    printf("  Rotated captures must be given oldest first (ex: 'capture.3 capture.2 capture.1 capture').\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Platform functions replaced at link time (see "-Wl,--wrap")
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t __wrap_PLATFORM_GET_TIMESTAMP(void)
+{
+    return now_ms;
+}
+
+uint8_t __wrap_PLATFORM_SEND_RAW_PACKET(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                                        uint16_t eth_type, const uint8_t *payload, uint16_t payload_len)
+{
+    (void)interface_name;
+    (void)dst_mac;
+    (void)src_mac;
+    (void)eth_type;
+    (void)payload;
+    (void)payload_len;
+
+    sent++;
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// External public functions
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+    const char *al_mac            = NULL;
+    const char *results_path      = NULL;
+    FILE       *results           = NULL;
+    uint8_t     map_whole_network = 0;
+    int         verbosity         = 0;
+    int         ret               = 0;
+    int         c;
+    int         i;
+
+    while ((c = getopt(argc, argv, "m:i:wo:vh")) != -1)
+    {
+        switch (c)
+        {
+            case 'm': al_mac            = optarg; break;
+            case 'w': map_whole_network = 1;      break;
+            case 'o': results_path      = optarg; break;
+            case 'v': verbosity++;                break;
+            case 'i':
+            {
+                if (!_parseInterfacesList(optarg))
+                {
+                    _printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            }
+            default:
+            {
+                _printUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    if (NULL == al_mac || optind == argc)
+    {
+        _printUsage(argv[0]);
+        return 1;
+    }
+    asciiToMac(al_mac, &al_mac_address);
+
+    if (NULL != results_path)
+    {
+        results = fopen(results_path, "a");
+        if (NULL == results)
+        {
+            PLATFORM_PRINTF("Could not open %s\n", results_path);
+            return 1;
+        }
+    }
+
+    PLATFORM_PRINTF_DEBUG_SET_VERBOSITY_LEVEL(verbosity);
+
+    _createAl(map_whole_network);
+
+    for (i = optind; i < argc; i++)
+    {
+        if (!_replayFile(argv[i]))
+        {
+            ret = 1;
+        }
+    }
+
+    _report(results, argv[argc - 1]);
+
+    if (NULL != results)
+    {
+        fclose(results);
+    }
+    free(stats);
+
+    return ret;
+}
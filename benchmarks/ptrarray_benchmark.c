@@ -0,0 +1,99 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/* Measure the ptrarray operations used by the data model: filling and emptying the neighbours of an interface, and
+ * stations associating to and leaving an AP (see tests/ptrarray_test.c for their behaviour).
+ */
+
+#include <ptrarray.h>
+#include "platform.h"
+#include <string.h>
+#include <time.h>       // clock_gettime()
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Number of elements and of rounds used in the benchmarks. */
+#define BENCHMARK_ELEMENTS (64)
+#define BENCHMARK_ROUNDS   (20000)
+
+/* Measure the time to fill an array with BENCHMARK_ELEMENTS elements and empty it again by removing them one by one, as
+ * happens with the neighbours of an interface. Elements are removed from the front, which is the worst case for
+ * PTRARRAY_REMOVE(). */
+#define BENCHMARK_FILL_AND_EMPTY(name, array, remove) \
+    do { \
+        double start = now(); \
+        unsigned round; \
+        unsigned i; \
+        for (round = 0; round < BENCHMARK_ROUNDS; round++) \
+        { \
+            for (i = 0; i < BENCHMARK_ELEMENTS; i++) \
+            { \
+                PTRARRAY_ADD(array, i + 1); \
+            } \
+            while ((array).length > 0) \
+            { \
+                remove(array, 0); \
+            } \
+        } \
+        PLATFORM_PRINTF("%-32s: %7.1f ns per element\n", name, \
+                        (now() - start) * 1e9 / BENCHMARK_ROUNDS / BENCHMARK_ELEMENTS); \
+    } while (0)
+
+/* Measure the time to add and remove one element to an array that holds @a base elements, as happens with the clients
+ * of an AP when a station associates and leaves. */
+#define BENCHMARK_CHURN(name, array, base) \
+    do { \
+        double start; \
+        unsigned round; \
+        unsigned i; \
+        for (i = 0; i < (base); i++) \
+        { \
+            PTRARRAY_ADD(array, i + 1); \
+        } \
+        start = now(); \
+        for (round = 0; round < BENCHMARK_ROUNDS * 16; round++) \
+        { \
+            PTRARRAY_ADD(array, round); \
+            PTRARRAY_REMOVE_UNORDERED(array, (array).length - 1); \
+        } \
+        PLATFORM_PRINTF("%-32s: %7.1f ns per add/remove\n", name, (now() - start) * 1e9 / BENCHMARK_ROUNDS / 16); \
+        PTRARRAY_CLEAR(array); \
+    } while (0)
+
+int main()
+{
+    PTRARRAY(unsigned) array;
+    PTRARRAY_INLINE(unsigned, 4) inline_array;
+
+    memset(&array, 0, sizeof(array));
+    memset(&inline_array, 0, sizeof(inline_array));
+
+    BENCHMARK_FILL_AND_EMPTY("fill and empty, ordered", array, PTRARRAY_REMOVE);
+    BENCHMARK_FILL_AND_EMPTY("fill and empty, unordered", array, PTRARRAY_REMOVE_UNORDERED);
+    BENCHMARK_CHURN("churn, 0 elements", array, 0);
+    BENCHMARK_CHURN("churn, 0 elements, inline", inline_array, 0);
+    BENCHMARK_CHURN("churn, 32 elements", array, 32);
+
+    return 0;
+}
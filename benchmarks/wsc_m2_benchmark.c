@@ -0,0 +1,196 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/* Measure how many M2 messages the registrar can build per second, as happens when many agents are onboarded at the
+ * same time, with DH key pairs generated on demand and with pre-generated key pairs.
+ *
+ * Each M2 is also processed by the enrollee, to check that the keys taken from the pool are valid.
+ */
+
+#include <platform.h>
+#include <utils.h>
+#include <datamodel.h>
+#include "../src/al_wsc.h"
+#include "../src/platform_crypto.h"
+
+#include <string.h>
+#include <time.h>       // clock_gettime()
+#include <unistd.h>     // usleep()
+
+/* Number of M1 messages received "at the same time", and number of times this is measured. */
+#define BURST_SIZE (8)
+#define ROUNDS     (16)
+
+static const mac_address al_mac = {0x02, 0x01, 0x02, 0x03, 0x04, 0x05};
+
+static struct bssInfo configured_bss;
+static unsigned       configured_nr;
+
+static bool addAP(struct radio *radio, struct bssInfo bss_info)
+{
+    (void)radio;
+    configured_bss = bss_info;
+    configured_nr++;
+    return true;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Build a burst of M2 messages in answer to an M1 of @a radio, and check them.
+ *
+ * Returns the time it took to build the M2 messages, or a negative value on error.
+ */
+static double burst(struct radio *radio, const struct wscRegistrarInfo *wsc_info)
+{
+    struct wscM1Info m1_info;
+    struct wscM2Buf  m2[BURST_SIZE];
+    double           start;
+    double           elapsed;
+    unsigned         i;
+    int              ret = 0;
+
+    if (!wscBuildM1(radio, &radio->device_data))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not build M1\n");
+        return -1;
+    }
+    if (!wscParseM1(radio->wsc_info->m1, radio->wsc_info->m1_len, &m1_info))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not parse M1\n");
+        return -1;
+    }
+
+    start = now();
+    for (i = 0; i < BURST_SIZE; i++)
+    {
+        if (!wscBuildM2(&m1_info, wsc_info, &m2[i]))
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Could not build M2 %u\n", i);
+            return -1;
+        }
+    }
+    elapsed = now() - start;
+
+    /* wscProcessM2() doesn't consume the M1 state, so all M2s can be checked against the same M1. */
+    configured_nr = 0;
+    for (i = 0; i < BURST_SIZE; i++)
+    {
+        if (!wscProcessM2(radio, m2[i].m2, m2[i].m2_size))
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Could not process M2 %u\n", i);
+            ret++;
+        }
+        free(m2[i].m2);
+    }
+    if (configured_nr != BURST_SIZE ||
+        configured_bss.ssid.length != wsc_info->bss_info.ssid.length ||
+        memcmp(configured_bss.ssid.ssid, wsc_info->bss_info.ssid.ssid, configured_bss.ssid.length) != 0 ||
+        configured_bss.key_len != wsc_info->bss_info.key_len ||
+        memcmp(configured_bss.key, wsc_info->bss_info.key, configured_bss.key_len) != 0)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("M2 settings were not received correctly\n");
+        ret++;
+    }
+
+    wscInfoFree(radio);
+    return ret == 0 ? elapsed : -1;
+}
+
+/* Run ROUNDS bursts, leaving the background thread (if any) time to refill the pool in between.
+ *
+ * Returns the number of M2 built per second, or a negative value on error.
+ */
+static double measure(struct radio *radio, const struct wscRegistrarInfo *wsc_info)
+{
+    double   total = 0;
+    double   elapsed;
+    unsigned i;
+
+    for (i = 0; i < ROUNDS; i++)
+    {
+        elapsed = burst(radio, wsc_info);
+        if (elapsed < 0)
+        {
+            return -1;
+        }
+        total += elapsed;
+        usleep((useconds_t)(4 * elapsed * 1e6));
+    }
+    return ROUNDS * BURST_SIZE / total;
+}
+
+int main()
+{
+    struct wscRegistrarInfo *wsc_info;
+    struct radio            *radio;
+    double                   on_demand;
+    double                   pooled;
+
+    local_device = alDeviceAlloc(al_mac);
+    registrar.d = local_device;
+    registrar.is_map = true;
+
+    wsc_info = zmemalloc(sizeof(*wsc_info));
+    memcpy(wsc_info->bss_info.bssid, al_mac, sizeof(mac_address));
+    wsc_info->bss_info.ssid.length = strlen("prplMesh");
+    memcpy(wsc_info->bss_info.ssid.ssid, "prplMesh", wsc_info->bss_info.ssid.length);
+    wsc_info->bss_info.auth_mode = auth_mode_wpa2psk;
+    wsc_info->bss_info.key_len = strlen("prplMeshKey");
+    memcpy(wsc_info->bss_info.key, "prplMeshKey", wsc_info->bss_info.key_len);
+    wsc_info->rf_bands = WPS_RF_24GHZ;
+    registrarAddWsc(wsc_info);
+
+    radio = radioAlloc(local_device, al_mac);
+    radio->addAP = addAP;
+
+    on_demand = measure(radio, wsc_info);
+    if (on_demand < 0)
+    {
+        return 1;
+    }
+    PLATFORM_PRINTF("M2, key pairs generated on demand : %7.1f M2/s\n", on_demand);
+
+    if (0 == PLATFORM_PREGENERATE_DH_KEY_PAIRS())
+    {
+        PLATFORM_PRINTF("M2, pre-generated key pairs       : not supported\n");
+    }
+    else
+    {
+        pooled = measure(radio, wsc_info);
+        if (pooled < 0)
+        {
+            return 1;
+        }
+        PLATFORM_PRINTF("M2, pre-generated key pairs       : %7.1f M2/s\n", pooled);
+
+        /* Right after a burst, the pool is (partly) empty: M2 must still be built correctly. */
+        if (burst(radio, wsc_info) < 0 || burst(radio, wsc_info) < 0)
+        {
+            return 1;
+        }
+    }
+
+    alDeviceDelete(local_device);
+    return 0;
+}
@@ -448,6 +448,7 @@ struct customCommandRequestALME
                                    // ALME_TYPE_CUSTOM_COMMAND_REQUEST
 
     #define CUSTOM_COMMAND_DUMP_NETWORK_DEVICES   (0x01)
+    #define CUSTOM_COMMAND_DUMP_CMDU_STATS        (0x02)
     uint8_t   command;               // One of the values from above. To see what
                                    // each of these commands is asking for, read
                                    // the comments inside the
@@ -477,6 +478,21 @@ struct customCommandResponseALME
                                    //      1905 node has gained so far of the
                                    //      environment (neighbors, their
                                    //      properties, their metrics, etc...)
+                                   //      Because this text can be longer
+                                   //      than what fits in one message, the
+                                   //      AL sends as many consecutive
+                                   //      responses as needed. Each of them
+                                   //      contains a NULL terminated piece of
+                                   //      the text, which the HLE must
+                                   //      concatenate.
+                                   //
+                                   //  - CUSTOM_COMMAND_DUMP_CMDU_STATS:
+                                   //      Same as above, but the text contains
+                                   //      the per message type statistics of
+                                   //      the AL (processing times, counters
+                                   //      and allocations), in the same
+                                   //      "key=value" format used in its
+                                   //      periodic log line.
 };
 
 
@@ -489,6 +505,9 @@ struct customCommandResponseALME
 // already been filled with the appropiate values extracted from the parsed
 // stream.
 //
+// 'packet_len' is the length of the stream. The TLVs embedded in an
+// ALME-GET-METRIC.response must fit in it.
+//
 //   NOTE:
 //     While the standard defines the *type* of ALME-SAP messages, it does *not*
 //     describe its actual mapping to bits. This is because HLE and AL are
@@ -552,7 +571,7 @@ struct customCommandResponseALME
 // Otherwise, the returned structure is dynamically allocated, and once it is
 // no longer needed, the user must call the "free_1905_ALME_structure()" function
 //
-uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream);
+uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream, uint16_t packet_len);
 
 
 // This is the opposite of "parse_1905_ALME_from_packet()": it receives a
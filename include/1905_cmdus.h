@@ -93,6 +93,72 @@ struct CMDU
                                       // structures.
                                       // The "end of message" TLV is not included
                                       // in this list.
+
+    struct CMDU_TLV_index *tlv_index; // Index of 'list_of_TLVs' by TLV type
+                                      // (see "index_1905_CMDU_TLVs()"), or
+                                      // NULL. CMDUs that are built by hand
+                                      // must set it to NULL.
+};
+
+// Index of the TLVs of a CMDU by type.
+//
+// 'order' contains the position in 'list_of_TLVs' of every TLV, grouped by
+// type (and, for each type, in the order they appear in 'list_of_TLVs').
+// The TLVs of type 't' are at positions 'order[first[t]]' to
+// 'order[first[t] + count[t] - 1]'.
+//
+struct CMDU_TLV_index
+{
+    uint16_t  first[TLV_TYPE_NUM];
+    uint16_t  count[TLV_TYPE_NUM];
+    uint16_t  order[];
+};
+
+// Alternative representation of a received CMDU where TLVs are only decoded
+// when someone actually needs them.
+//
+// The TLVs of all fragments are kept, back to back and still in their network
+// format (type, length and value), in 'payload'. While they are being copied
+// there, their position is recorded in 'tlvs' and all TLVs of one same type
+// are chained together, so that the n-th TLV of a given type can be found
+// without looking at the others.
+//
+// For the common CMDUs that only carry a couple of fixed size TLVs (such as
+// the "topology discovery" or the "topology notification"), the handler can
+// then read the fields it needs directly from 'payload' instead of having a
+// whole "struct CMDU" (and one structure per TLV) allocated and freed again
+// for each received packet.
+//
+#define CMDU_VIEW_NO_TLV  (0xffff)
+
+struct CMDU_view_TLV
+{
+    uint32_t  offset;                // Offset of the TLV (ie. of its "type"
+                                     // field) inside 'payload'
+
+    uint16_t  length;                // Length of the TLV value
+
+    uint8_t   type;                  // Any of the TLV_TYPE_* types
+
+    uint16_t  next;                  // Index (in 'tlvs') of the next TLV of
+                                     // the same type, or CMDU_VIEW_NO_TLV
+};
+
+struct CMDU_view
+{
+    uint8_t   message_version;       // Same as in "struct CMDU"
+    uint16_t  message_type;
+    uint16_t  message_id;
+    uint8_t   relay_indicator;
+
+    uint8_t  *payload;               // TLVs of all fragments, in order. The
+    uint32_t  payload_len;           // "end of message" TLVs are not included.
+
+    struct CMDU_view_TLV *tlvs;      // One entry for each TLV in 'payload', in
+    uint16_t              tlvs_nr;   // the same order.
+
+    uint16_t  first[TLV_TYPE_NUM];   // Index (in 'tlvs') of the first TLV of
+                                     // each type, or CMDU_VIEW_NO_TLV
 };
 
 
@@ -210,6 +276,53 @@ struct CMDU
 //
 struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams);
 
+// This function does the same as "parse_1905_CMDU_from_packets()" (the same
+// checks are done on the headers of all fragments, and the same rules are
+// applied regarding which TLVs must or may appear on each message type) but
+// returns a "struct CMDU_view" where TLVs are left undecoded.
+//
+// Because TLVs are not decoded, a TLV whose contents are malformed is not
+// detected here but only when it is decoded later (with
+// "decode_1905_CMDU_view_TLV()" or "convert_1905_CMDU_view_to_structure()").
+// Callers that read the raw TLV value instead (with
+// "get_1905_CMDU_view_TLV()") must check its length themselves.
+//
+// If any type of error/inconsistency is found, a NULL pointer is returned,
+// otherwise remember to free the returned view with "free_1905_CMDU_view()".
+//
+struct CMDU_view *parse_1905_CMDU_view_from_packets(uint8_t **packet_streams);
+
+// Return the number of TLVs of type 'tlv_type' in 'view'
+//
+uint16_t count_1905_CMDU_view_TLVs(const struct CMDU_view *view, uint8_t tlv_type);
+
+// Return a pointer to the value of the 'n'-th (starting at '0') TLV of type
+// 'tlv_type' in 'view' and set 'length' to its length, or return NULL if there
+// are not that many TLVs of that type.
+//
+// The returned pointer points inside the view and is valid until the view is
+// freed.
+//
+const uint8_t *get_1905_CMDU_view_TLV(const struct CMDU_view *view, uint8_t tlv_type, uint16_t n, uint16_t *length);
+
+// Decode the 'n'-th (starting at '0') TLV of type 'tlv_type' in 'view' into
+// the same structure "parse_1905_TLV_from_packet()" would return.
+//
+// Returns NULL if there is no such TLV or if it is malformed. Otherwise, free
+// the returned structure with "free_1905_TLV_structure()".
+//
+struct tlv *decode_1905_CMDU_view_TLV(const struct CMDU_view *view, uint8_t tlv_type, uint16_t n);
+
+// Decode all TLVs in 'view' and return the equivalent "struct CMDU" (ie. the
+// same thing "parse_1905_CMDU_from_packets()" would have returned for the same
+// packets).
+//
+// Returns NULL if any of the TLVs is malformed. Otherwise, free the returned
+// structure with "free_1905_CMDU_structure()". 'view' itself is not modified
+// and must still be freed by the caller.
+//
+struct CMDU *convert_1905_CMDU_view_to_structure(const struct CMDU_view *view);
+
 
 // This is the opposite of "parse_1905_CMDU_from_packets()": it receives a
 // pointer to a TLV structure and then returns a list of pointers to fragmented
@@ -283,6 +396,34 @@ bool parse_1905_CMDU_header_from_packet(const uint8_t *packet_buffer, size_t len
 void free_1905_CMDU_structure(struct CMDU *memory_structure);
 
 
+// Free a view returned by "parse_1905_CMDU_view_from_packets()"
+//
+void free_1905_CMDU_view(struct CMDU_view *view);
+
+
+// Build the 'tlv_index' of 'memory_structure' (replacing the previous one, if
+// any).
+//
+// CMDUs returned by "parse_1905_CMDU_from_packets()" and
+// "convert_1905_CMDU_view_to_structure()" are already indexed. Whoever modifies
+// 'list_of_TLVs' afterwards must either call this function again or free the
+// index and set it to NULL.
+//
+void index_1905_CMDU_TLVs(struct CMDU *memory_structure);
+
+// Return the number of TLVs of type 'tlv_type' in 'memory_structure'
+//
+uint16_t count_1905_CMDU_TLVs(const struct CMDU *memory_structure, uint8_t tlv_type);
+
+// Return the 'n'-th (starting at '0') TLV of type 'tlv_type' in
+// 'memory_structure', or NULL if there are not that many TLVs of that type.
+//
+// Both this function and "count_1905_CMDU_TLVs()" take constant time if the
+// CMDU is indexed. Otherwise they go through the whole 'list_of_TLVs'.
+//
+struct tlv *get_1905_CMDU_TLV(const struct CMDU *memory_structure, uint8_t tlv_type, uint16_t n);
+
+
 // This function receives a pointer to a list of streams (such as the one
 // returned by 'forge_1905_CMDU_from_structure()' and frees all the associated
 // structures
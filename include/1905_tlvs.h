@@ -1039,7 +1039,9 @@ struct apRadioIdentifierTLV {
 ////////////////////////////////////////////////////////////////////////////////
 
 // This function receives a pointer to a stream of bytes representing a 1905
-// TLV according to "Section 6.4"
+// TLV according to "Section 6.4" and the number of bytes ('packet_len') that
+// are left in the received frame from that point on. A TLV whose "Length"
+// field goes past those bytes is rejected.
 //
 // It then returns a pointer to a structure whose fields have already been
 // filled with the appropriate values extracted from the parsed stream.
@@ -1052,7 +1054,7 @@ struct apRadioIdentifierTLV {
 // Otherwise, the returned structure is dynamically allocated, and once it is
 // no longer needed, the user must call the "free_1905_TLV_structure()" function
 //
-struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream);
+struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream, uint16_t packet_len);
 
 
 // This is the opposite of "parse_1905_TLV_from_packet()": it receives a
@@ -138,8 +138,11 @@ struct interface
      */
     struct wscDeviceData *device_data;
 
-    /** @brief Neighbour interfaces. */
-    PTRARRAY(struct interface *) neighbors;
+    /** @brief Neighbour interfaces.
+     *
+     * Most interfaces have only a few neighbours, so these are stored inline. The order is not significant.
+     */
+    PTRARRAY_INLINE(struct interface *, 4) neighbors;
 
     /** @brief Operations on the interface.
      *
@@ -180,7 +183,10 @@ struct interfaceWifi {
      */
     struct bssInfo bssInfo;
 
-    /** @brief Radio on which this interface is active. Must not be NULL. */
+    /** @brief Radio on which this interface is active.
+     *
+     * Must not be NULL, except for the clients of an AP (see interfaceWifi::clients), for which it is not known.
+     */
     struct radio *radio;
 
     /** @brief Channel in use
@@ -193,9 +199,9 @@ struct interfaceWifi {
      *
      * Only valid if this is an AP.
      *
-     * These are also included in interface::neighbors.
+     * These are also included in interface::neighbors. The order is not significant.
      */
-    PTRARRAY(struct interfaceWifi *) clients;
+    PTRARRAY_INLINE(struct interfaceWifi *, 4) clients;
 };
 
 /** @brief Wi-Fi radio supported channels.
@@ -270,7 +276,7 @@ struct radio {
      */
     struct {
         uint8_t   m1[1000]; /**< Buffer for constructing the M1 message. */
-        uint8_t   m1_len;   /**< Used length of @a m1. */
+        uint16_t  m1_len;   /**< Used length of @a m1. */
         uint8_t  *nonce;    /**< Pointer into @a m1 to location of the nonce. Length is 16 bytes. */
         uint8_t  *mac;      /**< Pointer into @a m1 to location of the MAC address. */
         uint8_t  *priv_key; /**< Private key, allocated separately. */
@@ -324,6 +330,9 @@ struct alDevice {
 
     bool is_map_agent; /**< @brief true if this device is a Multi-AP Agent. */
     bool is_map_controller; /**< @brief true if this device is a Multi-AP Controller. */
+
+    /** @brief true if this device was restored from a topology snapshot and was not seen on the network since. */
+    bool stale;
 };
 
 /** @brief The local AL device.
@@ -403,6 +412,21 @@ void registrarAddWsc(struct wscRegistrarInfo *wsc);
  */
 extern dlist_head network;
 
+/** @brief Data model change counter.
+ * Incremented every time an object is added to or removed from the data model, or a neighbor link changes. Code that
+ * caches information derived from the data model (e.g. an exported snapshot) compares it with the value it saw last
+ * time to know if it must be refreshed.
+ *
+ * Code that modifies fields of existing objects directly should call datamodelChanged().
+ */
+extern uint32_t datamodel_generation;
+
+/** @brief Mark the data model as changed. */
+static inline void datamodelChanged(void)
+{
+    datamodel_generation++;
+}
+
 
 /** @brief Initialize the data model. Must be called before anything else. */
 void datamodelInit(void);
@@ -446,6 +470,15 @@ struct radio *findDeviceRadio(const struct alDevice *device, const mac_address u
 /** @brief Find the radio with the given name in the local device. */
 struct radio *findLocalRadio(const char *name);
 
+/** @brief Find the radio with the given radio::index in the local device. */
+struct radio *findLocalRadioByIndex(uint32_t index);
+
+/** @brief Find the channel of @a radio that has frequency @a freq, in any band.
+ *
+ * @return a pointer into the radioBand::channels array, or NULL if @a radio doesn't support that frequency.
+ */
+struct radioChannel *radioFindChannel(const struct radio *radio, uint32_t freq);
+
 /** @brief  Add an interface to ::radio
  *  @return 0:success, <0:error
  */
@@ -479,6 +512,24 @@ struct interfaceWifi *interfaceWifiAlloc(const mac_address addr, struct alDevice
 /** @brief Remove a BSS from a radio and delete it. */
 void interfaceWifiRemove(struct interfaceWifi *interfaceWifi);
 
+/** @brief Add the station with address @a addr as a client of the AP @a ap.
+ *
+ * If the station is not known yet, a new interfaceWifi without owner is created for it. Either way, it is also added as
+ * a neighbor of @a ap.
+ *
+ * @return the client, or NULL if @a addr is already known as an interface that is not a Wi-Fi interface (it is still
+ * added as a neighbor in that case).
+ */
+struct interfaceWifi *interfaceWifiAddClient(struct interfaceWifi *ap, const mac_address addr);
+
+/** @brief Remove the station with address @a addr from the clients of the AP @a ap.
+ *
+ * It is also removed as a neighbor, so it may be free'd (see interfaceRemoveNeighbor()).
+ *
+ * @return false if @a addr was not a client of @a ap.
+ */
+bool interfaceWifiRemoveClient(struct interfaceWifi *ap, const mac_address addr);
+
 /** @brief Associate an interface with an alDevice.
  *
  * The interface must not be associated with another device already.
@@ -0,0 +1,237 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef DATAMODEL_SHM_H
+#define DATAMODEL_SHM_H
+
+#include <stdbool.h>
+#include <stddef.h> // size_t
+#include <stdint.h>
+
+/** @file
+ * Shared memory export of the data model.
+ *
+ * The AL entity publishes a binary snapshot of the ::alDevice / ::interface / ::radio graph in a POSIX shared memory
+ * segment, so that local higher layer entities can read the topology without going through the ALME interface.
+ *
+ * The segment starts with a ::datamodelShmHeader, followed by tables of fixed-size records. Objects refer to each other
+ * by their index in the corresponding table; ::DATAMODEL_SHM_NONE means "no object". All values are in host byte
+ * order, since the segment is only accessible to local processes. Security material (e.g. WPA keys) is never
+ * exported.
+ *
+ * Consistency is guaranteed with a sequence lock: the writer increments datamodelShmHeader::sequence before and after
+ * updating the segment, so it is odd while an update is in progress. Readers copy the segment and retry if the
+ * sequence changed in the mean time. The datamodelShmReader functions implement this protocol.
+ *
+ * The segment only grows, so a reader's mapping always remains valid. When the snapshot no longer fits in the
+ * reader's mapping, the reader remaps it.
+ *
+ * The same layout is used by the AL entity to keep its view of the network across restarts (see
+ * topology_snapshot.h).
+ */
+
+/** @brief Name of the shared memory segment, as passed to shm_open(). */
+#define DATAMODEL_SHM_NAME      "/prplmesh_datamodel"
+
+#define DATAMODEL_SHM_MAGIC     (0x504d444d) /**< @brief "PMDM" */
+/** @brief Layout version.
+ * Must be incremented when the meaning of an existing field changes. Adding fields at the end of a record does not
+ * require a new version, since the record size is part of ::datamodelShmTable.
+ */
+#define DATAMODEL_SHM_VERSION   (1)
+
+#define DATAMODEL_SHM_NONE      (0xffffffffU) /**< @brief Index value meaning "no object". */
+#define DATAMODEL_SHM_NAME_SZ   (16)          /**< @brief Size of the (nul-terminated) name fields. */
+
+/** @brief Location of a table of records in the segment. */
+struct datamodelShmTable {
+    uint32_t offset;      /**< Offset of the first record, from the start of the segment. */
+    uint32_t nr;          /**< Number of records. */
+    uint32_t record_size; /**< Size of each record. May be larger than the structure known by the reader. */
+};
+
+/** @brief Header at the start of the shared memory segment. */
+struct datamodelShmHeader {
+    uint32_t magic;         /**< ::DATAMODEL_SHM_MAGIC */
+    uint16_t version;       /**< ::DATAMODEL_SHM_VERSION */
+    uint16_t header_size;   /**< sizeof(struct datamodelShmHeader) of the writer. */
+    uint32_t sequence;      /**< Sequence lock. Odd while the writer updates the segment. */
+    uint32_t generation;    /**< Value of ::datamodel_generation when the snapshot was taken. */
+    uint32_t timestamp;     /**< PLATFORM_GET_TIMESTAMP() when the snapshot was taken. */
+    uint32_t size;          /**< Number of valid bytes in the segment, including this header. */
+
+    uint8_t  local_al_mac[6];   /**< AL MAC address of the local device. */
+    uint8_t  registrar_al_mac[6]; /**< AL MAC address of the registrar/controller, or all zeroes if unknown. */
+
+    struct datamodelShmTable devices;    /**< Table of ::datamodelShmDevice */
+    struct datamodelShmTable interfaces; /**< Table of ::datamodelShmInterface */
+    struct datamodelShmTable links;      /**< Table of ::datamodelShmLink */
+    struct datamodelShmTable radios;     /**< Table of ::datamodelShmRadio */
+};
+
+/** @brief Flags of ::datamodelShmDevice.
+ * @{
+ */
+#define DATAMODEL_SHM_DEVICE_LOCAL           (0x0001) /**< This is ::local_device. */
+#define DATAMODEL_SHM_DEVICE_MAP_AGENT       (0x0002) /**< alDevice::is_map_agent */
+#define DATAMODEL_SHM_DEVICE_MAP_CONTROLLER  (0x0004) /**< alDevice::is_map_controller */
+#define DATAMODEL_SHM_DEVICE_REGISTRAR       (0x0008) /**< This is registrar::d */
+#define DATAMODEL_SHM_DEVICE_STALE           (0x0010) /**< alDevice::stale */
+/** @} */
+
+/** @brief Exported ::alDevice. */
+struct datamodelShmDevice {
+    uint8_t  al_mac_addr[6];
+    uint16_t flags;             /**< Combination of DATAMODEL_SHM_DEVICE_* flags. */
+    uint32_t interfaces_first;  /**< Index of the first interface of this device. Its interfaces are consecutive. */
+    uint32_t interfaces_nr;
+    uint32_t radios_first;      /**< Index of the first radio of this device. Its radios are consecutive. */
+    uint32_t radios_nr;
+};
+
+/** @brief Exported ::interface or ::interfaceWifi. */
+struct datamodelShmInterface {
+    uint8_t  addr[6];
+    uint16_t media_type;
+    char     name[DATAMODEL_SHM_NAME_SZ]; /**< Only set for local interfaces. */
+    uint32_t device;            /**< Index of the owning device, ::DATAMODEL_SHM_NONE for non-1905 neighbors. */
+    uint32_t radio;             /**< Index of the radio for Wi-Fi interfaces, ::DATAMODEL_SHM_NONE otherwise. */
+    uint32_t links_first;       /**< Index of the first link to a neighbor of this interface. Links are consecutive. */
+    uint32_t links_nr;
+    int16_t  type;              /**< ::interfaceType */
+    uint8_t  power_state;       /**< ::interfacePowerState */
+    uint8_t  wifi_role;         /**< ::interfaceWifiRole, only valid if @a type is interface_type_wifi. */
+    uint8_t  media_specific_info[16];
+    uint8_t  media_specific_info_length;
+    uint8_t  ssid_length;       /**< Length of @a ssid, only valid for Wi-Fi interfaces. */
+    uint8_t  bssid[6];          /**< Only valid for Wi-Fi interfaces. */
+    uint8_t  ssid[32];          /**< Only valid for Wi-Fi interfaces. */
+};
+
+/** @brief Exported entry of interface::neighbors. */
+struct datamodelShmLink {
+    uint32_t neighbor;                      /**< Index of the neighbor interface. */
+    uint32_t last_topology_discovery_ts;    /**< Of the neighbor interface. */
+    uint32_t last_bridge_discovery_ts;      /**< Of the neighbor interface. */
+};
+
+/** @brief Exported ::radio. */
+struct datamodelShmRadio {
+    uint8_t  uid[6];
+    uint8_t  conf_ants[2];      /**< radio::confAnts */
+    char     name[DATAMODEL_SHM_NAME_SZ];
+    uint32_t index;
+    uint32_t device;            /**< Index of the owning device. */
+    uint32_t max_ap_stations;
+    uint32_t max_bss;
+    uint8_t  bands;             /**< Bitmask of (1 << radioBand::id) for all supported bands. */
+    uint8_t  monitor;
+    uint16_t configured_bsses_nr;
+};
+
+/** @brief Get a pointer to record @a i of @a table in the snapshot starting at @a header.
+ *
+ * The caller must check that @a i is smaller than datamodelShmTable::nr.
+ */
+static inline const void *datamodelShmRecord(const struct datamodelShmHeader *header,
+                                             const struct datamodelShmTable *table, uint32_t i)
+{
+    return (const uint8_t *)header + table->offset + (size_t)i * table->record_size;
+}
+
+/** @brief Serialization of the data model in this layout.
+ * @{
+ */
+
+/** @brief Serialize the data model.
+ *
+ * @param buffer Buffer to build the snapshot in. It is (re)allocated if it is smaller than the snapshot, so it can be
+ * reused for the next snapshot.
+ * @param buffer_size Allocated size of @a buffer.
+ * @return the size of the snapshot.
+ */
+size_t datamodelSnapshotBuild(uint8_t **buffer, size_t *buffer_size);
+
+/** @brief Recreate the devices of a snapshot that are not in the data model.
+ *
+ * The snapshot is validated first, so it may come from an untrusted source (e.g. a file). Restored devices are marked
+ * alDevice::stale. Devices that already exist are not touched; for the local device, only the links between its
+ * existing interfaces and restored devices are added.
+ *
+ * Band and channel information of the radios is not part of the layout and is therefore not restored.
+ *
+ * @return the number of devices that were created.
+ */
+unsigned datamodelSnapshotRestore(const struct datamodelShmHeader *header, size_t size);
+
+/** @} */
+
+/** @brief Writer side, used by the AL entity.
+ * @{
+ */
+
+/** @brief Create (or re-open) the shared memory segment.
+ *
+ * If a segment of a previous AL instance exists and has a compatible layout, it is reused so that readers that still
+ * map it see the new snapshots.
+ *
+ * @return false if the segment could not be created. The AL can still run without it.
+ */
+bool datamodelShmInit(void);
+
+/** @brief Publish a new snapshot of the data model.
+ *
+ * @param force If false, nothing is done if ::datamodel_generation did not change since the previous snapshot.
+ */
+void datamodelShmPublish(bool force);
+
+/** @} */
+
+/** @brief Reader side, used by local higher layer entities.
+ *
+ * The structure must be initialised to 0 before calling datamodelShmReaderOpen().
+ * @{
+ */
+struct datamodelShmReader {
+    int       fd;
+    void     *map;          /**< Mapping of the segment. */
+    size_t    map_size;
+    uint8_t  *copy;         /**< Private, consistent copy of the latest snapshot. */
+    size_t    copy_size;
+    uint32_t  sequence;     /**< Sequence of the snapshot in @a copy. */
+};
+
+/** @brief Open the shared memory segment published by the AL entity. */
+bool datamodelShmReaderOpen(struct datamodelShmReader *reader);
+
+/** @brief Get a consistent snapshot.
+ *
+ * If the snapshot didn't change since the previous call, the same copy is returned without touching the segment
+ * contents. No system calls are done unless the segment grew beyond the current mapping.
+ *
+ * @return a pointer to the reader's private copy, valid until the next call, or NULL if no consistent and compatible
+ * snapshot could be obtained.
+ */
+const struct datamodelShmHeader *datamodelShmReaderGet(struct datamodelShmReader *reader);
+
+/** @brief Unmap the segment and free the private copy. */
+void datamodelShmReaderClose(struct datamodelShmReader *reader);
+
+/** @} */
+
+#endif // DATAMODEL_SHM_H
@@ -97,8 +97,8 @@ extern mac_address *    asciiToMac(
  * It is advisable to wrap the allocation macros in a type-specific allocation function (which can also initialize the
  * other struct members).
  *
- * A single item (that has not been added to a list and has no children) can be freed with the normal free() function.
- * An entire list, including children, can be freed with hlist_delete(), or a single item with hlist_delete_item().
+ * Items are allocated from the pools of pool_get_sized() (see pool.h), so they must never be freed with free(). An
+ * entire list, including children, can be freed with hlist_delete(), or a single item with hlist_delete_item().
  */
 typedef struct hlist_item {
     dlist_item l;
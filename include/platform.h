@@ -93,6 +93,12 @@ void PLATFORM_PRINTF_DEBUG_SET_VERBOSITY_LEVEL(int level);
 //
 uint32_t PLATFORM_GET_TIMESTAMP(void);
 
+// Return the number of microseconds ellapsed since the program started. It
+// wraps around every 71 minutes, so it is only meant to measure (short)
+// intervals.
+//
+uint32_t PLATFORM_GET_TIMESTAMP_US(void);
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Misc stuff
@@ -0,0 +1,105 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+/** @file
+ *  @brief Fixed-size object pools.
+ *
+ * Objects that are created and deleted all the time (data model objects, TLVs) are not allocated individually on the
+ * heap but taken from a pool. A pool hands out objects of a single size, carved out of slabs (blocks of several
+ * objects) that are never returned to the heap, so that the churn of short-lived objects does not fragment it.
+ *
+ * Deleted objects are kept in a LIFO free list: the next allocation reuses the most recently deleted object, which is
+ * the one most likely to still be in the cache.
+ *
+ * When compiled with @c POOL_DEBUG (see the @c POOL_DEBUG CMake option), deleted objects are filled with
+ * ::POOL_POISON. The poison is checked when the object is reused, so writes to deleted objects are detected, and so
+ * are double deletions.
+ *
+ * Like the data model itself, pools are not thread safe.
+ *
+ * Example:
+ * @code
+    static DEFINE_POOL(foo_pool, struct foo);
+
+    struct foo *f = pool_alloc(&foo_pool);
+    ...
+    pool_free(f);
+ * @endcode
+ */
+
+#include <stdbool.h>
+#include <stddef.h> /* size_t */
+
+/** @brief Value written to deleted objects when compiled with @c POOL_DEBUG. */
+#define POOL_POISON 0x6b
+
+/** @brief Pool statistics. */
+struct pool_stats {
+    size_t live;            /**< Number of objects currently allocated. */
+    size_t peak;            /**< Highest value @a live has ever had. */
+    size_t allocated_bytes; /**< Heap memory taken by the slabs of this pool. */
+};
+
+/** @brief A pool of objects of the same size.
+ *
+ * Only @a name and @a stats are meant to be accessed directly. Define it with DEFINE_POOL().
+ */
+struct pool {
+    const char *name;           /**< Name of the pool, used in statistics. Normally the type of the objects. */
+    size_t size;                /**< Size of the objects. */
+
+    struct pool_stats stats;
+
+    /* Private members */
+    void *free_list;            /**< Deleted objects, most recently deleted first. */
+    struct pool *next;          /**< Next pool in the list of pools that have been used (see pool_for_each()). */
+    bool registered;            /**< Set once the pool has been added to that list. */
+};
+
+/** @brief Initializer for a struct pool. */
+#define POOL_INITIALIZER(pool_name, object_size) { .name = (pool_name), .size = (object_size), }
+
+/** @brief Define a pool for objects of type @a type. May be preceded by the @c static keyword. */
+#define DEFINE_POOL(var, type) struct pool var = POOL_INITIALIZER(#type, sizeof(type))
+
+/** @brief Allocate an object from @a pool.
+ *
+ * @return The new object, initialised to 0. Like memalloc(), this function does not return if there is no memory.
+ */
+void *pool_alloc(struct pool *pool);
+
+/** @brief Return @a object (obtained with pool_alloc()) to its pool.
+ *
+ * The pool is found automatically. Passing NULL is allowed and does nothing.
+ */
+void pool_free(void *object);
+
+/** @brief Get the generic pool for objects of @a size bytes.
+ *
+ * This is used for objects whose type is not known at the allocation site (e.g. hlist items). Sizes are rounded up,
+ * so objects of similar size share a pool. Very big objects get a pool of their own.
+ */
+struct pool *pool_get_sized(size_t size);
+
+/** @brief Call @a callback for each pool that has been used so far, in order of first use. */
+void pool_for_each(void (*callback)(const struct pool *pool, void *ctx), void *ctx);
+
+#endif // POOL_H
@@ -24,12 +24,20 @@
  *
  * This file implements a container implemented as a pointer array.
  *
- * To be type-safe, this functionality is fully defined by macros. The pointer array consists of a length member and
- * a data pointer.
+ * To be type-safe, this functionality is fully defined by macros. The pointer array consists of a length member, a data
+ * pointer and the capacity of the allocated data. The capacity grows geometrically, so adding an element is amortised
+ * O(1) and does not reallocate every time.
+ *
+ * A pointer array declared with PTRARRAY_INLINE() in addition stores its first few elements inside the array structure
+ * itself, so that small arrays don't need any heap allocation at all.
  */
 
 #include "utils.h" /* container_of() */
 #include <stdbool.h>
+#include <string.h> /* memcpy(), memmove() */
+
+/** @brief Capacity of the first heap allocation of a pointer array. */
+#define PTRARRAY_MIN_CAPACITY 4
 
 /** @brief Declare an array of @a type.
  *
@@ -52,13 +60,54 @@
  *
  * Note that @a type may be any type (it must be a scalar type because other macros use assignment and comparison on
  * it). Normally it is a pointer type (hence the name pointer array).
+ *
+ * An empty pointer array never holds any memory: removing the last element releases it.
+ */
+#define PTRARRAY(type) PTRARRAY_INLINE(type, 0)
+
+/** @brief Declare an array of @a type that stores up to @a inline_count elements without heap allocation.
+ *
+ * This is used exactly like PTRARRAY(). While the array has at most @a inline_count elements, data points into the
+ * array structure itself. Therefore, such an array must not be copied (e.g. passed by value or copied with memcpy)
+ * while it is not empty.
  */
-#define PTRARRAY(type) \
+#define PTRARRAY_INLINE(type, inline_count) \
     struct { \
         unsigned length; \
         type *data; \
+        unsigned capacity; \
+        type inline_data[inline_count]; \
     }
 
+/** @brief Make sure @a ptrarray has room for at least @a count elements. */
+#define PTRARRAY_RESERVE(ptrarray, count) \
+    do { \
+        unsigned ptrarray_reserve_count = (count); \
+        unsigned ptrarray_reserve_capacity; \
+        if (ptrarray_reserve_count <= (ptrarray).capacity) \
+            break; \
+        if ((ptrarray).data == NULL && ptrarray_reserve_count <= ARRAY_SIZE((ptrarray).inline_data)) \
+        { \
+            (ptrarray).data = (ptrarray).inline_data; \
+            (ptrarray).capacity = ARRAY_SIZE((ptrarray).inline_data); \
+            break; \
+        } \
+        ptrarray_reserve_capacity = (ptrarray).capacity < PTRARRAY_MIN_CAPACITY ? \
+                                    PTRARRAY_MIN_CAPACITY : (ptrarray).capacity * 2; \
+        if (ptrarray_reserve_capacity < ptrarray_reserve_count) \
+            ptrarray_reserve_capacity = ptrarray_reserve_count; \
+        if ((ptrarray).data == (ptrarray).inline_data) \
+        { \
+            (ptrarray).data = memalloc(ptrarray_reserve_capacity * sizeof(*(ptrarray).data)); \
+            memcpy((ptrarray).data, (ptrarray).inline_data, (ptrarray).length * sizeof(*(ptrarray).data)); \
+        } \
+        else \
+        { \
+            (ptrarray).data = memrealloc((ptrarray).data, ptrarray_reserve_capacity * sizeof(*(ptrarray).data)); \
+        } \
+        (ptrarray).capacity = ptrarray_reserve_capacity; \
+    } while (0)
+
 /** @brief Add an element to a pointer array.
  *
  * The element is always added at the end.
@@ -68,7 +117,7 @@
  */
 #define PTRARRAY_ADD(ptrarray, item) \
     do { \
-        (ptrarray).data = memrealloc((ptrarray).data, ((ptrarray).length + 1) * sizeof(*(ptrarray).data)); \
+        PTRARRAY_RESERVE(ptrarray, (ptrarray).length + 1); \
         (ptrarray).data[(ptrarray).length] = item; \
         (ptrarray).length++; \
     } while (0)
@@ -87,38 +136,66 @@
         ptrarray_find_i; \
     })
 
+/** @brief Release the memory of @a ptrarray if it is empty. Internal helper. */
+#define PTRARRAY_RELEASE_IF_EMPTY(ptrarray) \
+    do { \
+        if ((ptrarray).length > 0) \
+            break; \
+        if ((ptrarray).data != (ptrarray).inline_data) \
+            free((ptrarray).data); \
+        (ptrarray).data = NULL; \
+        (ptrarray).capacity = 0; \
+    } while (0)
+
 /** @brief Remove an item at a certain index from a pointer array.
+ *
+ * The order of the remaining elements is preserved. If the order doesn't matter, PTRARRAY_REMOVE_UNORDERED() is
+ * cheaper.
  *
  * For convenience when used in combination with PTRARRAY_FIND, if @a index is equal to the length of the array, nothing
  * is removed.
  */
 #define PTRARRAY_REMOVE(ptrarray, index) \
     do { \
-        if (index >= (ptrarray).length) \
+        unsigned ptrarray_remove_index = (index); \
+        if (ptrarray_remove_index >= (ptrarray).length) \
             break; \
         (ptrarray).length--; \
-        if ((ptrarray).length > 0) \
-        { \
-            memmove((ptrarray).data + index, (ptrarray).data + (index) + 1, \
-                    ((ptrarray).length - (index)) * sizeof(*(ptrarray).data)); \
-            (ptrarray).data = memrealloc((ptrarray).data, ((ptrarray).length) * sizeof(*(ptrarray).data)); \
-        } else { \
-            free((ptrarray).data); \
-            (ptrarray).data = NULL; \
-        } \
+        memmove((ptrarray).data + ptrarray_remove_index, (ptrarray).data + ptrarray_remove_index + 1, \
+                ((ptrarray).length - ptrarray_remove_index) * sizeof(*(ptrarray).data)); \
+        PTRARRAY_RELEASE_IF_EMPTY(ptrarray); \
+    } while (0)
+
+/** @brief Remove an item at a certain index from a pointer array, in O(1).
+ *
+ * The last element takes the place of the removed one, so the order of the elements is not preserved.
+ *
+ * Like for PTRARRAY_REMOVE(), if @a index is equal to the length of the array, nothing is removed.
+ */
+#define PTRARRAY_REMOVE_UNORDERED(ptrarray, index) \
+    do { \
+        unsigned ptrarray_remove_index = (index); \
+        if (ptrarray_remove_index >= (ptrarray).length) \
+            break; \
+        (ptrarray).length--; \
+        (ptrarray).data[ptrarray_remove_index] = (ptrarray).data[(ptrarray).length]; \
+        PTRARRAY_RELEASE_IF_EMPTY(ptrarray); \
     } while (0)
 
 /** @brief Remove an item from a pointer array. */
 #define PTRARRAY_REMOVE_ELEMENT(ptrarray, item) \
     PTRARRAY_REMOVE(ptrarray, PTRARRAY_FIND(ptrarray, item))
 
+/** @brief Remove an item from a pointer array, without preserving the order of the other elements. */
+#define PTRARRAY_REMOVE_ELEMENT_UNORDERED(ptrarray, item) \
+    PTRARRAY_REMOVE_UNORDERED(ptrarray, PTRARRAY_FIND(ptrarray, item))
+
 
 /** @brief Remove all elements from the pointer array. */
 #define PTRARRAY_CLEAR(ptrarray) \
     do { \
-        free((ptrarray).data); \
-        (ptrarray).data = NULL; \
         (ptrarray).length = 0; \
+        PTRARRAY_RELEASE_IF_EMPTY(ptrarray); \
     } while(0)
 
 #endif // PTRARRAY_H
@@ -417,6 +417,18 @@ struct tlv_def
         __VA_ARGS__ \
     )
 
+#define TLV_DEF_ENTRY_4FIELDS(tlv_name, tlv_type, child, field1, fmt1, field2, fmt2, field3, fmt3, field4, fmt4, ...) \
+    TLV_DEF_ENTRY_INTERNAL(tlv_name, tlv_type, child, \
+        .fields = { \
+            TLV_STRUCT_FIELD_DESCRIPTION(struct tlv_name##TLV, field1, fmt1), \
+            TLV_STRUCT_FIELD_DESCRIPTION(struct tlv_name##TLV, field2, fmt2), \
+            TLV_STRUCT_FIELD_DESCRIPTION(struct tlv_name##TLV, field3, fmt3), \
+            TLV_STRUCT_FIELD_DESCRIPTION(struct tlv_name##TLV, field4, fmt4), \
+            TLV_STRUCT_FIELD_SENTINEL, \
+        }, \
+        __VA_ARGS__ \
+    )
+
 /** @} */
 
 /** @brief Definition of TLV metadata.
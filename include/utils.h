@@ -53,6 +53,13 @@
     ((type *)((char *)check_compatible_types(ptr, &((type*)ptr)->member) - offsetof(type, member)))
 
 
+/** @brief Number of allocations done so far with memalloc(), memrealloc() and pool_alloc().
+ *
+ * Used to count the allocations done while processing each message (see al_cmdu_stats.h). It is not atomic, so
+ * allocations done at the same time by other threads may be missed.
+ */
+extern unsigned long memalloc_count;
+
 /** @ brief Allocate a chunk of 'n' bytes and return a pointer to it.
  *
  * If no memory can be allocated, this function exits immediately.
@@ -61,6 +68,7 @@ static inline void *memalloc(size_t size)
 {
     void *p;
 
+    memalloc_count++;
     p = malloc(size);
 
     if (NULL == p)
@@ -84,6 +92,7 @@ static inline void *memrealloc(void *ptr, size_t size)
 {
     void *p;
 
+    memalloc_count++;
     p = realloc(ptr, size);
 
     if (NULL == p)
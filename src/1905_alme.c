@@ -316,7 +316,7 @@
 // Actual API functions
 ////////////////////////////////////////////////////////////////////////////////
 
-uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream)
+uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream, uint16_t packet_len)
 {
     if (NULL == packet_stream)
     {
@@ -701,11 +701,20 @@ uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream)
                     uint8_t  aux1;
                     uint16_t aux2;
 
+                    if ((size_t)(p - packet_stream) + 13 > packet_len)
+                    {
+                        // Truncated packet
+                        //
+                        free(ret->metrics);
+                        free(ret);
+                        return NULL;
+                    }
+
                     _EnB(&p,  ret->metrics[i].neighbor_dev_address, 6);
                     _EnB(&p,  ret->metrics[i].local_intf_address,   6);
                     _E1B(&p, &ret->metrics[i].bridge_flag);
 
-                    tx = (struct transmitterLinkMetricTLV *)parse_1905_TLV_from_packet(p);
+                    tx = (struct transmitterLinkMetricTLV *)parse_1905_TLV_from_packet(p, packet_len - (uint16_t)(p - packet_stream));
 
                     if (
                                          NULL                                                     ==  tx                                       ||
@@ -730,7 +739,7 @@ uint8_t *parse_1905_ALME_from_packet(const uint8_t *packet_stream)
                     _E2B(&p, &aux2);
                     p += aux2;
 
-                    rx = (struct receiverLinkMetricTLV *)parse_1905_TLV_from_packet(p);
+                    rx = (struct receiverLinkMetricTLV *)parse_1905_TLV_from_packet(p, packet_len - (uint16_t)(p - packet_stream));
 
                     if (
                                          NULL                                                     ==  rx                                       ||
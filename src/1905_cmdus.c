@@ -248,77 +248,52 @@ static uint8_t _relayed_CMDU[] = \
 //      c) It shall ignore the entire message if the message does not include
 //         all of the TLVs that are listed for this message
 //
-// This function receives a pointer to a CMDU structure, 'p' and a 'rules_type'
+// Only the number of times each type of TLV appears matters for these rules,
+// so this function receives 'counter' (indexed by TLV type) and a 'rules_type'
 // value:
 //
 //   * If 'rules_type' == CHECK_CMDU_TX_RULES, the function will check the
-//     structure against the "generating a CMDU" rules (ie. rules 1.a, 1.b and
+//     counters against the "generating a CMDU" rules (ie. rules 1.a, 1.b and
 //     1.c).
-//     If any of them is broken this function returns "0" (and 'p' is *not*
-//     freed, as this is the caller's responsability)
 //
 //   * If 'rules_type' == CHECK_CMDU_RX_RULES, the function will check the
-//     structure against the "receiving a CMDU" rules (ie. rules 2.a, 2.b and
+//     counters against the "receiving a CMDU" rules (ie. rules 2.a, 2.b and
 //     2.c)
-//     Regarding rule 2.a, we have chosen to preserve vendor specific TLVs in
-//     the structure.
+//     Regarding rule 2.a, we have chosen to preserve vendor specific TLVs.
 //     Rule 2.b is special in that non-vendor specific TLVs that are not
-//     specified for the message type are removed (ie. the 'p' structure is
-//     modified!)
-//     Rule 2.c is special in that if it is broken, 'p' is freed
+//     specified for the message type are flagged in 'tlvs_to_remove' (also
+//     indexed by TLV type) so that the caller removes them.
 //
 //  Note a small asymmetry: with 'rules_type' == CHECK_CMDU_TX_RULES,
 //  unexpected options cause the function to fail while with 'rules_type' ==
-//  CHECK_CMDU_RX_RULES they are simply removed (and freed) from the structure.
+//  CHECK_CMDU_RX_RULES they are simply flagged for removal.
 //  If you think about it, this is the correct behaviour: in transmission,
 //  do not let invalid packets to be generated, while in reception, if invalid
 //  packets are receive, ignore the unexpected pieces but process the rest.
 //
 //  In both cases, this function returns:
-//    '0' --> If 'p' did not respect the rules and could not be "fixed"
-//    '1' --> If 'p' was modified (ie. it is now valid). This can only happen
-//            when 'rules_type' == CHECK_CMDU_RX_RULES
-//    '2' --> If 'p' was not modifed (ie. it was valid from the beginning)
+//    '0' --> If the rules are broken and cannot be "fixed"
+//    '1' --> Otherwise
 //
 #define CHECK_CMDU_TX_RULES (1)
 #define CHECK_CMDU_RX_RULES (2)
-static uint8_t _check_CMDU_rules(const struct CMDU *p, uint8_t rules_type)
+
+static uint8_t _check_CMDU_counters(uint16_t message_type, uint16_t message_id, const uint16_t *counter,
+                                    uint8_t rules_type, uint8_t *tlvs_to_remove)
 {
     unsigned  i;
-    uint8_t  structure_has_been_modified;
-    uint8_t  counter[TLV_TYPE_NUM];
-    uint8_t  tlvs_to_remove[TLV_TYPE_NUM];
 
-    if ((NULL == p) || (NULL == p->list_of_TLVs))
-    {
-        // Invalid arguments
-        //
-        PLATFORM_PRINTF_DEBUG_ERROR("Invalid CMDU structure\n");
-        return 0;
-    }
-
-    // First of all, count how many times each type of TLV message appears in
-    // the structure. We will use this information later
-    //
     for (i=0; i<TLV_TYPE_NUM; i++)
     {
-        counter[i]        = 0;
         tlvs_to_remove[i] = 0;
     }
 
-    i = 0;
-    while (NULL != p->list_of_TLVs[i])
-    {
-        counter[p->list_of_TLVs[i]->type]++;
-        i++;
-    }
-
     for (i=0; i<TLV_TYPE_NUM; i++)
     {
         enum count_required required_count = count_required_zero;
 
         // Search the required count
-        if (p->message_id == CMDU_TYPE_VENDOR_SPECIFIC)
+        if (message_id == CMDU_TYPE_VENDOR_SPECIFIC)
         {
             // Special case for vendor specific CMDU: it can contain any TLV
             required_count = count_required_zero_or_more;
@@ -328,7 +303,7 @@ static uint8_t _check_CMDU_rules(const struct CMDU *p, uint8_t rules_type)
             // Special case for vendor specific TLV: it is always allowed
             required_count = count_required_zero_or_more;
         }
-        else if (cmdu_info[p->message_type].tlv_count_required == NULL)
+        else if (cmdu_info[message_type].tlv_count_required == NULL)
         {
             // No required counts specified for this CMDU, so required count is 0 for all TLVs
             required_count = count_required_zero;
@@ -336,7 +311,7 @@ static uint8_t _check_CMDU_rules(const struct CMDU *p, uint8_t rules_type)
         else
         {
             const struct cmdu_tlv_count_required *count_required;
-            for (count_required = cmdu_info[p->message_type].tlv_count_required;
+            for (count_required = cmdu_info[message_type].tlv_count_required;
                  count_required->count != count_required_sentinel;
                  count_required++)
             {
@@ -417,64 +392,43 @@ static uint8_t _check_CMDU_rules(const struct CMDU *p, uint8_t rules_type)
         }
     }
 
-    i = 0;
-    structure_has_been_modified = 0;
-    while (NULL != p->list_of_TLVs[i])
-    {
-        // Here we will just traverse the list of TLVs and remove the ones
-        // that shouldn't be there.
-        // When this happens, mark the structure as 'modified' so that we can
-        // later return the appropriate return code.
-        //
-        //   NOTE:
-        //     When removing TLVs they are first freed and the list of
-        //     pointers ('list_of_TLVs') is simply overwritten.
-        //     The original piece of memory that holds all pointers is not
-        //     redimensioned, though, as it would make things unnecessary more
-        //     complex.
-        //     In other words:
-        //
-        //       Before removal:
-        //         list_of_TLVs --> [p1, p2, p3, NULL]
-        //
-        //       After removing p2:
-        //         list_of_TLVs --> [p1, p3, NULL, NULL]
-        //
-        //       ...and not:
-        //         list_of_TLVs --> [p1, p3, NULL]
-        //
-        if (1 == tlvs_to_remove[p->list_of_TLVs[i]->type])
-        {
-            uint8_t j;
+    return 1;
+}
 
-            free_1905_TLV_structure(p->list_of_TLVs[i]);
+// Check the CMDU structure 'p' that is about to be forged against the
+// "generating a CMDU" rules.
+//
+// Returns '0' if any of them is broken, '1' otherwise.
+//
+static uint8_t _check_CMDU_rules(const struct CMDU *p)
+{
+    uint16_t  counter[TLV_TYPE_NUM];
+    uint8_t   tlvs_to_remove[TLV_TYPE_NUM];
+    unsigned  i;
 
-            structure_has_been_modified = 1;
-            j = i + 1;
-            while (p->list_of_TLVs[j])
-            {
-                p->list_of_TLVs[j-1] = p->list_of_TLVs[j];
-                j++;
-            }
-            p->list_of_TLVs[j-1] = p->list_of_TLVs[j];
-        }
-        else
-        {
-           i++;
-        }
+    if ((NULL == p) || (NULL == p->list_of_TLVs))
+    {
+        // Invalid arguments
+        //
+        PLATFORM_PRINTF_DEBUG_ERROR("Invalid CMDU structure\n");
+        return 0;
     }
 
-    // Regarding rules 1.c and 2.a, we don't really have to do anything special,
-    // thus we can return now
+    // Count how many times each type of TLV appears in the structure. If the
+    // structure is indexed, that is already known.
     //
-    if (1 == structure_has_been_modified)
+    if (NULL != p->tlv_index)
     {
-        return 1;
+        return _check_CMDU_counters(p->message_type, p->message_id, p->tlv_index->count, CHECK_CMDU_TX_RULES, tlvs_to_remove);
     }
-    else
+
+    memset(counter, 0, sizeof(counter));
+    for (i = 0; NULL != p->list_of_TLVs[i]; i++)
     {
-        return 2;
+        counter[p->list_of_TLVs[i]->type]++;
     }
+
+    return _check_CMDU_counters(p->message_type, p->message_id, counter, CHECK_CMDU_TX_RULES, tlvs_to_remove);
 }
 
 
@@ -483,14 +437,14 @@ static uint8_t _check_CMDU_rules(const struct CMDU *p, uint8_t rules_type)
 // Actual API functions
 ////////////////////////////////////////////////////////////////////////////////
 
-struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
+struct CMDU_view *parse_1905_CMDU_view_from_packets(uint8_t **packet_streams)
 {
-    struct CMDU *ret;
+    struct CMDU_view *ret;
 
     uint8_t  fragments_nr;
     uint8_t  current_fragment;
 
-    uint8_t  tlvs_nr;
+    uint16_t tlvs_size;
 
     uint8_t  error;
 
@@ -518,13 +472,14 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
     }
 
     // Allocate the return structure.
-    // Initially it will contain an empty list of TLVs that we will later
-    // re-allocate and fill.
+    // The payload can never be bigger than the fragments it comes from, so it
+    // is allocated once and for all. The list of TLVs starts small and grows
+    // (doubling its size) as needed.
     //
-    ret = (struct CMDU *)memalloc(sizeof(struct CMDU) * 1);
-    ret->list_of_TLVs = (struct tlv **)memalloc(sizeof(struct tlv *) * 1);
-    ret->list_of_TLVs[0] = NULL;
-    tlvs_nr = 0;
+    ret = (struct CMDU_view *)zmemalloc(sizeof(struct CMDU_view));
+    ret->payload = (uint8_t *)memalloc(fragments_nr * MAX_NETWORK_SEGMENT_SIZE);
+    tlvs_size    = 8;
+    ret->tlvs    = (struct CMDU_view_TLV *)memalloc(sizeof(struct CMDU_view_TLV) * tlvs_size);
 
     // Next, parse each fragment
     //
@@ -532,6 +487,7 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
     for (current_fragment = 0; current_fragment<fragments_nr; current_fragment++)
     {
         const uint8_t *p;
+        const uint8_t *tlvs_start;
         uint8_t i;
 
         uint8_t   message_version;
@@ -544,8 +500,6 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
         uint8_t   relay_indicator;
         uint8_t   last_fragment_indicator;
 
-        struct tlv *parsed;
-
         // We want to traverse fragments in order, thus lets search for the
         // fragment whose 'fragment_id' matches 'current_fragment' (which will
         // monotonically increase starting at '0')
@@ -654,68 +608,60 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
             break;
         }
 
-        // We can now parse the TLVs. 'p' is pointing to the first one at this
-        // moment
+        // We can now go through the TLVs. 'p' is pointing to the first one at
+        // this moment.
+        // Only their type and length are looked at: they are copied as they
+        // are to the payload and decoded later, if someone asks for them.
         //
+        tlvs_start = p;
         while (1)
         {
-            parsed = parse_1905_TLV_from_packet(p);
-            if (NULL == parsed)
-            {
-                // Error while parsing a TLV
-                // Dump TLV for visual inspection
-
-                const uint8_t *p2 = p;
-                uint16_t len;
-                uint8_t  aux;
-
-                _E1B(&p2, &aux);
-                _E2B(&p2, &len);
+            uint8_t  tlv_type;
+            uint16_t tlv_len;
 
-                PLATFORM_PRINTF_DEBUG_WARNING("Parsing error TLV type %u. Dumping bytes: \n", aux);
+            _E1B(&p, &tlv_type);
+            _E2B(&p, &tlv_len);
 
-                // Limit dump length
+            if (TLV_TYPE_END_OF_MESSAGE == tlv_type)
+            {
+                // No more TLVs
                 //
-                if (len > 200)
-                {
-                    len = 200;
-                }
-
-                print_callback(PLATFORM_PRINTF_DEBUG_WARNING, "", len, "Payload", "%02x", p2);
-                error = 6;
+                p -= 3;
                 break;
             }
 
-            if (TLV_TYPE_END_OF_MESSAGE == parsed->type)
+            if ((size_t)(p - tlvs_start) + tlv_len > MAX_NETWORK_SEGMENT_SIZE)
             {
-                // No more TLVs
+                // No fragment can be this long: either a length is wrong or
+                // the "end of message" TLV is missing.
                 //
-                free_1905_TLV_structure(parsed);
+                PLATFORM_PRINTF_DEBUG_WARNING("Parsing error TLV type %u: length %u goes past the end of the fragment\n",
+                                              tlv_type, tlv_len);
+                error = 6;
                 break;
             }
 
+            if (ret->tlvs_nr == tlvs_size)
+            {
+                tlvs_size *= 2;
+                ret->tlvs  = (struct CMDU_view_TLV *)memrealloc(ret->tlvs, sizeof(struct CMDU_view_TLV) * tlvs_size);
+            }
+            ret->tlvs[ret->tlvs_nr].offset = ret->payload_len + (uint32_t)(p - 3 - tlvs_start);
+            ret->tlvs[ret->tlvs_nr].length = tlv_len;
+            ret->tlvs[ret->tlvs_nr].type   = tlv_type;
+            ret->tlvs_nr++;
+
             // Advance 'p' to the next TLV.
             //
-            uint8_t  tlv_type;
-            uint16_t tlv_len;
-
-            _E1B(&p, &tlv_type);
-            _E2B(&p, &tlv_len);
-
             p += tlv_len;
-
-            // Add this new TLV to the list (the list needs to be re-allocated
-            // with more space first)
-            //
-            tlvs_nr++;
-            ret->list_of_TLVs = (struct tlv **)memrealloc(ret->list_of_TLVs, sizeof(struct tlv *) * (tlvs_nr+1));
-            ret->list_of_TLVs[tlvs_nr-1] = parsed;
-            ret->list_of_TLVs[tlvs_nr]   = NULL;
         }
         if (0 != error)
         {
             break;
         }
+
+        memcpy(ret->payload + ret->payload_len, tlvs_start, p - tlvs_start);
+        ret->payload_len += p - tlvs_start;
     }
 
     if (0 == error)
@@ -729,72 +675,65 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
         //   - All the other message types: Some TLVs (different for each of
         //     them) can only appear once, others can appear zero or more times
         //     and others must be ignored.
-        //     The '_check_CMDU_rules()' takes care of this for us.
+        //     The '_check_CMDU_counters()' takes care of this for us.
         //
         PLATFORM_PRINTF_DEBUG_DETAIL("CMDU type: %s\n", convert_1905_CMDU_type_to_string(ret->message_type));
 
         if (CMDU_TYPE_VENDOR_SPECIFIC == ret->message_type)
         {
-            if (NULL == ret->list_of_TLVs || NULL == ret->list_of_TLVs[0] || TLV_TYPE_VENDOR_SPECIFIC != ret->list_of_TLVs[0]->type)
+            if (0 == ret->tlvs_nr || TLV_TYPE_VENDOR_SPECIFIC != ret->tlvs[0].type)
             {
                 error = 7;
             }
         }
         else
         {
+            uint16_t counter[TLV_TYPE_NUM];
+            uint8_t  tlvs_to_remove[TLV_TYPE_NUM];
+            uint16_t i, j;
 
-            switch (_check_CMDU_rules(ret, CHECK_CMDU_RX_RULES))
+            memset(counter, 0, sizeof(counter));
+            for (i=0; i<ret->tlvs_nr; i++)
             {
-                case 0:
-                {
-                    // The structure was missing some required TLVs. This is
-                    // a malformed packet which must be ignored.
-                    //
-                    PLATFORM_PRINTF_DEBUG_WARNING("Structure is missing some required TLVs\n");
-                    PLATFORM_PRINTF_DEBUG_WARNING("List of present TLVs:\n");
+                counter[ret->tlvs[i].type]++;
+            }
 
-                    if (NULL != ret->list_of_TLVs)
-                    {
-                        uint8_t i;
-
-                        i = 0;
-                        while (ret->list_of_TLVs[i])
-                        {
-                            PLATFORM_PRINTF_DEBUG_WARNING("  - %s\n", convert_1905_TLV_type_to_string(ret->list_of_TLVs[i]->type));
-                            i++;
-                        }
-                        PLATFORM_PRINTF_DEBUG_WARNING("  - <END>\n");
-                    }
-                    else
+            if (0 == _check_CMDU_counters(ret->message_type, ret->message_id, counter, CHECK_CMDU_RX_RULES, tlvs_to_remove))
+            {
+                // The view was missing some required TLVs. This is a
+                // malformed packet which must be ignored.
+                //
+                PLATFORM_PRINTF_DEBUG_WARNING("Structure is missing some required TLVs\n");
+                PLATFORM_PRINTF_DEBUG_WARNING("List of present TLVs:\n");
+
+                if (0 != ret->tlvs_nr)
+                {
+                    for (i=0; i<ret->tlvs_nr; i++)
                     {
-                        PLATFORM_PRINTF_DEBUG_WARNING("  - <NONE>\n");
+                        PLATFORM_PRINTF_DEBUG_WARNING("  - %s\n", convert_1905_TLV_type_to_string(ret->tlvs[i].type));
                     }
-
-                    free_1905_CMDU_structure(ret);
-                    return NULL;
+                    PLATFORM_PRINTF_DEBUG_WARNING("  - <END>\n");
                 }
-                case 1:
+                else
                 {
-                    // The structure contained unxecpected TLVs. They have been
-                    // removed for us.
-                    //
-                    break;
+                    PLATFORM_PRINTF_DEBUG_WARNING("  - <NONE>\n");
                 }
-                case 2:
-                {
-                    // The structure was perfect and '_check_CMDU_rules()' did
-                    // not need to modify anything.
-                    //
-                    break;
-                }
-                default:
+
+                free_1905_CMDU_view(ret);
+                return NULL;
+            }
+
+            // Unexpected TLVs are dropped from the list (their bytes are simply
+            // left unused in the payload)
+            //
+            for (i=0, j=0; i<ret->tlvs_nr; i++)
+            {
+                if (0 == tlvs_to_remove[ret->tlvs[i].type])
                 {
-                    // This point should never be reached
-                    //
-                    error = 8;
-                    break;
+                    ret->tlvs[j++] = ret->tlvs[i];
                 }
             }
+            ret->tlvs_nr = j;
         }
     }
 
@@ -804,10 +743,165 @@ struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
     if (0 != error)
     {
         PLATFORM_PRINTF_DEBUG_WARNING("Parsing error %d\n", error);
-        free_1905_CMDU_structure(ret);
+        free_1905_CMDU_view(ret);
+        return NULL;
+    }
+
+    // Chain together the TLVs of each type. Going backwards, each TLV is
+    // prepended to its chain, which leaves them in the order they were
+    // received.
+    //
+    {
+        uint16_t i;
+
+        for (i=0; i<TLV_TYPE_NUM; i++)
+        {
+            ret->first[i] = CMDU_VIEW_NO_TLV;
+        }
+        for (i=ret->tlvs_nr; i>0; i--)
+        {
+            ret->tlvs[i-1].next              = ret->first[ret->tlvs[i-1].type];
+            ret->first[ret->tlvs[i-1].type]  = i-1;
+        }
+    }
+
+    return ret;
+}
+
+uint16_t count_1905_CMDU_view_TLVs(const struct CMDU_view *view, uint8_t tlv_type)
+{
+    uint16_t i;
+    uint16_t n;
+
+    n = 0;
+    for (i = view->first[tlv_type]; CMDU_VIEW_NO_TLV != i; i = view->tlvs[i].next)
+    {
+        n++;
+    }
+
+    return n;
+}
+
+// Return the entry of the 'n'-th TLV of type 'tlv_type' in 'view', or NULL
+//
+static const struct CMDU_view_TLV *_find_CMDU_view_TLV(const struct CMDU_view *view, uint8_t tlv_type, uint16_t n)
+{
+    uint16_t i;
+
+    for (i = view->first[tlv_type]; CMDU_VIEW_NO_TLV != i; i = view->tlvs[i].next)
+    {
+        if (0 == n--)
+        {
+            return &view->tlvs[i];
+        }
+    }
+
+    return NULL;
+}
+
+const uint8_t *get_1905_CMDU_view_TLV(const struct CMDU_view *view, uint8_t tlv_type, uint16_t n, uint16_t *length)
+{
+    const struct CMDU_view_TLV *t;
+
+    if (NULL == (t = _find_CMDU_view_TLV(view, tlv_type, n)))
+    {
+        return NULL;
+    }
+
+    *length = t->length;
+    return view->payload + t->offset + 3;
+}
+
+// Decode a single TLV entry of 'view', dumping its contents if it is malformed
+//
+static struct tlv *_decode_CMDU_view_TLV(const struct CMDU_view *view, const struct CMDU_view_TLV *t)
+{
+    struct tlv *parsed;
+    uint32_t    remaining;
+
+    // TLVs of several fragments are concatenated in the payload, so what is
+    // left of it can be longer than any single TLV
+    //
+    remaining = view->payload_len - t->offset;
+    if (remaining > 0xffff)
+    {
+        remaining = 0xffff;
+    }
+
+    parsed = parse_1905_TLV_from_packet(view->payload + t->offset, (uint16_t)remaining);
+    if (NULL == parsed)
+    {
+        // Error while parsing a TLV
+        // Dump TLV for visual inspection
+        //
+        PLATFORM_PRINTF_DEBUG_WARNING("Parsing error TLV type %u. Dumping bytes: \n", t->type);
+
+        // Limit dump length
+        //
+        print_callback(PLATFORM_PRINTF_DEBUG_WARNING, "", t->length > 200 ? 200 : t->length, "Payload", "%02x",
+                       view->payload + t->offset + 3);
+    }
+
+    return parsed;
+}
+
+struct tlv *decode_1905_CMDU_view_TLV(const struct CMDU_view *view, uint8_t tlv_type, uint16_t n)
+{
+    const struct CMDU_view_TLV *t;
+
+    if (NULL == (t = _find_CMDU_view_TLV(view, tlv_type, n)))
+    {
+        return NULL;
+    }
+
+    return _decode_CMDU_view_TLV(view, t);
+}
+
+struct CMDU *convert_1905_CMDU_view_to_structure(const struct CMDU_view *view)
+{
+    struct CMDU *ret;
+    uint16_t     i;
+
+    ret = (struct CMDU *)zmemalloc(sizeof(struct CMDU));
+    ret->message_version = view->message_version;
+    ret->message_type    = view->message_type;
+    ret->message_id      = view->message_id;
+    ret->relay_indicator = view->relay_indicator;
+
+    ret->list_of_TLVs = (struct tlv **)memalloc(sizeof(struct tlv *) * (view->tlvs_nr + 1));
+    for (i=0; i<view->tlvs_nr; i++)
+    {
+        ret->list_of_TLVs[i] = _decode_CMDU_view_TLV(view, &view->tlvs[i]);
+        if (NULL == ret->list_of_TLVs[i])
+        {
+            free_1905_CMDU_structure(ret);
+            return NULL;
+        }
+    }
+    ret->list_of_TLVs[view->tlvs_nr] = NULL;
+
+    index_1905_CMDU_TLVs(ret);
+
+    return ret;
+}
+
+struct CMDU *parse_1905_CMDU_from_packets(uint8_t **packet_streams)
+{
+    struct CMDU_view *view;
+    struct CMDU      *ret;
+
+    // Parse the headers and check which TLVs are there first, so that TLVs
+    // that are going to be ignored anyway are never decoded.
+    //
+    view = parse_1905_CMDU_view_from_packets(packet_streams);
+    if (NULL == view)
+    {
         return NULL;
     }
 
+    ret = convert_1905_CMDU_view_to_structure(view);
+    free_1905_CMDU_view(view);
+
     return ret;
 }
 
@@ -842,7 +936,7 @@ uint8_t **forge_1905_CMDU_from_structure(const struct CMDU *memory_structure, ui
 
     // Before anything else, let's check that the CMDU 'rules' are satisfied:
     //
-    if (0 == _check_CMDU_rules(memory_structure, CHECK_CMDU_TX_RULES))
+    if (0 == _check_CMDU_rules(memory_structure))
     {
         // Invalid arguments
         //
@@ -1101,11 +1195,121 @@ void free_1905_CMDU_structure(struct CMDU *memory_structure)
         free(memory_structure->list_of_TLVs);
     }
 
+    if (NULL != memory_structure)
+    {
+        free(memory_structure->tlv_index);
+    }
+
     free(memory_structure);
 
     return;
 }
 
+void free_1905_CMDU_view(struct CMDU_view *view)
+{
+    if (NULL != view)
+    {
+        free(view->payload);
+        free(view->tlvs);
+    }
+    free(view);
+}
+
+
+void index_1905_CMDU_TLVs(struct CMDU *memory_structure)
+{
+    struct CMDU_TLV_index *index;
+    uint16_t               next[TLV_TYPE_NUM];
+    uint16_t               tlvs_nr;
+    uint16_t               i;
+    uint16_t               position;
+
+    free(memory_structure->tlv_index);
+    memory_structure->tlv_index = NULL;
+
+    if (NULL == memory_structure->list_of_TLVs)
+    {
+        return;
+    }
+
+    tlvs_nr = 0;
+    while (NULL != memory_structure->list_of_TLVs[tlvs_nr])
+    {
+        tlvs_nr++;
+    }
+
+    index = (struct CMDU_TLV_index *)zmemalloc(sizeof(struct CMDU_TLV_index) + sizeof(uint16_t) * tlvs_nr);
+
+    for (i = 0; i < tlvs_nr; i++)
+    {
+        index->count[memory_structure->list_of_TLVs[i]->type]++;
+    }
+
+    // Each type gets as many consecutive positions in 'order' as TLVs of that
+    // type there are
+    //
+    position = 0;
+    for (i = 0; i < TLV_TYPE_NUM; i++)
+    {
+        index->first[i] = position;
+        next[i]         = position;
+        position       += index->count[i];
+    }
+
+    for (i = 0; i < tlvs_nr; i++)
+    {
+        index->order[next[memory_structure->list_of_TLVs[i]->type]++] = i;
+    }
+
+    memory_structure->tlv_index = index;
+}
+
+uint16_t count_1905_CMDU_TLVs(const struct CMDU *memory_structure, uint8_t tlv_type)
+{
+    uint16_t count;
+    uint16_t i;
+
+    if (NULL != memory_structure->tlv_index)
+    {
+        return memory_structure->tlv_index->count[tlv_type];
+    }
+
+    count = 0;
+    for (i = 0; NULL != memory_structure->list_of_TLVs && NULL != memory_structure->list_of_TLVs[i]; i++)
+    {
+        if (tlv_type == memory_structure->list_of_TLVs[i]->type)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+struct tlv *get_1905_CMDU_TLV(const struct CMDU *memory_structure, uint8_t tlv_type, uint16_t n)
+{
+    const struct CMDU_TLV_index *index = memory_structure->tlv_index;
+    uint16_t                     i;
+
+    if (NULL != index)
+    {
+        if (n >= index->count[tlv_type])
+        {
+            return NULL;
+        }
+        return memory_structure->list_of_TLVs[index->order[index->first[tlv_type] + n]];
+    }
+
+    for (i = 0; NULL != memory_structure->list_of_TLVs && NULL != memory_structure->list_of_TLVs[i]; i++)
+    {
+        if (tlv_type == memory_structure->list_of_TLVs[i]->type && 0 == n--)
+        {
+            return memory_structure->list_of_TLVs[i];
+        }
+    }
+
+    return NULL;
+}
 
 void free_1905_CMDU_packets(uint8_t **packet_streams)
 {
@@ -199,6 +199,55 @@ static bool linkMetricQueryTLVForge(const struct tlv_struct *item, uint8_t **buf
 
 /** @} */
 
+/** @brief Support functions for searchedRole and supportedRole TLVs.
+ *
+ * See "IEEE Std 1905.1-2013" Sections 6.4.14 and 6.4.16
+ *
+ * Both TLVs have the same layout, so they share the forge function. Parsing is done by the default fixed-layout
+ * parser, which accepts any role (the receiver decides what to do with unknown roles).
+ *
+ * @{
+ */
+
+static bool roleTLVForge(const struct tlv_struct *item, uint8_t **buffer, size_t *length)
+{
+    const struct searchedRoleTLV *self = container_of(item, const struct searchedRoleTLV, tlv.s);
+
+    if (IEEE80211_ROLE_REGISTRAR != self->role)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Malformed %s TLV: invalid role %u\n", item->desc->name, self->role);
+        return false;
+    }
+
+    return tlv_struct_forge_field(item, &item->desc->fields[0], buffer, length);
+}
+
+/** @} */
+
+/** @brief Support functions for autoconfigFreqBand and supportedFreqBand TLVs.
+ *
+ * See "IEEE Std 1905.1-2013" Sections 6.4.15 and 6.4.17
+ *
+ * @{
+ */
+
+static bool freqBandTLVForge(const struct tlv_struct *item, uint8_t **buffer, size_t *length)
+{
+    const struct autoconfigFreqBandTLV *self = container_of(item, const struct autoconfigFreqBandTLV, tlv.s);
+
+    if (IEEE80211_FREQUENCY_BAND_2_4_GHZ != self->freq_band &&
+        IEEE80211_FREQUENCY_BAND_5_GHZ   != self->freq_band &&
+        IEEE80211_FREQUENCY_BAND_60_GHZ  != self->freq_band)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Malformed %s TLV: invalid freq_band %u\n", item->desc->name, self->freq_band);
+        return false;
+    }
+
+    return tlv_struct_forge_field(item, &item->desc->fields[0], buffer, length);
+}
+
+/** @} */
+
 /** @brief Support functions for vendorSpecific TLV.
  *
  * See "IEEE Std 1905.1-2013" Section 6.4.2
@@ -546,6 +595,28 @@ static tlv_defs_t tlv_1905_defs = {
         .parse = linkMetricQueryTLVParse,
         .forge = linkMetricQueryTLVForge,
     ),
+    TLV_DEF_ENTRY_1FIELDS(searchedRole, TLV_TYPE_SEARCHED_ROLE, NULL,
+        role, tlv_struct_print_format_dec,
+        .forge = roleTLVForge,
+    ),
+    TLV_DEF_ENTRY_1FIELDS(autoconfigFreqBand, TLV_TYPE_AUTOCONFIG_FREQ_BAND, NULL,
+        freq_band, tlv_struct_print_format_dec,
+        .forge = freqBandTLVForge,
+    ),
+    TLV_DEF_ENTRY_1FIELDS(supportedRole, TLV_TYPE_SUPPORTED_ROLE, NULL,
+        role, tlv_struct_print_format_dec,
+        .forge = roleTLVForge,
+    ),
+    TLV_DEF_ENTRY_1FIELDS(supportedFreqBand, TLV_TYPE_SUPPORTED_FREQ_BAND, NULL,
+        freq_band, tlv_struct_print_format_dec,
+        .forge = freqBandTLVForge,
+    ),
+    TLV_DEF_ENTRY_4FIELDS(pushButtonJoinNotification, TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION, NULL,
+        al_mac_address,     tlv_struct_print_format_mac,
+        message_identifier, tlv_struct_print_format_dec,
+        mac_address,        tlv_struct_print_format_mac,
+        new_mac_address,    tlv_struct_print_format_mac,
+    ),
     TLV_DEF_ENTRY_0FIELDS(supportedService, TLV_TYPE_SUPPORTED_SERVICE, &_supportedServiceDesc, ),
     /* Searched service is exactly the same as supported service, so reuse the functions. Will be printed with the
      * wrong name, but who cares. */
@@ -616,18 +687,75 @@ struct supportedServiceTLV *searchedServiceTLVAlloc(dlist_head *parent, bool con
     return ret;
 }
 
+// Minimal length of the value of the TLVs that are still parsed by the switch
+// in "parse_1905_TLV_from_packet()" (ie. the length of their fixed part).
+//
+// The declared length of a TLV is checked against it once, before anything is
+// extracted, so that the (unchecked) extraction of the fixed part can never
+// read past the end of the TLV. TLVs parsed through "tlv_1905_defs" are checked
+// by "tlv_parse()" instead, using the minimal length of their description.
+//
+// Some TLVs are accepted with a length of zero when FIX_BROKEN_TLVS is set (see
+// the comments in their parsers).
+//
+#ifdef FIX_BROKEN_TLVS
+#  define MIN_LENGTH_OR_EMPTY(min_length) (0)
+#else
+#  define MIN_LENGTH_OR_EMPTY(min_length) (min_length)
+#endif
+
+static const uint16_t legacy_tlv_min_length[256] =
+{
+    [TLV_TYPE_DEVICE_INFORMATION_TYPE]              = 7,
+    [TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES]         = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST]        = 6,
+    [TLV_TYPE_NEIGHBOR_DEVICE_LIST]                 = 6,
+    [TLV_TYPE_TRANSMITTER_LINK_METRIC]              = 12,
+    [TLV_TYPE_RECEIVER_LINK_METRIC]                 = 12,
+    [TLV_TYPE_LINK_METRIC_RESULT_CODE]              = 1,
+    [TLV_TYPE_PUSH_BUTTON_EVENT_NOTIFICATION]       = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_GENERIC_PHY_DEVICE_INFORMATION]       = 7,
+    [TLV_TYPE_DEVICE_IDENTIFICATION]                = 192,
+    [TLV_TYPE_IPV4]                                 = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_IPV6]                                 = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_GENERIC_PHY_EVENT_NOTIFICATION]       = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_1905_PROFILE_VERSION]                 = 1,
+    [TLV_TYPE_POWER_OFF_INTERFACE]                  = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_INTERFACE_POWER_CHANGE_INFORMATION]   = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_INTERFACE_POWER_CHANGE_STATUS]        = MIN_LENGTH_OR_EMPTY(1),
+    [TLV_TYPE_L2_NEIGHBOR_DEVICE]                   = MIN_LENGTH_OR_EMPTY(1),
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // Actual API functions
 ////////////////////////////////////////////////////////////////////////////////
 
-struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
+struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream, uint16_t packet_len)
 {
     const uint8_t *p;
-    if (NULL == packet_stream)
+    uint16_t       declared_length;
+
+    if (NULL == packet_stream || packet_len < 3)
     {
         return NULL;
     }
 
+    p = packet_stream + 1;
+    _E2B(&p, &declared_length);
+    if ((uint32_t)declared_length + 3 > packet_len)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Malformed %s TLV: length %u goes past the end of the %u received bytes\n",
+                                      convert_1905_TLV_type_to_string(*packet_stream), declared_length, packet_len);
+        return NULL;
+    }
+    if (declared_length < legacy_tlv_min_length[*packet_stream])
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Malformed %s TLV: length %u is shorter than %u\n",
+                                      convert_1905_TLV_type_to_string(*packet_stream), declared_length,
+                                      legacy_tlv_min_length[*packet_stream]);
+        return NULL;
+    }
+
     // The first byte of the stream is the "Type" field from the TLV structure.
     // Valid values for this byte are the following ones...
     //
@@ -653,6 +781,17 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
             _EnB(&p,  ret->al_mac_address, 6);
             _E1B(&p, &ret->local_interfaces_nr);
 
+            // Each entry takes at least 9 bytes: reject a number of entries
+            // that can't fit before reading any of them
+            //
+            if (7 + 9 * ret->local_interfaces_nr > len)
+            {
+                // Malformed packet
+                //
+                free(ret);
+                return NULL;
+            }
+
             ret->local_interfaces = (struct _localInterfaceEntries *)memalloc(sizeof(struct _localInterfaceEntries) * ret->local_interfaces_nr);
 
             for (i=0; i < ret->local_interfaces_nr; i++)
@@ -1062,130 +1201,6 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
             return &ret->tlv;
         }
 
-        case TLV_TYPE_SEARCHED_ROLE:
-        {
-            // This parsing is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.14"
-
-            struct searchedRoleTLV  *ret;
-
-            uint16_t len;
-
-            ret = (struct searchedRoleTLV *)memalloc(sizeof(struct searchedRoleTLV));
-
-            p = packet_stream + 1;
-            _E2B(&p, &len);
-
-            // According to the standard, the length *must* be 1
-            //
-            if (1 != len)
-            {
-                // Malformed packet
-                //
-                free(ret);
-                return NULL;
-            }
-
-            ret->tlv.type = TLV_TYPE_SEARCHED_ROLE;
-
-            _E1B(&p, &ret->role);
-
-            return &ret->tlv;
-        }
-
-        case TLV_TYPE_AUTOCONFIG_FREQ_BAND:
-        {
-            // This parsing is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.15"
-
-            struct autoconfigFreqBandTLV  *ret;
-
-            uint16_t len;
-
-            ret = (struct autoconfigFreqBandTLV *)memalloc(sizeof(struct autoconfigFreqBandTLV));
-
-            p = packet_stream + 1;
-            _E2B(&p, &len);
-
-            // According to the standard, the length *must* be 1
-            //
-            if (1 != len)
-            {
-                // Malformed packet
-                //
-                free(ret);
-                return NULL;
-            }
-
-            ret->tlv.type = TLV_TYPE_AUTOCONFIG_FREQ_BAND;
-
-            _E1B(&p, &ret->freq_band);
-
-            return &ret->tlv;
-        }
-
-        case TLV_TYPE_SUPPORTED_ROLE:
-        {
-            // This parsing is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.16"
-
-            struct supportedRoleTLV  *ret;
-
-            uint16_t len;
-
-            ret = (struct supportedRoleTLV *)memalloc(sizeof(struct supportedRoleTLV));
-
-            p = packet_stream + 1;
-            _E2B(&p, &len);
-
-            // According to the standard, the length *must* be 1
-            //
-            if (1 != len)
-            {
-                // Malformed packet
-                //
-                free(ret);
-                return NULL;
-            }
-
-            ret->tlv.type = TLV_TYPE_SUPPORTED_ROLE;
-
-            _E1B(&p, &ret->role);
-
-            return &ret->tlv;
-        }
-
-        case TLV_TYPE_SUPPORTED_FREQ_BAND:
-        {
-            // This parsing is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.17"
-
-            struct supportedFreqBandTLV  *ret;
-
-            uint16_t len;
-
-            ret = (struct supportedFreqBandTLV *)memalloc(sizeof(struct supportedFreqBandTLV));
-
-            p = packet_stream + 1;
-            _E2B(&p, &len);
-
-            // According to the standard, the length *must* be 1
-            //
-            if (1 != len)
-            {
-                // Malformed packet
-                //
-                free(ret);
-                return NULL;
-            }
-
-            ret->tlv.type = TLV_TYPE_SUPPORTED_FREQ_BAND;
-
-            _E1B(&p, &ret->freq_band);
-
-            return &ret->tlv;
-        }
-
         case TLV_TYPE_WSC:
         {
             // This parsing is done according to the information detailed in
@@ -1328,40 +1343,6 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
             return &ret->tlv;
         }
 
-        case TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION:
-        {
-            // This parsing is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.20"
-
-            struct pushButtonJoinNotificationTLV  *ret;
-
-            uint16_t len;
-
-            ret = (struct pushButtonJoinNotificationTLV *)memalloc(sizeof(struct pushButtonJoinNotificationTLV));
-
-            p = packet_stream + 1;
-            _E2B(&p, &len);
-
-            // According to the standard, the length *must* be 20
-            //
-            if (20 != len)
-            {
-                // Malformed packet
-                //
-                free(ret);
-                return NULL;
-            }
-
-            ret->tlv.type = TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION;
-
-            _EnB(&p,  ret->al_mac_address, 6);
-            _E2B(&p, &ret->message_identifier);
-            _EnB(&p,  ret->mac_address, 6);
-            _EnB(&p,  ret->new_mac_address, 6);
-
-            return &ret->tlv;
-        }
-
         case TLV_TYPE_GENERIC_PHY_DEVICE_INFORMATION:
         {
             // This parsing is done according to the information detailed in
@@ -1382,6 +1363,17 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
             _EnB(&p,  ret->al_mac_address, 6);
             _E1B(&p, &ret->local_interfaces_nr);
 
+            // Each entry takes at least 44 bytes: reject a number of entries
+            // that can't fit before reading any of them
+            //
+            if (7 + 44 * ret->local_interfaces_nr > len)
+            {
+                // Malformed packet
+                //
+                free(ret);
+                return NULL;
+            }
+
             if (ret->local_interfaces_nr > 0)
             {
                 ret->local_interfaces = (struct _genericPhyDeviceEntries *)memalloc(sizeof(struct _genericPhyDeviceEntries) * ret->local_interfaces_nr);
@@ -1876,6 +1868,16 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
 
             _E1B(&p, &ret->power_change_interfaces_nr);
 
+            // All entries are 7 bytes long
+            //
+            if (1 + 7 * ret->power_change_interfaces_nr != len)
+            {
+                // Malformed packet
+                //
+                free(ret);
+                return NULL;
+            }
+
             if (ret->power_change_interfaces_nr > 0)
             {
                 ret->power_change_interfaces = (struct _powerChangeInformationEntries *)memalloc(sizeof(struct _powerChangeInformationEntries) * ret->power_change_interfaces_nr);
@@ -1938,6 +1940,16 @@ struct tlv *parse_1905_TLV_from_packet(const uint8_t *packet_stream)
 
             _E1B(&p, &ret->power_change_interfaces_nr);
 
+            // All entries are 7 bytes long
+            //
+            if (1 + 7 * ret->power_change_interfaces_nr != len)
+            {
+                // Malformed packet
+                //
+                free(ret);
+                return NULL;
+            }
+
             if (ret->power_change_interfaces_nr > 0)
             {
                 ret->power_change_interfaces = (struct _powerChangeStatusEntries *)memalloc(sizeof(struct _powerChangeStatusEntries) * ret->power_change_interfaces_nr);
@@ -2418,146 +2430,6 @@ uint8_t *forge_1905_TLV_from_structure(const struct tlv *tlv, uint16_t *len)
             return ret;
         }
 
-        case TLV_TYPE_SEARCHED_ROLE:
-        {
-            // This forging is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.14"
-
-            uint8_t *ret, *p;
-            struct searchedRoleTLV *m;
-
-            uint16_t tlv_length;
-
-            m = (struct searchedRoleTLV *)tlv;
-
-            tlv_length = 1;
-            *len = 1 + 2 + tlv_length;
-
-            p = ret = (uint8_t *)memalloc(1 + 2  + tlv_length);
-
-            _I1B(&m->tlv.type,     &p);
-            _I2B(&tlv_length,      &p);
-
-            if (m->role != IEEE80211_ROLE_REGISTRAR)
-            {
-                // Malformed structure
-                //
-                free(ret);
-                return NULL;
-            }
-
-            _I1B(&m->role,  &p);
-
-            return ret;
-        }
-
-        case TLV_TYPE_AUTOCONFIG_FREQ_BAND:
-        {
-            // This forging is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.14"
-
-            uint8_t *ret, *p;
-            struct autoconfigFreqBandTLV *m;
-
-            uint16_t tlv_length;
-
-            m = (struct autoconfigFreqBandTLV *)tlv;
-
-            tlv_length = 1;
-            *len = 1 + 2 + tlv_length;
-
-            p = ret = (uint8_t *)memalloc(1 + 2  + tlv_length);
-
-            _I1B(&m->tlv.type,     &p);
-            _I2B(&tlv_length,      &p);
-
-            if (
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_2_4_GHZ) &&
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_5_GHZ)   &&
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_60_GHZ)
-               )
-            {
-                // Malformed structure
-                //
-                free(ret);
-                return NULL;
-            }
-
-            _I1B(&m->freq_band,  &p);
-
-            return ret;
-        }
-
-        case TLV_TYPE_SUPPORTED_ROLE:
-        {
-            // This forging is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.16"
-
-            uint8_t *ret, *p;
-            struct supportedRoleTLV *m;
-
-            uint16_t tlv_length;
-
-            m = (struct supportedRoleTLV *)tlv;
-
-            tlv_length = 1;
-            *len = 1 + 2 + tlv_length;
-
-            p = ret = (uint8_t *)memalloc(1 + 2  + tlv_length);
-
-            _I1B(&m->tlv.type,     &p);
-            _I2B(&tlv_length,      &p);
-
-            if (m->role != IEEE80211_ROLE_REGISTRAR)
-            {
-                // Malformed structure
-                //
-                free(ret);
-                return NULL;
-            }
-
-            _I1B(&m->role,  &p);
-
-            return ret;
-        }
-
-        case TLV_TYPE_SUPPORTED_FREQ_BAND:
-        {
-            // This forging is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.17"
-
-            uint8_t *ret, *p;
-            struct supportedFreqBandTLV *m;
-
-            uint16_t tlv_length;
-
-            m = (struct supportedFreqBandTLV *)tlv;
-
-            tlv_length = 1;
-            *len = 1 + 2 + tlv_length;
-
-            p = ret = (uint8_t *)memalloc(1 + 2  + tlv_length);
-
-            _I1B(&m->tlv.type,     &p);
-            _I2B(&tlv_length,      &p);
-
-            if (
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_2_4_GHZ) &&
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_5_GHZ)   &&
-                 (m->freq_band != IEEE80211_FREQUENCY_BAND_60_GHZ)
-               )
-            {
-                // Malformed structure
-                //
-                free(ret);
-                return NULL;
-            }
-
-            _I1B(&m->freq_band,  &p);
-
-            return ret;
-        }
-
         case TLV_TYPE_WSC:
         {
             // This forging is done according to the information detailed in
@@ -2675,33 +2547,6 @@ uint8_t *forge_1905_TLV_from_structure(const struct tlv *tlv, uint16_t *len)
             return ret;
         }
 
-        case TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION:
-        {
-            // This forging is done according to the information detailed in
-            // "IEEE Std 1905.1-2013 Section 6.4.20"
-
-            uint8_t *ret, *p;
-            struct pushButtonJoinNotificationTLV *m;
-
-            uint16_t tlv_length;
-
-            m = (struct pushButtonJoinNotificationTLV *)tlv;
-
-            tlv_length = 20;
-            *len = 1 + 2 + tlv_length;
-
-            p = ret = (uint8_t *)memalloc(1 + 2  + tlv_length);
-
-            _I1B(&m->tlv.type,            &p);
-            _I2B(&tlv_length,             &p);
-            _InB( m->al_mac_address,      &p, 6);
-            _I2B(&m->message_identifier,  &p);
-            _InB( m->mac_address,         &p, 6);
-            _InB( m->new_mac_address,     &p, 6);
-
-            return ret;
-        }
-
         case TLV_TYPE_GENERIC_PHY_DEVICE_INFORMATION:
         {
             // This forging is done according to the information detailed in
@@ -3449,6 +3294,18 @@ void free_1905_TLV_structure(struct tlv *tlv)
             return;
         }
 
+        case TLV_TYPE_LINK_METRIC_RESULT_CODE:
+        case TLV_TYPE_DEVICE_IDENTIFICATION:
+        case TLV_TYPE_1905_PROFILE_VERSION:
+        {
+            // These TLVs are not allocated from their description (see
+            // "tlv_1905_defs") and contain no pointers
+            //
+            free(tlv);
+
+            return;
+        }
+
         case TLV_TYPE_INTERFACE_POWER_CHANGE_INFORMATION:
         {
             struct interfacePowerChangeInformationTLV *m;
@@ -3840,82 +3697,6 @@ uint8_t compare_1905_TLV_structures(struct tlv *tlv_1, struct tlv *tlv_2)
             }
         }
 
-        case TLV_TYPE_SEARCHED_ROLE:
-        {
-            struct searchedRoleTLV *p1, *p2;
-
-            p1 = (struct searchedRoleTLV *)tlv_1;
-            p2 = (struct searchedRoleTLV *)tlv_2;
-
-            if (
-                 p1->role != p2->role
-               )
-            {
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-        }
-
-        case TLV_TYPE_AUTOCONFIG_FREQ_BAND:
-        {
-            struct autoconfigFreqBandTLV *p1, *p2;
-
-            p1 = (struct autoconfigFreqBandTLV *)tlv_1;
-            p2 = (struct autoconfigFreqBandTLV *)tlv_2;
-
-            if (
-                 p1->freq_band != p2->freq_band
-               )
-            {
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-        }
-
-        case TLV_TYPE_SUPPORTED_ROLE:
-        {
-            struct supportedRoleTLV *p1, *p2;
-
-            p1 = (struct supportedRoleTLV *)tlv_1;
-            p2 = (struct supportedRoleTLV *)tlv_2;
-
-            if (
-                 p1->role != p2->role
-               )
-            {
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-        }
-
-        case TLV_TYPE_SUPPORTED_FREQ_BAND:
-        {
-            struct supportedFreqBandTLV *p1, *p2;
-
-            p1 = (struct supportedFreqBandTLV *)tlv_1;
-            p2 = (struct supportedFreqBandTLV *)tlv_2;
-
-            if (
-                 p1->freq_band != p2->freq_band
-               )
-            {
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-        }
-
         case TLV_TYPE_WSC:
         {
             struct wscTLV *p1, *p2;
@@ -4003,28 +3784,6 @@ uint8_t compare_1905_TLV_structures(struct tlv *tlv_1, struct tlv *tlv_2)
             return 0;
         }
 
-        case TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION:
-        {
-            struct pushButtonJoinNotificationTLV *p1, *p2;
-
-            p1 = (struct pushButtonJoinNotificationTLV *)tlv_1;
-            p2 = (struct pushButtonJoinNotificationTLV *)tlv_2;
-
-            if (
-                 memcmp(p1->al_mac_address,       p2->al_mac_address, 6) !=0  ||
-                                 p1->message_identifier != p2->message_identifier      ||
-                 memcmp(p1->mac_address,          p2->al_mac_address, 6) !=0  ||
-                 memcmp(p1->new_mac_address,      p2->al_mac_address, 6) !=0
-               )
-            {
-                return 1;
-            }
-            else
-            {
-                return 0;
-            }
-        }
-
         case TLV_TYPE_DEVICE_IDENTIFICATION:
         {
             struct deviceIdentificationTypeTLV *p1, *p2;
@@ -4703,50 +4462,6 @@ void visit_1905_TLV_structure(struct tlv *tlv, visitor_callback callback, void (
             return;
         }
 
-        case TLV_TYPE_SEARCHED_ROLE:
-        {
-            struct searchedRoleTLV *p;
-
-            p = (struct searchedRoleTLV *)tlv;
-
-            callback(write_function, tlv_prefix, sizeof(p->role), "role",  "%d",  &p->role);
-
-            return;
-        }
-
-        case TLV_TYPE_AUTOCONFIG_FREQ_BAND:
-        {
-            struct autoconfigFreqBandTLV *p;
-
-            p = (struct autoconfigFreqBandTLV *)tlv;
-
-            callback(write_function, tlv_prefix, sizeof(p->freq_band), "freq_band",  "%d",  &p->freq_band);
-
-            return;
-        }
-
-        case TLV_TYPE_SUPPORTED_ROLE:
-        {
-            struct supportedRoleTLV *p;
-
-            p = (struct supportedRoleTLV *)tlv;
-
-            callback(write_function, tlv_prefix, sizeof(p->role), "role",  "%d",  &p->role);
-
-            return;
-        }
-
-        case TLV_TYPE_SUPPORTED_FREQ_BAND:
-        {
-            struct supportedFreqBandTLV *p;
-
-            p = (struct supportedFreqBandTLV *)tlv;
-
-            callback(write_function, tlv_prefix, sizeof(p->freq_band), "freq_band",  "%d",  &p->freq_band);
-
-            return;
-        }
-
         case TLV_TYPE_WSC:
         {
             struct wscTLV *p;
@@ -4807,19 +4522,6 @@ void visit_1905_TLV_structure(struct tlv *tlv, visitor_callback callback, void (
             return;
         }
 
-        case TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION:
-        {
-            struct pushButtonJoinNotificationTLV *p;
-
-            p = (struct pushButtonJoinNotificationTLV *)tlv;
-
-            callback(write_function, tlv_prefix, sizeof(p->al_mac_address),     "al_mac_address",      "0x%02x",   p->al_mac_address);
-            callback(write_function, tlv_prefix, sizeof(p->message_identifier), "message_identifier",  "%d",      &p->message_identifier);
-            callback(write_function, tlv_prefix, sizeof(p->mac_address),        "mac_address",         "0x%02x",   p->mac_address);
-            callback(write_function, tlv_prefix, sizeof(p->new_mac_address),    "new_mac_address",     "0x%02x",   p->new_mac_address);
-            return;
-        }
-
         case TLV_TYPE_GENERIC_PHY_DEVICE_INFORMATION:
         {
             struct genericPhyDeviceInformationTypeTLV *p;
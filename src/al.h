@@ -81,10 +81,31 @@
 //       AL_ERROR_PROTOCOL_EXTENSION;
 //         Error registering, at least, one protocol extension.
 //
-//   - The HLE requested the AL service to stop. In this case it will return '0'
+//   - The HLE requested the AL service to stop, or the platform asked it to
+//     terminate (see "PLATFORM_QUEUE_EVENT_SHUTDOWN"). In this case it will
+//     return '0'
 //
 uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, char *registrar_interface);
 
+// The following two functions are the first steps of the processing of every
+// received 1905 packet in "start1905AL()". They are only exported so that
+// captured traffic can be replayed through the same path (see
+// "benchmarks/pcap_replay.c"): they keep internal state and must not be called
+// while the AL is running.
+//
+struct CMDU_view;
+
+// Buffer the fragment in 'packet_buffer' (a whole Ethernet frame, 'len' bytes
+// long) and return the view of the CMDU it completes, or NULL if more fragments
+// are still missing.
+//
+struct CMDU_view *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t len);
+
+// Return '1' if 'c' (received from 'src_mac_address') is a duplicate of a
+// recently received CMDU, and '0' otherwise.
+//
+uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU_view *c);
+
 
 #endif
 
@@ -0,0 +1,323 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "utils.h"
+
+#include "al_cmdu_stats.h"
+#include "1905_cmdus.h"
+
+#include <stdio.h>  // snprintf()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// Histogram buckets: values below 2^HISTOGRAM_SUB_BITS have a bucket each.
+// Above that, each power of two is split in 2^HISTOGRAM_SUB_BITS buckets.
+//
+#define HISTOGRAM_SUB_BITS     (3)
+#define HISTOGRAM_SUB_BUCKETS  (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS      ((32 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct _histogram
+{
+    uint32_t  count;
+    uint32_t  max;
+    uint32_t  buckets[HISTOGRAM_BUCKETS];
+};
+
+struct _typeStats
+{
+    uint32_t            frames[2];     // Indexed by CMDU_STATS_RX/CMDU_STATS_TX
+    uint32_t            bytes[2];
+
+    uint32_t            messages;      // Messages whose allocations were counted
+    unsigned long       allocations;   // Total allocations of those messages
+    unsigned long       max_allocations;
+
+    struct _histogram  *stages[CMDU_STATS_STAGES_NR];
+};
+
+// Slots of the 'types' array: one per 1905 CMDU type, then LLDP, then
+// everything else (unknown types, vendor extensions...)
+//
+#define TYPE_SLOT_LLDP   (CMDU_TYPE_GENERIC_PHY_RESPONSE + 1)
+#define TYPE_SLOT_OTHER  (CMDU_TYPE_GENERIC_PHY_RESPONSE + 2)
+#define TYPE_SLOTS_NR    (CMDU_TYPE_GENERIC_PHY_RESPONSE + 3)
+
+static const char *stage_names[CMDU_STATS_STAGES_NR] =
+{
+    [CMDU_STATS_STAGE_QUEUE]      = "queue",
+    [CMDU_STATS_STAGE_REASSEMBLY] = "reassembly",
+    [CMDU_STATS_STAGE_PARSE]      = "parse",
+    [CMDU_STATS_STAGE_PROCESS]    = "process",
+    [CMDU_STATS_STAGE_FORGE]      = "forge",
+    [CMDU_STATS_STAGE_SEND]       = "send",
+};
+
+static uint32_t            period = 0;
+static struct _typeStats  *types[TYPE_SLOTS_NR];
+static struct queueStats   queue;
+static uint8_t             queue_known = 0;
+
+// Return the statistics of 'message_type', allocating them the first time
+//
+static struct _typeStats *_typeStats(uint16_t message_type)
+{
+    unsigned slot;
+
+    if (CMDU_STATS_TYPE_LLDP == message_type)
+    {
+        slot = TYPE_SLOT_LLDP;
+    }
+    else if (message_type <= CMDU_TYPE_GENERIC_PHY_RESPONSE)
+    {
+        slot = message_type;
+    }
+    else
+    {
+        slot = TYPE_SLOT_OTHER;
+    }
+
+    if (NULL == types[slot])
+    {
+        types[slot] = (struct _typeStats *)zmemalloc(sizeof(struct _typeStats));
+    }
+    return types[slot];
+}
+
+static unsigned _bucket(uint32_t value)
+{
+    unsigned exponent;
+
+    if (value < HISTOGRAM_SUB_BUCKETS)
+    {
+        return value;
+    }
+
+    // Position of the most significant bit (at least HISTOGRAM_SUB_BITS)
+    //
+    exponent = 31 - __builtin_clz(value);
+
+    return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS +
+           (value >> (exponent - HISTOGRAM_SUB_BITS)) - HISTOGRAM_SUB_BUCKETS;
+}
+
+// Return the highest value that falls in bucket 'bucket'
+//
+static uint32_t _bucketMax(unsigned bucket)
+{
+    unsigned shift;
+    uint32_t sub;
+
+    if (bucket < HISTOGRAM_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    sub   = bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS;
+
+    return (uint32_t)((((uint64_t)sub + 1) << shift) - 1);
+}
+
+// Return the value below which 'percent'% of the samples of 'h' fall (never
+// more than the maximum seen)
+//
+static uint32_t _percentile(const struct _histogram *h, unsigned percent)
+{
+    uint64_t threshold;
+    uint64_t seen;
+    unsigned i;
+
+    // Rank of the sample we are looking for (rounded up, at least 1)
+    //
+    threshold = ((uint64_t)h->count * percent + 99) / 100;
+    if (0 == threshold)
+    {
+        threshold = 1;
+    }
+
+    seen = 0;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= threshold)
+        {
+            return _bucketMax(i) < h->max ? _bucketMax(i) : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+static void _dumpType(void (*write_function)(const char *fmt, ...), uint32_t now, const char *name,
+                      const struct _typeStats *t)
+{
+    char     line[768];
+    size_t   len;
+    unsigned i;
+
+    len = snprintf(line, sizeof(line), "cmdu_stats time_ms=%u type=%s rx_frames=%u rx_bytes=%u tx_frames=%u tx_bytes=%u "
+                   "messages=%u allocs_avg=%lu allocs_max=%lu",
+                   now, name, t->frames[CMDU_STATS_RX], t->bytes[CMDU_STATS_RX], t->frames[CMDU_STATS_TX],
+                   t->bytes[CMDU_STATS_TX], t->messages, 0 == t->messages ? 0 : t->allocations / t->messages,
+                   t->max_allocations);
+
+    for (i = 0; i < CMDU_STATS_STAGES_NR && len < sizeof(line); i++)
+    {
+        const struct _histogram *h = t->stages[i];
+
+        if (NULL == h)
+        {
+            len += snprintf(line + len, sizeof(line) - len, " %s=0/0/0/0/0", stage_names[i]);
+        }
+        else
+        {
+            len += snprintf(line + len, sizeof(line) - len, " %s=%u/%u/%u/%u/%u", stage_names[i], h->count,
+                            _percentile(h, 50), _percentile(h, 90), _percentile(h, 99), h->max);
+        }
+    }
+
+    write_function("%s\n", line);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (exported only to files in this same folder)
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t cmdu_stats_enabled = 0;
+
+void cmduStatsPeriodSet(uint32_t period_ms)
+{
+    period             = period_ms;
+    cmdu_stats_enabled = 0 != period_ms;
+}
+
+uint32_t cmduStatsPeriodGet(void)
+{
+    return period;
+}
+
+void cmduStatsQueue(const struct queueStats *queue_stats)
+{
+    queue       = *queue_stats;
+    queue_known = 1;
+}
+
+void cmduStatsSample(uint16_t message_type, uint8_t stage, uint32_t duration_us)
+{
+    struct _typeStats *t;
+    struct _histogram *h;
+
+    if (!cmdu_stats_enabled || stage >= CMDU_STATS_STAGES_NR)
+    {
+        return;
+    }
+
+    t = _typeStats(message_type);
+    if (NULL == t->stages[stage])
+    {
+        t->stages[stage] = (struct _histogram *)zmemalloc(sizeof(struct _histogram));
+    }
+    h = t->stages[stage];
+
+    h->buckets[_bucket(duration_us)]++;
+    h->count++;
+    if (duration_us > h->max)
+    {
+        h->max = duration_us;
+    }
+}
+
+void cmduStatsFrame(uint16_t message_type, uint8_t direction, uint32_t len)
+{
+    struct _typeStats *t;
+
+    if (!cmdu_stats_enabled || direction > CMDU_STATS_TX)
+    {
+        return;
+    }
+
+    t = _typeStats(message_type);
+    t->frames[direction]++;
+    t->bytes[direction] += len;
+}
+
+void cmduStatsAllocations(uint16_t message_type, unsigned long allocations)
+{
+    struct _typeStats *t;
+
+    if (!cmdu_stats_enabled)
+    {
+        return;
+    }
+
+    t = _typeStats(message_type);
+    t->messages++;
+    t->allocations += allocations;
+    if (allocations > t->max_allocations)
+    {
+        t->max_allocations = allocations;
+    }
+}
+
+void cmduStatsDump(void (*write_function)(const char *fmt, ...))
+{
+    char              name[8];
+    uint32_t          now;
+    unsigned          i;
+
+    now = PLATFORM_GET_TIMESTAMP();
+
+    if (!cmdu_stats_enabled)
+    {
+        write_function("cmdu_stats time_ms=%u disabled\n", now);
+        return;
+    }
+
+    if (queue_known)
+    {
+        write_function("cmdu_stats time_ms=%u queue enqueued=%u dropped=%u depth=%u peak_depth=%u\n",
+                       now, queue.enqueued, queue.dropped, queue.depth, queue.peak_depth);
+    }
+
+    for (i = 0; i < TYPE_SLOTS_NR; i++)
+    {
+        if (NULL == types[i])
+        {
+            continue;
+        }
+
+        if (TYPE_SLOT_LLDP == i)
+        {
+            _dumpType(write_function, now, "lldp", types[i]);
+        }
+        else if (TYPE_SLOT_OTHER == i)
+        {
+            _dumpType(write_function, now, "other", types[i]);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "0x%04x", i);
+            _dumpType(write_function, now, name, types[i]);
+        }
+    }
+}
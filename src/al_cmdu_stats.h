@@ -0,0 +1,134 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _AL_CMDU_STATS_H_
+#define _AL_CMDU_STATS_H_
+
+#include "platform.h"
+#include "platform_os.h"
+
+// Per message type instrumentation of the AL.
+//
+// For each CMDU type (and for LLDP frames) the AL counts the frames and bytes
+// it receives and sends, the allocations done to handle each received message
+// and how long each of these stages takes (in microseconds):
+//
+//   - CMDU_STATS_STAGE_QUEUE: time a received frame spent in the platform
+//     queue before the AL read it.
+//   - CMDU_STATS_STAGE_REASSEMBLY: time between the first and the last
+//     fragment of a fragmented CMDU.
+//   - CMDU_STATS_STAGE_PARSE: "parse_1905_CMDU_view_from_packets()".
+//   - CMDU_STATS_STAGE_PROCESS: "process1905CmduView()" (the handler).
+//   - CMDU_STATS_STAGE_FORGE: "forge_1905_CMDU_from_structure()".
+//   - CMDU_STATS_STAGE_SEND: "PLATFORM_SEND_RAW_PACKET()" of each frame.
+//
+// Times are kept in log-linear histograms (like HdrHistogram does): each power
+// of two is split in 8 buckets, so percentiles are reported with a precision
+// of 12.5% whatever their magnitude, using less than 1 KiB per histogram.
+// Histograms are only allocated for the (type, stage) pairs that are actually
+// seen.
+//
+// Statistics are disabled by default. Then, the hooks below cost a test of
+// "cmdu_stats_enabled" and nothing else, and the AL queue does not keep its
+// own statistics either (see "PLATFORM_ENABLE_QUEUE_STATS()").
+//
+// Everything here runs in the AL thread, so there is no locking.
+
+#define CMDU_STATS_STAGE_QUEUE       (0)
+#define CMDU_STATS_STAGE_REASSEMBLY  (1)
+#define CMDU_STATS_STAGE_PARSE       (2)
+#define CMDU_STATS_STAGE_PROCESS     (3)
+#define CMDU_STATS_STAGE_FORGE       (4)
+#define CMDU_STATS_STAGE_SEND        (5)
+#define CMDU_STATS_STAGES_NR         (6)
+
+// Message type used for LLDP frames (CMDU types are never this big)
+//
+#define CMDU_STATS_TYPE_LLDP         (0xffff)
+
+// Direction of a frame (see "cmduStatsFrame()")
+//
+#define CMDU_STATS_RX                (0)
+#define CMDU_STATS_TX                (1)
+
+// Set the period (in milliseconds) of the statistics log line (see
+// "cmduStatsDump()"). "0" (the default) disables the statistics.
+//
+// Must be called before the AL entity is started.
+//
+void cmduStatsPeriodSet(uint32_t period_ms);
+
+// Return the value set with "cmduStatsPeriodSet()"
+//
+uint32_t cmduStatsPeriodGet(void);
+
+// Record the latest statistics of the AL platform queue (see
+// "PLATFORM_GET_QUEUE_STATS()"), which are reported along with the message
+// ones
+//
+void cmduStatsQueue(const struct queueStats *queue_stats);
+
+// Record that stage 'stage' of a message of type 'message_type' took
+// 'duration_us' microseconds
+//
+void cmduStatsSample(uint16_t message_type, uint8_t stage, uint32_t duration_us);
+
+// Record a frame of 'len' bytes of type 'message_type' received or sent
+// ('direction' is CMDU_STATS_RX or CMDU_STATS_TX)
+//
+void cmduStatsFrame(uint16_t message_type, uint8_t direction, uint32_t len);
+
+// Record that 'allocations' allocations (see "memalloc_count") were done to
+// handle a received message of type 'message_type'
+//
+void cmduStatsAllocations(uint16_t message_type, unsigned long allocations);
+
+// Write the statistics as text, using 'write_function' (which works like
+// "printf()").
+//
+// The output is meant to be parsed by scripts: one line per message type seen
+// so far, plus one line for the platform queue, all of them starting with
+// "cmdu_stats time_ms=<PLATFORM_GET_TIMESTAMP()>" and made of "key=value"
+// pairs. Stage times are written as "<count>/<p50>/<p90>/<p99>/<max>" (in
+// microseconds).
+//
+void cmduStatsDump(void (*write_function)(const char *fmt, ...));
+
+// Hooks used by the instrumented code. They do nothing unless statistics are
+// enabled. Example:
+//
+//     uint32_t start = cmduStatsClock();
+//     ...
+//     cmduStatsElapsed(message_type, CMDU_STATS_STAGE_PARSE, start);
+//
+extern uint8_t cmdu_stats_enabled;
+
+static inline uint32_t cmduStatsClock(void)
+{
+    return cmdu_stats_enabled ? PLATFORM_GET_TIMESTAMP_US() : 0;
+}
+
+static inline void cmduStatsElapsed(uint16_t message_type, uint8_t stage, uint32_t start_us)
+{
+    if (cmdu_stats_enabled)
+    {
+        cmduStatsSample(message_type, stage, PLATFORM_GET_TIMESTAMP_US() - start_us);
+    }
+}
+
+#endif
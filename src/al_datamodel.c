@@ -41,12 +41,17 @@ static struct _dataModel
 {
     uint8_t              map_whole_network_flag;
 
+    uint32_t             restore_timestamp;  // Last call to "DMnetworkDevicesRestore()"
+
     uint8_t              network_devices_nr;
 
     struct _networkDevice
     {
             uint32_t                                      update_timestamp;
 
+            uint8_t                                       stale;  // Restored from a snapshot, not
+                                                                  // confirmed by the device yet
+
             struct deviceInformationTypeTLV            *info;
 
             uint8_t                                       bridges_nr;
@@ -160,6 +165,7 @@ void DMinit()
     data_model.network_devices          = (struct _networkDevice *)memalloc(sizeof(struct _networkDevice));
 
     data_model.network_devices[0].update_timestamp          = PLATFORM_GET_TIMESTAMP();
+    data_model.network_devices[0].stale                     = 0;
     data_model.network_devices[0].info                      = NULL;
     data_model.network_devices[0].bridges_nr                = 0;
     data_model.network_devices[0].bridges                   = NULL;
@@ -250,192 +256,145 @@ uint8_t *DMinterfaceNameToMac(const char *interface_name)
 }
 
 
-uint8_t (*DMgetListOfInterfaceNeighbors(char *local_interface_name, uint8_t *al_mac_addresses_nr))[6]
+// Return the next neighbor interface of the interface(s) walked by 'cursor',
+// or NULL when there are no more.
+//
+// When 'cursor->device' is set, all its interfaces are walked, starting at
+// 'cursor->interface'. Otherwise, only 'cursor->interface' is.
+//
+static struct interface *_cursorNext(struct DMneighborCursor *cursor)
 {
-    unsigned i;
-    uint8_t (*ret)[6];
-
-    struct interface *x;
-
-    if (NULL == (x = findLocalInterface(local_interface_name)))
-    {
-        // Non existent interface
-        //
-        *al_mac_addresses_nr = 0;
-        return NULL;
-    }
-
-    /* First count the number of AL neighbors */
-    *al_mac_addresses_nr = 0;
-    for (i = 0; i < x->neighbors.length; i++)
+    while (NULL != cursor->interface)
     {
-        if (x->neighbors.data[i]->owner != NULL)
+        if (cursor->index < cursor->interface->neighbors.length)
         {
-            (*al_mac_addresses_nr)++;
+            return cursor->interface->neighbors.data[cursor->index++];
         }
-    }
 
-    if (0 == *al_mac_addresses_nr)
-    {
-        return NULL;
-    }
-
-    ret = (uint8_t (*)[6])memalloc(sizeof(uint8_t[6]) * (*al_mac_addresses_nr));
-
-    for (i = 0; i < x->neighbors.length; i++)
-    {
-        if (x->neighbors.data[i]->owner != NULL)
+        if (NULL == cursor->device || cursor->interface->l.next == &cursor->device->interfaces)
         {
-            memcpy(&ret[i][0], x->neighbors.data[i]->owner->al_mac_addr, 6);
+            cursor->interface = NULL;
+        }
+        else
+        {
+            cursor->interface = container_of(cursor->interface->l.next, struct interface, l);
+            cursor->index     = 0;
         }
     }
 
-    return ret;
+    return NULL;
 }
 
-uint8_t (*DMgetListOfNeighbors(uint8_t *al_mac_addresses_nr))[6]
+// Make 'cursor' walk the neighbors of all the interfaces of 'device'
+//
+static void _cursorBeginDevice(struct DMneighborCursor *cursor, struct alDevice *device)
 {
-    unsigned i;
-    uint8_t k;
-
-    uint8_t total;
-    uint8_t (*ret)[6];
-
-    struct interface *interface;
+    cursor->device    = device;
+    cursor->interface = NULL;
+    cursor->index     = 0;
 
-    if (NULL == al_mac_addresses_nr)
+    if (NULL != device && !dlist_empty(&device->interfaces))
     {
-        return NULL;
+        cursor->interface = container_of(dlist_get_first(&device->interfaces), struct interface, l);
     }
+}
+
+void DMinterfaceNeighborsBegin(struct DMneighborCursor *cursor, const char *local_interface_name)
+{
+    cursor->device    = NULL;
+    cursor->interface = findLocalInterface(local_interface_name);
+    cursor->index     = 0;
+}
 
-    total = 0;
-    ret   = NULL;
+uint8_t *DMinterfaceNeighborsNext(struct DMneighborCursor *cursor)
+{
+    struct interface *neighbor_interface;
 
-    dlist_for_each(interface, local_device->interfaces, l)
+    while (NULL != (neighbor_interface = _cursorNext(cursor)))
     {
-        for (i = 0; i < interface->neighbors.length; i++)
+        if (NULL != neighbor_interface->owner)
         {
-            struct alDevice *neighbor = interface->neighbors.data[i]->owner;
-            bool already_present = false;
-
-            if (neighbor == NULL)
-            {
-                // Non-1905 neighbor
-                continue;
-            }
-
-            // Check for duplicates
-            for (k=0; k<total; k++)
-            {
-                if (0 == memcmp(&ret[k], neighbor->al_mac_addr, 6))
-                {
-                    already_present = true;
-                    break;
-                }
-            }
-
-            if (already_present)
-            {
-                continue;
-            }
-
-            // If we get here, this is a new neighbor and we need to add it to
-            // the list
-            //
-            if (NULL == ret)
-            {
-                ret = (uint8_t (*)[6])memalloc(sizeof(uint8_t[6]));
-            }
-            else
-            {
-                ret = (uint8_t (*)[6])memrealloc(ret, sizeof(uint8_t[6])*(total + 1));
-            }
-            memcpy(&ret[total], neighbor->al_mac_addr, 6);
-
-            total++;
+            return neighbor_interface->owner->al_mac_addr;
         }
     }
 
-    *al_mac_addresses_nr = total;
-
-    return ret;
+    return NULL;
 }
 
-uint8_t (*DMgetListOfLinksWithNeighbor(uint8_t *neighbor_al_mac_address, char ***interfaces, uint8_t *links_nr))[6]
+void DMneighborsBegin(struct DMneighborCursor *cursor)
 {
-    uint8_t i;
-    uint8_t total;
+    _cursorBeginDevice(cursor, local_device);
+}
 
-    uint8_t (*ret)[6];
-    char  **intfs;
-    struct alDevice *neighbor = alDeviceFind(neighbor_al_mac_address);
-    struct interface *interface;
+uint8_t *DMneighborsNext(struct DMneighborCursor *cursor)
+{
+    struct interface *neighbor_interface;
 
-    if (neighbor == NULL)
+    while (NULL != (neighbor_interface = _cursorNext(cursor)))
     {
-        // Non-existent neighbor
-        *interfaces = NULL;
-        *links_nr = 0;
-        return NULL;
-    }
+        struct DMneighborCursor  previous;
+        struct interface        *x;
+        bool                     already_reported = false;
 
-    total = 0;
-    ret   = NULL;
-    intfs = NULL;
+        if (NULL == neighbor_interface->owner)
+        {
+            // Non-1905 neighbor
+            //
+            continue;
+        }
 
-    dlist_for_each(interface, neighbor->interfaces, l)
-    {
-        for (i = 0; i < interface->neighbors.length; i++)
+        // Check for duplicates by walking again all the neighbors that come
+        // before this one. There are only a handful of them, and this way
+        // nothing needs to be allocated.
+        //
+        _cursorBeginDevice(&previous, cursor->device);
+        while (NULL != (x = _cursorNext(&previous)) &&
+               (previous.interface != cursor->interface || previous.index != cursor->index))
         {
-            struct interface *local_interface = interface->neighbors.data[i];
-            if (local_interface->owner == local_device)
+            if (x->owner == neighbor_interface->owner)
             {
-                // This is a new link between the local AL and the remote AL.
-                // Add it.
-                //
-                if (NULL == ret)
-                {
-                    ret   = (uint8_t (*)[6])memalloc(sizeof(uint8_t[6]));
-                    intfs = (char **)memalloc(sizeof(char *));
-                }
-                else
-                {
-                    ret   = (uint8_t (*)[6])memrealloc(ret, sizeof(uint8_t[6])*(total + 1));
-                    intfs = (char **)memrealloc(intfs, sizeof(char *)*(total + 1));
-                }
-                memcpy(&ret[total], interface->addr, 6);
-                intfs[total] = local_interface->name;
-
-                total++;
-
+                already_reported = true;
+                break;
             }
         }
+
+        if (!already_reported)
+        {
+            return neighbor_interface->owner->al_mac_addr;
+        }
     }
 
-    *links_nr   = total;
-    *interfaces = intfs;
+    return NULL;
+}
 
-    return ret;
+void DMlinksWithNeighborBegin(struct DMneighborCursor *cursor, uint8_t *neighbor_al_mac_address)
+{
+    _cursorBeginDevice(cursor, alDeviceFind(neighbor_al_mac_address));
 }
 
-void DMfreeListOfLinksWithNeighbor(uint8_t (*p)[6], char **interfaces, uint8_t links_nr)
+uint8_t DMlinksWithNeighborNext(struct DMneighborCursor *cursor, char **local_interface_name, uint8_t **neighbor_interface_address)
 {
-    if (0 == links_nr)
-    {
-        return;
-    }
+    struct interface *local_interface;
 
-    if (NULL != interfaces)
+    if (NULL == local_device)
     {
-        free(interfaces);
+        return 0;
     }
 
-    if (NULL != p)
+    // The neighbor's interfaces are walked: each of their neighbors that
+    // belongs to the local AL is one link.
+    //
+    while (NULL != (local_interface = _cursorNext(cursor)))
     {
-        free(p);
+        if (local_interface->owner == local_device)
+        {
+            *local_interface_name       = (char *)local_interface->name;
+            *neighbor_interface_address = cursor->interface->addr;
+            return 1;
+        }
     }
 
-    return;
+    return 0;
 }
 
 uint8_t DMupdateDiscoveryTimeStamps(uint8_t *receiving_interface_addr, uint8_t *al_mac_address, uint8_t *mac_address, uint8_t timestamp_type, uint32_t *ellapsed)
@@ -468,6 +427,7 @@ uint8_t DMupdateDiscoveryTimeStamps(uint8_t *receiving_interface_addr, uint8_t *
     {
         neighbor = alDeviceAlloc(al_mac_address);
     }
+    neighbor->stale = false;
 
     // Find or create the neighbor interface
     neighbor_interface = alDeviceFindInterface(neighbor, mac_address);
@@ -710,6 +670,7 @@ uint8_t DMupdateNetworkDeviceInfo(uint8_t *al_mac_address,
                                 uint8_t v6_update,  struct ipv6TypeTLV                          *ipv6)
 {
     uint8_t i,j;
+    struct alDevice *device;
 
     if (
          (NULL == al_mac_address)                                                     ||
@@ -723,6 +684,14 @@ uint8_t DMupdateNetworkDeviceInfo(uint8_t *al_mac_address,
         return 0;
     }
 
+    // The device has just told us about itself, so whatever we restored from
+    // a snapshot can be trusted again
+    //
+    if (NULL != (device = alDeviceFind(al_mac_address)))
+    {
+        device->stale = false;
+    }
+
     // First, search for an existing entry with the same AL MAC address
     // Remember that the first entry holds a reference to the *local* node.
     //
@@ -762,6 +731,7 @@ uint8_t DMupdateNetworkDeviceInfo(uint8_t *al_mac_address,
             }
 
             data_model.network_devices[data_model.network_devices_nr].update_timestamp          = PLATFORM_GET_TIMESTAMP();
+            data_model.network_devices[data_model.network_devices_nr].stale                     = 0;
             data_model.network_devices[data_model.network_devices_nr].info                      = 1 == in_update ? info                 : NULL;
             data_model.network_devices[data_model.network_devices_nr].bridges_nr                = 1 == br_update ? bridges_nr           : 0;
             data_model.network_devices[data_model.network_devices_nr].bridges                   = 1 == br_update ? bridges              : NULL;
@@ -797,6 +767,7 @@ uint8_t DMupdateNetworkDeviceInfo(uint8_t *al_mac_address,
         // the old item)
         //
         data_model.network_devices[i].update_timestamp = PLATFORM_GET_TIMESTAMP();
+        data_model.network_devices[i].stale            = 0;
 
         if (NULL != info)
         {
@@ -950,9 +921,13 @@ uint8_t DMnetworkDeviceInfoNeedsUpdate(uint8_t *al_mac_address)
     }
     else
     {
-        // A matching entry was found. Check its timestamp.
+        // A matching entry was found. Check its timestamp (entries restored
+        // from a snapshot must always be refreshed)
         //
-        if (PLATFORM_GET_TIMESTAMP() - data_model.network_devices[i].update_timestamp > MAX_AGE * 1000)
+        if (
+             (1 == data_model.network_devices[i].stale)                                              ||
+             (PLATFORM_GET_TIMESTAMP() - data_model.network_devices[i].update_timestamp > MAX_AGE * 1000)
+           )
         {
             return 1;
         }
@@ -980,7 +955,7 @@ uint8_t DMupdateNetworkDeviceMetrics(uint8_t *metrics)
     // the "from" and the "to" AL MAC addresses).
     // This information is contained inside the 'metrics' structure itself.
     //
-    if (TLV_TYPE_TRANSMITTER_LINK_METRIC == *metrics)
+    if (TLV_TYPE_TRANSMITTER_LINK_METRIC == ((struct tlv *)metrics)->type)
     {
         struct transmitterLinkMetricTLV *p;
 
@@ -990,7 +965,7 @@ uint8_t DMupdateNetworkDeviceMetrics(uint8_t *metrics)
         TO_al_mac_address   = p->neighbor_al_address;
 
     }
-    else if (TLV_TYPE_RECEIVER_LINK_METRIC == *metrics)
+    else if (TLV_TYPE_RECEIVER_LINK_METRIC == ((struct tlv *)metrics)->type)
     {
         struct receiverLinkMetricTLV *p;
 
@@ -1001,7 +976,7 @@ uint8_t DMupdateNetworkDeviceMetrics(uint8_t *metrics)
     }
     else
     {
-        PLATFORM_PRINTF_DEBUG_DETAIL("Invalid 'metrics' argument. Type = %d\n", *metrics);
+        PLATFORM_PRINTF_DEBUG_DETAIL("Invalid 'metrics' argument. Type = %d\n", ((struct tlv *)metrics)->type);
         return 0;
     }
 
@@ -1065,7 +1040,7 @@ uint8_t DMupdateNetworkDeviceMetrics(uint8_t *metrics)
 
         memcpy(data_model.network_devices[i].metrics_with_neighbors[data_model.network_devices[i].metrics_with_neighbors_nr].neighbor_al_mac_address, TO_al_mac_address, 6);
 
-        if (TLV_TYPE_TRANSMITTER_LINK_METRIC == *metrics)
+        if (TLV_TYPE_TRANSMITTER_LINK_METRIC == ((struct tlv *)metrics)->type)
         {
             data_model.network_devices[i].metrics_with_neighbors[data_model.network_devices[i].metrics_with_neighbors_nr].tx_metrics_timestamp = PLATFORM_GET_TIMESTAMP();
             data_model.network_devices[i].metrics_with_neighbors[data_model.network_devices[i].metrics_with_neighbors_nr].tx_metrics           = (struct transmitterLinkMetricTLV*)metrics;
@@ -1089,7 +1064,7 @@ uint8_t DMupdateNetworkDeviceMetrics(uint8_t *metrics)
         // A matching entry was found. Update it. But first, free the old TLV
         // structures.
         //
-        if (TLV_TYPE_TRANSMITTER_LINK_METRIC == *metrics)
+        if (TLV_TYPE_TRANSMITTER_LINK_METRIC == ((struct tlv *)metrics)->type)
         {
             free_1905_TLV_structure(&data_model.network_devices[i].metrics_with_neighbors[j].tx_metrics->tlv);
 
@@ -1128,6 +1103,7 @@ void DMdumpNetworkDevices(void (*write_function)(const char *fmt, ...))
         snprintf(new_prefix, MAX_PREFIX-1, "  device[%d]->", i);
         new_prefix[MAX_PREFIX-1] = 0x0;
         write_function("%supdate timestamp: %d\n", new_prefix, data_model.network_devices[i].update_timestamp);
+        write_function("%sstale: %d\n", new_prefix, data_model.network_devices[i].stale);
 
         snprintf(new_prefix, MAX_PREFIX-1, "  device[%d]->general_info->", i);
         new_prefix[MAX_PREFIX-1] = 0x0;
@@ -1460,7 +1436,10 @@ uint8_t DMrunGarbageCollector(void)
             }
 
             // And also from the local interfaces database
-            alDeviceDelete(alDeviceFind(al_mac_address));
+            if (NULL != alDeviceFind(al_mac_address))
+            {
+                alDeviceDelete(alDeviceFind(al_mac_address));
+            }
         }
 
         if (NULL != p)
@@ -1469,6 +1448,28 @@ uint8_t DMrunGarbageCollector(void)
         }
     }
 
+    // Devices restored from a snapshot that have not shown up since then are
+    // gone. Their "network_devices" entries (if any) have just been removed
+    // above, as nobody updated them either.
+    //
+    if (PLATFORM_GET_TIMESTAMP() - data_model.restore_timestamp > (GC_MAX_AGE*1000))
+    {
+        dlist_item *item = network.next;
+
+        while (item != &network)
+        {
+            struct alDevice *device = container_of(item, struct alDevice, l);
+
+            item = item->next;
+            if (device->stale && device != local_device)
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("Removing stale device (" MACSTR ")\n", MAC2STR(device->al_mac_addr));
+                alDeviceDelete(device);
+                removed_entries++;
+            }
+        }
+    }
+
     // If at least one element was removed, we need to realloc
     //
     if (original_devices_nr != data_model.network_devices_nr)
@@ -1499,14 +1500,20 @@ void DMremoveALNeighborFromInterface(uint8_t *al_mac_address, char *interface_na
     }
     else
     {
-        for (i = 0; i < interface->neighbors.length; i++)
+        i = 0;
+        while (i < interface->neighbors.length)
         {
             neighbor = interface->neighbors.data[i]->owner;
             if (neighbor != NULL && memcmp(neighbor->al_mac_addr, al_mac_address, 6) == 0)
             {
+                // Another neighbor takes this position, so don't move on
                 interfaceRemoveNeighbor(interface, interface->neighbors.data[i]);
                 // @todo shouldn't the neighbor itself be deleted as well if it has no more neighbors?
             }
+            else
+            {
+                i++;
+            }
         }
     }
 }
@@ -1556,3 +1563,311 @@ struct vendorSpecificTLV ***DMextensionsGet(uint8_t *al_mac_address, uint8_t **n
 
     return extensions;
 }
+
+// Return the index of the "network_devices" entry of 'al_mac_address', or
+// "network_devices_nr" if there is none.
+//
+static uint8_t _networkDeviceIndex(const uint8_t *al_mac_address)
+{
+    uint8_t i;
+
+    for (i=0; i<data_model.network_devices_nr; i++)
+    {
+        if (NULL != data_model.network_devices[i].info &&
+            0 == memcmp(data_model.network_devices[i].info->al_mac_address, al_mac_address, 6))
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+// Append the forged version of 'tlv' (if not NULL) to the 'stream' buffer,
+// which is 'stream_len' bytes long and has room for 'stream_size' bytes.
+//
+static void _appendForgedTLV(uint8_t **stream, uint32_t *stream_len, uint32_t *stream_size, struct tlv *tlv)
+{
+    uint8_t  *forged;
+    uint16_t  forged_len;
+
+    if (NULL == tlv)
+    {
+        return;
+    }
+
+    if (NULL == (forged = forge_1905_TLV_from_structure(tlv, &forged_len)))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not forge TLV of type %d. Not saving it...\n", tlv->type);
+        return;
+    }
+
+    if (*stream_len + forged_len > *stream_size)
+    {
+        *stream_size = 2 * (*stream_len + forged_len);
+        *stream      = (uint8_t *)memrealloc(*stream, *stream_size);
+    }
+    memcpy(*stream + *stream_len, forged, forged_len);
+    *stream_len += forged_len;
+
+    free_1905_TLV_packet(forged);
+}
+
+// Add 'tlv' to the dynamically allocated list of TLVs 'list', which contains
+// 'nr' elements.
+//
+static void _addTLVToList(struct tlv ***list, uint8_t *nr, struct tlv *tlv)
+{
+    if (0xff == *nr)
+    {
+        free_1905_TLV_structure(tlv);
+        return;
+    }
+    *list = (struct tlv **)memrealloc(*list, sizeof(struct tlv *) * (*nr + 1));
+    (*list)[(*nr)++] = tlv;
+}
+
+uint8_t *DMnetworkDevicesSave(uint32_t *len)
+{
+    uint8_t  *stream      = NULL;
+    uint32_t  stream_size = 0;
+    uint8_t   i, j;
+
+    *len = 0;
+
+    // Entry "0" is the local device, which is always regenerated on demand,
+    // so it is not saved.
+    //
+    for (i=1; i<data_model.network_devices_nr; i++)
+    {
+        struct _networkDevice *x = &data_model.network_devices[i];
+
+        if (NULL == x->info)
+        {
+            continue;
+        }
+
+        // The "device information" TLV must be the first one of each device:
+        // it marks the start of a new device when the stream is restored.
+        //
+        _appendForgedTLV(&stream, len, &stream_size, &x->info->tlv);
+
+        for (j=0; j<x->bridges_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, &x->bridges[j]->tlv);
+        }
+        for (j=0; j<x->non1905_neighbors_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, &x->non1905_neighbors[j]->tlv);
+        }
+        for (j=0; j<x->x1905_neighbors_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, &x->x1905_neighbors[j]->tlv);
+        }
+        for (j=0; j<x->power_off_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, &x->power_off[j]->tlv);
+        }
+        for (j=0; j<x->l2_neighbors_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, &x->l2_neighbors[j]->tlv);
+        }
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->supported_service ? NULL : &x->supported_service->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->generic_phy       ? NULL : &x->generic_phy->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->profile           ? NULL : &x->profile->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->identification    ? NULL : &x->identification->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->control_url       ? NULL : &x->control_url->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->ipv4              ? NULL : &x->ipv4->tlv);
+        _appendForgedTLV(&stream, len, &stream_size, NULL == x->ipv6              ? NULL : &x->ipv6->tlv);
+
+        // Metrics TLVs contain the AL MAC addresses of both ends, so they
+        // don't depend on the position in the stream.
+        //
+        for (j=0; j<x->metrics_with_neighbors_nr; j++)
+        {
+            _appendForgedTLV(&stream, len, &stream_size, NULL == x->metrics_with_neighbors[j].tx_metrics ? NULL : &x->metrics_with_neighbors[j].tx_metrics->tlv);
+            _appendForgedTLV(&stream, len, &stream_size, NULL == x->metrics_with_neighbors[j].rx_metrics ? NULL : &x->metrics_with_neighbors[j].rx_metrics->tlv);
+        }
+
+        // Extensions are not saved: they are owned by the protocol extenders,
+        // which will fill them in again.
+    }
+
+    return stream;
+}
+
+uint8_t DMnetworkDevicesRestore(const uint8_t *stream, uint32_t len)
+{
+    struct _restoredDevice
+    {
+        struct deviceInformationTypeTLV  *info;
+
+        uint8_t      bridges_nr;            struct tlv **bridges;
+        uint8_t      non1905_neighbors_nr;  struct tlv **non1905_neighbors;
+        uint8_t      x1905_neighbors_nr;    struct tlv **x1905_neighbors;
+        uint8_t      power_off_nr;          struct tlv **power_off;
+        uint8_t      l2_neighbors_nr;       struct tlv **l2_neighbors;
+
+        struct tlv  *supported_service;
+        struct tlv  *generic_phy;
+        struct tlv  *profile;
+        struct tlv  *identification;
+        struct tlv  *control_url;
+        struct tlv  *ipv4;
+        struct tlv  *ipv6;
+
+        uint8_t      metrics_nr;            struct tlv **metrics;
+    } d;
+
+    uint8_t      restored   = 0;
+    uint32_t     offset     = 0;
+    uint8_t      i;
+
+    data_model.restore_timestamp = PLATFORM_GET_TIMESTAMP();
+
+    memset(&d, 0, sizeof(d));
+
+    while (1)
+    {
+        struct tlv *tlv = NULL;
+        uint32_t    tlv_len;
+
+        // Each TLV is "type" (1 byte) + "length" (2 bytes) + "value". Anything
+        // which does not fit in the stream is ignored.
+        //
+        if (offset + 3 <= len)
+        {
+            tlv_len = 3 + ((stream[offset+1] << 8) | stream[offset+2]);
+            if (offset + tlv_len <= len)
+            {
+                tlv     = parse_1905_TLV_from_packet(stream + offset, (uint16_t)(len - offset > 0xffff ? 0xffff : len - offset));
+                offset += tlv_len;
+                if (NULL == tlv)
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Invalid TLV in saved devices database. Ignoring it...\n");
+                    continue;
+                }
+            }
+        }
+
+        if (NULL == tlv || TLV_TYPE_DEVICE_INFORMATION_TYPE == tlv->type)
+        {
+            // End of the previous device. Only add it if nobody told us about
+            // it already.
+            //
+            if (NULL != d.info)
+            {
+                if (
+                     (0xff == data_model.network_devices_nr)                                       ||
+                     (_networkDeviceIndex(d.info->al_mac_address) < data_model.network_devices_nr) ||
+                     (0 == memcmp(d.info->al_mac_address, DMalMacGet(), 6))
+                   )
+                {
+                    free_1905_TLV_structure(&d.info->tlv);
+                    for (i=0; i<d.bridges_nr;           i++) free_1905_TLV_structure(d.bridges[i]);
+                    for (i=0; i<d.non1905_neighbors_nr; i++) free_1905_TLV_structure(d.non1905_neighbors[i]);
+                    for (i=0; i<d.x1905_neighbors_nr;   i++) free_1905_TLV_structure(d.x1905_neighbors[i]);
+                    for (i=0; i<d.power_off_nr;         i++) free_1905_TLV_structure(d.power_off[i]);
+                    for (i=0; i<d.l2_neighbors_nr;      i++) free_1905_TLV_structure(d.l2_neighbors[i]);
+                    for (i=0; i<d.metrics_nr;           i++) free_1905_TLV_structure(d.metrics[i]);
+                    free(d.bridges);
+                    free(d.non1905_neighbors);
+                    free(d.x1905_neighbors);
+                    free(d.power_off);
+                    free(d.l2_neighbors);
+                    free(d.metrics);
+                    free_1905_TLV_structure(d.supported_service);
+                    free_1905_TLV_structure(d.generic_phy);
+                    free_1905_TLV_structure(d.profile);
+                    free_1905_TLV_structure(d.identification);
+                    free_1905_TLV_structure(d.control_url);
+                    free_1905_TLV_structure(d.ipv4);
+                    free_1905_TLV_structure(d.ipv6);
+                }
+                else
+                {
+                    struct alDevice *device;
+
+                    DMupdateNetworkDeviceInfo(d.info->al_mac_address,
+                                              1, d.info,
+                                              1, (struct deviceBridgingCapabilityTLV **)d.bridges,           d.bridges_nr,
+                                              1, (struct non1905NeighborDeviceListTLV **)d.non1905_neighbors, d.non1905_neighbors_nr,
+                                              1, (struct neighborDeviceListTLV **)d.x1905_neighbors,         d.x1905_neighbors_nr,
+                                              1, (struct powerOffInterfaceTLV **)d.power_off,                d.power_off_nr,
+                                              1, (struct l2NeighborDeviceTLV **)d.l2_neighbors,              d.l2_neighbors_nr,
+                                              NULL != d.supported_service, (struct supportedServiceTLV *)d.supported_service,
+                                              NULL != d.generic_phy,       (struct genericPhyDeviceInformationTypeTLV *)d.generic_phy,
+                                              NULL != d.profile,           (struct x1905ProfileVersionTLV *)d.profile,
+                                              NULL != d.identification,    (struct deviceIdentificationTypeTLV *)d.identification,
+                                              NULL != d.control_url,       (struct controlUrlTypeTLV *)d.control_url,
+                                              NULL != d.ipv4,              (struct ipv4TypeTLV *)d.ipv4,
+                                              NULL != d.ipv6,              (struct ipv6TypeTLV *)d.ipv6);
+
+                    // "DMupdateNetworkDeviceInfo()" considers the device as
+                    // confirmed. It isn't.
+                    //
+                    data_model.network_devices[data_model.network_devices_nr-1].stale = 1;
+                    if (NULL != (device = alDeviceFind(d.info->al_mac_address)))
+                    {
+                        device->stale = true;
+                    }
+                    restored++;
+
+                    // Metrics can only be added once the device exists
+                    //
+                    for (i=0; i<d.metrics_nr; i++)
+                    {
+                        if (0 == DMupdateNetworkDeviceMetrics((uint8_t *)d.metrics[i]))
+                        {
+                            free_1905_TLV_structure(d.metrics[i]);
+                        }
+                    }
+                    free(d.metrics);
+                }
+                memset(&d, 0, sizeof(d));
+            }
+
+            if (NULL == tlv)
+            {
+                break;
+            }
+            d.info = (struct deviceInformationTypeTLV *)tlv;
+            continue;
+        }
+
+        if (NULL == d.info)
+        {
+            // Not preceded by a "device information" TLV
+            //
+            free_1905_TLV_structure(tlv);
+            continue;
+        }
+
+        switch (tlv->type)
+        {
+            case TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES:  _addTLVToList(&d.bridges,           &d.bridges_nr,           tlv); break;
+            case TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST: _addTLVToList(&d.non1905_neighbors, &d.non1905_neighbors_nr, tlv); break;
+            case TLV_TYPE_NEIGHBOR_DEVICE_LIST:          _addTLVToList(&d.x1905_neighbors,   &d.x1905_neighbors_nr,   tlv); break;
+            case TLV_TYPE_POWER_OFF_INTERFACE:           _addTLVToList(&d.power_off,         &d.power_off_nr,         tlv); break;
+            case TLV_TYPE_L2_NEIGHBOR_DEVICE:            _addTLVToList(&d.l2_neighbors,      &d.l2_neighbors_nr,      tlv); break;
+            case TLV_TYPE_TRANSMITTER_LINK_METRIC:
+            case TLV_TYPE_RECEIVER_LINK_METRIC:          _addTLVToList(&d.metrics,           &d.metrics_nr,           tlv); break;
+
+            case TLV_TYPE_SUPPORTED_SERVICE:             free_1905_TLV_structure(d.supported_service); d.supported_service = tlv; break;
+            case TLV_TYPE_GENERIC_PHY_DEVICE_INFORMATION:free_1905_TLV_structure(d.generic_phy);       d.generic_phy       = tlv; break;
+            case TLV_TYPE_1905_PROFILE_VERSION:          free_1905_TLV_structure(d.profile);           d.profile           = tlv; break;
+            case TLV_TYPE_DEVICE_IDENTIFICATION:         free_1905_TLV_structure(d.identification);    d.identification    = tlv; break;
+            case TLV_TYPE_CONTROL_URL:                   free_1905_TLV_structure(d.control_url);       d.control_url       = tlv; break;
+            case TLV_TYPE_IPV4:                          free_1905_TLV_structure(d.ipv4);              d.ipv4              = tlv; break;
+            case TLV_TYPE_IPV6:                          free_1905_TLV_structure(d.ipv6);              d.ipv6              = tlv; break;
+
+            default:
+            {
+                PLATFORM_PRINTF_DEBUG_WARNING("Unexpected TLV (%d) in saved devices database. Ignoring it...\n", tlv->type);
+                free_1905_TLV_structure(tlv);
+                break;
+            }
+        }
+    }
+
+    return restored;
+}
@@ -56,27 +56,55 @@ const char *DMmacToInterfaceName(const uint8_t *mac_address);
 uint8_t *DMinterfaceNameToMac(const char *interface_name);
 
 
-// Returns a list of 6 bytes arrays with the AL MACs of all neighbors (on the
-// provided interface) from where a "topology discovery" message has been
-// received.
+// The following functions walk the neighbors of the local AL directly in the
+// data model, so that building a response does not need to allocate (and
+// free) temporary lists.
 //
-// The returned pointer, once it is no longer needed, must be freed by the
-// caller with "free()"
+// All of them use a cursor, which is initialized with the "...Begin()"
+// function and then passed to the "...Next()" function until it reports that
+// there are no more elements. The data model must not be modified while a
+// cursor is in use. Example:
 //
-uint8_t (*DMgetListOfInterfaceNeighbors(char *local_interface_name, uint8_t *al_mac_addresses_nr))[6];
+//   struct DMneighborCursor cursor;
+//   uint8_t *al_mac_address;
+//
+//   DMneighborsBegin(&cursor);
+//   while (NULL != (al_mac_address = DMneighborsNext(&cursor)))
+//   {
+//       <use it...>
+//   }
+//
+// The returned pointers point into the data model: they must not be freed and
+// they are only valid until the data model is modified.
+//
+struct alDevice;
+struct interface;
+
+struct DMneighborCursor
+{
+    struct alDevice  *device;     // Device whose interfaces are walked (NULL
+                                  // if only 'interface' is walked)
+    struct interface *interface;  // Interface whose neighbors are walked
+    unsigned          index;      // Next position in 'interface->neighbors'
+};
 
-// Returns a list of 6 bytes arrays with the AL MACs of all neighbors (from
-// *all* interfaces) from where a "topology discovery" message has been
-// received.
+// Walk the AL MACs of all neighbors (on the provided interface) from where a
+// "topology discovery" message has been received.
 //
-// Each neighbor is reported at most once, even if it is reachable from
-// different interfaces. Thus the returned list does not contain repeated
-// elements.
+// A neighbor connected through several of its interfaces is reported once per
+// interface.
+//
+void     DMinterfaceNeighborsBegin(struct DMneighborCursor *cursor, const char *local_interface_name);
+uint8_t *DMinterfaceNeighborsNext(struct DMneighborCursor *cursor);
+
+// Walk the AL MACs of all neighbors (from *all* interfaces) from where a
+// "topology discovery" message has been received.
 //
-// The returned pointer, once it is no longer needed, must be freed by the
-// caller with "free()"
+// Each neighbor is reported at most once, even if it is reachable from
+// different interfaces.
 //
-uint8_t (*DMgetListOfNeighbors(uint8_t *al_mac_addresses_nr))[6];
+void     DMneighborsBegin(struct DMneighborCursor *cursor);
+uint8_t *DMneighborsNext(struct DMneighborCursor *cursor);
 
 
 // A given neighbor might be "reachable" in several ways:
@@ -87,14 +115,12 @@ uint8_t (*DMgetListOfNeighbors(uint8_t *al_mac_addresses_nr))[6];
 //   - From several interfaces, each of them connected with one or more remote
 //     interfaces.
 //
-// This function returns all the ways a neighbor is reachable:
-//   - The output argument 'links_nr' contains the number of ways the neighbor
-//     can be reached.
-//   - The output argument 'interfaces' is an array of 'links_nr' pointers to
-//     strings, each of them containing the name of a local interface (ex:
-//     "eth0")
-//   - The returned pointer contains 'links_nr' MAC addresses that correspond to
-//     interfaces in the provided neighbour.
+// These functions walk all the ways a neighbor is reachable. Each call to
+// "DMlinksWithNeighborNext()" returns "1" and sets:
+//   - 'local_interface_name' to the name of a local interface (ex: "eth0")
+//   - 'neighbor_interface_address' to the MAC address of the interface in the
+//     provided neighbor that is connected to it.
+// ...until there are no more links, in which case it returns "0".
 //
 //  So, for example, if we have this:
 //
@@ -107,43 +133,14 @@ uint8_t (*DMgetListOfNeighbors(uint8_t *al_mac_addresses_nr))[6];
 //                                C
 //                           eth1
 //
-//  ...and we are "A", then the following calls will return the following
-//  results:
-//
-//    - DMgetListOfLinkswithNeighbor(B):
-//        ret        = [<B_eth0_addr>, <B_eth1_addr>]
-//        interfaces = ["eth0",        "eth1"]
-//        links_nr   = 2
-//
-//    - DMgetListOfLinkswithNeighbor(C):
-//        ret        = [<C_eth0_addr>]
-//        interfaces = ["eth1"]
-//        links_nr   = 1
-//
-//
-// The returned pointers, once they are no longer needed, must be freed by the
-// caller with "DMfreeListOfLinksWithNeighbor()". Example:
-//
-//   uint8_t (*ret)[6];
-//   char **interfaces;
-//   uint8_t links_nr;
-//
-//   ret = DMgetListOfLinksWithNeighbor(neighbor_al_mac_address, &interfaces, &links_nr);
+//  ...and we are "A", then walking the links with B returns
+//  ("eth0", <B_eth0_addr>) and ("eth1", <B_eth1_addr>), while walking the links
+//  with C returns ("eth1", <C_eth0_addr>).
 //
-//   <use it...>
+// Walking the links with a neighbor that does not exist returns nothing.
 //
-//   DMfreeListOfLinksWithNeighbor(ret, interfaces, links_nr);
-//
-// If there is a problem, this function returns NULL and nothing needs to be
-// freed by the caller
-//
-uint8_t (*DMgetListOfLinksWithNeighbor(uint8_t *neighbor_al_mac_address, char ***interfaces, uint8_t *links_nr))[6];
-
-// Use this to free the two pointers returned by
-// "DMgetListOfInterfaceNeighbors()" (ie. the "interfaces" pointer and the
-// returned value pointer)
-//
-void DMfreeListOfLinksWithNeighbor(uint8_t (*p)[6], char **interfaces, uint8_t links_nr);
+void    DMlinksWithNeighborBegin(struct DMneighborCursor *cursor, uint8_t *neighbor_al_mac_address);
+uint8_t DMlinksWithNeighborNext(struct DMneighborCursor *cursor, char **local_interface_name, uint8_t **neighbor_interface_address);
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -391,5 +388,36 @@ void DMremoveALNeighborFromInterface(uint8_t *al_mac_address, char *interface_na
 //
 struct vendorSpecificTLV ***DMextensionsGet(uint8_t *al_mac_address, uint8_t **nr);
 
+// Serialize the "devices" database (ie. everything that was learned from the
+// other 1905 nodes through "DMupdateNetworkDeviceInfo()" and
+// "DMupdateNetworkDeviceMetrics()") so that it can be saved across restarts.
+//
+// The returned buffer is a sequence of forged TLVs, where each device starts
+// with its "device information" TLV. The local device and the TLV extensions
+// are not included.
+//
+// 'len' is set to the length of the returned buffer, which must be freed by
+// the caller. NULL is returned if there is nothing to save.
+//
+uint8_t *DMnetworkDevicesSave(uint32_t *len);
+
+// Restore the devices contained in a buffer previously returned by
+// "DMnetworkDevicesSave()". Devices which are already known are skipped.
+//
+// Restored entries are marked as stale:
+//
+//   - "DMnetworkDeviceInfoNeedsUpdate()" returns "1" for them until they are
+//     updated again with "DMupdateNetworkDeviceInfo()".
+//
+//   - "DMrunGarbageCollector()" removes them "GC_MAX_AGE" seconds after this
+//     call if that didn't happen. It also removes (at that same point) the
+//     devices of the data model which are still "stale", so this function
+//     must be called after "datamodelSnapshotRestore()" (even with an empty
+//     buffer).
+//
+// Returns the number of restored devices.
+//
+uint8_t DMnetworkDevicesRestore(const uint8_t *stream, uint32_t len);
+
 #endif
 
@@ -39,11 +39,19 @@
 #include "al_recv.h"
 #include "al_utils.h"
 #include "al_extension.h"
+#include "topology_snapshot.h"
+#include "al_link_metrics.h"
+#include "al_tx_scheduler.h"
+#include "al_requests.h"
+#include "al_cmdu_stats.h"
 
 #include <datamodel.h>
+#include <datamodel_shm.h>
+#include <pool.h>
 
 #include "platform_interfaces.h"
 #include "platform_os.h"
+#include "platform_crypto.h"
 #include "platform_alme_server.h"
 #include "linux/platform_uci.h"
 
@@ -55,6 +63,11 @@
 
 #define TIMER_TOKEN_DISCOVERY          (1)
 #define TIMER_TOKEN_GARBAGE_COLLECTOR  (2)
+#define TIMER_TOKEN_TOPOLOGY_SNAPSHOT  (3)
+#define TIMER_TOKEN_LINK_METRICS       (4)
+#define TIMER_TOKEN_TX_SCHEDULER       (5)
+#define TIMER_TOKEN_REQUESTS           (6)
+#define TIMER_TOKEN_CMDU_STATS         (7)
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -84,8 +97,8 @@
 // Every time this function is called, two things can happen:
 //
 //   1. The just received fragment was the last one needed to complete a CMDU.
-//      In this case, the CMDU structure result of all those fragments being
-//      parsed is returned.
+//      In this case, the CMDU view (see "parse_1905_CMDU_view_from_packets()")
+//      result of all those fragments being parsed is returned.
 //
 //   2. The just received fragment is not yet the last one needed to complete a
 //      CMDU. In this case the fragment is internally buffered (ie. the caller
@@ -99,7 +112,7 @@
 //
 //   - 'len' is the length of this 'packet_buffer' in bytes
 //
-struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t len)
+struct CMDU_view *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t len)
 {
     #define MAX_MIDS_IN_FLIGHT     5
     #define MAX_FRAGMENTS_PER_MID  3
@@ -147,6 +160,10 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
                        // which a fragment was received (so that we can free
                        // it when the CMDUs buffer is full)
 
+        uint32_t first_fragment_us;
+                       // When the first fragment was received (only set when
+                       // statistics are enabled, see "al_cmdu_stats.h")
+
     } mids_in_flight[MAX_MIDS_IN_FLIGHT] = \
     {[ 0 ... MAX_MIDS_IN_FLIGHT-1 ] = (struct _midsInFlight) { .in_use = 0 }};
 
@@ -155,6 +172,7 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
     uint8_t  i, j;
     const uint8_t *p;
     struct CMDU_header cmdu_header;
+    uint32_t start;
 
     if (!parse_1905_CMDU_header_from_packet(packet_buffer, len, &cmdu_header))
     {
@@ -168,6 +186,21 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
     p = packet_buffer + (6+6+2);
     len -= (6+6+2);
 
+    // Most CMDUs fit in a single packet. These don't need to be buffered: they
+    // can be parsed right away from the received stream.
+    //
+    if (0 == cmdu_header.fragment_id && 1 == cmdu_header.last_fragment_indicator)
+    {
+        uint8_t *streams[2] = {(uint8_t *)p, NULL};
+        struct CMDU_view *c;
+
+        start = cmduStatsClock();
+        c = parse_1905_CMDU_view_from_packets(streams);
+        cmduStatsElapsed(cmdu_header.message_type, CMDU_STATS_STAGE_PARSE, start);
+
+        return c;
+    }
+
     // Find the set of streams associated to this 'mid' and add the just
     // received stream to its set of streams
     //
@@ -329,7 +362,8 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
               //       received yet.
         }
 
-        mids_in_flight[i].age = current_age++;
+        mids_in_flight[i].age               = current_age++;
+        mids_in_flight[i].first_fragment_us = cmduStatsClock();
     }
 
     // At this point we have an entry in the 'mids_in_flight' array (entry 'i')
@@ -343,7 +377,7 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
     //
     if (MAX_FRAGMENTS_PER_MID != mids_in_flight[i].last_fragment)
     {
-        struct CMDU *c;
+        struct CMDU_view *c;
 
         for (j=0; j<=mids_in_flight[i].last_fragment; j++)
         {
@@ -354,7 +388,11 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
             }
         }
 
-        c = parse_1905_CMDU_from_packets(mids_in_flight[i].streams);
+        cmduStatsElapsed(cmdu_header.message_type, CMDU_STATS_STAGE_REASSEMBLY, mids_in_flight[i].first_fragment_us);
+
+        start = cmduStatsClock();
+        c = parse_1905_CMDU_view_from_packets(mids_in_flight[i].streams);
+        cmduStatsElapsed(cmdu_header.message_type, CMDU_STATS_STAGE_PARSE, start);
 
         if (NULL == c)
         {
@@ -362,7 +400,7 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
         }
         else
         {
-            PLATFORM_PRINTF_DEBUG_DETAIL("All fragments belonging to this CMDU have already been received and the CMDU structure is ready\n");
+            PLATFORM_PRINTF_DEBUG_DETAIL("All fragments belonging to this CMDU have already been received and the CMDU view is ready\n");
         }
 
         for (j=0; j<=mids_in_flight[i].last_fragment; j++)
@@ -409,7 +447,7 @@ struct CMDU *_reAssembleFragmentedCMDUs(const uint8_t *packet_buffer, uint16_t l
 //   2. Otherwise, the entry is added (discarding, if needed, the oldest entry)
 //      and this function returns '0'
 //
-uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU *c)
+uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU_view *c)
 {
     #define MAX_DUPLICATES_LOG_ENTRIES 10
 
@@ -432,7 +470,7 @@ uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU *c)
         CMDU_TYPE_GENERIC_PHY_RESPONSE            == c->message_type
       )
     {
-        // This is a "hack" until a better way to handle MIDs is found.
+        // Responses are special.
         //
         // Let me explain.
         //
@@ -462,11 +500,12 @@ uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU *c)
         // HOWEVER, because of what "AL 2" learnt in "t=2", this response will
         // be discarded!
         //
-        // In oder words... until the standard clarifies how MIDs should be
-        // generated to avoid this problem, we will just accept (and process)
-        // all response messages... even if they are duplicates.
+        // In oder words... responses cannot be checked against the log of
+        // received MIDs. Instead, they are matched against the queries we
+        // have sent (see "al_requests.h"): a second response to the same query
+        // is discarded, and responses we know nothing about are processed.
         //
-        return 0;
+        return REQUEST_RESPONSE_DUPLICATE == requestResponseReceived(src_mac_address, c->message_type, c->message_id) ? 1 : 0;
     }
 
     // For relayed CMDUs, use the AL MAC, otherwise use the ethernet src MAC.
@@ -474,20 +513,13 @@ uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU *c)
     memcpy(mac_address, src_mac_address, 6);
     if (1 == c->relay_indicator)
     {
-        uint8_t i;
-        struct tlv *p;
+        const uint8_t *al_mac_address;
+        uint16_t       al_mac_address_len;
 
-        i = 0;
-        while (NULL != (p = c->list_of_TLVs[i]))
+        al_mac_address = get_1905_CMDU_view_TLV(c, TLV_TYPE_AL_MAC_ADDRESS_TYPE, 0, &al_mac_address_len);
+        if (NULL != al_mac_address && 6 == al_mac_address_len)
         {
-            if (TLV_TYPE_AL_MAC_ADDRESS_TYPE == p->type)
-            {
-                struct alMacAddressTypeTLV *t = (struct alMacAddressTypeTLV *)p;
-
-                memcpy(mac_address, t->al_mac_address, 6);
-                break;
-            }
-            i++;
+            memcpy(mac_address, al_mac_address, 6);
         }
     }
 
@@ -556,18 +588,22 @@ uint8_t _checkDuplicates(uint8_t *src_mac_address, struct CMDU *c)
 // bit set, after processing, we must forward it on all authenticated 1905
 // interfaces (except on the one where it was received).
 //
-// This function checks if the provided 'c' structure has that "relayed
-// multicast" flag set and, if so, retransmits it on all local interfaces
-// (except for the one whose MAC address matches 'receiving_interface_addr') to
+// This function checks if the provided 'v' view has that "relayed multicast"
+// flag set and, if so, retransmits it on all local interfaces (except for the
+// one whose MAC address matches 'receiving_interface_addr') to
 // 'destination_mac_addr' and the same "message id" (MID) as the one contained
-// in the originally received 'c' structure.
+// in the originally received 'v' view.
+//
+// The TLVs are only decoded (so that the CMDU can be forged again) if there is
+// at least one interface to forward it on.
 //
-void _checkForwarding(uint8_t *receiving_interface_addr, uint8_t *destination_mac_addr, struct CMDU *c)
+void _checkForwarding(uint8_t *receiving_interface_addr, uint8_t *destination_mac_addr, struct CMDU_view *v)
 {
     uint8_t i;
 
-    if (c->relay_indicator)
+    if (v->relay_indicator)
     {
+        struct CMDU *c = NULL;
         char **ifs_names;
         uint8_t  ifs_nr;
 
@@ -618,7 +654,7 @@ void _checkForwarding(uint8_t *receiving_interface_addr, uint8_t *destination_ma
 
             // Retransmit message
             //
-            switch (c->message_type)
+            switch (v->message_type)
             {
                 case CMDU_TYPE_TOPOLOGY_DISCOVERY:
                 {
@@ -693,12 +729,19 @@ void _checkForwarding(uint8_t *receiving_interface_addr, uint8_t *destination_ma
             }
             PLATFORM_PRINTF_DEBUG_INFO("--> %s (forwarding from %s to %s)\n", aux, DMmacToInterfaceName(receiving_interface_addr), ifs_names[i]);
 
-            if (0 == send1905RawPacket(ifs_names[i], c->message_id, destination_mac_addr, c))
+            if (NULL == c && NULL == (c = convert_1905_CMDU_view_to_structure(v)))
+            {
+                PLATFORM_PRINTF_DEBUG_WARNING("Malformed 1905 message. Not forwarding it.\n");
+                break;
+            }
+
+            if (0 == send1905RawPacket(ifs_names[i], v->message_id, destination_mac_addr, c))
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Could not retransmit 1905 message on interface %s\n", x->name);
             }
         }
         free_LIST_OF_1905_INTERFACES(ifs_names, ifs_nr);
+        free_1905_CMDU_structure(c);
     }
 
     return;
@@ -853,6 +896,207 @@ void _triggerAPSearchProcess(void)
     free_LIST_OF_1905_INTERFACES(ifs_names, ifs_nr);
 }
 
+// This function applies to the data model a change reported by the Wi-Fi
+// driver through a "PLATFORM_QUEUE_EVENT_RADIO_CHANGE" message (see
+// "platform_os.h"). 'p' points to the message payload (ie. right after the
+// length).
+//
+// Changes that refer to interfaces or radios we don't know about are ignored.
+//
+void _processRadioChange(const uint8_t *p)
+{
+    uint8_t      type;
+    uint32_t     radio_index;
+    mac_address  interface_addr;
+    mac_address  station_addr;
+    uint16_t     freq;
+    uint8_t      role;
+
+    struct interface      *interface;
+    struct interfaceWifi  *interface_wifi = NULL;
+    struct radio          *radio;
+    unsigned               i;
+
+    _E1B(&p, &type);
+    _E4B(&p, &radio_index);
+    _EnB(&p, interface_addr, 6);
+    _EnB(&p, station_addr,   6);
+    _E2B(&p, &freq);
+    _E1B(&p, &role);
+
+    interface = alDeviceFindInterface(local_device, interface_addr);
+    if (NULL != interface && interface_type_wifi == interface->type)
+    {
+        interface_wifi = container_of(interface, struct interfaceWifi, i);
+    }
+
+    switch (type)
+    {
+        case PLATFORM_RADIO_CHANGE_STATION_ADDED:
+        case PLATFORM_RADIO_CHANGE_STATION_REMOVED:
+        {
+            if (NULL == interface_wifi || interface_wifi_role_ap != interface_wifi->role)
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("Station " MACSTR " event on unknown AP " MACSTR "\n",
+                                             MAC2STR(station_addr), MAC2STR(interface_addr));
+                break;
+            }
+
+            if (PLATFORM_RADIO_CHANGE_STATION_ADDED == type)
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("Station " MACSTR " associated to " MACSTR "\n",
+                                           MAC2STR(station_addr), MAC2STR(interface_addr));
+                interfaceWifiAddClient(interface_wifi, station_addr);
+            }
+            else
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("Station " MACSTR " disassociated from " MACSTR "\n",
+                                           MAC2STR(station_addr), MAC2STR(interface_addr));
+                interfaceWifiRemoveClient(interface_wifi, station_addr);
+            }
+            break;
+        }
+
+        case PLATFORM_RADIO_CHANGE_CHANNEL_SWITCH:
+        {
+            struct radioChannel *channel;
+
+            if (NULL == interface_wifi || NULL == interface_wifi->radio)
+            {
+                break;
+            }
+            radio = interface_wifi->radio;
+
+            channel = radioFindChannel(radio, freq);
+            if (NULL == channel)
+            {
+                PLATFORM_PRINTF_DEBUG_WARNING("Radio %s switched to unsupported frequency %u\n", radio->name, freq);
+                break;
+            }
+            PLATFORM_PRINTF_DEBUG_INFO("Radio %s switched to channel %u\n", radio->name, channel->id);
+
+            // All the BSSes of a radio share the same channel
+            //
+            for (i = 0; i < radio->configured_bsses.length; i++)
+            {
+                radio->configured_bsses.data[i]->channel = channel;
+            }
+            datamodelChanged();
+            break;
+        }
+
+        case PLATFORM_RADIO_CHANGE_INTERFACE_ADDED:
+        {
+            radio = findLocalRadioByIndex(radio_index);
+            if (NULL == radio)
+            {
+                PLATFORM_PRINTF_DEBUG_WARNING("New interface " MACSTR " on unknown radio %u\n",
+                                              MAC2STR(interface_addr), radio_index);
+                break;
+            }
+            if (NULL != interface && NULL == interface_wifi)
+            {
+                break;
+            }
+
+            if (NULL == interface_wifi)
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("New interface " MACSTR " on radio %s\n", MAC2STR(interface_addr), radio->name);
+                interface_wifi = interfaceWifiAlloc(interface_addr, local_device);
+                interface_wifi->i.power_state = interface_power_state_on;
+            }
+            if (NULL == interface_wifi->radio)
+            {
+                radioAddInterfaceWifi(radio, interface_wifi);
+            }
+
+            switch (role)
+            {
+                case IEEE80211_ROLE_AP:
+                    interface_wifi->role = interface_wifi_role_ap;
+                    break;
+                case IEEE80211_ROLE_NON_AP_NON_PCP_STA:
+                    interface_wifi->role = interface_wifi_role_sta;
+                    break;
+                default:
+                    interface_wifi->role = interface_wifi_role_other;
+                    break;
+            }
+            datamodelChanged();
+            break;
+        }
+
+        case PLATFORM_RADIO_CHANGE_INTERFACE_REMOVED:
+        {
+            if (NULL == interface_wifi)
+            {
+                break;
+            }
+            PLATFORM_PRINTF_DEBUG_INFO("Interface " MACSTR " removed\n", MAC2STR(interface_addr));
+
+            if (NULL != interface->name)
+            {
+                // This is one of the 1905 interfaces we were started with. It
+                // is still referenced by name elsewhere, so keep it but mark
+                // it as down.
+                //
+                interface->power_state = interface_power_state_off;
+                datamodelChanged();
+            }
+            else if (NULL != interface_wifi->radio)
+            {
+                interfaceWifiRemove(interface_wifi);
+            }
+            else
+            {
+                interfaceDelete(interface);
+            }
+            break;
+        }
+
+        default:
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Unknown radio change type (%d)\n", type);
+            break;
+        }
+    }
+}
+
+// Callback for "pool_for_each()" that prints the statistics of one pool
+//
+static void _printPoolStats(const struct pool *pool, void *ctx)
+{
+    (void)ctx;
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("  pool %-24s live=%zu peak=%zu allocated=%zu bytes\n",
+                                 pool->name, pool->stats.live, pool->stats.peak, pool->stats.allocated_bytes);
+}
+
+// Print the statistics of the TX scheduler
+//
+static void _printTxSchedulerStats(void)
+{
+    struct txSchedulerStats stats;
+
+    txSchedulerStatsGet(&stats);
+    PLATFORM_PRINTF_DEBUG_DETAIL("  TX scheduler sent=%u deferred=%u coalesced=%u dropped=%u pending=%u/%u/%u peak=%u\n",
+                                 stats.sent, stats.deferred, stats.coalesced, stats.dropped,
+                                 stats.pending[TX_PRIORITY_CONTROL], stats.pending[TX_PRIORITY_QUERY],
+                                 stats.pending[TX_PRIORITY_DISCOVERY], stats.peak_pending);
+}
+
+// Print the statistics of the queries sent to other ALs
+//
+static void _printRequestStats(void)
+{
+    struct requestStats stats;
+
+    requestStatsGet(&stats);
+    PLATFORM_PRINTF_DEBUG_DETAIL("  Queries sent=%u merged=%u answered=%u retries=%u timeouts=%u duplicates=%u unsolicited=%u outstanding=%u\n",
+                                 stats.sent, stats.merged, stats.answered, stats.retries, stats.timeouts, stats.duplicates,
+                                 stats.unsolicited, stats.outstanding);
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions
@@ -862,6 +1106,12 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
 {
     uint8_t   queue_id;
     uint8_t  *queue_message;
+    uint8_t   tx_timer_armed = 0;
+    uint32_t  tx_wait;
+    uint32_t  requests_timer_deadline = 0;
+    uint32_t  requests_wait;
+
+    struct queueStats queue_stats;
 
     uint8_t i;
     struct interface *interface;
@@ -993,6 +1243,38 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
         }
     }
 
+    // As a registrar, we might have to answer many M1 messages at the same
+    // time (ex: when all the agents boot after a power outage). Keep some DH
+    // key pairs ready for the M2 responses. Agents only need one key pair per
+    // radio, so they keep generating them on demand.
+    //
+    if (registrarIsLocal())
+    {
+        PLATFORM_PRINTF_DEBUG_DETAIL("Pre-generating DH key pairs...\n");
+        if (0 == PLATFORM_PREGENERATE_DH_KEY_PAIRS())
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Could not pre-generate DH key pairs\n");
+        }
+    }
+
+    // Start from the view of the network saved by a previous instance (if
+    // any). It is revalidated as soon as discovery starts.
+    //
+    if (NULL != topologySnapshotPathGet())
+    {
+        PLATFORM_PRINTF_DEBUG_DETAIL("Loading topology snapshot...\n");
+        topologySnapshotLoad();
+    }
+
+    // Export the data model to local HLEs through shared memory. This is
+    // optional: if it fails, HLEs can still use the ALME interface.
+    //
+    PLATFORM_PRINTF_DEBUG_DETAIL("Exporting data model in shared memory...\n");
+    if (!datamodelShmInit())
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not export data model in shared memory\n");
+    }
+
     // Create a queue that will later be used by the platform code to notify us
     // when certain types of "events" take place
     //
@@ -1003,6 +1285,21 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
         PLATFORM_PRINTF_DEBUG_ERROR("Could not create events queue\n");
         return AL_ERROR_OS;
     }
+    if (cmdu_stats_enabled)
+    {
+        PLATFORM_ENABLE_QUEUE_STATS(queue_id);
+    }
+
+    // We want to know when we are asked to terminate, to save our state
+    // first. This must be registered before any other event (see
+    // "platform_os.h").
+    //
+    PLATFORM_PRINTF_DEBUG_DETAIL("Registering the SHUTDOWN event...\n");
+    if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_SHUTDOWN, NULL))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("Could not register 'shutdown' event\n");
+        return AL_ERROR_OS;
+    }
 
     // We are interested in processing 1905 packets that arrive on any of the
     // 1905 interfaces.
@@ -1061,6 +1358,63 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
         }
     }
 
+    // ...and, if enabled, a timer to save the topology snapshot from time to
+    // time (so that we don't lose everything if we are killed without notice)
+    //
+    if (NULL != topologySnapshotPathGet())
+    {
+        struct eventTimeOut aux;
+
+        PLATFORM_PRINTF_DEBUG_DETAIL("Registering TOPOLOGY SNAPSHOT time out event (periodic)...\n");
+
+        aux.timeout_ms = TOPOLOGY_SNAPSHOT_PERIOD;
+        aux.token      = TIMER_TOKEN_TOPOLOGY_SNAPSHOT;
+
+        if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_TIMEOUT_PERIODIC, &aux))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Could not register timer callback\n");
+            return AL_ERROR_OS;
+        }
+    }
+
+    // ...and, if the link metrics cache is enabled, a timer to refresh the
+    // links that are being polled (and forget the ones that are not)
+    //
+    if (0 != linkMetricsCacheValidityGet())
+    {
+        struct eventTimeOut aux;
+
+        PLATFORM_PRINTF_DEBUG_DETAIL("Registering LINK METRICS time out event (periodic)...\n");
+
+        aux.timeout_ms = linkMetricsCacheValidityGet();
+        aux.token      = TIMER_TOKEN_LINK_METRICS;
+
+        if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_TIMEOUT_PERIODIC, &aux))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Could not register timer callback\n");
+            return AL_ERROR_OS;
+        }
+    }
+
+    // ...and, if the per message type statistics are enabled, a timer to log
+    // them
+    //
+    if (0 != cmduStatsPeriodGet())
+    {
+        struct eventTimeOut aux;
+
+        PLATFORM_PRINTF_DEBUG_DETAIL("Registering CMDU STATS time out event (periodic)...\n");
+
+        aux.timeout_ms = cmduStatsPeriodGet();
+        aux.token      = TIMER_TOKEN_CMDU_STATS;
+
+        if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_TIMEOUT_PERIODIC, &aux))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Could not register timer callback\n");
+            return AL_ERROR_OS;
+        }
+    }
+
     // As soon as we enter the queue message processing loop we want to start
     // the discovery process as if a "DISCOVERY timeout" event had just
     // happened.
@@ -1125,6 +1479,26 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
         return AL_ERROR_OS;
     }
 
+    // ...and the "crypto job done" event, so that the slow WSC operations can
+    // be run in the background. If this fails, they are simply run from this
+    // thread.
+    //
+    PLATFORM_PRINTF_DEBUG_DETAIL("Registering the CRYPTO JOB DONE event...\n");
+    if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE, NULL))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not register 'crypto job done' event. Crypto jobs will block the AL.\n");
+    }
+
+    // ...and the "radio change" event, so that the data model follows the
+    // local stations, channels and Wi-Fi interfaces as they change. Not all
+    // platforms have Wi-Fi radios, so this is not fatal either.
+    //
+    PLATFORM_PRINTF_DEBUG_DETAIL("Registering the RADIO CHANGE event...\n");
+    if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_RADIO_CHANGE, NULL))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not register 'radio change' event\n");
+    }
+
     // Any third-party software based on ieee1905 can extend the protocol
     // behaviour
     //
@@ -1138,6 +1512,7 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
     //
     PLATFORM_PRINTF_DEBUG_DETAIL("Allocating memory to hold a queue message...\n");
     queue_message = (uint8_t *)memalloc(MAX_NETWORK_SEGMENT_SIZE+3);
+    memset(&queue_stats, 0, sizeof(queue_stats));
 
     PLATFORM_PRINTF_DEBUG_DETAIL("Entering read-process loop...\n");
     while(1)
@@ -1161,6 +1536,23 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
         _E1B(&p, &message_type);
         _E2B(&p, &message_len);
 
+        if (cmdu_stats_enabled && PLATFORM_GET_QUEUE_STATS(queue_id, &queue_stats))
+        {
+            cmduStatsQueue(&queue_stats);
+        }
+
+        // Platform events (other than timers, received packets and crypto
+        // jobs, which only affect the local topology through the data model)
+        // may change what we report in the "topology response"
+        //
+        if (PLATFORM_QUEUE_EVENT_NEW_1905_PACKET  != message_type &&
+            PLATFORM_QUEUE_EVENT_TIMEOUT          != message_type &&
+            PLATFORM_QUEUE_EVENT_TIMEOUT_PERIODIC != message_type &&
+            PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE  != message_type)
+        {
+            invalidateTopologyResponse();
+        }
+
         switch(message_type)
         {
             case PLATFORM_QUEUE_EVENT_NEW_1905_PACKET:
@@ -1216,6 +1608,19 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                 PLATFORM_PRINTF_DEBUG_DETAIL("    Src address: %02x:%02x:%02x:%02x:%02x:%02x\n", src_addr[0], src_addr[1], src_addr[2], src_addr[3], src_addr[4], src_addr[5]);
                 PLATFORM_PRINTF_DEBUG_DETAIL("    Ether type : 0x%04x\n", ether_type);
 
+                if (cmdu_stats_enabled)
+                {
+                    uint16_t stats_type;
+
+                    // The CMDU message type comes right after the 2 bytes of
+                    // the message version and the reserved field
+                    //
+                    stats_type = ETHERTYPE_1905 == ether_type ? (q[2] << 8) | q[3] : CMDU_STATS_TYPE_LLDP;
+
+                    cmduStatsFrame(stats_type, CMDU_STATS_RX, message_len - 6);
+                    cmduStatsSample(stats_type, CMDU_STATS_STAGE_QUEUE, queue_stats.last_wait_us);
+                }
+
                 switch(ether_type)
                 {
                     case ETHERTYPE_LLDP:
@@ -1245,10 +1650,13 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
 
                     case ETHERTYPE_1905:
                     {
-                        struct CMDU *c;
+                        struct CMDU_view *c;
+                        unsigned long     allocations;
 
                         PLATFORM_PRINTF_DEBUG_DETAIL("CMDU message received. Reassembling...\n");
 
+                        allocations = memalloc_count;
+
                         c = _reAssembleFragmentedCMDUs(p, message_len);
 
                         if (NULL == c)
@@ -1267,14 +1675,14 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                             }
                             else
                             {
-                                uint8_t res;
-
-                                PLATFORM_PRINTF_DEBUG_DETAIL("CMDU message contents:\n");
-                                visit_1905_CMDU_structure(c, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+                                uint8_t  res;
+                                uint32_t start;
 
                                 // Process the message on the local node
                                 //
-                                res = process1905Cmdu(c, receiving_interface_addr, src_addr, queue_id);
+                                start = cmduStatsClock();
+                                res = process1905CmduView(c, receiving_interface_addr, src_addr, queue_id);
+                                cmduStatsElapsed(c->message_type, CMDU_STATS_STAGE_PROCESS, start);
                                 if (PROCESS_CMDU_OK_TRIGGER_AP_SEARCH == res)
                                 {
                                     _triggerAPSearchProcess();
@@ -1287,7 +1695,9 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                                 _checkForwarding(receiving_interface_addr, dst_addr, c);
                             }
 
-                            free_1905_CMDU_structure(c);
+                            cmduStatsAllocations(c->message_type, memalloc_count - allocations);
+
+                            free_1905_CMDU_view(c);
                         }
 
                         break;
@@ -1317,11 +1727,16 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                 uint8_t   alme_client_id;
                 uint8_t  *alme_tlv;
 
+                if (message_len < 1)
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Empty ALME message. Ignoring...\n");
+                    break;
+                }
                 _E1B(&p, &alme_client_id);
 
                 PLATFORM_PRINTF_DEBUG_DETAIL("New queue message arrived: ALME message (client ID = %d).\n", alme_client_id);
 
-                alme_tlv = parse_1905_ALME_from_packet(p);
+                alme_tlv = parse_1905_ALME_from_packet(p, message_len - 1);
                 if (NULL == alme_tlv)
                 {
                     PLATFORM_PRINTF_DEBUG_WARNING("Invalid ALME message. Ignoring...\n");
@@ -1414,14 +1829,24 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                                 PLATFORM_PRINTF_DEBUG_WARNING("Could not send LLDP bridge discovery message\n");
                             }
                         }
+                        discoveryTemplatesPrune(ifs_names, ifs_nr);
                         free_LIST_OF_1905_INTERFACES(ifs_names, ifs_nr);
 
+                        // Not everything in the data model bumps its
+                        // generation (e.g. discovery timestamps), so refresh
+                        // the exported snapshot periodically anyway.
+                        //
+                        datamodelShmPublish(true);
+
                         break;
                     }
 
                     case TIMER_TOKEN_GARBAGE_COLLECTOR:
                     {
                         PLATFORM_PRINTF_DEBUG_DETAIL("Running garbage collector...\n");
+                        pool_for_each(_printPoolStats, NULL);
+                        _printTxSchedulerStats();
+                        _printRequestStats();
 
                         if (DMrunGarbageCollector() > 0)
                         {
@@ -1485,6 +1910,48 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                         break;
                     }
 
+                    case TIMER_TOKEN_TOPOLOGY_SNAPSHOT:
+                    {
+                        PLATFORM_PRINTF_DEBUG_DETAIL("Saving topology snapshot...\n");
+
+                        if (0 == topologySnapshotSave())
+                        {
+                            PLATFORM_PRINTF_DEBUG_WARNING("Could not save topology snapshot\n");
+                        }
+                        break;
+                    }
+
+                    case TIMER_TOKEN_LINK_METRICS:
+                    {
+                        linkMetricsCacheRefresh();
+                        break;
+                    }
+
+                    case TIMER_TOKEN_TX_SCHEDULER:
+                    {
+                        // Pending CMDUs are transmitted below
+                        //
+                        tx_timer_armed = 0;
+                        break;
+                    }
+
+                    case TIMER_TOKEN_REQUESTS:
+                    {
+                        // Expired queries are handled below
+                        //
+                        requests_timer_deadline = 0;
+                        break;
+                    }
+
+                    case TIMER_TOKEN_CMDU_STATS:
+                    {
+                        // Printed whatever the verbosity level: it was
+                        // explicitly asked for
+                        //
+                        cmduStatsDump(PLATFORM_PRINTF);
+                        break;
+                    }
+
                     default:
                     {
                         PLATFORM_PRINTF_DEBUG_WARNING("Unknown timer ID!! Ignoring...\n");
@@ -1912,6 +2379,50 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                 break;
             }
 
+            case PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE:
+            {
+                struct cryptoJob *job;
+
+                if (message_len != sizeof(job))
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Invalid 'crypto job done' message length (%d)\n", message_len);
+                    break;
+                }
+
+                memcpy(&job, p, sizeof(job));
+                job->done(job);
+
+                break;
+            }
+
+            case PLATFORM_QUEUE_EVENT_RADIO_CHANGE:
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("New queue message arrived: radio change event\n");
+
+                if (message_len < 20)
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Invalid 'radio change' message length (%d)\n", message_len);
+                    break;
+                }
+
+                _processRadioChange(p);
+
+                break;
+            }
+
+            case PLATFORM_QUEUE_EVENT_SHUTDOWN:
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("Shutting down...\n");
+
+                if (0 == topologySnapshotSave())
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Could not save topology snapshot\n");
+                }
+
+                free(queue_message);
+                return 0;
+            }
+
             default:
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Unknown queue message type (%d)\n", message_type);
@@ -1919,6 +2430,56 @@ uint8_t start1905AL(uint8_t *al_mac_address, uint8_t map_whole_network_flag, cha
                 break;
             }
         }
+
+        // Retransmit the queries that have not been answered in time (see
+        // "al_requests.h"). If there are deadlines pending, make sure we come
+        // back in time for the first one (a new query may have a deadline
+        // earlier than the one the timer is armed for).
+        //
+        requests_wait = requestTimeoutsRun();
+        if (0 != requests_wait &&
+            (0 == requests_timer_deadline || (int32_t)(PLATFORM_GET_TIMESTAMP() + requests_wait - requests_timer_deadline) < 0))
+        {
+            struct eventTimeOut aux;
+
+            aux.timeout_ms = requests_wait;
+            aux.token      = TIMER_TOKEN_REQUESTS;
+
+            if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_TIMEOUT, &aux))
+            {
+                PLATFORM_PRINTF_DEBUG_ERROR("Could not register timer callback\n");
+            }
+            else
+            {
+                requests_timer_deadline = PLATFORM_GET_TIMESTAMP() + requests_wait;
+            }
+        }
+
+        // Transmit the CMDUs that had to wait (see "al_tx_scheduler.h") and,
+        // if some are still waiting, make sure we come back in time for them
+        //
+        tx_wait = txSchedulerRun();
+        if (0 != tx_wait && 0 == tx_timer_armed)
+        {
+            struct eventTimeOut aux;
+
+            aux.timeout_ms = tx_wait;
+            aux.token      = TIMER_TOKEN_TX_SCHEDULER;
+
+            if (0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_TIMEOUT, &aux))
+            {
+                PLATFORM_PRINTF_DEBUG_ERROR("Could not register timer callback\n");
+            }
+            else
+            {
+                tx_timer_armed = 1;
+            }
+        }
+
+        // Publish the new state of the data model (if something changed while
+        // processing this message)
+        //
+        datamodelShmPublish(false);
     }
 
     return 0;
@@ -158,7 +158,7 @@ uint8_t free1905CmduExtensions(struct CMDU *c)
             {
                 free(vs_tlv->m);
             }
-            free(vs_tlv);
+            hlist_delete_item(&vs_tlv->tlv.s.h);
         }
         i++;
     }
@@ -399,6 +399,13 @@ uint8_t vendorSpecificTLVInsertInCDMU(struct CMDU *memory_structure, struct vend
     memory_structure->list_of_TLVs[tlv_stop++] = &vendor_specific->tlv;
     memory_structure->list_of_TLVs[tlv_stop]   = NULL;
 
+    // Keep the index (if any) in sync with the new list
+    //
+    if (NULL != memory_structure->tlv_index)
+    {
+        index_1905_CMDU_TLVs(memory_structure);
+    }
+
     return 1;
 }
 
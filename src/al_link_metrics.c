@@ -0,0 +1,224 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "utils.h"
+
+#include "al_link_metrics.h"
+#include "platform_interfaces.h"
+
+#include <dlist.h>
+#include <pool.h>
+
+#include <string.h> // memcmp(), memcpy(), ...
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+struct _linkMetricsEntry
+{
+    dlist_item          l;
+
+    char                local_interface_name[32];
+    uint8_t             neighbor_interface_address[6];
+
+    struct linkMetrics  metrics;     // Last value obtained from the platform
+    uint32_t            timestamp;   // When 'metrics' was obtained
+    uint8_t             used;        // Number of times the entry was asked for
+                                     // (saturated at 255), cleared by
+                                     // "linkMetricsCacheRefresh()"
+};
+
+static uint32_t                      validity = LINK_METRICS_CACHE_DEFAULT_VALIDITY;
+static DEFINE_DLIST_HEAD(entries);
+static DEFINE_POOL(entries_pool, struct _linkMetricsEntry);
+static struct linkMetricsCacheStats  stats;
+
+// Used to return the metrics when the cache is disabled
+//
+static struct linkMetrics            uncached;
+
+// Query the platform for the metrics of entry 'e'. Returns "0" if they could
+// not be obtained.
+//
+static uint8_t _fetch(struct _linkMetricsEntry *e)
+{
+    struct linkMetrics *m;
+
+    m = PLATFORM_GET_LINK_METRICS(e->local_interface_name, e->neighbor_interface_address);
+    if (NULL == m)
+    {
+        return 0;
+    }
+
+    memcpy(&e->metrics, m, sizeof(e->metrics));
+    e->timestamp = PLATFORM_GET_TIMESTAMP();
+    free_LINK_METRICS(m);
+
+    return 1;
+}
+
+static void _removeEntry(struct _linkMetricsEntry *e)
+{
+    dlist_remove(&e->l);
+    pool_free(e);
+    stats.entries--;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (exported only to files in this same folder)
+////////////////////////////////////////////////////////////////////////////////
+
+void linkMetricsCacheValiditySet(uint32_t validity_ms)
+{
+    if (0 != validity_ms && validity_ms < LINK_METRICS_CACHE_MIN_VALIDITY)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Link metrics validity of %u ms is too short. Using %u ms.\n",
+                                      validity_ms, LINK_METRICS_CACHE_MIN_VALIDITY);
+        validity_ms = LINK_METRICS_CACHE_MIN_VALIDITY;
+    }
+    validity = validity_ms;
+}
+
+uint32_t linkMetricsCacheValidityGet(void)
+{
+    return validity;
+}
+
+const struct linkMetrics *linkMetricsGet(const char *local_interface_name, const uint8_t *neighbor_interface_address)
+{
+    struct _linkMetricsEntry *e;
+    struct linkMetrics       *m;
+
+    if (NULL == local_interface_name || NULL == neighbor_interface_address)
+    {
+        return NULL;
+    }
+
+    if (0 == validity || strlen(local_interface_name) >= sizeof(e->local_interface_name))
+    {
+        // Not cached
+        //
+        stats.misses++;
+        m = PLATFORM_GET_LINK_METRICS((char *)local_interface_name, (uint8_t *)neighbor_interface_address);
+        if (NULL == m)
+        {
+            return NULL;
+        }
+        memcpy(&uncached, m, sizeof(uncached));
+        free_LINK_METRICS(m);
+
+        return &uncached;
+    }
+
+    dlist_for_each(e, entries, l)
+    {
+        if (0 == memcmp(e->neighbor_interface_address, neighbor_interface_address, 6) &&
+            0 == strcmp(e->local_interface_name, local_interface_name))
+        {
+            break;
+        }
+    }
+
+    if (NULL != e)
+    {
+        if (e->used < 0xff)
+        {
+            e->used++;
+        }
+
+        if (PLATFORM_GET_TIMESTAMP() - e->timestamp <= validity)
+        {
+            stats.hits++;
+            return &e->metrics;
+        }
+
+        stats.misses++;
+        if (0 == _fetch(e))
+        {
+            _removeEntry(e);
+            return NULL;
+        }
+        return &e->metrics;
+    }
+
+    stats.misses++;
+
+    e = pool_alloc(&entries_pool);
+    strcpy(e->local_interface_name, local_interface_name);
+    memcpy(e->neighbor_interface_address, neighbor_interface_address, 6);
+    e->used = 1;
+
+    if (0 == _fetch(e))
+    {
+        pool_free(e);
+        return NULL;
+    }
+
+    dlist_add_tail(&entries, &e->l);
+    stats.entries++;
+
+    return &e->metrics;
+}
+
+void linkMetricsCacheRefresh(void)
+{
+    struct _linkMetricsEntry *e;
+    struct _linkMetricsEntry *next;
+
+    for (e = container_of(entries.next, struct _linkMetricsEntry, l); &e->l != &entries; e = next)
+    {
+        next = container_of(e->l.next, struct _linkMetricsEntry, l);
+
+        if (0 == e->used)
+        {
+            // Not asked for during the last window
+            //
+            _removeEntry(e);
+            continue;
+        }
+
+        // A link asked for only once per window gains nothing from a
+        // background refresh: it would replace the read of the next request
+        // instead of saving it. It is kept as it is, and the next request
+        // reads the platform if the metrics are too old by then.
+        //
+        if (e->used > 1)
+        {
+            if (0 == _fetch(e))
+            {
+                // The link is gone
+                //
+                _removeEntry(e);
+                continue;
+            }
+            stats.refreshes++;
+        }
+
+        e->used = 0;
+    }
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Link metrics cache: %u links, %u hits, %u misses, %u background refreshes\n",
+                                 stats.entries, stats.hits, stats.misses, stats.refreshes);
+}
+
+void linkMetricsCacheStatsGet(struct linkMetricsCacheStats *s)
+{
+    memcpy(s, &stats, sizeof(*s));
+}
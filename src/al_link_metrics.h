@@ -0,0 +1,100 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _AL_LINK_METRICS_H_
+#define _AL_LINK_METRICS_H_
+
+#include "platform.h"
+#include "platform_interfaces.h"
+
+// Link metrics are reported in "link metric responses" (to other ALs, see
+// "send1905MetricsResponsePacket()"), in ALME "get metric" responses (to HLEs,
+// see "send1905MetricsResponseALME()") and in BBF non-1905 link metrics. All
+// of them need the same counters, which the platform reads from sysfs or from
+// the drivers each time "PLATFORM_GET_LINK_METRICS()" is called.
+//
+// When several controllers and HLEs poll us, the same counters end up being
+// read many times per second, so the metrics of each (local interface,
+// neighbor interface) pair are cached here for a short time:
+//
+//   - A cached value is used if it is not older than the validity window (see
+//     "linkMetricsCacheValiditySet()"). Otherwise, the platform is queried
+//     again.
+//
+//   - Links that have been asked for more than once during the last window
+//     are refreshed in the background (see "linkMetricsCacheRefresh()"), so
+//     that polling them does not query the platform in the request path.
+//     Links asked for only once are not refreshed (their next request reads
+//     the platform if needed), and links that have not been asked for are
+//     forgotten.
+//
+// Everything here runs in the AL thread, so there is no locking.
+
+// Default validity window, in milliseconds
+//
+#define LINK_METRICS_CACHE_DEFAULT_VALIDITY  (1000)
+
+// Smallest validity window, in milliseconds. The cache is refreshed once per
+// window, so shorter ones would just keep the AL busy with timer events.
+//
+#define LINK_METRICS_CACHE_MIN_VALIDITY      (100)
+
+// Set the time (in milliseconds) during which cached metrics are used. "0"
+// disables the cache: the platform is queried on each request. Other values
+// below LINK_METRICS_CACHE_MIN_VALIDITY are raised to it.
+//
+// Must be called before the AL entity is started.
+//
+void linkMetricsCacheValiditySet(uint32_t validity_ms);
+
+// Return the value set with "linkMetricsCacheValiditySet()"
+//
+uint32_t linkMetricsCacheValidityGet(void);
+
+// Return the metrics of the link between 'local_interface_name' and the
+// neighbor interface with MAC address 'neighbor_interface_address' (see
+// "PLATFORM_GET_LINK_METRICS()"), or NULL if they could not be obtained.
+//
+// The returned structure belongs to the cache and must *not* be freed. It is
+// valid until the next call to "linkMetricsCacheRefresh()" (ie. until the AL
+// goes back to its event loop).
+//
+const struct linkMetrics *linkMetricsGet(const char *local_interface_name, const uint8_t *neighbor_interface_address);
+
+// Refresh the links that have been asked for more than once since the
+// previous call, and forget the ones that have not been asked for. Also logs
+// the cache statistics.
+//
+// Must be called once per validity window (the AL entity registers a periodic
+// timer for this).
+//
+void linkMetricsCacheRefresh(void);
+
+// Cache statistics, since the AL entity was started
+//
+struct linkMetricsCacheStats
+{
+    uint32_t hits;        // Requests answered from the cache
+    uint32_t misses;      // Requests that had to query the platform
+    uint32_t refreshes;   // Background queries to the platform
+    uint32_t entries;     // Links currently cached
+};
+
+void linkMetricsCacheStatsGet(struct linkMetricsCacheStats *stats);
+
+#endif
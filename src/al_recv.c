@@ -22,6 +22,7 @@
 #include "al_datamodel.h"
 #include "al_utils.h"
 #include "al_send.h"
+#include "al_requests.h"
 #include "al_wsc.h"
 #include "al_extension.h"
 
@@ -34,6 +35,7 @@
 
 #include "platform_interfaces.h"
 #include "platform_alme_server.h"
+#include "platform_crypto.h"
 
 #include <datamodel.h>
 
@@ -99,6 +101,182 @@ static struct wscRegistrarInfo *findWscInfoForBand(uint8_t freq_band)
     }
 }
 
+/** @brief Job that builds the M2 messages in answer to a received M1.
+ *
+ * Everything the job needs is copied in it, since the CMDU that contained the M1 is freed, and the sender may even be
+ * removed from the data model, before the job completes.
+ */
+struct wscM2Job {
+    struct cryptoJob job;
+
+    uint8_t          *m1;                           /**< Copy of the received M1. */
+    struct wscM1Info  m1_info;                      /**< Parsed from @a m1. */
+
+    struct wscRegistrarInfo *wsc_info;              /**< Copy of the matching registrar::wsc entries. */
+    unsigned          wsc_info_nr;
+
+    mac_address       receiving_interface_addr;     /**< Local interface on which the M1 was received. */
+    mac_address       sender_al_mac_addr;           /**< Where to send the M2 messages. */
+    mac_address       radio_uid;                    /**< Only valid if @a send_radio_identifier is true. */
+    bool              send_radio_identifier;
+
+    wscM2List         m2_list;                      /**< Result of the job. */
+};
+
+/** @brief cryptoJob::run callback of ::wscM2Job. */
+static void wscM2JobRun(struct cryptoJob *job)
+{
+    struct wscM2Job *m2_job = container_of(job, struct wscM2Job, job);
+    unsigned i;
+
+    for (i = 0; i < m2_job->wsc_info_nr; i++)
+    {
+        struct wscM2Buf new_m2;
+
+        if (!wscBuildM2(&m2_job->m1_info, &m2_job->wsc_info[i], &new_m2))
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Could not build M2 for " MACSTR "\n", MAC2STR(m2_job->sender_al_mac_addr));
+            continue;
+        }
+        PTRARRAY_ADD(m2_job->m2_list, new_m2);
+    }
+}
+
+/** @brief cryptoJob::done callback of ::wscM2Job: send the M2 messages and free the job.
+ *
+ * The M2 messages are dropped if the local device stopped being the registrar while the job was running.
+ */
+static void wscM2JobDone(struct cryptoJob *job)
+{
+    struct wscM2Job *m2_job = container_of(job, struct wscM2Job, job);
+    const char *interface_name = DMmacToInterfaceName(m2_job->receiving_interface_addr);
+
+    if (!registrarIsLocal())
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No longer the registrar. Dropping M2 for " MACSTR "\n",
+                                      MAC2STR(m2_job->sender_al_mac_addr));
+    }
+    else if (NULL == interface_name)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Interface " MACSTR " disappeared before M2 could be sent\n",
+                                      MAC2STR(m2_job->receiving_interface_addr));
+    }
+    else if (0 == send1905APAutoconfigurationWSCM2Packet(interface_name, getNextMid(),
+                                                         m2_job->sender_al_mac_addr, m2_job->m2_list,
+                                                         m2_job->radio_uid, m2_job->send_radio_identifier))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'AP autoconfiguration WSC-M2' message\n");
+    }
+
+    wscFreeM2List(m2_job->m2_list);
+    free(m2_job->wsc_info);
+    free(m2_job->m1);
+    free(m2_job);
+}
+
+
+// Update the data model after a "topology discovery" from interface
+// 'mac_address' of AL 'al_mac_address' has been received on
+// 'receiving_interface_addr', and query the sender if needed.
+//
+static uint8_t _processTopologyDiscovery(uint8_t *receiving_interface_addr, uint8_t *al_mac_address, uint8_t *mac_address)
+{
+    uint8_t  first_discovery;
+    uint32_t ellapsed;
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("AL MAC address = %02x:%02x:%02x:%02x:%02x:%02x\n", al_mac_address[0], al_mac_address[1], al_mac_address[2], al_mac_address[3], al_mac_address[4], al_mac_address[5]);
+    PLATFORM_PRINTF_DEBUG_DETAIL("MAC    address = %02x:%02x:%02x:%02x:%02x:%02x\n", mac_address[0],    mac_address[1],    mac_address[2],    mac_address[3],    mac_address[4],    mac_address[5]);
+
+    // Next, update the data model
+    //
+    if (1 == (first_discovery = DMupdateDiscoveryTimeStamps(receiving_interface_addr, al_mac_address, mac_address, TIMESTAMP_TOPOLOGY_DISCOVERY, &ellapsed)))
+    {
+#ifdef SPEED_UP_DISCOVERY
+        // If the data model did not contain an entry for this neighbor,
+        // "manually" (ie. "out of cycle") send a "Topology Discovery"
+        // message on the receiving interface.
+        // This will speed up the network discovery process, so that
+        // the new node does not have to wait until our "60 seconds"
+        // timer expires for him to "discover" us
+        //
+        PLATFORM_PRINTF_DEBUG_DETAIL("Is this a new node? Re-scheduling a Topology Discovery so that he 'discovers' us\n");
+
+        if (0 == send1905TopologyDiscoveryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid()))
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Could not send 1905 topology discovery message\n");
+        }
+#endif
+    }
+
+    // Finally, query the advertising neighbor for (much) more detailed
+    // information (but only if we haven't recently queried it!)
+    // This will make the other end send us a
+    // CMDU_TYPE_TOPOLOGY_RESPONSE message, which we will later
+    // process.
+    //
+    if (
+         0 == DMnetworkDeviceInfoNeedsUpdate(al_mac_address) ||  // Recently received a Topology Response or....
+         (2 == first_discovery && ellapsed < 5000)               // ...recently (<5 seconds) received a Topology Discovery
+
+       )
+    {
+        // The first condition prevents us from re-asking (ie.
+        // re-sending "Topology Queries") to one same node (we already
+        // knew of) faster than once every minute.
+        //
+        // The second condition prevents us from flooding new nodes
+        // (from which we haven't received a "Topology Response" yet)
+        // with "Topology Queries" faster than once every 5 seconds)
+        //
+        return PROCESS_CMDU_OK;
+    }
+
+    if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), al_mac_address, CMDU_TYPE_TOPOLOGY_QUERY))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'topology query' message\n");
+    }
+
+    return PROCESS_CMDU_OK;
+}
+
+// Query AL 'al_mac_address' after it sent a "topology notification" that has
+// been received on 'receiving_interface_addr'.
+//
+static uint8_t _processTopologyNotification(uint8_t *receiving_interface_addr, uint8_t *al_mac_address)
+{
+    PLATFORM_PRINTF_DEBUG_DETAIL("AL MAC address = %02x:%02x:%02x:%02x:%02x:%02x\n", al_mac_address[0], al_mac_address[1], al_mac_address[2], al_mac_address[3], al_mac_address[4], al_mac_address[5]);
+
+#ifdef SPEED_UP_DISCOVERY
+    // We will send a topology discovery back. Why is this useful?
+    // Well... imagine a node that has just entered the secure network.
+    // The first thing this node will do is sending a
+    // "topology notification" which, when received by us, will trigger
+    // a "topology query".
+    // However, unless we send a "topology discovery" back, the new node
+    // will not query us for a while (until we actually send our
+    // periodic "topology discovery").
+    //
+    PLATFORM_PRINTF_DEBUG_DETAIL("Is this a new node? Re-scheduling a Topology Discovery so that he 'discovers' us\n");
+
+    if (0 == send1905TopologyDiscoveryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid()))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send 1905 topology discovery message\n");
+    }
+#endif
+    // Finally, query the informing node.
+    // Note that we don't have to check (as we did in the "topology
+    // discovery" case) if we recently updated the data model or not.
+    // This is because a "topology notification" *always* implies
+    // network changes and thus the device must always be (re)-queried.
+    //
+    if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), al_mac_address, CMDU_TYPE_TOPOLOGY_QUERY))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'topology query' message\n");
+    }
+
+    return PROCESS_CMDU_OK;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Public functions (exported only to files in this same folder)
@@ -125,19 +303,8 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             // interface MACs are seen on each interface) and send a "topology
             // query" message asking for more details.
 
-            struct tlv *p;
-            uint8_t  i;
-
-            uint8_t  dummy_mac_address[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-            uint8_t  al_mac_address[6];
-            uint8_t  mac_address[6];
-
-            uint8_t  first_discovery;
-            uint32_t ellapsed;
-
-            memcpy(al_mac_address, dummy_mac_address, 6);
-            memcpy(mac_address,    dummy_mac_address, 6);
+            struct alMacAddressTypeTLV *al_mac_tlv;
+            struct macAddressTypeTLV   *mac_tlv;
 
             PLATFORM_PRINTF_DEBUG_INFO("<-- CMDU_TYPE_TOPOLOGY_DISCOVERY (%s)\n", DMmacToInterfaceName(receiving_interface_addr));
 
@@ -153,101 +320,18 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             }
 
             // First, extract the AL MAC and MAC addresses of the interface
-            // which transmitted this "topology discovery" message
+            // which transmitted this "topology discovery" message, and make
+            // sure that both were contained in the CMDU
             //
-            i = 0;
-            while (NULL != (p = c->list_of_TLVs[i]))
-            {
-                switch (p->type)
-                {
-                    case TLV_TYPE_AL_MAC_ADDRESS_TYPE:
-                    {
-                        struct alMacAddressTypeTLV *t = (struct alMacAddressTypeTLV *)p;
-
-                        memcpy(al_mac_address, t->al_mac_address, 6);
-
-                        break;
-                    }
-                    case TLV_TYPE_MAC_ADDRESS_TYPE:
-                    {
-                        struct macAddressTypeTLV *t = (struct macAddressTypeTLV *)p;
-
-                        memcpy(mac_address, t->mac_address, 6);
-
-                        break;
-                    }
-                    default:
-                    {
-                        PLATFORM_PRINTF_DEBUG_WARNING("Unexpected TLV (%d) type inside CMDU\n", p->type);
-                        break;
-                    }
-                }
-                i++;
-            }
-
-            // Make sure that both the AL MAC and MAC addresses were contained
-            // in the CMDU
-            //
-            if (0 == memcmp(al_mac_address, dummy_mac_address, 6) ||
-                0 == memcmp(mac_address,    dummy_mac_address, 6))
+            al_mac_tlv = (struct alMacAddressTypeTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_AL_MAC_ADDRESS_TYPE, 0);
+            mac_tlv    = (struct macAddressTypeTLV   *)get_1905_CMDU_TLV(c, TLV_TYPE_MAC_ADDRESS_TYPE,    0);
+            if (NULL == al_mac_tlv || NULL == mac_tlv)
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("More TLVs were expected inside this CMDU\n");
                 return PROCESS_CMDU_KO;
             }
 
-            PLATFORM_PRINTF_DEBUG_DETAIL("AL MAC address = %02x:%02x:%02x:%02x:%02x:%02x\n", al_mac_address[0], al_mac_address[1], al_mac_address[2], al_mac_address[3], al_mac_address[4], al_mac_address[5]);
-            PLATFORM_PRINTF_DEBUG_DETAIL("MAC    address = %02x:%02x:%02x:%02x:%02x:%02x\n", mac_address[0],    mac_address[1],    mac_address[2],    mac_address[3],    mac_address[4],    mac_address[5]);
-
-            // Next, update the data model
-            //
-            if (1 == (first_discovery = DMupdateDiscoveryTimeStamps(receiving_interface_addr, al_mac_address, mac_address, TIMESTAMP_TOPOLOGY_DISCOVERY, &ellapsed)))
-            {
-#ifdef SPEED_UP_DISCOVERY
-                // If the data model did not contain an entry for this neighbor,
-                // "manually" (ie. "out of cycle") send a "Topology Discovery"
-                // message on the receiving interface.
-                // This will speed up the network discovery process, so that
-                // the new node does not have to wait until our "60 seconds"
-                // timer expires for him to "discover" us
-                //
-                PLATFORM_PRINTF_DEBUG_DETAIL("Is this a new node? Re-scheduling a Topology Discovery so that he 'discovers' us\n");
-
-                if (0 == send1905TopologyDiscoveryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid()))
-                {
-                    PLATFORM_PRINTF_DEBUG_WARNING("Could not send 1905 topology discovery message\n");
-                }
-#endif
-            }
-
-            // Finally, query the advertising neighbor for (much) more detailed
-            // information (but only if we haven't recently queried it!)
-            // This will make the other end send us a
-            // CMDU_TYPE_TOPOLOGY_RESPONSE message, which we will later
-            // process.
-            //
-            if (
-                 0 == DMnetworkDeviceInfoNeedsUpdate(al_mac_address) ||  // Recently received a Topology Response or....
-                 (2 == first_discovery && ellapsed < 5000)               // ...recently (<5 seconds) received a Topology Discovery
-
-               )
-            {
-                // The first condition prevents us from re-asking (ie.
-                // re-sending "Topology Queries") to one same node (we already
-                // knew of) faster than once every minute.
-                //
-                // The second condition prevents us from flooding new nodes
-                // (from which we haven't received a "Topology Response" yet)
-                // with "Topology Queries" faster than once every 5 seconds)
-                //
-                break;
-            }
-
-            if ( 0 == send1905TopologyQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), al_mac_address))
-            {
-                PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'topology query' message\n");
-            }
-
-            break;
+            return _processTopologyDiscovery(receiving_interface_addr, al_mac_tlv->al_mac_address, mac_tlv->mac_address);
         }
         case CMDU_TYPE_TOPOLOGY_NOTIFICATION:
         {
@@ -256,15 +340,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             // The "sender" AL MAC address is contained in the unique TLV
             // embedded in the just received "topology notification" CMDU.
 
-            struct tlv *p;
-            uint8_t  i;
-
-            uint8_t dummy_mac_address[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-            uint8_t  al_mac_address[6];
-
-
-            memcpy(al_mac_address, dummy_mac_address, 6);
+            struct alMacAddressTypeTLV *al_mac_tlv;
 
             PLATFORM_PRINTF_DEBUG_INFO("<-- CMDU_TYPE_TOPOLOGY_NOTIFICATION (%s)\n", DMmacToInterfaceName(receiving_interface_addr));
 
@@ -277,68 +353,14 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             // Extract the AL MAC addresses of the interface which transmitted
             // this "topology notification" message
             //
-            i = 0;
-            while (NULL != (p = c->list_of_TLVs[i]))
-            {
-                switch (p->type)
-                {
-                    case TLV_TYPE_AL_MAC_ADDRESS_TYPE:
-                    {
-                        struct alMacAddressTypeTLV *t = (struct alMacAddressTypeTLV *)p;
-
-                        memcpy(al_mac_address, t->al_mac_address, 6);
-
-                        break;
-                    }
-                    default:
-                    {
-                        PLATFORM_PRINTF_DEBUG_WARNING("Unexpected TLV (%d) type inside CMDU\n", p->type);
-                        break;
-                    }
-                }
-                i++;
-            }
-
-            // Make sure that both the AL MAC and MAC addresses were contained
-            // in the CMDU
-            //
-            if (0 == memcmp(al_mac_address, dummy_mac_address, 6))
+            al_mac_tlv = (struct alMacAddressTypeTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_AL_MAC_ADDRESS_TYPE, 0);
+            if (NULL == al_mac_tlv)
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("More TLVs were expected inside this CMDU\n");
                 return PROCESS_CMDU_KO;
             }
 
-            PLATFORM_PRINTF_DEBUG_DETAIL("AL MAC address = %02x:%02x:%02x:%02x:%02x:%02x\n", al_mac_address[0], al_mac_address[1], al_mac_address[2], al_mac_address[3], al_mac_address[4], al_mac_address[5]);
-
-#ifdef SPEED_UP_DISCOVERY
-            // We will send a topology discovery back. Why is this useful?
-            // Well... imagine a node that has just entered the secure network.
-            // The first thing this node will do is sending a
-            // "topology notification" which, when received by us, will trigger
-            // a "topology query".
-            // However, unless we send a "topology discovery" back, the new node
-            // will not query us for a while (until we actually send our
-            // periodic "topology discovery").
-            //
-             PLATFORM_PRINTF_DEBUG_DETAIL("Is this a new node? Re-scheduling a Topology Discovery so that he 'discovers' us\n");
-
-             if (0 == send1905TopologyDiscoveryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid()))
-             {
-                 PLATFORM_PRINTF_DEBUG_WARNING("Could not send 1905 topology discovery message\n");
-             }
-#endif
-            // Finally, query the informing node.
-            // Note that we don't have to check (as we did in the "topology
-            // discovery" case) if we recently updated the data model or not.
-            // This is because a "topology notification" *always* implies
-            // network changes and thus the device must always be (re)-queried.
-            //
-            if ( 0 == send1905TopologyQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), al_mac_address))
-            {
-                PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'topology query' message\n");
-            }
-
-            break;
+            return _processTopologyNotification(receiving_interface_addr, al_mac_tlv->al_mac_address);
         }
         case CMDU_TYPE_TOPOLOGY_QUERY:
         {
@@ -422,66 +444,13 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             // capability TLVs, non-1905 neighbors TLVs and 1905 neighbors TLVs
             // there are
             //
-            bridges_nr           = 0;
-            non1905_neighbors_nr = 0;
-            x1905_neighbors_nr   = 0;
-            power_off_nr         = 0;
-            l2_neighbors_nr      = 0;
-            i                    = 0;
-            while (NULL != (p = c->list_of_TLVs[i]))
-            {
-                switch (p->type)
-                {
-                    case TLV_TYPE_DEVICE_INFORMATION_TYPE:
-                    {
-                        info = (struct deviceInformationTypeTLV *)p;
-                        break;
-                    }
-                    case TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES:
-                    {
-                        bridges_nr++;
-                        break;
-                    }
-                    case TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST:
-                    {
-                        non1905_neighbors_nr++;
-                        break;
-                    }
-                    case TLV_TYPE_NEIGHBOR_DEVICE_LIST:
-                    {
-                        x1905_neighbors_nr++;
-                        break;
-                    }
-                    case TLV_TYPE_POWER_OFF_INTERFACE:
-                    {
-                        power_off_nr++;
-                        break;
-                    }
-                    case TLV_TYPE_L2_NEIGHBOR_DEVICE:
-                    {
-                        l2_neighbors_nr++;
-                        break;
-                    }
-                    case TLV_TYPE_SUPPORTED_SERVICE:
-                    {
-                        s = (struct supportedServiceTLV *)p;
-                        break;
-                    }
-                    case TLV_TYPE_VENDOR_SPECIFIC:
-                    {
-                        // According to the standard, zero or more Vendor
-                        // Specific TLVs may be present.
-                        //
-                        break;
-                    }
-                    default:
-                    {
-                        PLATFORM_PRINTF_DEBUG_WARNING("Unexpected TLV (%d) type inside CMDU\n", p->type);
-                        break;
-                    }
-                }
-                i++;
-            }
+            info                 = (struct deviceInformationTypeTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_DEVICE_INFORMATION_TYPE, 0);
+            s                    = (struct supportedServiceTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_SUPPORTED_SERVICE, 0);
+            bridges_nr           = count_1905_CMDU_TLVs(c, TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES);
+            non1905_neighbors_nr = count_1905_CMDU_TLVs(c, TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST);
+            x1905_neighbors_nr   = count_1905_CMDU_TLVs(c, TLV_TYPE_NEIGHBOR_DEVICE_LIST);
+            power_off_nr         = count_1905_CMDU_TLVs(c, TLV_TYPE_POWER_OFF_INTERFACE);
+            l2_neighbors_nr      = count_1905_CMDU_TLVs(c, TLV_TYPE_L2_NEIGHBOR_DEVICE);
 
             // Next, now that we know how many TLVs of each type there are,
             // create an array of pointers big enough to contain them and fill
@@ -508,61 +477,47 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                 r = (struct l2NeighborDeviceTLV          **)memalloc(sizeof(struct l2NeighborDeviceTLV          *) * l2_neighbors_nr);
             }
 
-            xi = 0;
-            yi = 0;
-            zi = 0;
-            qi = 0;
-            ri = 0;
-            i  = 0;
+            for (xi = 0; xi < bridges_nr; xi++)
+            {
+                x[xi] = (struct deviceBridgingCapabilityTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES, xi);
+            }
+            for (yi = 0; yi < non1905_neighbors_nr; yi++)
+            {
+                y[yi] = (struct non1905NeighborDeviceListTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST, yi);
+            }
+            for (zi = 0; zi < x1905_neighbors_nr; zi++)
+            {
+                z[zi] = (struct neighborDeviceListTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_NEIGHBOR_DEVICE_LIST, zi);
+            }
+            for (qi = 0; qi < power_off_nr; qi++)
+            {
+                q[qi] = (struct powerOffInterfaceTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_POWER_OFF_INTERFACE, qi);
+            }
+            for (ri = 0; ri < l2_neighbors_nr; ri++)
+            {
+                r[ri] = (struct l2NeighborDeviceTLV *)get_1905_CMDU_TLV(c, TLV_TYPE_L2_NEIGHBOR_DEVICE, ri);
+            }
+
+            // We are not interested in other TLVs (such as the zero or more
+            // Vendor Specific TLVs the standard allows). Free them
+            //
+            i = 0;
             while (NULL != (p = c->list_of_TLVs[i]))
             {
                 switch (p->type)
                 {
                     case TLV_TYPE_DEVICE_INFORMATION_TYPE:
-                    {
-                        break;
-                    }
                     case TLV_TYPE_DEVICE_BRIDGING_CAPABILITIES:
-                    {
-                        x[xi++] = (struct deviceBridgingCapabilityTLV *)p;
-                        break;
-                    }
                     case TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST:
-                    {
-                        y[yi++] = (struct non1905NeighborDeviceListTLV *)p;
-                        break;
-                    }
                     case TLV_TYPE_NEIGHBOR_DEVICE_LIST:
-                    {
-                        z[zi++] = (struct neighborDeviceListTLV *)p;
-                        break;
-                    }
                     case TLV_TYPE_POWER_OFF_INTERFACE:
-                    {
-                        q[qi++] = (struct powerOffInterfaceTLV *)p;
-                        break;
-                    }
                     case TLV_TYPE_L2_NEIGHBOR_DEVICE:
-                    {
-                        r[ri++] = (struct l2NeighborDeviceTLV *)p;
-                        break;
-                    }
                     case TLV_TYPE_SUPPORTED_SERVICE:
                     {
                         break;
                     }
-                    case TLV_TYPE_VENDOR_SPECIFIC:
-                    {
-                        // According to the standard, zero or more Vendor
-                        // Specific TLVs may be present.
-                        //
-                        free_1905_TLV_structure(p);
-                        break;
-                    }
                     default:
                     {
-                        // We are not interested in other TLVs. Free them
-                        //
                         free_1905_TLV_structure(p);
                         break;
                     }
@@ -620,11 +575,11 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
             // And finally, send other queries to the device so that we can
             // keep updating the database once the responses are received
             //
-            if ( 0 == send1905MetricsQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), info->al_mac_address))
+            if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), info->al_mac_address, CMDU_TYPE_LINK_METRIC_QUERY))
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'metrics query' message\n");
             }
-            if ( 0 == send1905HighLayerQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), info->al_mac_address))
+            if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), info->al_mac_address, CMDU_TYPE_HIGHER_LAYER_QUERY))
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'high layer query' message\n");
             }
@@ -635,7 +590,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                     // There is *at least* one generic inteface in the response,
                     // thus query for more information
                     //
-                    if ( 0 == send1905GenericPhyQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), info->al_mac_address))
+                    if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), info->al_mac_address, CMDU_TYPE_GENERIC_PHY_QUERY))
                     {
                         PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'generic phy query' message\n");
                     }
@@ -702,7 +657,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                             continue;
                         }
 
-                        if ( 0 == send1905TopologyQueryPacket(DMmacToInterfaceName(receiving_interface_addr), getNextMid(), z[i]->neighbors[j].mac_address))
+                        if ( 0 == requestSend(DMmacToInterfaceName(receiving_interface_addr), z[i]->neighbors[j].mac_address, CMDU_TYPE_TOPOLOGY_QUERY))
                         {
                             PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'topology query' message\n");
                         }
@@ -1287,6 +1242,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                         if (wsc_type == WSC_TYPE_M1)
                         {
                             PLATFORM_PRINTF_DEBUG_WARNING("Only a single M2 TLV is allowed.\n");
+                            PTRARRAY_CLEAR(wsc_list);
                             return PROCESS_CMDU_KO;
                         }
                         m.m2 = t->wsc_frame;
@@ -1295,6 +1251,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                         if (new_wsc_type == WSC_TYPE_M1 && wsc_type == WSC_TYPE_M2)
                         {
                             PLATFORM_PRINTF_DEBUG_WARNING("Only M2 TLVs are allowed in M2 CMDU.\n");
+                            PTRARRAY_CLEAR(wsc_list);
                             return PROCESS_CMDU_KO;
                         }
                         PTRARRAY_ADD(wsc_list, m);
@@ -1336,12 +1293,14 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                     {
                         PLATFORM_PRINTF_DEBUG_WARNING("Received AP radio identifier for unknown radio " MACSTR "\n",
                                                       MAC2STR(ap_radio_identifier->radio_uid));
+                        PTRARRAY_CLEAR(wsc_list);
                         return PROCESS_CMDU_KO;
                     }
                     if (radio->wsc_info == NULL)
                     {
                         PLATFORM_PRINTF_DEBUG_WARNING("Received WSC M2 for radio " MACSTR " which didn't send M1\n",
                                                       MAC2STR(ap_radio_identifier->radio_uid));
+                        PTRARRAY_CLEAR(wsc_list);
                         return PROCESS_CMDU_KO;
                     }
                 }
@@ -1359,6 +1318,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                     if (radio == NULL)
                     {
                         PLATFORM_PRINTF_DEBUG_WARNING("Received M2 but no corresponding M1 found.\n");
+                        PTRARRAY_CLEAR(wsc_list);
                         return PROCESS_CMDU_KO;
                     }
                 }
@@ -1396,7 +1356,7 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                 //
                 // Process it and send an M2 response.
                 //
-                wscM2List m2_list = {0, NULL};
+                struct wscM2Job *m2_job;
                 struct wscM1Info m1_info;
 
                 bool send_radio_identifier = ap_radio_basic_capabilities != NULL;
@@ -1405,6 +1365,16 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
 
                 struct wscRegistrarInfo *wsc_info;
 
+                // Only the registrar answers. This is checked here (and not
+                // by the job, which runs in another thread and must not
+                // touch the data model).
+                //
+                if (!registrarIsLocal())
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("We are not a registrar. Ignoring M1 message.\n");
+                    break;
+                }
+
                 /* wsc_list will have length 1, checked above (implicitly) */
                 if (!wscParseM1(wsc_list.data[0].m2, wsc_list.data[0].m2_size, &m1_info))
                 {
@@ -1433,33 +1403,49 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
                     /* @todo add channels based on channel info in ap_radio_basic_capabilities. */
                 }
 
+                // Building the M2 messages takes a while (Diffie Hellman key
+                // exchange), so it is done in the background while we go on
+                // processing other messages. The M2 CMDU is sent when the job
+                // completes.
+                //
+                m2_job = zmemalloc(sizeof(*m2_job));
+                m2_job->job.run  = wscM2JobRun;
+                m2_job->job.done = wscM2JobDone;
+
+                m2_job->m1 = memalloc(wsc_list.data[0].m2_size);
+                memcpy(m2_job->m1, wsc_list.data[0].m2, wsc_list.data[0].m2_size);
+                wscParseM1(m2_job->m1, wsc_list.data[0].m2_size, &m2_job->m1_info);
+
                 dlist_for_each(wsc_info, registrar.wsc, l)
                 {
                     if ((m1_info.rf_bands | wsc_info->rf_bands) != 0 &&
                         (m1_info.auth_types | wsc_info->bss_info.auth_mode) != 0)
                     {
-                        struct wscM2Buf new_m2;
-
-                        wscBuildM2(&m1_info, wsc_info, &new_m2);
-                        PTRARRAY_ADD(m2_list, new_m2);
+                        m2_job->wsc_info = memrealloc(m2_job->wsc_info, (m2_job->wsc_info_nr + 1) * sizeof(*wsc_info));
+                        m2_job->wsc_info[m2_job->wsc_info_nr++] = *wsc_info;
                     }
                 }
 
+                memcpy(m2_job->receiving_interface_addr, receiving_interface_addr, sizeof(mac_address));
+                memcpy(m2_job->sender_al_mac_addr, sender_device->al_mac_addr, sizeof(mac_address));
+                if (send_radio_identifier)
+                {
+                    memcpy(m2_job->radio_uid, ap_radio_basic_capabilities->radio_uid, sizeof(mac_address));
+                }
+                m2_job->send_radio_identifier = send_radio_identifier;
 
-                if ( 0 == send1905APAutoconfigurationWSCM2Packet(DMmacToInterfaceName(receiving_interface_addr), getNextMid(),
-                                                                 sender_device->al_mac_addr, m2_list,
-                                                                 send_radio_identifier ? ap_radio_basic_capabilities->radio_uid : NULL,
-                                                                 send_radio_identifier))
+                if (0 == PLATFORM_SUBMIT_CRYPTO_JOB(&m2_job->job))
                 {
-                    PLATFORM_PRINTF_DEBUG_WARNING("Could not send 'AP autoconfiguration WSC-M2' message\n");
+                    wscM2JobRun(&m2_job->job);
+                    wscM2JobDone(&m2_job->job);
                 }
-                wscFreeM2List(m2_list);
             }
             else
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Unknown type of WSC message!\n");
             }
 
+            PTRARRAY_CLEAR(wsc_list);
             break;
         }
         case CMDU_TYPE_AP_AUTOCONFIGURATION_RENEW:
@@ -2129,6 +2115,91 @@ uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8
     return PROCESS_CMDU_OK;
 }
 
+uint8_t process1905CmduView(struct CMDU_view *v, uint8_t *receiving_interface_addr, uint8_t *src_addr, uint8_t queue_id)
+{
+    const uint8_t *tlv_al_mac_address;
+    const uint8_t *tlv_mac_address;
+    uint16_t       tlv_al_mac_address_len;
+    uint16_t       tlv_mac_address_len;
+
+    uint8_t        al_mac_address[6];
+    uint8_t        mac_address[6];
+
+    struct CMDU   *c;
+    uint8_t        ret;
+
+    if (NULL == v)
+    {
+        return PROCESS_CMDU_KO;
+    }
+
+    // "Topology discovery" and "topology notification" messages are by far the
+    // most common ones, and all that is needed from them is one or two MAC
+    // addresses, so these are read directly from the view.
+    //
+    // Protocol extensions only look at vendor specific TLVs. If there are any,
+    // take the regular path so that the extensions get to see them.
+    //
+    if (0 == count_1905_CMDU_view_TLVs(v, TLV_TYPE_VENDOR_SPECIFIC))
+    {
+        switch (v->message_type)
+        {
+            case CMDU_TYPE_TOPOLOGY_DISCOVERY:
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("<-- CMDU_TYPE_TOPOLOGY_DISCOVERY (%s)\n", DMmacToInterfaceName(receiving_interface_addr));
+
+                tlv_al_mac_address = get_1905_CMDU_view_TLV(v, TLV_TYPE_AL_MAC_ADDRESS_TYPE, 0, &tlv_al_mac_address_len);
+                tlv_mac_address    = get_1905_CMDU_view_TLV(v, TLV_TYPE_MAC_ADDRESS_TYPE,    0, &tlv_mac_address_len);
+
+                if (NULL == tlv_al_mac_address || 6 != tlv_al_mac_address_len ||
+                    NULL == tlv_mac_address    || 6 != tlv_mac_address_len)
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Malformed TLVs inside this CMDU\n");
+                    return PROCESS_CMDU_KO;
+                }
+                memcpy(al_mac_address, tlv_al_mac_address, 6);
+                memcpy(mac_address,    tlv_mac_address,    6);
+
+                return _processTopologyDiscovery(receiving_interface_addr, al_mac_address, mac_address);
+            }
+            case CMDU_TYPE_TOPOLOGY_NOTIFICATION:
+            {
+                PLATFORM_PRINTF_DEBUG_INFO("<-- CMDU_TYPE_TOPOLOGY_NOTIFICATION (%s)\n", DMmacToInterfaceName(receiving_interface_addr));
+
+                tlv_al_mac_address = get_1905_CMDU_view_TLV(v, TLV_TYPE_AL_MAC_ADDRESS_TYPE, 0, &tlv_al_mac_address_len);
+
+                if (NULL == tlv_al_mac_address || 6 != tlv_al_mac_address_len)
+                {
+                    PLATFORM_PRINTF_DEBUG_WARNING("Malformed TLVs inside this CMDU\n");
+                    return PROCESS_CMDU_KO;
+                }
+                memcpy(al_mac_address, tlv_al_mac_address, 6);
+
+                return _processTopologyNotification(receiving_interface_addr, al_mac_address);
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    c = convert_1905_CMDU_view_to_structure(v);
+    if (NULL == c)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Malformed TLVs inside this CMDU\n");
+        return PROCESS_CMDU_KO;
+    }
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("CMDU message contents:\n");
+    visit_1905_CMDU_structure(c, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+
+    ret = process1905Cmdu(c, receiving_interface_addr, src_addr, queue_id);
+    free_1905_CMDU_structure(c);
+
+    return ret;
+}
+
 uint8_t processLlpdPayload(struct PAYLOAD *payload, uint8_t *receiving_interface_addr)
 {
     struct tlv *p;
@@ -55,6 +55,15 @@
 #define PROCESS_CMDU_OK_TRIGGER_AP_SEARCH   (2)
 uint8_t process1905Cmdu(struct CMDU *c, uint8_t *receiving_interface_addr, uint8_t *src_addr, uint8_t queue_id);
 
+// Same as "process1905Cmdu()" but for a CMDU view (see
+// "parse_1905_CMDU_view_from_packets()").
+//
+// The most frequent CMDUs are handled directly from the view. For all the
+// others, the view is first converted to a "struct CMDU" which is then passed
+// to "process1905Cmdu()".
+//
+uint8_t process1905CmduView(struct CMDU_view *v, uint8_t *receiving_interface_addr, uint8_t *src_addr, uint8_t queue_id);
+
 // Call this function when receiving an LLPD "bridge discovery" message so that
 // the topology database is properly updated.
 //
@@ -0,0 +1,564 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "utils.h"
+
+#include "al_requests.h"
+#include "al_datamodel.h"
+#include "al_send.h"
+#include "al_utils.h"
+#include "1905_cmdus.h"
+
+#include <dlist.h>
+#include <pool.h>
+
+#include <string.h> // memcmp(), memcpy(), ...
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// Timer wheel: deadlines are rounded up to REQUEST_WHEEL_TICK_MS and stored in
+// slot "(deadline / REQUEST_WHEEL_TICK_MS) % REQUEST_WHEEL_SLOTS". Deadlines
+// further away than one turn of the wheel share the slot with closer ones, so
+// each entry is checked against its own deadline when its slot comes up.
+//
+#define REQUEST_WHEEL_TICK_MS  (50)
+#define REQUEST_WHEEL_SLOTS    (128)
+
+// Outstanding queries are indexed by MID. MIDs are consecutive, so the low
+// bits are enough to spread them.
+//
+#define REQUEST_HASH_SIZE      (64)
+
+// Number of ALs whose round trip time is remembered. When there are more,
+// the least recently used one is forgotten.
+//
+#define REQUEST_MAX_RTT_ENTRIES  (64)
+
+struct _request
+{
+    dlist_item  h;                  // In its "requests_hash[]" bucket
+    dlist_item  w;                  // In its "wheel[]" slot
+
+    uint8_t     al_mac_address[6];
+    char       *interface_name;
+    uint16_t    query_type;
+    uint16_t    mid;
+
+    uint32_t    sent_timestamp;
+    uint32_t    deadline;
+    uint8_t     retries;
+    uint8_t     answered;           // Kept only to spot duplicated responses
+};
+
+struct _rtt
+{
+    dlist_item  l;
+
+    uint8_t     al_mac_address[6];
+    uint32_t    srtt;               // Smoothed round trip time
+    uint32_t    rttvar;             // Round trip time variation
+};
+
+static dlist_head requests_hash[REQUEST_HASH_SIZE];
+static dlist_head wheel[REQUEST_WHEEL_SLOTS];
+static uint32_t   wheel_tick;       // Last tick whose slot was processed
+static uint8_t    initialized = 0;
+
+static DEFINE_DLIST_HEAD(rtts);     // Most recently used first
+static uint32_t   rtts_nr = 0;
+
+static DEFINE_POOL(requests_pool, struct _request);
+static DEFINE_POOL(rtts_pool, struct _rtt);
+
+static struct requestStats stats;
+
+static void _init(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < REQUEST_HASH_SIZE; i++)
+    {
+        dlist_head_init(&requests_hash[i]);
+    }
+    for (i = 0; i < REQUEST_WHEEL_SLOTS; i++)
+    {
+        dlist_head_init(&wheel[i]);
+    }
+    wheel_tick  = PLATFORM_GET_TIMESTAMP() / REQUEST_WHEEL_TICK_MS;
+    initialized = 1;
+}
+
+static uint16_t _responseType(uint16_t query_type)
+{
+    switch (query_type)
+    {
+        case CMDU_TYPE_TOPOLOGY_QUERY:     return CMDU_TYPE_TOPOLOGY_RESPONSE;
+        case CMDU_TYPE_LINK_METRIC_QUERY:  return CMDU_TYPE_LINK_METRIC_RESPONSE;
+        case CMDU_TYPE_HIGHER_LAYER_QUERY: return CMDU_TYPE_HIGHER_LAYER_RESPONSE;
+        case CMDU_TYPE_GENERIC_PHY_QUERY:  return CMDU_TYPE_GENERIC_PHY_RESPONSE;
+        default:                           return 0xffff;
+    }
+}
+
+static uint8_t _send(struct _request *r)
+{
+    switch (r->query_type)
+    {
+        case CMDU_TYPE_TOPOLOGY_QUERY:
+        {
+            return send1905TopologyQueryPacket(r->interface_name, r->mid, r->al_mac_address);
+        }
+        case CMDU_TYPE_LINK_METRIC_QUERY:
+        {
+            return send1905MetricsQueryPacket(r->interface_name, r->mid, r->al_mac_address);
+        }
+        case CMDU_TYPE_HIGHER_LAYER_QUERY:
+        {
+            return send1905HighLayerQueryPacket(r->interface_name, r->mid, r->al_mac_address);
+        }
+        case CMDU_TYPE_GENERIC_PHY_QUERY:
+        {
+            return send1905GenericPhyQueryPacket(r->interface_name, r->mid, r->al_mac_address);
+        }
+        default:
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Cannot track queries of type 0x%04x\n", r->query_type);
+            return 0;
+        }
+    }
+}
+
+// Return the round trip time estimation of AL 'al_mac_address' (creating it,
+// if 'create' is set), or NULL
+//
+static struct _rtt *_getRtt(const uint8_t *al_mac_address, uint8_t create)
+{
+    struct _rtt *t;
+
+    dlist_for_each(t, rtts, l)
+    {
+        if (0 == memcmp(t->al_mac_address, al_mac_address, 6))
+        {
+            // Keep the list in "most recently used" order
+            //
+            dlist_remove(&t->l);
+            dlist_add_head(&rtts, &t->l);
+            return t;
+        }
+    }
+
+    if (!create)
+    {
+        return NULL;
+    }
+
+    if (rtts_nr >= REQUEST_MAX_RTT_ENTRIES)
+    {
+        t = container_of(rtts.prev, struct _rtt, l);
+        dlist_remove(&t->l);
+    }
+    else
+    {
+        t = pool_alloc(&rtts_pool);
+        rtts_nr++;
+    }
+    memcpy(t->al_mac_address, al_mac_address, 6);
+    t->srtt   = 0;
+    t->rttvar = 0;
+    dlist_add_head(&rtts, &t->l);
+
+    return t;
+}
+
+// Timeout of the first transmission of a query to 'al_mac_address'
+//
+static uint32_t _timeout(const uint8_t *al_mac_address)
+{
+    struct _rtt *t;
+    uint32_t     timeout;
+
+    t = _getRtt(al_mac_address, 0);
+    if (NULL == t || 0 == t->srtt)
+    {
+        return REQUEST_INITIAL_TIMEOUT_MS;
+    }
+
+    timeout = t->srtt + 4 * t->rttvar;
+    if (timeout < REQUEST_MIN_TIMEOUT_MS)
+    {
+        timeout = REQUEST_MIN_TIMEOUT_MS;
+    }
+    if (timeout > REQUEST_MAX_TIMEOUT_MS)
+    {
+        timeout = REQUEST_MAX_TIMEOUT_MS;
+    }
+    return timeout;
+}
+
+// Update the round trip time estimation of 'al_mac_address' with a new
+// measure (see RFC 6298)
+//
+static void _sampleRtt(const uint8_t *al_mac_address, uint32_t rtt)
+{
+    struct _rtt *t;
+    uint32_t     delta;
+
+    if (0 == rtt)
+    {
+        rtt = 1;
+    }
+
+    t = _getRtt(al_mac_address, 1);
+    if (0 == t->srtt)
+    {
+        t->srtt   = rtt;
+        t->rttvar = rtt / 2;
+    }
+    else
+    {
+        delta     = t->srtt > rtt ? t->srtt - rtt : rtt - t->srtt;
+        t->rttvar = (3 * t->rttvar + delta) / 4;
+        t->srtt   = (7 * t->srtt + rtt) / 8;
+    }
+}
+
+static void _schedule(struct _request *r, uint32_t deadline)
+{
+    r->deadline = deadline;
+    dlist_add_tail(&wheel[(deadline / REQUEST_WHEEL_TICK_MS) % REQUEST_WHEEL_SLOTS], &r->w);
+}
+
+static void _insert(struct _request *r)
+{
+    dlist_add_tail(&requests_hash[r->mid % REQUEST_HASH_SIZE], &r->h);
+}
+
+static void _free(struct _request *r)
+{
+    dlist_remove(&r->h);
+    dlist_remove(&r->w);
+    if (!r->answered)
+    {
+        stats.outstanding--;
+    }
+    free(r->interface_name);
+    pool_free(r);
+}
+
+static void _answered(struct _request *r, uint32_t now)
+{
+    r->answered = 1;
+    stats.answered++;
+    stats.outstanding--;
+
+    // Keep it around to spot duplicates
+    //
+    dlist_remove(&r->w);
+    _schedule(r, now + REQUEST_DUPLICATE_WINDOW_MS);
+}
+
+static void _expire(struct _request *r, uint32_t now)
+{
+    uint32_t timeout;
+
+    if (r->answered)
+    {
+        _free(r);
+        return;
+    }
+
+    if (r->retries >= REQUEST_MAX_RETRIES)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No response to query 0x%04x sent to %02x:%02x:%02x:%02x:%02x:%02x after %d attempts. Giving up.\n",
+                                      r->query_type, r->al_mac_address[0], r->al_mac_address[1], r->al_mac_address[2],
+                                      r->al_mac_address[3], r->al_mac_address[4], r->al_mac_address[5], r->retries + 1);
+        stats.timeouts++;
+        _free(r);
+        return;
+    }
+
+    // Retransmit it with a new MID (the peer would discard the old one as a
+    // duplicate if only the response was lost), doubling the timeout
+    //
+    r->retries++;
+    stats.retries++;
+
+    timeout = _timeout(r->al_mac_address) << r->retries;
+    if (timeout > REQUEST_MAX_TIMEOUT_MS)
+    {
+        timeout = REQUEST_MAX_TIMEOUT_MS;
+    }
+
+    dlist_remove(&r->h);
+    dlist_remove(&r->w);
+    r->mid            = getNextMid();
+    r->sent_timestamp = now;
+    _insert(r);
+    _schedule(r, now + timeout);
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Retransmitting query 0x%04x to %02x:%02x:%02x:%02x:%02x:%02x (attempt %d, MID %d)\n",
+                                 r->query_type, r->al_mac_address[0], r->al_mac_address[1], r->al_mac_address[2],
+                                 r->al_mac_address[3], r->al_mac_address[4], r->al_mac_address[5], r->retries + 1, r->mid);
+    if (0 == _send(r))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not retransmit query 0x%04x\n", r->query_type);
+    }
+}
+
+// Return the unanswered query of type 'query_type' sent to 'al_mac_address',
+// or NULL
+//
+static struct _request *_outstanding(const uint8_t *al_mac_address, uint16_t query_type)
+{
+    struct _request *r;
+    uint32_t         i;
+
+    for (i = 0; i < REQUEST_HASH_SIZE; i++)
+    {
+        dlist_for_each(r, requests_hash[i], h)
+        {
+            if (!r->answered && r->query_type == query_type && 0 == memcmp(r->al_mac_address, al_mac_address, 6))
+            {
+                return r;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Return '1' if the response received from 'src_mac_address' comes from the AL
+// that 'r' was sent to
+//
+static uint8_t _fromDestination(struct _request *r, uint8_t *src_mac_address)
+{
+    uint8_t *al_mac_address;
+    uint8_t  ret;
+
+    if (0 == memcmp(r->al_mac_address, src_mac_address, 6))
+    {
+        return 1;
+    }
+
+    // Some implementations send their responses from the address of the
+    // interface instead of the AL MAC address
+    //
+    al_mac_address = DMmacToAlMac(src_mac_address);
+    if (NULL == al_mac_address)
+    {
+        return 0;
+    }
+    ret = 0 == memcmp(r->al_mac_address, al_mac_address, 6);
+    free(al_mac_address);
+
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (exported only to files in this same folder)
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t requestSend(const char *interface_name, uint8_t *al_mac_address, uint16_t query_type)
+{
+    struct _request *r;
+    uint32_t         now;
+
+    if (NULL == interface_name)
+    {
+        return 0;
+    }
+
+    if (!initialized)
+    {
+        _init();
+    }
+
+    // The same query is already waiting for its response (which will bring the
+    // same information). Sending another one would not help: the TX scheduler
+    // would merge it with the first one if it is still queued, and its MID
+    // would then never be answered.
+    //
+    if (NULL != _outstanding(al_mac_address, query_type))
+    {
+        PLATFORM_PRINTF_DEBUG_DETAIL("Query 0x%04x to %02x:%02x:%02x:%02x:%02x:%02x already outstanding. Not sent again.\n",
+                                     query_type, al_mac_address[0], al_mac_address[1], al_mac_address[2],
+                                     al_mac_address[3], al_mac_address[4], al_mac_address[5]);
+        stats.merged++;
+        return 1;
+    }
+
+    now = PLATFORM_GET_TIMESTAMP();
+
+    r = pool_alloc(&requests_pool);
+    memcpy(r->al_mac_address, al_mac_address, 6);
+    r->interface_name = memalloc(strlen(interface_name) + 1);
+    strcpy(r->interface_name, interface_name);
+    r->query_type     = query_type;
+    r->mid            = getNextMid();
+    r->sent_timestamp = now;
+
+    if (0 == _send(r))
+    {
+        free(r->interface_name);
+        pool_free(r);
+        return 0;
+    }
+
+    _insert(r);
+    _schedule(r, now + _timeout(al_mac_address));
+
+    stats.sent++;
+    stats.outstanding++;
+
+    return 1;
+}
+
+uint8_t requestResponseReceived(uint8_t *src_mac_address, uint16_t message_type, uint16_t message_id)
+{
+    struct _request *r;
+    uint32_t         now;
+    uint32_t         i;
+
+    if (!initialized)
+    {
+        _init();
+    }
+
+    now = PLATFORM_GET_TIMESTAMP();
+
+    dlist_for_each(r, requests_hash[message_id % REQUEST_HASH_SIZE], h)
+    {
+        if (r->mid == message_id && _responseType(r->query_type) == message_type &&
+            _fromDestination(r, src_mac_address))
+        {
+            if (r->answered)
+            {
+                stats.duplicates++;
+                return REQUEST_RESPONSE_DUPLICATE;
+            }
+
+            _sampleRtt(r->al_mac_address, now - r->sent_timestamp);
+            _answered(r, now);
+
+            return REQUEST_RESPONSE_MATCHED;
+        }
+    }
+
+    // Not the answer to a tracked query. However, it brings the same
+    // information, so there is no point in retransmitting a query of the same
+    // type to the same AL.
+    //
+    stats.unsolicited++;
+
+    for (i = 0; i < REQUEST_HASH_SIZE; i++)
+    {
+        dlist_for_each(r, requests_hash[i], h)
+        {
+            if (!r->answered && _responseType(r->query_type) == message_type && _fromDestination(r, src_mac_address))
+            {
+                _answered(r, now);
+                return REQUEST_RESPONSE_UNSOLICITED;
+            }
+        }
+    }
+
+    return REQUEST_RESPONSE_UNSOLICITED;
+}
+
+uint32_t requestTimeoutsRun(void)
+{
+    struct _request *r;
+    struct _request *next;
+    dlist_head       expired;
+    uint32_t         now;
+    uint32_t         now_tick;
+    uint32_t         tick;
+    uint32_t         i;
+
+    if (!initialized)
+    {
+        return 0;
+    }
+
+    now      = PLATFORM_GET_TIMESTAMP();
+    now_tick = now / REQUEST_WHEEL_TICK_MS;
+
+    // Collect the entries of all the slots that have been left behind (the
+    // slot of the current tick may still contain deadlines in the future).
+    // They are handled afterwards, as retransmissions are added to the wheel.
+    //
+    dlist_head_init(&expired);
+
+    for (tick = wheel_tick + 1, i = 0; tick < now_tick && i < REQUEST_WHEEL_SLOTS; tick++, i++)
+    {
+        dlist_head *slot = &wheel[tick % REQUEST_WHEEL_SLOTS];
+
+        for (r = container_of(slot->next, struct _request, w); &r->w != slot; r = next)
+        {
+            next = container_of(r->w.next, struct _request, w);
+
+            if ((int32_t)(now - r->deadline) >= 0)
+            {
+                dlist_remove(&r->w);
+                dlist_add_tail(&expired, &r->w);
+            }
+        }
+    }
+    if (now_tick > 0)
+    {
+        wheel_tick = now_tick - 1;
+    }
+
+    for (r = container_of(expired.next, struct _request, w); &r->w != &expired; r = next)
+    {
+        next = container_of(r->w.next, struct _request, w);
+        _expire(r, now);
+    }
+
+    // Time until the next slot that has something due
+    //
+    for (tick = now_tick, i = 0; i < REQUEST_WHEEL_SLOTS; tick++, i++)
+    {
+        dlist_for_each(r, wheel[tick % REQUEST_WHEEL_SLOTS], w)
+        {
+            if (r->deadline / REQUEST_WHEEL_TICK_MS == tick)
+            {
+                return (tick + 1) * REQUEST_WHEEL_TICK_MS - now;
+            }
+        }
+    }
+
+    // Deadlines further away than a turn of the wheel (or nothing at all)
+    //
+    for (i = 0; i < REQUEST_WHEEL_SLOTS; i++)
+    {
+        if (!dlist_empty(&wheel[i]))
+        {
+            return REQUEST_WHEEL_SLOTS * REQUEST_WHEEL_TICK_MS;
+        }
+    }
+    return 0;
+}
+
+void requestStatsGet(struct requestStats *s)
+{
+    memcpy(s, &stats, sizeof(*s));
+}
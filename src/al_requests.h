@@ -0,0 +1,120 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _AL_REQUESTS_H_
+#define _AL_REQUESTS_H_
+
+#include "platform.h"
+
+// Queries sent to other ALs ("topology query", "link metric query", "higher
+// layer query" and "generic phy query") are tracked here until their response
+// arrives:
+//
+//   - Each outstanding query is kept in a table indexed by its MID, so that
+//     the response (which carries the same MID) is found in constant time
+//     (see "requestResponseReceived()").
+//
+//   - If no response arrives in time, the query is retransmitted (with a new
+//     MID, so that the peer does not discard it as a duplicate) up to
+//     REQUEST_MAX_RETRIES times, doubling the timeout each time.
+//
+//   - The timeout is derived from the round trip time measured on previous
+//     queries to the same AL (smoothed RTT plus four times its variation, as
+//     TCP does), so that slow neighbors are not flooded with retransmissions
+//     and fast ones are retried quickly.
+//
+//   - Once a query has been answered, it is remembered for a while so that
+//     duplicates of its response can be discarded.
+//
+// Deadlines are kept in a timer wheel, which is advanced by
+// "requestTimeoutsRun()". The AL entity calls it after processing each event
+// (and from a timer while there are deadlines pending).
+//
+// Everything here runs in the AL thread, so there is no locking.
+
+// Timeout of the first query sent to an AL whose round trip time is unknown,
+// and limits of the adaptive timeout (all in milliseconds)
+//
+#define REQUEST_INITIAL_TIMEOUT_MS   (1000)
+#define REQUEST_MIN_TIMEOUT_MS       (200)
+#define REQUEST_MAX_TIMEOUT_MS       (8000)
+
+// Number of retransmissions before giving up
+//
+#define REQUEST_MAX_RETRIES          (3)
+
+// Time during which an answered query is remembered (to discard duplicated
+// responses)
+//
+#define REQUEST_DUPLICATE_WINDOW_MS  (2000)
+
+// Send a query of type 'query_type' (one of CMDU_TYPE_TOPOLOGY_QUERY,
+// CMDU_TYPE_LINK_METRIC_QUERY, CMDU_TYPE_HIGHER_LAYER_QUERY or
+// CMDU_TYPE_GENERIC_PHY_QUERY) to the AL whose AL MAC address is
+// 'al_mac_address', through local interface 'interface_name', and track it
+// until it is answered.
+//
+// If a query of the same type to the same AL is already waiting for its
+// response, nothing is sent (that response will bring the same information).
+//
+// Return '0' if the query could not be sent, '1' otherwise.
+//
+uint8_t requestSend(const char *interface_name, uint8_t *al_mac_address, uint16_t query_type);
+
+// Possible return values of "requestResponseReceived()"
+//
+#define REQUEST_RESPONSE_UNSOLICITED  (0)  // Not the answer to a tracked query
+#define REQUEST_RESPONSE_MATCHED      (1)  // Answer to a tracked query
+#define REQUEST_RESPONSE_DUPLICATE    (2)  // Already received: discard it
+
+// Must be called for every response CMDU (of type 'message_type' and with MID
+// 'message_id') received from 'src_mac_address' before processing it.
+//
+// Responses that do not answer a tracked query (for example, because they
+// were sent to a query from another module, or because they arrived after the
+// query was retransmitted) are not discarded, but they still satisfy any
+// outstanding query of the same type to the same AL.
+//
+uint8_t requestResponseReceived(uint8_t *src_mac_address, uint16_t message_type, uint16_t message_id);
+
+// Retransmit (or give up on) the queries whose deadline has passed, and forget
+// the answered ones that are old enough.
+//
+// Return the time (in milliseconds) after which this function must be called
+// again, or '0' if there is nothing pending.
+//
+uint32_t requestTimeoutsRun(void);
+
+// Tracker statistics, since the AL entity was started
+//
+struct requestStats
+{
+    uint32_t sent;          // Queries sent (not counting retransmissions)
+    uint32_t merged;        // Queries not sent because the same one was
+                            // already outstanding
+    uint32_t answered;      // Queries answered
+    uint32_t retries;       // Retransmissions
+    uint32_t timeouts;      // Queries given up on
+    uint32_t duplicates;    // Duplicated responses discarded
+    uint32_t unsolicited;   // Responses that did not match a tracked query
+    uint32_t outstanding;   // Queries currently waiting for their response
+};
+
+void requestStatsGet(struct requestStats *stats);
+
+#endif
@@ -38,6 +38,9 @@
 #include "platform_alme_server.h"
 
 #include "al_extension.h"
+#include "al_link_metrics.h"
+#include "al_tx_scheduler.h"
+#include "al_cmdu_stats.h"
 
 #include <datamodel.h>
 #include <string.h> // memset(), memcmp(), ...
@@ -295,8 +298,8 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
     *non_1905_neighbors_nr = 0;
     *neighbors_nr          = 0;
 
-    uint8_t (*al_mac_addresses)[6];
-    uint8_t al_mac_addresses_nr;
+    struct DMneighborCursor   cursor;
+    uint8_t                  *al_mac_address;
 
     interfaces_names = PLATFORM_GET_LIST_OF_1905_INTERFACES(&interfaces_names_nr);
 
@@ -313,8 +316,6 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
             continue;
         }
 
-        al_mac_addresses = DMgetListOfInterfaceNeighbors(interfaces_names[i], &al_mac_addresses_nr);
-
         no  = (struct non1905NeighborDeviceListTLV *)memalloc(sizeof(struct non1905NeighborDeviceListTLV));
         yes = (struct neighborDeviceListTLV *)       memalloc(sizeof(struct neighborDeviceListTLV));
 
@@ -342,20 +343,6 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
         //
         if (x->neighbor_mac_addresses_nr != INTERFACE_NEIGHBORS_UNKNOWN)
         {
-            uint8_t *al_mac_address_has_been_reported;
-
-            // Keep track of all the AL MACs that the interface reports he is
-            // seeing.
-            //
-            if (0 != al_mac_addresses_nr)
-            {
-                // Originally, none of the neighbors in the data model has been
-                // reported...
-                //
-                al_mac_address_has_been_reported = (uint8_t *)memalloc(sizeof(uint8_t) * al_mac_addresses_nr);
-                memset(al_mac_address_has_been_reported, 0x0, al_mac_addresses_nr);
-            }
-
             for (j=0; j<x->neighbor_mac_addresses_nr; j++)
             {
                 uint8_t *al_mac;
@@ -410,17 +397,6 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
 
                     uint8_t already_added;
 
-                    // Mark this AL MAC as reported
-                    //
-                    for (k=0; k<al_mac_addresses_nr; k++)
-                    {
-                        if (0 == memcmp(al_mac, al_mac_addresses[k], 6))
-                        {
-                            al_mac_address_has_been_reported[k] = 1;
-                            break;
-                        }
-                    }
-
                     // Make sure it has not already been added
                     //
                     already_added = 0;
@@ -463,21 +439,31 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
             free_1905_INTERFACE_INFO(x);
 
             // Update the datamodel so that those neighbours whose MAC addresses
-            // have not been reported are removed.
+            // have not been reported (ie. those that are not in "yes") are
+            // removed.
             // This will speed up the "removal" of nodes.
             //
-            for (j=0; j<al_mac_addresses_nr; j++)
+            // Removing a neighbour modifies the data model, so the walk starts
+            // again after each removal.
+            //
+            DMinterfaceNeighborsBegin(&cursor, interfaces_names[i]);
+            while (NULL != (al_mac_address = DMinterfaceNeighborsNext(&cursor)))
             {
-                if (0 == al_mac_address_has_been_reported[j])
+                for (k=0; k<yes->neighbors_nr; k++)
                 {
-                    DMremoveALNeighborFromInterface(al_mac_addresses[j], interfaces_names[i]);
+                    if (0 == memcmp(al_mac_address, yes->neighbors[k].mac_address, 6))
+                    {
+                        break;
+                    }
+                }
+
+                if (k == yes->neighbors_nr)
+                {
+                    DMremoveALNeighborFromInterface(al_mac_address, interfaces_names[i]);
                     DMrunGarbageCollector();
+                    DMinterfaceNeighborsBegin(&cursor, interfaces_names[i]);
                 }
             }
-            if (al_mac_addresses_nr > 0 && NULL != al_mac_address_has_been_reported)
-            {
-                free(al_mac_address_has_been_reported);
-            }
         }
         else
         {
@@ -487,7 +473,8 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
             // (which were discovered by us -not the platform- thanks to the
             // topology discovery process) should be returned.
 
-            for (j=0; j<al_mac_addresses_nr; j++)
+            DMinterfaceNeighborsBegin(&cursor, interfaces_names[i]);
+            while (NULL != (al_mac_address = DMinterfaceNeighborsNext(&cursor)))
             {
                 uint8_t already_added;
 
@@ -496,7 +483,7 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
                 already_added = 0;
                 for (k=0; k<yes->neighbors_nr; k++)
                 {
-                    if (0 == memcmp(al_mac_addresses[j], yes->neighbors[k].mac_address, 6))
+                    if (0 == memcmp(al_mac_address, yes->neighbors[k].mac_address, 6))
                     {
                         already_added = 1;
                         break;
@@ -516,20 +503,14 @@ void _obtainLocalNeighborsTLV(struct non1905NeighborDeviceListTLV ***non_1905_ne
                         yes->neighbors = (struct _neighborEntries *)memrealloc(yes->neighbors, sizeof(struct _neighborEntries)*(yes->neighbors_nr+1));
                     }
 
-                    yes->neighbors[yes->neighbors_nr].mac_address[0] = al_mac_addresses[j][0];
-                    yes->neighbors[yes->neighbors_nr].mac_address[1] = al_mac_addresses[j][1];
-                    yes->neighbors[yes->neighbors_nr].mac_address[2] = al_mac_addresses[j][2];
-                    yes->neighbors[yes->neighbors_nr].mac_address[3] = al_mac_addresses[j][3];
-                    yes->neighbors[yes->neighbors_nr].mac_address[4] = al_mac_addresses[j][4];
-                    yes->neighbors[yes->neighbors_nr].mac_address[5] = al_mac_addresses[j][5];
-                    yes->neighbors[yes->neighbors_nr].bridge_flag    = DMisNeighborBridged(interfaces_names[i], al_mac_addresses[j]);
+                    memcpy(yes->neighbors[yes->neighbors_nr].mac_address, al_mac_address, 6);
+                    yes->neighbors[yes->neighbors_nr].bridge_flag    = DMisNeighborBridged(interfaces_names[i], al_mac_address);
 
                     yes->neighbors_nr++;
 
                 }
             }
         }
-        free(al_mac_addresses);
 
         // At this point we have, for this particular interface, all the
         // non 1905 neighbors in "no" and all 1905 neighbors in "yes".
@@ -968,16 +949,23 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
                              struct receiverLinkMetricTLV    ***rx,
                              uint8_t *nr)
 {
-    uint8_t (*al_mac_addresses)[6];
-    uint8_t   al_mac_addresses_nr;
+    struct DMneighborCursor   neighbors;
+    struct DMneighborCursor   links;
+    uint8_t                  *al_mac_address;
+    uint8_t                   al_mac_addresses_nr;
 
     struct transmitterLinkMetricTLV   **tx_tlvs;
     struct receiverLinkMetricTLV      **rx_tlvs;
 
     uint8_t total_tlvs;
-    uint8_t i, j;
+    uint8_t j;
 
-    al_mac_addresses = DMgetListOfNeighbors(&al_mac_addresses_nr);
+    al_mac_addresses_nr = 0;
+    DMneighborsBegin(&neighbors);
+    while (NULL != DMneighborsNext(&neighbors))
+    {
+        al_mac_addresses_nr++;
+    }
 
     // We will need either 1 or 'al_mac_addresses_nr' Rx and/or Tx TLVs,
     // depending on the value of the 'destination' argument (ie. one Rx and/or
@@ -1028,10 +1016,11 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
     // "join" our local node with that neighbor.
     //
     total_tlvs = 0;
-    for (i=0; i<al_mac_addresses_nr; i++)
+    DMneighborsBegin(&neighbors);
+    while (NULL != (al_mac_address = DMneighborsNext(&neighbors)))
     {
-        uint8_t  (*remote_macs)[6];
-        char   **local_interfaces;
+        char      *local_interface;
+        uint8_t   *remote_mac;
         uint8_t    links_nr;
 
         // Check if we are really interested in obtaining metrics information
@@ -1039,7 +1028,7 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
         //
         if (
              LINK_METRIC_QUERY_TLV_SPECIFIC_NEIGHBOR == destination          &&
-             0 != memcmp(al_mac_addresses[i], specific_neighbor, 6)
+             0 != memcmp(al_mac_address, specific_neighbor, 6)
            )
         {
             // Not interested
@@ -1047,10 +1036,15 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
             continue;
         }
 
-        // Obtain the list of "links" that connect our AL node with this
-        // specific neighbor.
+        // Count the "links" that connect our AL node with this specific
+        // neighbor.
         //
-        remote_macs = DMgetListOfLinksWithNeighbor(al_mac_addresses[i], &local_interfaces, &links_nr);
+        links_nr = 0;
+        DMlinksWithNeighborBegin(&links, al_mac_address);
+        while (DMlinksWithNeighborNext(&links, &local_interface, &remote_mac))
+        {
+            links_nr++;
+        }
 
         if (links_nr > 0)
         {
@@ -1064,7 +1058,7 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
 
                                 tx_tlvs[total_tlvs]->tlv.type                    = TLV_TYPE_TRANSMITTER_LINK_METRIC;
                 memcpy(tx_tlvs[total_tlvs]->local_al_address,             DMalMacGet(),                       6);
-                memcpy(tx_tlvs[total_tlvs]->neighbor_al_address,          al_mac_addresses[i],                6);
+                memcpy(tx_tlvs[total_tlvs]->neighbor_al_address,          al_mac_address,                     6);
                                 tx_tlvs[total_tlvs]->transmitter_link_metrics_nr = links_nr;
                                 tx_tlvs[total_tlvs]->transmitter_link_metrics    = memalloc(sizeof(struct _transmitterLinkMetricEntries) * links_nr);
             }
@@ -1074,25 +1068,28 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
 
                                 rx_tlvs[total_tlvs]->tlv.type                    = TLV_TYPE_RECEIVER_LINK_METRIC;
                 memcpy(rx_tlvs[total_tlvs]->local_al_address,             DMalMacGet(),                       6);
-                memcpy(rx_tlvs[total_tlvs]->neighbor_al_address,          al_mac_addresses[i],                6);
+                memcpy(rx_tlvs[total_tlvs]->neighbor_al_address,          al_mac_address,                     6);
                                 rx_tlvs[total_tlvs]->receiver_link_metrics_nr    = links_nr;
                                 rx_tlvs[total_tlvs]->receiver_link_metrics       = memalloc(sizeof(struct _receiverLinkMetricEntries) * links_nr);
             }
 
             // ...and then, for each link, fill the specific link information:
             //
+            DMlinksWithNeighborBegin(&links, al_mac_address);
             for (j=0; j<links_nr; j++)
             {
                 struct interfaceInfo *f;
-                struct linkMetrics   *l;
+                const struct linkMetrics *l;
+
+                DMlinksWithNeighborNext(&links, &local_interface, &remote_mac);
 
-                f = PLATFORM_GET_1905_INTERFACE_INFO(local_interfaces[j]);
-                l = PLATFORM_GET_LINK_METRICS(local_interfaces[j], remote_macs[j]);
+                f = PLATFORM_GET_1905_INTERFACE_INFO(local_interface);
+                l = linkMetricsGet(local_interface, remote_mac);
 
                 if (NULL != tx_tlvs)
                 {
-                    memcpy(tx_tlvs[total_tlvs]->transmitter_link_metrics[j].local_interface_address,    DMinterfaceNameToMac(local_interfaces[j]), 6);
-                    memcpy(tx_tlvs[total_tlvs]->transmitter_link_metrics[j].neighbor_interface_address, remote_macs[j],                            6);
+                    memcpy(tx_tlvs[total_tlvs]->transmitter_link_metrics[j].local_interface_address,    DMinterfaceNameToMac(local_interface), 6);
+                    memcpy(tx_tlvs[total_tlvs]->transmitter_link_metrics[j].neighbor_interface_address, remote_mac,                                6);
 
                     if (NULL == f)
                     {
@@ -1102,7 +1099,7 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
                     {
                         tx_tlvs[total_tlvs]->transmitter_link_metrics[j].intf_type = f->interface_type;
                     }
-                    tx_tlvs[total_tlvs]->transmitter_link_metrics[j].bridge_flag = DMisLinkBridged(local_interfaces[j], al_mac_addresses[i], remote_macs[j]);
+                    tx_tlvs[total_tlvs]->transmitter_link_metrics[j].bridge_flag = DMisLinkBridged(local_interface, al_mac_address, remote_mac);
 
                     if (NULL == l)
                     {
@@ -1124,8 +1121,8 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
 
                 if (NULL != rx_tlvs)
                 {
-                    memcpy(rx_tlvs[total_tlvs]->receiver_link_metrics[j].local_interface_address,    DMinterfaceNameToMac(local_interfaces[j]), 6);
-                    memcpy(rx_tlvs[total_tlvs]->receiver_link_metrics[j].neighbor_interface_address, remote_macs[j],                            6);
+                    memcpy(rx_tlvs[total_tlvs]->receiver_link_metrics[j].local_interface_address,    DMinterfaceNameToMac(local_interface), 6);
+                    memcpy(rx_tlvs[total_tlvs]->receiver_link_metrics[j].neighbor_interface_address, remote_mac,                                6);
 
                     if (NULL == f)
                     {
@@ -1154,20 +1151,12 @@ void _obtainLocalMetricsTLVs(uint8_t destination, uint8_t *specific_neighbor, ui
                 {
                     free_1905_INTERFACE_INFO(f);
                 }
-                if (NULL != l)
-                {
-                    free_LINK_METRICS(l);
-                }
             }
 
             total_tlvs++;
         }
-
-        DMfreeListOfLinksWithNeighbor(remote_macs, local_interfaces, links_nr);
     }
 
-    free(al_mac_addresses);
-
     if (
          LINK_METRIC_QUERY_TLV_SPECIFIC_NEIGHBOR == destination &&
          total_tlvs == 0
@@ -1944,61 +1933,175 @@ void _freeLocalIpsTLVs(struct ipv4TypeTLV *ipv4, struct ipv6TypeTLV *ipv6)
 }
 
 //******************************************************************************
-//******* "Buffer writer" stuff (read below) ***********************************
+//******* "Stream writer" stuff (read below) ***********************************
 //******************************************************************************
 //
-// The following "buffer writer" related variables and functions are used to
-// "trick" the "DMdumpNetworkDevices()" function to print to a memory buffer
+// The following "stream writer" related variables and functions are used to
+// "trick" the "DMdumpNetworkDevices()" function to print to the ALME client
 // instead of to a file descriptor (ex: STDOUT)
 //
-//   TODO: Review this mechanism so that such a huge malloc is not needed.
-//         Because the information contained in this buffer is meant to be sent
-//         through a TCP socket, maybe we could allocate small chunks and keep
-//         sending them through the socket... however this would require several
-//         changes in the way things operate now...
-//         Think about it (and, who knows... maybe we decide to leave it as it
-//         is now after all).
+// The output is accumulated in a small buffer. Every time it is full, its
+// contents are sent to the ALME client as an "ALME-CUSTOM-COMMAND.response"
+// message (containing a NULL terminated piece of text) and the buffer is
+// reused.
+// This way the size of the dump is neither limited by the 16 bits length field
+// of that message nor by the memory available in the AL, and each call to the
+// writer only costs as much as the text it adds.
 //
-#define MEMORY_BUFFER_SIZE (63*1024)
-char   *memory_buffer     = NULL;
-uint16_t  memory_buffer_i   = 0;
+// If a part cannot be sent (ex: the ALME client went away), the rest of the
+// dump is not rendered at all: the writer does nothing until the next
+// "_almeStreamWriterInit()".
+//
+#define ALME_STREAM_CHUNK_SIZE (8*1024)
+
+static struct _almeStreamWriter
+{
+    uint8_t   alme_client_id;
+    uint8_t   failed;                              // A part could not be sent
+    uint16_t  len;                                 // Used bytes of 'buffer', not
+                                                   // counting the final NULL
+    char      buffer[ALME_STREAM_CHUNK_SIZE + 1];  // +1 for the final NULL
+
+} alme_stream;
 
-void _memoryBufferWriterInit()
+static void _almeStreamWriterInit(uint8_t alme_client_id)
 {
-    memory_buffer     = (char *)memalloc(MEMORY_BUFFER_SIZE);
-    memory_buffer_i   = 0;
+    alme_stream.alme_client_id = alme_client_id;
+    alme_stream.failed         = 0;
+    alme_stream.len            = 0;
 }
-void _memoryBufferWriter(const char *fmt, ...)
+
+// Send the contents of the buffer as one part of the ALME reply. 'last' must be
+// set to '1' for the final part (which is sent even if the buffer is empty, or
+// if a previous part failed, so that the platform knows the reply is over).
+//
+// Returns '0' if this or any previous part could not be sent, '1' otherwise.
+//
+static uint8_t _almeStreamFlush(uint8_t last)
 {
-    va_list arglist;
+    struct customCommandResponseALME  out;
+
+    uint8_t    *packet_out;
+    uint16_t    packet_out_len;
 
-    if (memory_buffer_i >= MEMORY_BUFFER_SIZE-1)
+    if (alme_stream.failed)
     {
-        // Too big...
+        // Discard whatever is left
         //
-        PLATFORM_PRINTF_DEBUG_WARNING("Memory buffer overflow.\n");
+        alme_stream.len = 0;
+    }
+
+    if (0 == alme_stream.len && 0 == last)
+    {
+        return !alme_stream.failed;
+    }
+
+    alme_stream.buffer[alme_stream.len] = 0x0;
+
+    out.alme_type = ALME_TYPE_CUSTOM_COMMAND_RESPONSE;
+    out.bytes_nr  = alme_stream.len + 1;
+    out.bytes     = alme_stream.buffer;
+
+    packet_out = forge_1905_ALME_from_structure((uint8_t *)&out, &packet_out_len);
+    if (NULL == packet_out)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_ALME_from_structure() failed.\n");
+    }
+    if (0 == PLATFORM_SEND_ALME_REPLY_PART(alme_stream.alme_client_id, packet_out, NULL == packet_out ? 0 : packet_out_len, last))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send part of the ALME reply. Dropping the rest of it.\n");
+        alme_stream.failed = 1;
+    }
+    if (NULL != packet_out)
+    {
+        free_1905_ALME_packet(packet_out);
+    }
+
+    alme_stream.len = 0;
+
+    return !alme_stream.failed;
+}
+
+static void _almeStreamWriter(const char *fmt, ...)
+{
+    va_list arglist;
+    int     n;
+
+    if (alme_stream.failed)
+    {
         return;
     }
 
     va_start(arglist, fmt);
-    vsnprintf(memory_buffer + memory_buffer_i, MEMORY_BUFFER_SIZE - memory_buffer_i, fmt, arglist);
+    n = vsnprintf(alme_stream.buffer + alme_stream.len, sizeof(alme_stream.buffer) - alme_stream.len, fmt, arglist);
     va_end(arglist);
 
-    memory_buffer[MEMORY_BUFFER_SIZE-1] = 0x0;
-    memory_buffer_i = strlen(memory_buffer);
-    memory_buffer[memory_buffer_i] = 0x0;
+    if (n < 0)
+    {
+        return;
+    }
+    if ((size_t)n <= ALME_STREAM_CHUNK_SIZE - alme_stream.len)
+    {
+        alme_stream.len += n;
+        return;
+    }
 
-    return;
-}
-void _memoryBufferWriterEnd()
-{
-    if (NULL != memory_buffer)
+    // It didn't fit. Send whatever was there before this call and try again
+    // with an empty buffer.
+    //
+    if (alme_stream.len > 0)
+    {
+        if (0 == _almeStreamFlush(0))
+        {
+            return;
+        }
+
+        va_start(arglist, fmt);
+        n = vsnprintf(alme_stream.buffer, sizeof(alme_stream.buffer), fmt, arglist);
+        va_end(arglist);
+
+        if (n < 0)
+        {
+            return;
+        }
+        if (n <= ALME_STREAM_CHUNK_SIZE)
+        {
+            alme_stream.len = n;
+            return;
+        }
+    }
+
+    // A single piece of text which is bigger than a whole chunk. Render it
+    // into a temporary buffer and send it in several parts.
+    //
     {
-        free(memory_buffer);
+        char   *aux;
+        size_t  offset;
+
+        aux = (char *)memalloc(n + 1);
+
+        va_start(arglist, fmt);
+        vsnprintf(aux, n + 1, fmt, arglist);
+        va_end(arglist);
+
+        offset = 0;
+        while ((size_t)n - offset > ALME_STREAM_CHUNK_SIZE)
+        {
+            memcpy(alme_stream.buffer, aux + offset, ALME_STREAM_CHUNK_SIZE);
+            alme_stream.len = ALME_STREAM_CHUNK_SIZE;
+            if (0 == _almeStreamFlush(0))
+            {
+                free(aux);
+                return;
+            }
+
+            offset += ALME_STREAM_CHUNK_SIZE;
+        }
+        memcpy(alme_stream.buffer, aux + offset, n - offset);
+        alme_stream.len = n - offset;
 
-        memory_buffer_i   = 0;
+        free(aux);
     }
-    return;
 }
 
 //******************************************************************************
@@ -2139,210 +2242,289 @@ void _updateLocalDeviceData()
     freeExtendedLocalInfo(&extensions, &extensions_nr);
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// Public functions (exported only to files in this same folder)
-////////////////////////////////////////////////////////////////////////////////
+//******************************************************************************
+//******* Preforged discovery frames *******************************************
+//******************************************************************************
+//
+// "Topology discovery" CMDUs and LLDP "bridge discovery" payloads are sent on
+// every interface each time the discovery timer expires, but their contents
+// only depend on the AL MAC address and on the MAC address of the interface
+// (plus, for the CMDU, on the MID).
+//
+// Because of this, both frames are forged once per interface and kept here.
+// They are forged again when any of the two MAC addresses changes. The only
+// thing done on each send is patching the MID into the preforged CMDU.
+// Templates of interfaces that go away are released by
+// "discoveryTemplatesPrune()".
+//
+// Note that protocol extensions (see "send1905CmduExtensions()") are inserted
+// when the template is built, and not each time it is sent.
+//
 
-uint8_t send1905RawPacket(const char *interface_name, uint16_t mid, const uint8_t *dst_mac_address, struct CMDU *cmdu)
+// Offset of the "message id" field inside a forged CMDU: "message version"
+// (1 byte), "reserved" (1 byte) and "message type" (2 bytes) come before it.
+//
+#define CMDU_MESSAGE_ID_OFFSET (4)
+
+struct _discoveryTemplate
 {
-    uint8_t  **streams;
-    uint16_t  *streams_lens;
+    dlist_item  l;
 
-    uint8_t total_streams, x;
+    char       *interface_name;
+    uint8_t     al_mac_address[6];
+    uint8_t     interface_mac_address[6];
 
-    // Insert protocol extensions to the CMDU, which has been already built at
-    // this point.
+    // Preforged "topology discovery" CMDU (NULL if not forged yet)
     //
-    send1905CmduExtensions(cmdu);
-
-    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of CMDU to send:\n");
-    visit_1905_CMDU_structure(cmdu, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
-
-    streams = forge_1905_CMDU_from_structure(cmdu, &streams_lens);
-    if (NULL == streams)
-    {
-        // Could not forge the packet. Error?
-        //
-        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() failed!\n");
-        return 0;
-    }
+    uint8_t    *topology_discovery;
+    uint16_t    topology_discovery_len;
 
-    // Free previously allocated CMDU extensions (no longer needed)
+    // Preforged LLDP "bridge discovery" payload (NULL if not forged yet)
     //
-    free1905CmduExtensions(cmdu);
+    uint8_t    *bridge_discovery;
+    uint16_t    bridge_discovery_len;
+};
 
-    total_streams = 0;
-    while(streams[total_streams])
-    {
-        total_streams++;
-    }
-
-    if (0 == total_streams)
-    {
-        // Could not forge the packet. Error?
-        //
-        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() returned 0 streams!\n");
+static DEFINE_DLIST_HEAD(discovery_templates);
 
-        free_1905_CMDU_packets(streams);
-        free(streams_lens);
-        return 0;
-    }
+// Release the preforged frames of a template (they will be forged again the
+// next time they are needed)
+//
+static void _invalidateDiscoveryTemplate(struct _discoveryTemplate *t)
+{
+    free(t->topology_discovery);
+    t->topology_discovery     = NULL;
+    t->topology_discovery_len = 0;
 
-    x = 0;
-    while(streams[x])
+    if (NULL != t->bridge_discovery)
     {
-        PLATFORM_PRINTF_DEBUG_DETAIL("Sending 1905 message on interface %s, MID %d, fragment %d/%d\n", interface_name, mid, x+1, total_streams);
-        if (0 == PLATFORM_SEND_RAW_PACKET(interface_name,
-                                          dst_mac_address,
-                                          DMalMacGet(),
-                                          ETHERTYPE_1905,
-                                          streams[x],
-                                          streams_lens[x]))
-        {
-            PLATFORM_PRINTF_DEBUG_ERROR("Packet could not be sent!\n");
-        }
-
-        x++;
+        free_lldp_PAYLOAD_packet(t->bridge_discovery);
     }
-
-    free_1905_CMDU_packets(streams);
-    free(streams_lens);
-
-    return 1;
+    t->bridge_discovery     = NULL;
+    t->bridge_discovery_len = 0;
 }
 
-uint8_t send1905RawALME(uint8_t alme_client_id, uint8_t *alme)
+// Return the template associated to 'interface_name' (a new one is created the
+// first time), making sure its contents match the current AL and interface MAC
+// addresses.
+//
+static struct _discoveryTemplate *_getDiscoveryTemplate(const char *interface_name)
 {
-    uint8_t    *packet_out;
-    uint16_t    packet_out_len;
+    struct _discoveryTemplate *t;
+    uint8_t                   *al_mac_address;
+    uint8_t                   *interface_mac_address;
 
-    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of ALME reply to send:\n");
-    visit_1905_ALME_structure((uint8_t *)alme, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+    al_mac_address        = DMalMacGet();
+    interface_mac_address = DMinterfaceNameToMac(interface_name);
 
-    // Use the getIntfListResponseALME structure to forge the packet
-    // bit stream
-    //
-    packet_out = forge_1905_ALME_from_structure((uint8_t *)alme, &packet_out_len);
-    if (NULL == packet_out)
+    dlist_for_each(t, discovery_templates, l)
     {
-        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_ALME_from_structure() failed.\n");
-
-        PLATFORM_SEND_ALME_REPLY(alme_client_id, NULL, 0);
-        return 0;
+        if (0 == strcmp(t->interface_name, interface_name))
+        {
+            if (0 != memcmp(t->al_mac_address,        al_mac_address,        6) ||
+                0 != memcmp(t->interface_mac_address, interface_mac_address, 6))
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("MAC address changed. Discovery frames for interface %s will be forged again\n", interface_name);
+                _invalidateDiscoveryTemplate(t);
+                memcpy(t->al_mac_address,        al_mac_address,        6);
+                memcpy(t->interface_mac_address, interface_mac_address, 6);
+            }
+            return t;
+        }
     }
 
-    // Send the ALME reply back
-    //
-    PLATFORM_SEND_ALME_REPLY(alme_client_id, packet_out, packet_out_len);
-
-    free_1905_ALME_packet(packet_out);
+    t = (struct _discoveryTemplate *)zmemalloc(sizeof(struct _discoveryTemplate));
+    t->interface_name = strdup(interface_name);
+    memcpy(t->al_mac_address,        al_mac_address,        6);
+    memcpy(t->interface_mac_address, interface_mac_address, 6);
+    dlist_add_tail(&discovery_templates, &t->l);
 
-    return 1;
+    return t;
 }
 
-uint8_t send1905TopologyDiscoveryPacket(const char *interface_name, uint16_t mid)
+// Build the "topology discovery" CMDU for the interface of template 't' and
+// keep its bit stream there. Returns "0" on error.
+//
+static uint8_t _forgeTopologyDiscovery(struct _discoveryTemplate *t)
 {
     // The "topology discovery" message is a CMDU with two TLVs:
     //   - One AL MAC address type TLV
     //   - One MAC address type TLV
 
-    uint8_t  interface_mac_address[6];
-
-    uint8_t  mcast_address[] = MCAST_1905;
-
-    struct CMDU                discovery_message;
+    struct CMDU                 discovery_message;
     struct alMacAddressTypeTLV *al_mac_addr_tlv;
-    struct macAddressTypeTLV   *mac_addr_tlv = X1905_TLV_ALLOC(macAddressType, TLV_TYPE_MAC_ADDRESS_TYPE, NULL);
-
-    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_DISCOVERY (%s)\n", interface_name);
+    struct macAddressTypeTLV   *mac_addr_tlv;
 
-    memcpy(interface_mac_address, DMinterfaceNameToMac(interface_name), 6);
+    uint8_t  **streams;
+    uint16_t  *streams_lens;
+    uint32_t   start;
+    uint8_t    ret = 0;
 
     // Fill the AL MAC address type TLV
     //
-    al_mac_addr_tlv = _obtainLocalAlMacAddressTLV(NULL);
+    al_mac_addr_tlv = X1905_TLV_ALLOC(alMacAddressType, TLV_TYPE_AL_MAC_ADDRESS_TYPE, NULL);
+    memcpy(al_mac_addr_tlv->al_mac_address, t->al_mac_address, 6);
 
     // Fill the MAC address type TLV
     //
-    memcpy(mac_addr_tlv->mac_address, interface_mac_address, 6);
+    mac_addr_tlv = X1905_TLV_ALLOC(macAddressType, TLV_TYPE_MAC_ADDRESS_TYPE, NULL);
+    memcpy(mac_addr_tlv->mac_address, t->interface_mac_address, 6);
 
-    // Build the CMDU
+    // Build the CMDU. The MID is patched in each time the stream is sent.
     //
     discovery_message.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
     discovery_message.message_type    = CMDU_TYPE_TOPOLOGY_DISCOVERY;
-    discovery_message.message_id      = mid;
+    discovery_message.message_id      = 0;
     discovery_message.relay_indicator = 0;
+    discovery_message.tlv_index       = NULL;
     discovery_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*3);
     discovery_message.list_of_TLVs[0] = &al_mac_addr_tlv->tlv;
     discovery_message.list_of_TLVs[1] = &mac_addr_tlv->tlv;
     discovery_message.list_of_TLVs[2] = NULL;
 
-    // Send the packet
-    //
-    if (0 == send1905RawPacket(interface_name, mid, mcast_address, &discovery_message))
-    {
-        PLATFORM_PRINTF_DEBUG_ERROR("Could not send the 1905 packet\n");
-        free(discovery_message.list_of_TLVs);
-        return 0;
-    }
-
-    free(discovery_message.list_of_TLVs);
-    return 1;
-}
-
-uint8_t send1905TopologyQueryPacket(const char *interface_name, uint16_t mid, uint8_t *destination_al_mac_address)
-{
-    // The "topology query" message is a CMDU with no TLVs
-
-    uint8_t ret;
+    send1905CmduExtensions(&discovery_message);
 
-    struct CMDU  query_message;
+    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of CMDU to send:\n");
+    visit_1905_CMDU_structure(&discovery_message, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
 
-    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_QUERY (%s)\n", interface_name);
-    PLATFORM_PRINTF_DEBUG_DETAIL("Sending to %02x:%02x:%02x:%02x:%02x:%02x\n", destination_al_mac_address[0], destination_al_mac_address[1], destination_al_mac_address[2], destination_al_mac_address[3], destination_al_mac_address[4], destination_al_mac_address[5]);
+    start = cmduStatsClock();
+    streams = forge_1905_CMDU_from_structure(&discovery_message, &streams_lens);
+    cmduStatsElapsed(CMDU_TYPE_TOPOLOGY_DISCOVERY, CMDU_STATS_STAGE_FORGE, start);
 
-    // Build the CMDU
-    //
-    query_message.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
-    query_message.message_type    = CMDU_TYPE_TOPOLOGY_QUERY;
-    query_message.message_id      = mid;
-    query_message.relay_indicator = 0;
-    query_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *));
-    query_message.list_of_TLVs[0] = NULL;
+    free1905CmduExtensions(&discovery_message);
 
-    // Send the packet
-    //
-    if (0 == send1905RawPacket(interface_name, mid, destination_al_mac_address, &query_message))
+    if (NULL == streams)
     {
-        PLATFORM_PRINTF_DEBUG_WARNING("Could not send packet\n");
-        ret = 0;
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() failed!\n");
+    }
+    else if (NULL == streams[0] || NULL != streams[1])
+    {
+        // Only single fragment CMDUs can be preforged (this one is always
+        // small enough to fit in one)
+        //
+        PLATFORM_PRINTF_DEBUG_WARNING("Topology discovery CMDU does not fit in one fragment\n");
     }
     else
     {
+        t->topology_discovery     = (uint8_t *)memalloc(streams_lens[0]);
+        t->topology_discovery_len = streams_lens[0];
+        memcpy(t->topology_discovery, streams[0], streams_lens[0]);
         ret = 1;
     }
 
-    // Free memory
-    //
-    free(query_message.list_of_TLVs);
+    if (NULL != streams)
+    {
+        free_1905_CMDU_packets(streams);
+        free(streams_lens);
+    }
+
+    free_1905_TLV_structure(&al_mac_addr_tlv->tlv);
+    free_1905_TLV_structure(&mac_addr_tlv->tlv);
+    free(discovery_message.list_of_TLVs);
 
     return ret;
 }
 
-uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid, uint8_t* destination_al_mac_address)
+// Build the LLDP "bridge discovery" payload for the interface of template 't'
+// and keep its bit stream there. Returns "0" on error.
+//
+static uint8_t _forgeBridgeDiscovery(struct _discoveryTemplate *t)
 {
-    // The "topology response" message is a CMDU with the following TLVs:
-    //   - One device information type TLV
-    //   - Zero or one device bridging capability TLVs
-    //   - Zero or more non-1905 neighbor device list TLVs
-    //   - Zero or more 1905 neighbor device list TLVs
-    //   - Zero or more power off interface TLVs
-    //   - Zero or more L2 neighbor device TLVs
-    //
-    // The "Multi-AP Specification Version 1.0" adds the following TLVs:
-    //   - Zero or one supported service TLV
-    //   - One AP Operational BSS TLV
-    //   - Zero or one Associated Clients TLV
+    struct chassisIdTLV      chassis_id_tlv;
+    struct portIdTLV         port_id_tlv;
+    struct timeToLiveTypeTLV time_to_live_tlv;
+
+    struct PAYLOAD payload;
+
+    // Fill the chassis ID TLV
+    //
+    chassis_id_tlv.tlv.type           = TLV_TYPE_CHASSIS_ID;
+    chassis_id_tlv.chassis_id_subtype = CHASSIS_ID_TLV_SUBTYPE_MAC_ADDRESS;
+    memcpy(chassis_id_tlv.chassis_id, t->al_mac_address, 6);
+
+    // Fill the port ID TLV
+    //
+    port_id_tlv.tlv.type            = TLV_TYPE_PORT_ID;
+    port_id_tlv.port_id_subtype     = PORT_ID_TLV_SUBTYPE_MAC_ADDRESS;
+    memcpy(port_id_tlv.port_id, t->interface_mac_address, 6);
+
+    // Fill the time to live TLV
+    //
+    time_to_live_tlv.tlv.type       = TLV_TYPE_TIME_TO_LIVE;
+    time_to_live_tlv.ttl            = TIME_TO_LIVE_TLV_1905_DEFAULT_VALUE;
+
+    // Forge the LLDP payload containing all these TLVs
+    //
+    payload.list_of_TLVs[0] = &chassis_id_tlv.tlv;
+    payload.list_of_TLVs[1] = &port_id_tlv.tlv;
+    payload.list_of_TLVs[2] = &time_to_live_tlv.tlv;
+    payload.list_of_TLVs[3] = NULL;
+
+    t->bridge_discovery = forge_lldp_PAYLOAD_from_structure(&payload, &t->bridge_discovery_len);
+    if (NULL == t->bridge_discovery)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_lldp_PAYLOAD_from_structure() failed!\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+//******************************************************************************
+//******* Preforged topology response ******************************************
+//******************************************************************************
+//
+// Every neighbor (and, when the whole network is mapped, every node of the
+// network) sends us "topology queries" over and over. Collecting the TLVs of
+// the response means querying the platform for every interface, so the
+// response is forged once and kept here until something changes:
+//
+//   - The data model changes (see "datamodel_generation").
+//
+//   - A platform event that may change the local topology is received (see
+//     "invalidateTopologyResponse()").
+//
+//   - It is older than TOPOLOGY_RESPONSE_MAX_AGE_MS. Some of the information
+//     reported by the platform (power state, neighbors seen by the driver,
+//     ...) changes without any event.
+//
+// Answering a query then only means patching the MID into the preforged
+// streams and sending them.
+//
+#define TOPOLOGY_RESPONSE_MAX_AGE_MS (5000)
+
+static struct _topologyResponse
+{
+    // Preforged streams (one per fragment, NULL terminated) and their lengths
+    // (NULL if not forged yet)
+    //
+    uint8_t    **streams;
+    uint16_t    *streams_lens;
+
+    // Value of "datamodel_generation" and time when they were forged
+    //
+    uint32_t     generation;
+    uint32_t     timestamp;
+
+} topology_response;
+
+// Build the "topology response" CMDU and keep its bit streams in
+// "topology_response". Returns "0" on error.
+//
+static uint8_t _forgeTopologyResponse(void)
+{
+    // The "topology response" message is a CMDU with the following TLVs:
+    //   - One device information type TLV
+    //   - Zero or one device bridging capability TLVs
+    //   - Zero or more non-1905 neighbor device list TLVs
+    //   - Zero or more 1905 neighbor device list TLVs
+    //   - Zero or more power off interface TLVs
+    //   - Zero or more L2 neighbor device TLVs
+    //
+    // The "Multi-AP Specification Version 1.0" adds the following TLVs:
+    //   - Zero or one supported service TLV
+    //   - One AP Operational BSS TLV
+    //   - Zero or one Associated Clients TLV
     //
     //   NOTE: The "non-1905 neighbor" and the "L2 neighbor" device TLVs are
     //   kind of overlaping... but this is what the standard says.
@@ -2358,7 +2540,7 @@ uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid,
     //   NOTE: Since a compliant implementation should ignore unknown TLVs, we can simply always send the Multi-AP
     //   TLVs
 
-    uint8_t  ret;
+    uint8_t  ret = 0;
 
     struct CMDU                            response_message;
     struct deviceInformationTypeTLV        device_info;
@@ -2376,8 +2558,11 @@ uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid,
     uint8_t                                 total_tlvs            = 0;
     uint8_t                                 i, j;
 
-    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_RESPONSE (%s)\n", interface_name);
-    PLATFORM_PRINTF_DEBUG_DETAIL("Sending to %02x:%02x:%02x:%02x:%02x:%02x\n", destination_al_mac_address[0], destination_al_mac_address[1], destination_al_mac_address[2], destination_al_mac_address[3], destination_al_mac_address[4], destination_al_mac_address[5]);
+    uint8_t                               **streams;
+    uint16_t                               *streams_lens;
+    uint32_t                                start;
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Local topology changed. Forging a new topology response...\n");
 
     // Fill all the needed TLVs
     //
@@ -2422,8 +2607,9 @@ uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid,
 
     response_message.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
     response_message.message_type    = CMDU_TYPE_TOPOLOGY_RESPONSE;
-    response_message.message_id      = mid;
+    response_message.message_id      = 0;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
     response_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*(total_tlvs+1));
     response_message.list_of_TLVs[0] = &device_info.tlv;
 
@@ -2464,18 +2650,43 @@ uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid,
 
     response_message.list_of_TLVs[i] = NULL;
 
-    // Send the packet
+    // Forge it. The MID is patched in each time the streams are sent.
     //
-    if (0 == send1905RawPacket(interface_name, mid, destination_al_mac_address, &response_message))
+    send1905CmduExtensions(&response_message);
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of CMDU to send:\n");
+    visit_1905_CMDU_structure(&response_message, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+
+    start = cmduStatsClock();
+    streams = forge_1905_CMDU_from_structure(&response_message, &streams_lens);
+    cmduStatsElapsed(CMDU_TYPE_TOPOLOGY_RESPONSE, CMDU_STATS_STAGE_FORGE, start);
+
+    free1905CmduExtensions(&response_message);
+
+    if (NULL == streams)
     {
-        PLATFORM_PRINTF_DEBUG_WARNING("Could not send packet\n");
-        ret = 0 ;
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() failed!\n");
+    }
+    else if (NULL == streams[0])
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() returned 0 streams!\n");
+        free_1905_CMDU_packets(streams);
+        free(streams_lens);
     }
     else
     {
+        topology_response.streams      = streams;
+        topology_response.streams_lens = streams_lens;
         ret = 1;
     }
 
+    // Collecting the TLVs above may have updated the data model (neighbors
+    // that the platform no longer reports are removed), so the generation is
+    // only recorded now.
+    //
+    topology_response.generation = datamodel_generation;
+    topology_response.timestamp  = PLATFORM_GET_TIMESTAMP();
+
     // Free all allocated (and no longer needed) memory
     //
     _freeLocalDeviceInfoTLV          (&device_info);
@@ -2491,6 +2702,215 @@ uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid,
     return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (exported only to files in this same folder)
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t send1905RawPacket(const char *interface_name, uint16_t mid, const uint8_t *dst_mac_address, struct CMDU *cmdu)
+{
+    uint8_t  **streams;
+    uint16_t  *streams_lens;
+    uint32_t   start;
+
+    uint8_t total_streams, ret;
+
+    // Insert protocol extensions to the CMDU, which has been already built at
+    // this point.
+    //
+    send1905CmduExtensions(cmdu);
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of CMDU to send:\n");
+    visit_1905_CMDU_structure(cmdu, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+
+    start = cmduStatsClock();
+    streams = forge_1905_CMDU_from_structure(cmdu, &streams_lens);
+    cmduStatsElapsed(cmdu->message_type, CMDU_STATS_STAGE_FORGE, start);
+    if (NULL == streams)
+    {
+        // Could not forge the packet. Error?
+        //
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() failed!\n");
+        return 0;
+    }
+
+    // Free previously allocated CMDU extensions (no longer needed)
+    //
+    free1905CmduExtensions(cmdu);
+
+    total_streams = 0;
+    while(streams[total_streams])
+    {
+        total_streams++;
+    }
+
+    if (0 == total_streams)
+    {
+        // Could not forge the packet. Error?
+        //
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_CMDU_from_structure() returned 0 streams!\n");
+
+        free_1905_CMDU_packets(streams);
+        free(streams_lens);
+        return 0;
+    }
+
+    ret = txSchedulerSend(interface_name, dst_mac_address, DMalMacGet(), ETHERTYPE_1905, streams, streams_lens);
+
+    free_1905_CMDU_packets(streams);
+    free(streams_lens);
+
+    return ret;
+}
+
+uint8_t send1905RawALME(uint8_t alme_client_id, uint8_t *alme)
+{
+    uint8_t    *packet_out;
+    uint16_t    packet_out_len;
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("Contents of ALME reply to send:\n");
+    visit_1905_ALME_structure((uint8_t *)alme, print_callback, PLATFORM_PRINTF_DEBUG_DETAIL, "");
+
+    // Use the getIntfListResponseALME structure to forge the packet
+    // bit stream
+    //
+    packet_out = forge_1905_ALME_from_structure((uint8_t *)alme, &packet_out_len);
+    if (NULL == packet_out)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("forge_1905_ALME_from_structure() failed.\n");
+
+        PLATFORM_SEND_ALME_REPLY(alme_client_id, NULL, 0);
+        return 0;
+    }
+
+    // Send the ALME reply back
+    //
+    PLATFORM_SEND_ALME_REPLY(alme_client_id, packet_out, packet_out_len);
+
+    free_1905_ALME_packet(packet_out);
+
+    return 1;
+}
+
+uint8_t send1905TopologyDiscoveryPacket(const char *interface_name, uint16_t mid)
+{
+    // The "topology discovery" message only depends on the AL and interface
+    // MAC addresses, so it is forged once and reused (see
+    // "_getDiscoveryTemplate()")
+
+    uint8_t  mcast_address[] = MCAST_1905;
+    uint8_t *streams[2];
+
+    struct _discoveryTemplate *t;
+
+    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_DISCOVERY (%s)\n", interface_name);
+
+    t = _getDiscoveryTemplate(interface_name);
+    if (NULL == t->topology_discovery && 0 == _forgeTopologyDiscovery(t))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("Could not send the 1905 packet\n");
+        return 0;
+    }
+
+    // Patch the MID
+    //
+    t->topology_discovery[CMDU_MESSAGE_ID_OFFSET]     = (uint8_t)(mid >> 8);
+    t->topology_discovery[CMDU_MESSAGE_ID_OFFSET + 1] = (uint8_t)(mid & 0xff);
+
+    streams[0] = t->topology_discovery;
+    streams[1] = NULL;
+
+    return txSchedulerSend(interface_name, mcast_address, t->al_mac_address, ETHERTYPE_1905, streams, &t->topology_discovery_len);
+}
+
+uint8_t send1905TopologyQueryPacket(const char *interface_name, uint16_t mid, uint8_t *destination_al_mac_address)
+{
+    // The "topology query" message is a CMDU with no TLVs
+
+    uint8_t ret;
+
+    struct CMDU  query_message;
+
+    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_QUERY (%s)\n", interface_name);
+    PLATFORM_PRINTF_DEBUG_DETAIL("Sending to %02x:%02x:%02x:%02x:%02x:%02x\n", destination_al_mac_address[0], destination_al_mac_address[1], destination_al_mac_address[2], destination_al_mac_address[3], destination_al_mac_address[4], destination_al_mac_address[5]);
+
+    // Build the CMDU
+    //
+    query_message.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
+    query_message.message_type    = CMDU_TYPE_TOPOLOGY_QUERY;
+    query_message.message_id      = mid;
+    query_message.relay_indicator = 0;
+    query_message.tlv_index       = NULL;
+    query_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *));
+    query_message.list_of_TLVs[0] = NULL;
+
+    // Send the packet
+    //
+    if (0 == send1905RawPacket(interface_name, mid, destination_al_mac_address, &query_message))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send packet\n");
+        ret = 0;
+    }
+    else
+    {
+        ret = 1;
+    }
+
+    // Free memory
+    //
+    free(query_message.list_of_TLVs);
+
+    return ret;
+}
+
+uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid, uint8_t* destination_al_mac_address)
+{
+    // The "topology response" contents don't depend on who is asking, so it is
+    // forged once and reused (see "_forgeTopologyResponse()")
+
+    uint8_t x;
+
+    PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_TOPOLOGY_RESPONSE (%s)\n", interface_name);
+    PLATFORM_PRINTF_DEBUG_DETAIL("Sending to %02x:%02x:%02x:%02x:%02x:%02x\n", destination_al_mac_address[0], destination_al_mac_address[1], destination_al_mac_address[2], destination_al_mac_address[3], destination_al_mac_address[4], destination_al_mac_address[5]);
+
+    if (NULL != topology_response.streams &&
+        (topology_response.generation != datamodel_generation ||
+         PLATFORM_GET_TIMESTAMP() - topology_response.timestamp > TOPOLOGY_RESPONSE_MAX_AGE_MS))
+    {
+        invalidateTopologyResponse();
+    }
+
+    if (NULL == topology_response.streams && 0 == _forgeTopologyResponse())
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not send packet\n");
+        return 0;
+    }
+
+    x = 0;
+    while (topology_response.streams[x])
+    {
+        // Patch the MID
+        //
+        topology_response.streams[x][CMDU_MESSAGE_ID_OFFSET]     = (uint8_t)(mid >> 8);
+        topology_response.streams[x][CMDU_MESSAGE_ID_OFFSET + 1] = (uint8_t)(mid & 0xff);
+
+        x++;
+    }
+
+    return txSchedulerSend(interface_name, destination_al_mac_address, DMalMacGet(), ETHERTYPE_1905,
+                           topology_response.streams, topology_response.streams_lens);
+}
+
+void invalidateTopologyResponse(void)
+{
+    if (NULL != topology_response.streams)
+    {
+        free_1905_CMDU_packets(topology_response.streams);
+        free(topology_response.streams_lens);
+    }
+    topology_response.streams      = NULL;
+    topology_response.streams_lens = NULL;
+}
+
 uint8_t send1905TopologyNotificationPacket(const char *interface_name, uint16_t mid)
 {
     // The "topology discovery" message is a CMDU with one TLVs:
@@ -2515,6 +2935,7 @@ uint8_t send1905TopologyNotificationPacket(const char *interface_name, uint16_t
     discovery_message.message_type    = CMDU_TYPE_TOPOLOGY_NOTIFICATION;
     discovery_message.message_id      = mid;
     discovery_message.relay_indicator = 0;
+    discovery_message.tlv_index       = NULL;
     discovery_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*3);
     discovery_message.list_of_TLVs[0] = &al_mac_addr_tlv->tlv;
     discovery_message.list_of_TLVs[1] = NULL;
@@ -2560,6 +2981,7 @@ uint8_t send1905MetricsQueryPacket(const char *interface_name, uint16_t mid, uin
     query_message.message_type    = CMDU_TYPE_LINK_METRIC_QUERY;
     query_message.message_id      = mid;
     query_message.relay_indicator = 0;
+    query_message.tlv_index       = NULL;
     query_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*2);
     query_message.list_of_TLVs[0] = &metric_query_tlv->tlv;
     query_message.list_of_TLVs[1] = NULL;
@@ -2626,6 +3048,7 @@ uint8_t send1905MetricsResponsePacket(const char *interface_name, uint16_t mid,
     response_message.message_type    = CMDU_TYPE_LINK_METRIC_RESPONSE;
     response_message.message_id      = mid;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
 
     if (NULL == tx_tlvs || NULL == rx_tlvs)
     {
@@ -2954,6 +3377,7 @@ uint8_t send1905PushButtonEventNotificationPacket(const char *interface_name, ui
     notification_message.message_type        = CMDU_TYPE_PUSH_BUTTON_EVENT_NOTIFICATION;
     notification_message.message_id          = mid;
     notification_message.relay_indicator     = 1;
+    notification_message.tlv_index           = NULL;
 
     if (generic_media_types_nr != 0)
     {
@@ -3015,7 +3439,7 @@ uint8_t send1905PushButtonJoinNotificationPacket(const char *interface_name, uin
     uint8_t  mcast_address[] = MCAST_1905;
 
     struct CMDU                             notification_message;
-    struct pushButtonJoinNotificationTLV    pb_join_tlv;
+    struct pushButtonJoinNotificationTLV   *pb_join_tlv;
 
     PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION (%s)\n", interface_name);
 
@@ -3023,26 +3447,26 @@ uint8_t send1905PushButtonJoinNotificationPacket(const char *interface_name, uin
 
     // Fill the push button join notification TLV
     //
-    pb_join_tlv.tlv.type           = TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION;
-    pb_join_tlv.al_mac_address[0]  = original_al_mac_address[0];
-    pb_join_tlv.al_mac_address[1]  = original_al_mac_address[1];
-    pb_join_tlv.al_mac_address[2]  = original_al_mac_address[2];
-    pb_join_tlv.al_mac_address[3]  = original_al_mac_address[3];
-    pb_join_tlv.al_mac_address[4]  = original_al_mac_address[4];
-    pb_join_tlv.al_mac_address[5]  = original_al_mac_address[5];
-    pb_join_tlv.message_identifier = original_mid;
-    pb_join_tlv.mac_address[0]     = local_mac_address[0];
-    pb_join_tlv.mac_address[1]     = local_mac_address[1];
-    pb_join_tlv.mac_address[2]     = local_mac_address[2];
-    pb_join_tlv.mac_address[3]     = local_mac_address[3];
-    pb_join_tlv.mac_address[4]     = local_mac_address[4];
-    pb_join_tlv.mac_address[5]     = local_mac_address[5];
-    pb_join_tlv.new_mac_address[0] = local_mac_address[0];
-    pb_join_tlv.new_mac_address[1] = new_mac_address[1];
-    pb_join_tlv.new_mac_address[2] = new_mac_address[2];
-    pb_join_tlv.new_mac_address[3] = new_mac_address[3];
-    pb_join_tlv.new_mac_address[4] = new_mac_address[4];
-    pb_join_tlv.new_mac_address[5] = new_mac_address[5];
+    pb_join_tlv = X1905_TLV_ALLOC(pushButtonJoinNotification, TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION, NULL);
+    pb_join_tlv->al_mac_address[0]  = original_al_mac_address[0];
+    pb_join_tlv->al_mac_address[1]  = original_al_mac_address[1];
+    pb_join_tlv->al_mac_address[2]  = original_al_mac_address[2];
+    pb_join_tlv->al_mac_address[3]  = original_al_mac_address[3];
+    pb_join_tlv->al_mac_address[4]  = original_al_mac_address[4];
+    pb_join_tlv->al_mac_address[5]  = original_al_mac_address[5];
+    pb_join_tlv->message_identifier = original_mid;
+    pb_join_tlv->mac_address[0]     = local_mac_address[0];
+    pb_join_tlv->mac_address[1]     = local_mac_address[1];
+    pb_join_tlv->mac_address[2]     = local_mac_address[2];
+    pb_join_tlv->mac_address[3]     = local_mac_address[3];
+    pb_join_tlv->mac_address[4]     = local_mac_address[4];
+    pb_join_tlv->mac_address[5]     = local_mac_address[5];
+    pb_join_tlv->new_mac_address[0] = local_mac_address[0];
+    pb_join_tlv->new_mac_address[1] = new_mac_address[1];
+    pb_join_tlv->new_mac_address[2] = new_mac_address[2];
+    pb_join_tlv->new_mac_address[3] = new_mac_address[3];
+    pb_join_tlv->new_mac_address[4] = new_mac_address[4];
+    pb_join_tlv->new_mac_address[5] = new_mac_address[5];
 
     // Build the CMDU
     //
@@ -3050,9 +3474,10 @@ uint8_t send1905PushButtonJoinNotificationPacket(const char *interface_name, uin
     notification_message.message_type    = CMDU_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION;
     notification_message.message_id      = mid;
     notification_message.relay_indicator = 1;
+    notification_message.tlv_index       = NULL;
     notification_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*3);
     notification_message.list_of_TLVs[0] = &_obtainLocalAlMacAddressTLV(NULL)->tlv;
-    notification_message.list_of_TLVs[1] = &pb_join_tlv.tlv;
+    notification_message.list_of_TLVs[1] = &pb_join_tlv->tlv;
     notification_message.list_of_TLVs[2] = NULL;
 
     // Send the packet
@@ -3067,6 +3492,7 @@ uint8_t send1905PushButtonJoinNotificationPacket(const char *interface_name, uin
         ret = 1;
     }
 
+    free_1905_TLV_structure(&pb_join_tlv->tlv);
     free(notification_message.list_of_TLVs);
 
     return ret;
@@ -3084,8 +3510,8 @@ uint8_t send1905APAutoconfigurationSearchPacket(const char *interface_name, uint
     uint8_t  mcast_address[] = MCAST_1905;
 
     struct CMDU                   search_message;
-    struct searchedRoleTLV        searched_role_tlv;
-    struct autoconfigFreqBandTLV  ac_freq_band_tlv;
+    struct searchedRoleTLV        *searched_role_tlv;
+    struct autoconfigFreqBandTLV  *ac_freq_band_tlv;
     struct supportedServiceTLV    *supported_service_tlv;
     struct supportedServiceTLV    *searched_service_tlv;
 
@@ -3093,13 +3519,13 @@ uint8_t send1905APAutoconfigurationSearchPacket(const char *interface_name, uint
 
     // Fill the searched role TLV
     //
-    searched_role_tlv.tlv.type = TLV_TYPE_SEARCHED_ROLE;
-    searched_role_tlv.role     = IEEE80211_ROLE_AP;
+    searched_role_tlv = X1905_TLV_ALLOC(searchedRole, TLV_TYPE_SEARCHED_ROLE, NULL);
+    searched_role_tlv->role = IEEE80211_ROLE_AP;
 
     // Fill the autoconfig freq band TLV
     //
-    ac_freq_band_tlv.tlv.type  = TLV_TYPE_AUTOCONFIG_FREQ_BAND;
-    ac_freq_band_tlv.freq_band = freq_band;
+    ac_freq_band_tlv = X1905_TLV_ALLOC(autoconfigFreqBand, TLV_TYPE_AUTOCONFIG_FREQ_BAND, NULL);
+    ac_freq_band_tlv->freq_band = freq_band;
 
     supported_service_tlv = _obtainLocalSupportedServicesTLV(NULL);
 
@@ -3113,10 +3539,11 @@ uint8_t send1905APAutoconfigurationSearchPacket(const char *interface_name, uint
     search_message.message_type    = CMDU_TYPE_AP_AUTOCONFIGURATION_SEARCH;
     search_message.message_id      = mid;
     search_message.relay_indicator = 1;
+    search_message.tlv_index       = NULL;
     search_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*6);
     search_message.list_of_TLVs[0] = &_obtainLocalAlMacAddressTLV(NULL)->tlv;
-    search_message.list_of_TLVs[1] = &searched_role_tlv.tlv;
-    search_message.list_of_TLVs[2] = &ac_freq_band_tlv.tlv;
+    search_message.list_of_TLVs[1] = &searched_role_tlv->tlv;
+    search_message.list_of_TLVs[2] = &ac_freq_band_tlv->tlv;
     search_message.list_of_TLVs[3] = &supported_service_tlv->tlv;
     search_message.list_of_TLVs[4] = &searched_service_tlv->tlv;
     search_message.list_of_TLVs[5] = NULL;
@@ -3135,6 +3562,8 @@ uint8_t send1905APAutoconfigurationSearchPacket(const char *interface_name, uint
     //
     /** @todo free supported services */
 
+    free_1905_TLV_structure(&searched_role_tlv->tlv);
+    free_1905_TLV_structure(&ac_freq_band_tlv->tlv);
     free(search_message.list_of_TLVs);
 
     return ret;
@@ -3150,21 +3579,21 @@ uint8_t send1905APAutoconfigurationResponsePacket(const char *interface_name, ui
     uint8_t ret;
 
     struct CMDU                  response_message;
-    struct supportedRoleTLV      supported_role_tlv;
-    struct supportedFreqBandTLV  supported_freq_band_tlv;
+    struct supportedRoleTLV      *supported_role_tlv;
+    struct supportedFreqBandTLV  *supported_freq_band_tlv;
     struct supportedServiceTLV   *supported_service_tlv;
 
     PLATFORM_PRINTF_DEBUG_INFO("--> CMDU_TYPE_AP_AUTOCONFIGURATION_RESPONSE (%s)\n", interface_name);
 
     // Fill the supported role TLV
     //
-    supported_role_tlv.tlv.type = TLV_TYPE_SUPPORTED_ROLE;
-    supported_role_tlv.role     = IEEE80211_ROLE_AP;
+    supported_role_tlv = X1905_TLV_ALLOC(supportedRole, TLV_TYPE_SUPPORTED_ROLE, NULL);
+    supported_role_tlv->role = IEEE80211_ROLE_AP;
 
     // Fill the supported freq band TLV
     //
-    supported_freq_band_tlv.tlv.type  = TLV_TYPE_SUPPORTED_FREQ_BAND;
-    supported_freq_band_tlv.freq_band = freq_band;
+    supported_freq_band_tlv = X1905_TLV_ALLOC(supportedFreqBand, TLV_TYPE_SUPPORTED_FREQ_BAND, NULL);
+    supported_freq_band_tlv->freq_band = freq_band;
 
     supported_service_tlv = _obtainLocalSupportedServicesTLV(NULL);
 
@@ -3174,9 +3603,10 @@ uint8_t send1905APAutoconfigurationResponsePacket(const char *interface_name, ui
     response_message.message_type    = CMDU_TYPE_AP_AUTOCONFIGURATION_RESPONSE;
     response_message.message_id      = mid;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
     response_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*4);
-    response_message.list_of_TLVs[0] = &supported_role_tlv.tlv;
-    response_message.list_of_TLVs[1] = &supported_freq_band_tlv.tlv;
+    response_message.list_of_TLVs[0] = &supported_role_tlv->tlv;
+    response_message.list_of_TLVs[1] = &supported_freq_band_tlv->tlv;
     if (include_easymesh)
     {
         response_message.list_of_TLVs[2] = &supported_service_tlv->tlv;
@@ -3200,6 +3630,8 @@ uint8_t send1905APAutoconfigurationResponsePacket(const char *interface_name, ui
     // Free memory
     //
     /** @todo free supported services */
+    free_1905_TLV_structure(&supported_role_tlv->tlv);
+    free_1905_TLV_structure(&supported_freq_band_tlv->tlv);
     free(response_message.list_of_TLVs);
 
     return ret;
@@ -3233,6 +3665,7 @@ uint8_t send1905APAutoconfigurationWSCM1Packet(const char *interface_name, uint1
     data_message.message_type    = CMDU_TYPE_AP_AUTOCONFIGURATION_WSC;
     data_message.message_id      = mid;
     data_message.relay_indicator = 0;
+    data_message.tlv_index       = NULL;
     data_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*3);
     data_message.list_of_TLVs[0] = &wsc_tlv.tlv;
     data_message.list_of_TLVs[1] = NULL;
@@ -3294,13 +3727,18 @@ uint8_t send1905APAutoconfigurationWSCM2Packet(const char *interface_name, uint1
     data_message.message_type    = CMDU_TYPE_AP_AUTOCONFIGURATION_WSC;
     data_message.message_id      = mid;
     data_message.relay_indicator = 0;
+    data_message.tlv_index       = NULL;
     data_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*(num_tlvs+1));
 
     // Fill the WSC TLVs
     //
     for (i = 0; i < wsc_frames.length; i++)
     {
-        struct wscTLV *wsc_tlv = X1905_TLV_ALLOC(wsc, TLV_TYPE_WSC, NULL);
+        // Not allocated from its description (see "tlv_1905_defs"), like
+        // the WSC TLVs built by the parser
+        //
+        struct wscTLV *wsc_tlv = (struct wscTLV *)memalloc(sizeof(struct wscTLV));
+        wsc_tlv->tlv.type       = TLV_TYPE_WSC;
         data_message.list_of_TLVs[i] = &wsc_tlv->tlv;
         wsc_tlv->wsc_frame_size = wsc_frames.data[i].m2_size;
         wsc_tlv->wsc_frame      = (uint8_t *)memalloc(wsc_frames.data[i].m2_size);
@@ -3315,6 +3753,7 @@ uint8_t send1905APAutoconfigurationWSCM2Packet(const char *interface_name, uint1
         memcpy(&apRadioIdentifier->radio_uid, radio_uid, sizeof(mac_address));
         data_message.list_of_TLVs[num_tlvs - 1] = &apRadioIdentifier->tlv;
     }
+    data_message.list_of_TLVs[num_tlvs] = NULL;
 
     if (0 == send1905RawPacket(interface_name, mid, destination_al_mac_address, &data_message))
     {
@@ -3354,6 +3793,7 @@ uint8_t send1905GenericPhyQueryPacket(const char *interface_name, uint16_t mid,
     query_message.message_type    = CMDU_TYPE_GENERIC_PHY_QUERY;
     query_message.message_id      = mid;
     query_message.relay_indicator = 0;
+    query_message.tlv_index       = NULL;
     query_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *));
     query_message.list_of_TLVs[0] = NULL;
 
@@ -3399,6 +3839,7 @@ uint8_t send1905GenericPhyResponsePacket(const char *interface_name, uint16_t mi
     response_message.message_type    = CMDU_TYPE_GENERIC_PHY_RESPONSE;
     response_message.message_id      = mid;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
     response_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*2);
     response_message.list_of_TLVs[0] = &generic_phy.tlv;
     response_message.list_of_TLVs[1] = NULL;
@@ -3441,6 +3882,7 @@ uint8_t send1905HighLayerQueryPacket(const char *interface_name, uint16_t mid, u
     query_message.message_type    = CMDU_TYPE_HIGHER_LAYER_QUERY;
     query_message.message_id      = mid;
     query_message.relay_indicator = 0;
+    query_message.tlv_index       = NULL;
     query_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *));
     query_message.list_of_TLVs[0] = NULL;
 
@@ -3515,6 +3957,7 @@ uint8_t send1905HighLayerResponsePacket(const char *interface_name, uint16_t mid
     response_message.message_type    = CMDU_TYPE_HIGHER_LAYER_RESPONSE;
     response_message.message_id      = mid;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
     response_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *)*(total_tlvs+1));
     response_message.list_of_TLVs[0] = &_obtainLocalAlMacAddressTLV(NULL)->tlv;
     response_message.list_of_TLVs[1] = &profile_tlv.tlv;
@@ -3613,6 +4056,7 @@ uint8_t send1905InterfacePowerChangeRequestPacket(const char *interface_name, ui
     request_message.message_type    = CMDU_TYPE_INTERFACE_POWER_CHANGE_REQUEST;
     request_message.message_id      = mid;
     request_message.relay_indicator = 0;
+    request_message.tlv_index       = NULL;
     request_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *) * 2);
     request_message.list_of_TLVs[0] = &power_change.tlv;
     request_message.list_of_TLVs[1] = NULL;
@@ -3685,6 +4129,7 @@ uint8_t send1905InterfacePowerChangeResponsePacket(const char *interface_name, u
     response_message.message_type    = CMDU_TYPE_INTERFACE_POWER_CHANGE_RESPONSE;
     response_message.message_id      = mid;
     response_message.relay_indicator = 0;
+    response_message.tlv_index       = NULL;
     response_message.list_of_TLVs    = (struct tlv **)memalloc(sizeof(struct tlv *) * 2);
     response_message.list_of_TLVs[0] = &power_change.tlv;
     response_message.list_of_TLVs[1] = NULL;
@@ -3712,81 +4157,54 @@ uint8_t send1905InterfacePowerChangeResponsePacket(const char *interface_name, u
 
 uint8_t sendLLDPBridgeDiscoveryPacket(const char *interface_name)
 {
-    uint8_t  al_mac_address[6];
-    uint8_t  interface_mac_address[6];
-
-    struct chassisIdTLV      chassis_id_tlv;
-    struct portIdTLV         port_id_tlv;
-    struct timeToLiveTypeTLV time_to_live_tlv;
-
-    struct PAYLOAD payload;
+    uint8_t  mcast_address[] = MCAST_LLDP;
+    uint8_t *streams[2];
 
-    uint8_t  *stream;
-    uint16_t  stream_len;
+    struct _discoveryTemplate *t;
 
     PLATFORM_PRINTF_DEBUG_INFO("--> LLDP BRIDGE DISCOVERY (%s)\n", interface_name);
 
-    memcpy(al_mac_address,        DMalMacGet(),                         6);
-    memcpy(interface_mac_address, DMinterfaceNameToMac(interface_name), 6);
-
-    // Fill the chassis ID TLV
-    //
-    chassis_id_tlv.tlv.type           = TLV_TYPE_CHASSIS_ID;
-    chassis_id_tlv.chassis_id_subtype = CHASSIS_ID_TLV_SUBTYPE_MAC_ADDRESS;
-    chassis_id_tlv.chassis_id[0]      = al_mac_address[0];
-    chassis_id_tlv.chassis_id[1]      = al_mac_address[1];
-    chassis_id_tlv.chassis_id[2]      = al_mac_address[2];
-    chassis_id_tlv.chassis_id[3]      = al_mac_address[3];
-    chassis_id_tlv.chassis_id[4]      = al_mac_address[4];
-    chassis_id_tlv.chassis_id[5]      = al_mac_address[5];
+    t = _getDiscoveryTemplate(interface_name);
+    if (NULL == t->bridge_discovery && 0 == _forgeBridgeDiscovery(t))
+    {
+        return 0;
+    }
 
-    // Fill the port ID TLV
-    //
-    port_id_tlv.tlv.type            = TLV_TYPE_PORT_ID;
-    port_id_tlv.port_id_subtype     = PORT_ID_TLV_SUBTYPE_MAC_ADDRESS;
-    port_id_tlv.port_id[0]          = interface_mac_address[0];
-    port_id_tlv.port_id[1]          = interface_mac_address[1];
-    port_id_tlv.port_id[2]          = interface_mac_address[2];
-    port_id_tlv.port_id[3]          = interface_mac_address[3];
-    port_id_tlv.port_id[4]          = interface_mac_address[4];
-    port_id_tlv.port_id[5]          = interface_mac_address[5];
+    streams[0] = t->bridge_discovery;
+    streams[1] = NULL;
 
-    // Fill the time to live TLV
-    //
-    time_to_live_tlv.tlv.type       = TLV_TYPE_TIME_TO_LIVE;
-    time_to_live_tlv.ttl            = TIME_TO_LIVE_TLV_1905_DEFAULT_VALUE;
-
-    // Forge the LLDP payload containing all these TLVs
-    //
-    payload.list_of_TLVs[0] = &chassis_id_tlv.tlv;
-    payload.list_of_TLVs[1] = &port_id_tlv.tlv;
-    payload.list_of_TLVs[2] = &time_to_live_tlv.tlv;
-    payload.list_of_TLVs[3] = NULL;
+    PLATFORM_PRINTF_DEBUG_DETAIL("Sending LLDP bridge discovery message on interface %s\n", interface_name);
+    return txSchedulerSend(interface_name, mcast_address, t->interface_mac_address, ETHERTYPE_LLDP, streams, &t->bridge_discovery_len);
+}
 
-    stream = forge_lldp_PAYLOAD_from_structure(&payload, &stream_len);
+void discoveryTemplatesPrune(char **interfaces_names, uint8_t interfaces_nr)
+{
+    struct _discoveryTemplate *t;
+    struct _discoveryTemplate *next;
+    uint8_t                    i;
 
-    // Finally, send the packet!
-    //
+    for (t = container_of(discovery_templates.next, struct _discoveryTemplate, l); &t->l != &discovery_templates; t = next)
     {
-        uint8_t   mcast_address[] = MCAST_LLDP;
+        next = container_of(t->l.next, struct _discoveryTemplate, l);
 
-        PLATFORM_PRINTF_DEBUG_DETAIL("Sending LLDP bridge discovery message on interface %s\n", interface_name);
-        if (0 == PLATFORM_SEND_RAW_PACKET(interface_name,
-                                          mcast_address,
-                                          interface_mac_address,
-                                          ETHERTYPE_LLDP,
-                                          stream,
-                                          stream_len))
+        for (i = 0; i < interfaces_nr; i++)
         {
-            PLATFORM_PRINTF_DEBUG_ERROR("Packet could not be sent!\n");
+            if (0 == strcmp(t->interface_name, interfaces_names[i]))
+            {
+                break;
+            }
+        }
+        if (i < interfaces_nr)
+        {
+            continue;
         }
-    }
-
-    // Free memory
-    //
-    free_lldp_PAYLOAD_packet(stream);
 
-    return 1;
+        PLATFORM_PRINTF_DEBUG_DETAIL("Interface %s is gone. Releasing its discovery frames\n", t->interface_name);
+        _invalidateDiscoveryTemplate(t);
+        dlist_remove(&t->l);
+        free(t->interface_name);
+        free(t);
+    }
 }
 
 uint8_t send1905InterfaceListResponseALME(uint8_t alme_client_id)
@@ -4013,11 +4431,6 @@ uint8_t send1905CustomCommandResponseALME(uint8_t alme_client_id, uint8_t comman
 
     PLATFORM_PRINTF_DEBUG_INFO("--> ALME_TYPE_CUSTOM_COMMAND_RESPONSE\n");
 
-    // Fill the requested ALME response
-    //
-    out = (struct customCommandResponseALME *)memalloc(sizeof(struct customCommandResponseALME));
-    out->alme_type = ALME_TYPE_CUSTOM_COMMAND_RESPONSE;
-
     switch (command)
     {
         case CUSTOM_COMMAND_DUMP_NETWORK_DEVICES:
@@ -4027,21 +4440,33 @@ uint8_t send1905CustomCommandResponseALME(uint8_t alme_client_id, uint8_t comman
             _updateLocalDeviceData();
 
             // Dump the database (which contains information from the local and
-            // remote nodes) into a text buffer and send that as a reponse
+            // remote nodes) as text, which is streamed to the ALME client as
+            // it is being generated (see "_almeStreamWriter()")
             //
-            _memoryBufferWriterInit();
+            _almeStreamWriterInit(alme_client_id);
 
-            DMdumpNetworkDevices(_memoryBufferWriter);
+            DMdumpNetworkDevices(_almeStreamWriter);
 
-            memory_buffer[memory_buffer_i] = 0x0;
+            return _almeStreamFlush(1) ? 0 : 1;
+        }
 
-            out->bytes_nr = memory_buffer_i+1;
-            out->bytes    = memory_buffer;
+        case CUSTOM_COMMAND_DUMP_CMDU_STATS:
+        {
+            _almeStreamWriterInit(alme_client_id);
 
-            break;
+            cmduStatsDump(_almeStreamWriter);
+
+            return _almeStreamFlush(1) ? 0 : 1;
         }
     }
 
+    // Unknown command: send an empty response
+    //
+    out = (struct customCommandResponseALME *)memalloc(sizeof(struct customCommandResponseALME));
+    out->alme_type = ALME_TYPE_CUSTOM_COMMAND_RESPONSE;
+    out->bytes_nr  = 0;
+    out->bytes     = NULL;
+
     // Send the packet
     //
     if (0 == send1905RawALME(alme_client_id, (uint8_t *)out))
@@ -4054,18 +4479,6 @@ uint8_t send1905CustomCommandResponseALME(uint8_t alme_client_id, uint8_t comman
         ret = 0;
     }
 
-    // Free memory not needed anymore
-    //
-    if (CUSTOM_COMMAND_DUMP_NETWORK_DEVICES == command)
-    {
-        // Here we will free the memory buffer *and* set the pointer in the
-        // "out" structure to NULL, so that later "free_1905_ALME_structure()"
-        // doesn't try to free it again
-        //
-        _memoryBufferWriterEnd();
-        out->bytes_nr = 0;
-        out->bytes    = NULL;
-    }
     free_1905_ALME_structure((uint8_t *)out);
 
     return ret;
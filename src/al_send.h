@@ -119,6 +119,13 @@ uint8_t send1905TopologyQueryPacket(const char *interface_name, uint16_t mid, ui
 //
 uint8_t send1905TopologyResponsePacket(const char *interface_name, uint16_t mid, uint8_t *destination_al_mac_address);
 
+// The "topology response" is forged once and reused until the data model
+// changes (or some time passes). Call this function when something that is
+// reported in it, but is not part of the data model (ex: the interfaces power
+// state), may have changed, so that it is built again for the next query.
+//
+void invalidateTopologyResponse(void);
+
 // This function sends a "1905 topology notification packet" on the provided
 // interface.
 //
@@ -519,6 +526,16 @@ uint8_t send1905InterfacePowerChangeResponsePacket(const char *interface_name, u
 //
 uint8_t sendLLDPBridgeDiscoveryPacket(const char *interface_name);
 
+// The discovery messages sent by "send1905TopologyDiscoveryPacket()" and
+// "sendLLDPBridgeDiscoveryPacket()" are forged once per interface and kept in
+// memory. This function releases the ones of the interfaces that are no longer
+// in 'interfaces_names' (the list of 'interfaces_nr' elements returned by
+// "PLATFORM_GET_LIST_OF_1905_INTERFACES()").
+//
+// It is meant to be called each time the discovery messages are sent.
+//
+void discoveryTemplatesPrune(char **interfaces_names, uint8_t interfaces_nr);
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Functions to send ALME reply messages
@@ -550,6 +567,11 @@ uint8_t send1905MetricsResponseALME(uint8_t alme_client_id, uint8_t *mac_address
 // generated and sent back (ie. the 'command' contained in the original request)
 // This 'command' can take any of the "CUSTOM_COMMAND_*" available values.
 //
+// The responses to "CUSTOM_COMMAND_DUMP_NETWORK_DEVICES" and
+// "CUSTOM_COMMAND_DUMP_CMDU_STATS" are sent as a sequence of
+// "ALME-CUSTOM-COMMAND.response" messages, each of them containing the next
+// piece of the text dump (see "PLATFORM_SEND_ALME_REPLY_PART()").
+//
 uint8_t send1905CustomCommandResponseALME(uint8_t alme_client_id, uint8_t command);
 
 #endif
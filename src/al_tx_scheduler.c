@@ -0,0 +1,458 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "utils.h"
+
+#include "al_tx_scheduler.h"
+#include "al_cmdu_stats.h"
+#include "1905_cmdus.h"
+#include "1905_l2.h"
+#include "platform_interfaces.h"
+
+#include <dlist.h>
+#include <pool.h>
+
+#include <string.h> // memcmp(), memcpy(), ...
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// Offsets of the "message type" and "message id" fields inside a forged CMDU
+//
+#define CMDU_MESSAGE_TYPE_OFFSET  (2)
+#define CMDU_MESSAGE_ID_OFFSET    (4)
+
+// Token bucket of a destination MAC address on a given interface (a multicast
+// CMDU sent on all interfaces uses one bucket per interface, as each copy goes
+// to different peers)
+//
+struct _txBucket
+{
+    dlist_item  l;
+
+    char       *interface_name;
+    uint8_t     dst_mac[6];
+    uint32_t    tokens;            // CMDUs that can be sent right now
+    uint32_t    refill_timestamp;  // When the last token was added
+    uint32_t    pending;           // CMDUs queued for this destination
+};
+
+// A CMDU waiting to be transmitted
+//
+struct _txEntry
+{
+    dlist_item         l;
+
+    struct _txBucket  *bucket;
+    uint8_t            priority;
+
+    char              *interface_name;
+    uint8_t            src_mac[6];
+    uint16_t           eth_type;
+    uint16_t           message_type;
+
+    uint8_t          **streams;       // NULL terminated
+    uint16_t          *streams_lens;
+};
+
+static DEFINE_DLIST_HEAD(buckets);
+static DEFINE_POOL(buckets_pool, struct _txBucket);
+static DEFINE_POOL(entries_pool, struct _txEntry);
+
+// One FIFO of pending CMDUs per priority class
+//
+static dlist_head queues[TX_PRIORITY_NR] =
+{
+    {&queues[0], &queues[0]},
+    {&queues[1], &queues[1]},
+    {&queues[2], &queues[2]},
+};
+
+static struct txSchedulerStats stats;
+
+static uint32_t _pendingTotal(void)
+{
+    uint32_t total = 0;
+    uint8_t  p;
+
+    for (p = 0; p < TX_PRIORITY_NR; p++)
+    {
+        total += stats.pending[p];
+    }
+    return total;
+}
+
+static uint16_t _messageType(uint16_t eth_type, uint8_t **streams, const uint16_t *streams_lens)
+{
+    if (ETHERTYPE_1905 != eth_type || streams_lens[0] < CMDU_MESSAGE_ID_OFFSET + 2)
+    {
+        return 0xffff;
+    }
+    return (streams[0][CMDU_MESSAGE_TYPE_OFFSET] << 8) | streams[0][CMDU_MESSAGE_TYPE_OFFSET + 1];
+}
+
+static uint8_t _priority(uint16_t eth_type, uint16_t message_type)
+{
+    if (ETHERTYPE_1905 != eth_type)
+    {
+        return TX_PRIORITY_DISCOVERY;
+    }
+
+    switch (message_type)
+    {
+        case CMDU_TYPE_TOPOLOGY_DISCOVERY:
+        {
+            return TX_PRIORITY_DISCOVERY;
+        }
+        case CMDU_TYPE_TOPOLOGY_QUERY:
+        case CMDU_TYPE_LINK_METRIC_QUERY:
+        case CMDU_TYPE_AP_AUTOCONFIGURATION_SEARCH:
+        case CMDU_TYPE_HIGHER_LAYER_QUERY:
+        case CMDU_TYPE_INTERFACE_POWER_CHANGE_REQUEST:
+        case CMDU_TYPE_GENERIC_PHY_QUERY:
+        {
+            return TX_PRIORITY_QUERY;
+        }
+        default:
+        {
+            // Responses, notifications, WSC, vendor specific...
+            //
+            return TX_PRIORITY_CONTROL;
+        }
+    }
+}
+
+// Add the tokens earned since the last refill (up to TX_SCHEDULER_BURST)
+//
+static void _refill(struct _txBucket *b, uint32_t now)
+{
+    uint32_t earned;
+
+    earned = (now - b->refill_timestamp) / TX_SCHEDULER_INTERVAL_MS;
+
+    if (b->tokens + earned >= TX_SCHEDULER_BURST)
+    {
+        b->tokens           = TX_SCHEDULER_BURST;
+        b->refill_timestamp = now;
+    }
+    else
+    {
+        b->tokens           += earned;
+        b->refill_timestamp += earned * TX_SCHEDULER_INTERVAL_MS;
+    }
+}
+
+static struct _txBucket *_getBucket(const char *interface_name, const uint8_t *dst_mac, uint32_t now)
+{
+    struct _txBucket *b;
+
+    dlist_for_each(b, buckets, l)
+    {
+        if (0 == memcmp(b->dst_mac, dst_mac, 6) && 0 == strcmp(b->interface_name, interface_name))
+        {
+            return b;
+        }
+    }
+
+    b = pool_alloc(&buckets_pool);
+    b->interface_name = strdup(interface_name);
+    memcpy(b->dst_mac, dst_mac, 6);
+    b->tokens           = TX_SCHEDULER_BURST;
+    b->refill_timestamp = now;
+    dlist_add_tail(&buckets, &b->l);
+
+    return b;
+}
+
+static void _transmit(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                      uint16_t eth_type, uint8_t **streams, const uint16_t *streams_lens)
+{
+    uint8_t  total_streams;
+    uint8_t  x;
+    uint16_t message_type;
+    uint32_t start;
+
+    total_streams = 0;
+    while (streams[total_streams])
+    {
+        total_streams++;
+    }
+
+    for (x = 0; x < total_streams; x++)
+    {
+        if (ETHERTYPE_1905 == eth_type)
+        {
+            PLATFORM_PRINTF_DEBUG_DETAIL("Sending 1905 message on interface %s, MID %d, fragment %d/%d\n", interface_name,
+                                         (streams[x][CMDU_MESSAGE_ID_OFFSET] << 8) | streams[x][CMDU_MESSAGE_ID_OFFSET + 1],
+                                         x+1, total_streams);
+        }
+        start = cmduStatsClock();
+        if (0 == PLATFORM_SEND_RAW_PACKET(interface_name, dst_mac, src_mac, eth_type, streams[x], streams_lens[x]))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Packet could not be sent!\n");
+        }
+        if (cmdu_stats_enabled)
+        {
+            message_type = ETHERTYPE_1905 == eth_type ?
+                           (streams[x][CMDU_MESSAGE_TYPE_OFFSET] << 8) | streams[x][CMDU_MESSAGE_TYPE_OFFSET + 1] :
+                           CMDU_STATS_TYPE_LLDP;
+            cmduStatsElapsed(message_type, CMDU_STATS_STAGE_SEND, start);
+            cmduStatsFrame(message_type, CMDU_STATS_TX, streams_lens[x]);
+        }
+    }
+
+    stats.sent++;
+}
+
+// Return '1' if 'e' is the same CMDU (except for the MID) as the one in
+// 'streams'. LLDP frames (which have no MID) are compared as a whole.
+//
+static uint8_t _sameCmdu(struct _txEntry *e, const char *interface_name, uint8_t **streams, const uint16_t *streams_lens)
+{
+    uint8_t x;
+
+    if (0 != strcmp(e->interface_name, interface_name))
+    {
+        return 0;
+    }
+
+    for (x = 0; NULL != e->streams[x] && NULL != streams[x]; x++)
+    {
+        if (e->streams_lens[x] != streams_lens[x])
+        {
+            return 0;
+        }
+
+        if (ETHERTYPE_1905 == e->eth_type)
+        {
+            if (0 != memcmp(e->streams[x], streams[x], CMDU_MESSAGE_ID_OFFSET) ||
+                0 != memcmp(e->streams[x] + CMDU_MESSAGE_ID_OFFSET + 2, streams[x] + CMDU_MESSAGE_ID_OFFSET + 2,
+                            streams_lens[x] - CMDU_MESSAGE_ID_OFFSET - 2))
+            {
+                return 0;
+            }
+        }
+        else if (0 != memcmp(e->streams[x], streams[x], streams_lens[x]))
+        {
+            return 0;
+        }
+    }
+
+    return NULL == e->streams[x] && NULL == streams[x];
+}
+
+static void _removeEntry(struct _txEntry *e)
+{
+    uint8_t x;
+
+    dlist_remove(&e->l);
+    e->bucket->pending--;
+    stats.pending[e->priority]--;
+
+    for (x = 0; NULL != e->streams[x]; x++)
+    {
+        free(e->streams[x]);
+    }
+    free(e->streams);
+    free(e->streams_lens);
+    free(e->interface_name);
+    pool_free(e);
+}
+
+// Make room in the queue for a CMDU of priority 'priority' by dropping the
+// newest CMDU of a lower priority. Returns '0' if there is none.
+//
+static uint8_t _evict(uint8_t priority)
+{
+    uint8_t p;
+
+    for (p = TX_PRIORITY_NR - 1; p > priority; p--)
+    {
+        if (!dlist_empty(&queues[p]))
+        {
+            struct _txEntry *e = container_of(queues[p].prev, struct _txEntry, l);
+
+            PLATFORM_PRINTF_DEBUG_WARNING("TX queue full. Dropping message type 0x%04x\n", e->message_type);
+            _removeEntry(e);
+            stats.dropped++;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (exported only to files in this same folder)
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t txSchedulerSend(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                        uint16_t eth_type, uint8_t **streams, const uint16_t *streams_lens)
+{
+    struct _txBucket *b;
+    struct _txEntry  *e;
+    uint32_t          now;
+    uint16_t          message_type;
+    uint8_t           priority;
+    uint8_t           total_streams;
+    uint8_t           x;
+
+    now = PLATFORM_GET_TIMESTAMP();
+
+    b = _getBucket(interface_name, dst_mac, now);
+    _refill(b, now);
+
+    if (0 == b->pending && b->tokens > 0)
+    {
+        // Nothing is waiting for this destination and it has budget left: no
+        // need to queue anything
+        //
+        b->tokens--;
+        _transmit(interface_name, dst_mac, src_mac, eth_type, streams, streams_lens);
+        return 1;
+    }
+
+    message_type = _messageType(eth_type, streams, streams_lens);
+    priority     = _priority(eth_type, message_type);
+
+    if (TX_PRIORITY_CONTROL != priority)
+    {
+        // Sending the same query (or discovery message) twice does not give
+        // the destination any more information
+        //
+        dlist_for_each(e, queues[priority], l)
+        {
+            if (e->bucket == b && e->eth_type == eth_type && e->message_type == message_type &&
+                _sameCmdu(e, interface_name, streams, streams_lens))
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("Same message (type 0x%04x) already queued for %02x:%02x:%02x:%02x:%02x:%02x. Not queued again.\n",
+                                             message_type, dst_mac[0], dst_mac[1], dst_mac[2], dst_mac[3], dst_mac[4], dst_mac[5]);
+                stats.coalesced++;
+                return 1;
+            }
+        }
+    }
+
+    if (_pendingTotal() >= TX_SCHEDULER_MAX_PENDING &&
+        0 == _evict(priority))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("TX queue full. Dropping message type 0x%04x\n", message_type);
+        stats.dropped++;
+        return 0;
+    }
+
+    // Queue a copy of the CMDU
+    //
+    total_streams = 0;
+    while (streams[total_streams])
+    {
+        total_streams++;
+    }
+
+    e = pool_alloc(&entries_pool);
+    e->bucket         = b;
+    e->priority       = priority;
+    e->interface_name = memalloc(strlen(interface_name) + 1);
+    strcpy(e->interface_name, interface_name);
+    memcpy(e->src_mac, src_mac, 6);
+    e->eth_type       = eth_type;
+    e->message_type   = message_type;
+    e->streams        = memalloc(sizeof(uint8_t *) * (total_streams + 1));
+    e->streams_lens   = memalloc(sizeof(uint16_t) * total_streams);
+    for (x = 0; x < total_streams; x++)
+    {
+        e->streams[x] = memalloc(streams_lens[x]);
+        memcpy(e->streams[x], streams[x], streams_lens[x]);
+        e->streams_lens[x] = streams_lens[x];
+    }
+    e->streams[total_streams] = NULL;
+
+    dlist_add_tail(&queues[priority], &e->l);
+    b->pending++;
+
+    stats.deferred++;
+    stats.pending[priority]++;
+    if (_pendingTotal() > stats.peak_pending)
+    {
+        stats.peak_pending = _pendingTotal();
+    }
+
+    return 1;
+}
+
+uint32_t txSchedulerRun(void)
+{
+    struct _txBucket *b;
+    struct _txBucket *next_b;
+    struct _txEntry  *e;
+    struct _txEntry  *next_e;
+    uint32_t          now;
+    uint32_t          wait;
+    uint8_t           p;
+
+    now  = PLATFORM_GET_TIMESTAMP();
+    wait = 0;
+
+    for (p = 0; p < TX_PRIORITY_NR; p++)
+    {
+        for (e = container_of(queues[p].next, struct _txEntry, l); &e->l != &queues[p]; e = next_e)
+        {
+            next_e = container_of(e->l.next, struct _txEntry, l);
+
+            b = e->bucket;
+            _refill(b, now);
+
+            if (b->tokens > 0)
+            {
+                b->tokens--;
+                _transmit(e->interface_name, b->dst_mac, e->src_mac, e->eth_type, e->streams, e->streams_lens);
+                _removeEntry(e);
+            }
+            else if (0 == wait || TX_SCHEDULER_INTERVAL_MS - (now - b->refill_timestamp) < wait)
+            {
+                wait = TX_SCHEDULER_INTERVAL_MS - (now - b->refill_timestamp);
+            }
+        }
+    }
+
+    // Forget the destinations that are back to their full budget
+    //
+    for (b = container_of(buckets.next, struct _txBucket, l); &b->l != &buckets; b = next_b)
+    {
+        next_b = container_of(b->l.next, struct _txBucket, l);
+
+        if (0 == b->pending)
+        {
+            _refill(b, now);
+            if (TX_SCHEDULER_BURST == b->tokens)
+            {
+                dlist_remove(&b->l);
+                pool_free(b);
+            }
+        }
+    }
+
+    return wait;
+}
+
+void txSchedulerStatsGet(struct txSchedulerStats *s)
+{
+    memcpy(s, &stats, sizeof(*s));
+}
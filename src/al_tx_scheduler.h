@@ -0,0 +1,107 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _AL_TX_SCHEDULER_H_
+#define _AL_TX_SCHEDULER_H_
+
+#include "platform.h"
+
+// All CMDUs (and LLDP frames) that the AL transmits go through this scheduler,
+// which sits between the forging of the CMDU (see "al_send.c") and
+// "PLATFORM_SEND_RAW_PACKET()".
+//
+// Handlers are free to send many CMDUs in a row (a single "topology response"
+// makes the AL send up to four queries to each new neighbor), so the
+// scheduler makes sure that:
+//
+//   - Each destination MAC address receives, at most, a burst of
+//     TX_SCHEDULER_BURST CMDUs, followed by one CMDU every
+//     TX_SCHEDULER_INTERVAL_MS milliseconds (token bucket). This prevents the
+//     peers' receive queues from overflowing. Each interface has its own
+//     budget, so that sending a multicast CMDU on every interface (ex:
+//     topology discovery) only uses one token per interface.
+//
+//   - CMDUs that have to wait are sent in priority order: responses,
+//     notifications and AP autoconfiguration (which other nodes are waiting
+//     for) first, then queries, and then discovery messages.
+//
+//   - A query (or discovery message) that is identical (except for the MID)
+//     to one that is still waiting for the same destination is not queued
+//     again.
+//
+// CMDUs whose destination has not used up its budget are transmitted
+// immediately, so in the usual case nothing is delayed (nor copied).
+//
+// The pending CMDUs are transmitted by "txSchedulerRun()", which the AL entity
+// calls after processing each event (and from a timer while there are CMDUs
+// waiting).
+//
+// Everything here runs in the AL thread, so there is no locking.
+
+// Pacing parameters (per destination MAC address and interface)
+//
+#define TX_SCHEDULER_BURST        (16)
+#define TX_SCHEDULER_INTERVAL_MS  (20)
+
+// Maximum number of CMDUs waiting to be transmitted. When the queue is full,
+// the newest CMDU of the lowest priority is dropped.
+//
+#define TX_SCHEDULER_MAX_PENDING  (256)
+
+// Priority classes, highest first
+//
+#define TX_PRIORITY_CONTROL    (0)  // Responses, notifications, autoconfiguration
+#define TX_PRIORITY_QUERY      (1)  // Queries and requests
+#define TX_PRIORITY_DISCOVERY  (2)  // Topology discovery and LLDP
+#define TX_PRIORITY_NR         (3)
+
+// Transmit (or queue, see above) the frames in the NULL terminated list
+// 'streams' (with lengths 'streams_lens'), which are the fragments of a single
+// CMDU (or a single LLDP frame).
+//
+// The arguments are the same ones as in "PLATFORM_SEND_RAW_PACKET()". The
+// caller keeps the ownership of 'streams' and 'streams_lens' (they are copied
+// if needed).
+//
+// Return '0' if the CMDU was dropped (queue full), '1' otherwise.
+//
+uint8_t txSchedulerSend(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                        uint16_t eth_type, uint8_t **streams, const uint16_t *streams_lens);
+
+// Transmit all pending CMDUs whose destination has budget left.
+//
+// Return the time (in milliseconds) after which this function must be called
+// again, or '0' if there is nothing pending.
+//
+uint32_t txSchedulerRun(void);
+
+// Scheduler statistics, since the AL entity was started
+//
+struct txSchedulerStats
+{
+    uint32_t sent;                     // CMDUs transmitted
+    uint32_t deferred;                 // CMDUs that had to wait in the queue
+    uint32_t coalesced;                // Duplicates not queued (see above)
+    uint32_t dropped;                  // CMDUs dropped (queue full)
+    uint32_t pending[TX_PRIORITY_NR];  // CMDUs currently waiting, per class
+    uint32_t peak_pending;             // Highest number of CMDUs waiting
+};
+
+void txSchedulerStatsGet(struct txSchedulerStats *stats);
+
+#endif
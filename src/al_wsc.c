@@ -319,6 +319,7 @@ bool wscBuildM1(struct radio *radio, const struct wscDeviceData *wsc_device_data
         aux16 = ATTR_PUBLIC_KEY;                                          _I2B(&aux16,       &p);
         aux16 = pub_len;                                                  _I2B(&aux16,       &p);
                                                                           _InB( pub,         &p, pub_len);
+        free(pub);
     }
 
     // AUTHENTICATION TYPES
@@ -493,6 +494,8 @@ bool wscBuildM1(struct radio *radio, const struct wscDeviceData *wsc_device_data
         aux8  = WPS_VERSION;                                              _I1B(&aux8,          &p);
     }
 
+    radio->wsc_info->m1_len = p - radio->wsc_info->m1;
+
     return true;
 }
 
@@ -688,7 +691,6 @@ bool wscProcessM2(struct radio *radio, const uint8_t *m2, uint16_t m2_size)
         len[0]  = shared_secret_len;
 
         PLATFORM_SHA256(1, addr, len, dhkey);
-        free(shared_secret);
 
         // Next, concatenate three things (the enrolle nonce contained in M1,
         // the enrolle MAC address, and the nonce we just generated before, and
@@ -725,6 +727,8 @@ bool wscProcessM2(struct radio *radio, const uint8_t *m2, uint16_t m2_size)
         PLATFORM_PRINTF_DEBUG_DETAIL("  authkey           (%3d bytes): 0x%02x, 0x%02x, 0x%02x, ..., 0x%02x, 0x%02x, 0x%02x\n", WPS_AUTHKEY_LEN, authkey[0], authkey[1], authkey[2], authkey[WPS_AUTHKEY_LEN-3], authkey[WPS_AUTHKEY_LEN-2], authkey[WPS_AUTHKEY_LEN-1]);
         PLATFORM_PRINTF_DEBUG_DETAIL("  keywrapkey        (%3d bytes): 0x%02x, 0x%02x, 0x%02x, ..., 0x%02x, 0x%02x, 0x%02x\n", WPS_KEYWRAPKEY_LEN, keywrapkey[0], keywrapkey[1], keywrapkey[2], keywrapkey[WPS_KEYWRAPKEY_LEN-3], keywrapkey[WPS_KEYWRAPKEY_LEN-2], keywrapkey[WPS_KEYWRAPKEY_LEN-1]);
         PLATFORM_PRINTF_DEBUG_DETAIL("  emsk              (%3d bytes): 0x%02x, 0x%02x, 0x%02x, ..., 0x%02x, 0x%02x, 0x%02x\n", WPS_EMSK_LEN, emsk[0], emsk[1], emsk[2], emsk[WPS_EMSK_LEN-3], emsk[WPS_EMSK_LEN-2], emsk[WPS_EMSK_LEN-1]);
+
+        free(shared_secret);
     }
 
     // With the just computed key, check the message authentication
@@ -885,7 +889,7 @@ bool wscProcessM2(struct radio *radio, const uint8_t *m2, uint16_t m2_size)
         switch (auth_type)
         {
         case auth_mode_open:
-            if (encryption_type != IEEE80211_ENCRYPTION_MODE_NONE)
+            if (encryption_type != WPS_ENCR_NONE)
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Invalid encryption type %u for open mode\n", encryption_type);
                 return false;
@@ -893,7 +897,7 @@ bool wscProcessM2(struct radio *radio, const uint8_t *m2, uint16_t m2_size)
             break;
         case auth_mode_wpa2:
         case auth_mode_wpa2psk:
-            if (encryption_type != IEEE80211_ENCRYPTION_MODE_AES)
+            if (encryption_type != WPS_ENCR_AES)
             {
                 PLATFORM_PRINTF_DEBUG_WARNING("Invalid encryption type %u for WPA2 mode\n", encryption_type);
                 return false;
@@ -1002,12 +1006,6 @@ bool wscBuildM2(struct wscM1Info *m1_info, const struct wscRegistrarInfo *wsc_in
 
     uint8_t  registrar_nonce[16];
 
-    if (!registrarIsLocal())
-    {
-        PLATFORM_PRINTF_DEBUG_WARNING("We are not a registrar. Ignoring M1 message.\n");
-        return false;
-    }
-
     if (m1_info->mac_address == NULL || m1_info->nonce == NULL || m1_info->pubkey == NULL)
     {
         PLATFORM_PRINTF_DEBUG_WARNING("Incomplete M1 message received\n");
@@ -1080,6 +1078,7 @@ bool wscBuildM2(struct wscM1Info *m1_info, const struct wscRegistrarInfo *wsc_in
         aux16 = ATTR_PUBLIC_KEY;                                          _I2B(&aux16,       &p2);
         aux16 = pub_len;                                                  _I2B(&aux16,       &p2);
                                                                           _InB( pub,         &p2, pub_len);
+        free(pub);
 
         // We will use it later... save it.
         //
@@ -1159,6 +1158,7 @@ bool wscBuildM2(struct wscM1Info *m1_info, const struct wscRegistrarInfo *wsc_in
         PLATFORM_PRINTF_DEBUG_DETAIL("  emsk              (%3d bytes): 0x%02x, 0x%02x, 0x%02x, ..., 0x%02x, 0x%02x, 0x%02x\n", WPS_EMSK_LEN, emsk[0], emsk[1], emsk[2], emsk[WPS_EMSK_LEN-3], emsk[WPS_EMSK_LEN-2], emsk[WPS_EMSK_LEN-1]);
 
         free(shared_secret);
+        free(local_privkey);
     }
 
     aux16 = ATTR_AUTH_TYPE_FLAGS;                                     _I2B(&aux16,                &p2);
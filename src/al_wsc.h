@@ -118,6 +118,13 @@ struct wscM2Buf {
 };
 typedef PTRARRAY(struct wscM2Buf) wscM2List;
 
+/** @brief Build M2 in answer to @a m1_info, with the credentials of @a wsc_info.
+ *
+ * It only uses its arguments (not the data model), so it can run on the crypto worker thread (see
+ * PLATFORM_SUBMIT_CRYPTO_JOB()). The caller must check that the local device is the registrar (registrarIsLocal()).
+ *
+ * @return true on success, false on failure.
+ */
 bool wscBuildM2(struct wscM1Info *m1_info, const struct wscRegistrarInfo *wsc_info, struct wscM2Buf *m2);
 void wscFreeM2List(wscM2List m2_list);
 
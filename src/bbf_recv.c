@@ -73,50 +73,43 @@ uint8_t CBKprocess1905BBFExtensions(struct CMDU *memory_structure)
         {
             struct tlv *tlv;
 
-            i = 0;
-            while (NULL != (p = memory_structure->list_of_TLVs[i]))
+            // Protocol extensions are always embedded inside a Vendor Specific
+            // TLV. Ignore other TLVs
+            //
+            for (i = 0; NULL != (vs_tlv = (struct vendorSpecificTLV *)get_1905_CMDU_TLV(memory_structure, TLV_TYPE_VENDOR_SPECIFIC, i)); i++)
             {
-                // Protocol extensions are always embedded inside a Vendor
-                // Specific TLV. Ignore other TLVs
+                // Process only embedded BBF TLVs
                 //
-                if (p->type == TLV_TYPE_VENDOR_SPECIFIC)
+                if (0 == memcmp(vs_tlv->vendorOUI, BBF_OUI, 3))
                 {
-                    vs_tlv = (struct vendorSpecificTLV *)p;
+                    tlv = parse_bbf_TLV_from_packet(vs_tlv->m);
 
-                    // Process only embedded BBF TLVs
-                    //
-                    if (0 == memcmp(vs_tlv->vendorOUI, BBF_OUI, 3))
+                    if (NULL == tlv)
                     {
-                        tlv = parse_bbf_TLV_from_packet(vs_tlv->m);
-
-                        if (NULL == tlv)
+                        PLATFORM_PRINTF_DEBUG_ERROR("Malformed non-1905 Link Metric Query Tlv");
+                    }
+                    else
+                    {
+                        if (tlv->type == BBF_TLV_TYPE_NON_1905_LINK_METRIC_QUERY)
                         {
-                            PLATFORM_PRINTF_DEBUG_ERROR("Malformed non-1905 Link Metric Query Tlv");
+                            // BBF query TLV has been received.
+                            // CMDU response must contain BBF metric TLVs
+                            //
+                            bbf_query = 1;
                         }
                         else
                         {
-                            if (tlv->type == BBF_TLV_TYPE_NON_1905_LINK_METRIC_QUERY)
-                            {
-                                // BBF query TLV has been received.
-                                // CMDU response must contain BBF metric TLVs
-                                //
-                                bbf_query = 1;
-                            }
-                            else
-                            {
-                                PLATFORM_PRINTF_DEBUG_ERROR("Unexpected BBF protocol extension TLV");
-                            }
-
-                            // Release BBF TLV
-                            //
-                            free_bbf_TLV_structure(tlv);
+                            PLATFORM_PRINTF_DEBUG_ERROR("Unexpected BBF protocol extension TLV");
                         }
-                        // Only one BBF TLV is expected in this CMDU
+
+                        // Release BBF TLV
                         //
-                        break;
+                        free_bbf_TLV_structure(tlv);
                     }
+                    // Only one BBF TLV is expected in this CMDU
+                    //
+                    break;
                 }
-                i++;
             }
 
             break;
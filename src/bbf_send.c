@@ -24,6 +24,7 @@
 
 #include "al_datamodel.h"
 #include "al_extension.h"
+#include "al_link_metrics.h"
 #include "platform_interfaces.h"
 
 #include <string.h> // memset(), memcmp(), ...
@@ -72,9 +73,6 @@ static void _obtainLocalNon1905NeighborsTLV(struct non1905NeighborDeviceListTLV
     *non_1905_neighbors    = NULL;
     *non_1905_neighbors_nr = 0;
 
-    uint8_t (*al_mac_addresses)[6];
-    uint8_t al_mac_addresses_nr;
-
     interfaces_names = PLATFORM_GET_LIST_OF_1905_INTERFACES(&interfaces_names_nr);
 
     for (i=0; i<interfaces_names_nr; i++)
@@ -89,8 +87,6 @@ static void _obtainLocalNon1905NeighborsTLV(struct non1905NeighborDeviceListTLV
             continue;
         }
 
-        al_mac_addresses = DMgetListOfInterfaceNeighbors(interfaces_names[i], &al_mac_addresses_nr);
-
         no  = (struct non1905NeighborDeviceListTLV *)memalloc(sizeof(struct non1905NeighborDeviceListTLV));
 
         no->tlv.type              = TLV_TYPE_NON_1905_NEIGHBOR_DEVICE_LIST;
@@ -107,20 +103,6 @@ static void _obtainLocalNon1905NeighborsTLV(struct non1905NeighborDeviceListTLV
         //
         if (x->neighbor_mac_addresses_nr != INTERFACE_NEIGHBORS_UNKNOWN)
         {
-            uint8_t *al_mac_address_has_been_reported;
-
-            // Keep track of all the AL MACs that the interface reports he is
-            // seeing.
-            //
-            if (0 != al_mac_addresses_nr)
-            {
-                // Originally, none of the neighbors in the data model has been
-                // reported...
-                //
-                al_mac_address_has_been_reported = (uint8_t *)memalloc(sizeof(uint8_t) * al_mac_addresses_nr);
-                memset(al_mac_address_has_been_reported, 0x0, al_mac_addresses_nr);
-            }
-
             for (j=0; j<x->neighbor_mac_addresses_nr; j++)
             {
                 uint8_t *al_mac;
@@ -177,13 +159,7 @@ static void _obtainLocalNon1905NeighborsTLV(struct non1905NeighborDeviceListTLV
                 }
             }
             free_1905_INTERFACE_INFO(x);
-
-            if (al_mac_addresses_nr > 0 && NULL != al_mac_address_has_been_reported)
-            {
-                free(al_mac_address_has_been_reported);
-            }
         }
-        free(al_mac_addresses);
 
         // At this point we have, for this particular interface, all the non
         // 1905 neighbors in "no" and all 1905 neighbors in "yes".
@@ -572,10 +548,10 @@ static void _obtainLocalNon1905MetricsTLV(uint8_t destination, uint8_t *specific
             for (j=0; j<links_nr; j++)
             {
                 struct interfaceInfo *f;
-                struct linkMetrics   *l;
+                const struct linkMetrics *l;
 
                 f = PLATFORM_GET_1905_INTERFACE_INFO(local_interfaces[j]);
-                l = PLATFORM_GET_LINK_METRICS(local_interfaces[j], remote_macs[j]);
+                l = linkMetricsGet(local_interfaces[j], remote_macs[j]);
 
                 if (NULL != tx_tlvs)
                 {
@@ -642,16 +618,16 @@ static void _obtainLocalNon1905MetricsTLV(uint8_t destination, uint8_t *specific
                 {
                     free_1905_INTERFACE_INFO(f);
                 }
-                if (NULL != l)
-                {
-                    free_LINK_METRICS(l);
-                }
             }
 
             total_tlvs++;
         }
 
-        DMfreeListOfLinksWithNeighbor(remote_macs, local_interfaces, links_nr);
+        if (links_nr > 0)
+        {
+            free(remote_macs);
+            free(local_interfaces);
+        }
     }
 
     free(mac_addresses);
@@ -77,7 +77,7 @@ struct tlv *parse_bbf_TLV_from_packet(const uint8_t *packet_stream)
             {
                // Reserved (invalid) value received
                //
-               free(ret);
+               hlist_delete_item(&ret->tlv.s.h);
                return NULL;
             }
             else if (0 == destination)
@@ -95,7 +95,7 @@ struct tlv *parse_bbf_TLV_from_packet(const uint8_t *packet_stream)
             {
                // This code cannot be reached
                //
-               free(ret);
+               hlist_delete_item(&ret->tlv.s.h);
                return NULL;
             }
 
@@ -105,7 +105,7 @@ struct tlv *parse_bbf_TLV_from_packet(const uint8_t *packet_stream)
             {
                // Reserved (invalid) value received
                //
-               free(ret);
+               hlist_delete_item(&ret->tlv.s.h);
                return NULL;
             }
             else if (0 == link_metrics_type)
@@ -124,7 +124,7 @@ struct tlv *parse_bbf_TLV_from_packet(const uint8_t *packet_stream)
             {
                // This code cannot be reached
                //
-               free(ret);
+               hlist_delete_item(&ret->tlv.s.h);
                return NULL;
             }
 
@@ -523,6 +523,14 @@ void free_bbf_TLV_structure(struct tlv *memory_structure)
     switch (memory_structure->type)
     {
         case BBF_TLV_TYPE_NON_1905_LINK_METRIC_QUERY:
+        {
+            // Allocated with "linkMetricQueryTLVAllocAll()"
+            //
+            hlist_delete_item(&memory_structure->s.h);
+
+            return;
+        }
+
         case BBF_TLV_TYPE_NON_1905_LINK_METRIC_RESULT_CODE:
         {
             free(memory_structure);
@@ -18,6 +18,7 @@
 
 #include <datamodel.h>
 #include <platform.h>
+#include <pool.h>
 
 #include <assert.h>
 #include <string.h> // memcpy
@@ -34,6 +35,15 @@ struct registrar registrar = {
 
 DEFINE_DLIST_HEAD(network);
 
+/* Devices, radios and interfaces come and go all the time (e.g. every station that associates creates an interface),
+ * so they are allocated from pools. */
+static DEFINE_POOL(al_device_pool, struct alDevice);
+static DEFINE_POOL(radio_pool, struct radio);
+static DEFINE_POOL(interface_pool, struct interface);
+static DEFINE_POOL(interface_wifi_pool, struct interfaceWifi);
+
+uint32_t datamodel_generation = 0;
+
 void datamodelInit(void)
 {
 }
@@ -42,37 +52,42 @@ void datamodelInit(void)
  */
 struct alDevice *alDeviceAlloc(const mac_address al_mac_addr)
 {
-    struct alDevice *ret = zmemalloc(sizeof(struct alDevice));
+    struct alDevice *ret = pool_alloc(&al_device_pool);
     dlist_add_tail(&network, &ret->l);
     memcpy(ret->al_mac_addr, al_mac_addr, sizeof(mac_address));
     dlist_head_init(&ret->interfaces);
     dlist_head_init(&ret->radios);
     ret->is_map_agent = false;
     ret->is_map_controller = false;
+    datamodelChanged();
     return ret;
 }
 
 void alDeviceDelete(struct alDevice *alDevice)
 {
-    while (!dlist_empty(&alDevice->interfaces)) {
-        struct interface *interface = container_of(dlist_get_first(&alDevice->interfaces), struct interface, l);
-        interfaceDelete(interface);
-    }
+    /* Radios first: deleting a radio also deletes its configured BSSes, which are in the interfaces list as well. */
     while (!dlist_empty(&alDevice->radios)) {
         struct radio *radio = container_of(dlist_get_first(&alDevice->radios), struct radio, l);
         radioDelete(radio);
     }
-    free(alDevice);
+    while (!dlist_empty(&alDevice->interfaces)) {
+        struct interface *interface = container_of(dlist_get_first(&alDevice->interfaces), struct interface, l);
+        interfaceDelete(interface);
+    }
+    dlist_remove(&alDevice->l);
+    pool_free(alDevice);
+    datamodelChanged();
 }
 
 /* 'radio' related functions
  */
 struct radio*   radioAlloc(struct alDevice *dev, const mac_address mac)
 {
-    struct radio *r = zmemalloc(sizeof(struct radio));
-    memcpy(&r->uid, &mac, sizeof(mac_address));
+    struct radio *r = pool_alloc(&radio_pool);
+    memcpy(r->uid, mac, sizeof(mac_address));
     r->index = -1;
     dlist_add_tail(&dev->radios, &r->l);
+    datamodelChanged();
     return r;
 }
 
@@ -99,7 +114,8 @@ void    radioDelete(struct radio *radio)
         free(radio->bands.data[i]);
     }
     PTRARRAY_CLEAR(radio->bands);
-    free(radio);
+    pool_free(radio);
+    datamodelChanged();
 }
 
 struct radio *findDeviceRadio(const struct alDevice *device, const mac_address uid)
@@ -128,10 +144,42 @@ struct radio *findLocalRadio(const char *name)
     return NULL;
 }
 
+struct radio *findLocalRadioByIndex(uint32_t index)
+{
+    struct radio *radio;
+    dlist_for_each(radio, local_device->radios, l)
+    {
+        if (radio->index == index)
+        {
+            return radio;
+        }
+    }
+    return NULL;
+}
+
+struct radioChannel *radioFindChannel(const struct radio *radio, uint32_t freq)
+{
+    unsigned i, j;
+
+    for (i = 0; i < radio->bands.length; i++)
+    {
+        struct radioBand *band = radio->bands.data[i];
+        for (j = 0; j < band->channels.length; j++)
+        {
+            if (band->channels.data[j].freq == freq)
+            {
+                return &band->channels.data[j];
+            }
+        }
+    }
+    return NULL;
+}
+
 int radioAddInterfaceWifi(struct radio *radio, struct interfaceWifi *ifw)
 {
     PTRARRAY_ADD(radio->configured_bsses, ifw);
     ifw->radio = radio;
+    datamodelChanged();
     return 0;
 }
 
@@ -186,48 +234,64 @@ static struct interface * interfaceInit(struct interface *i, const mac_address a
     if (owner != NULL) {
         alDeviceAddInterface(owner, i);
     }
+    datamodelChanged();
     return i;
 }
 
 struct interface *interfaceAlloc(const mac_address addr, struct alDevice *owner)
 {
-    return interfaceInit(zmemalloc(sizeof(struct interface)), addr, owner);
+    return interfaceInit(pool_alloc(&interface_pool), addr, owner);
 }
 
 void interfaceDelete(struct interface *interface)
 {
-    unsigned i;
-    for (i = 0; i < interface->neighbors.length; i++)
+    while (interface->neighbors.length > 0)
     {
-        interfaceRemoveNeighbor(interface, interface->neighbors.data[i]);
+        interfaceRemoveNeighbor(interface, interface->neighbors.data[0]);
     }
     /* Even if the interface doesn't have an owner, removing it from the empty list doesn't hurt. */
     dlist_remove(&interface->l);
-    free(interface);
+    pool_free(interface);
+    datamodelChanged();
 }
 
 void interfaceAddNeighbor(struct interface *interface, struct interface *neighbor)
 {
     PTRARRAY_ADD(interface->neighbors, neighbor);
     PTRARRAY_ADD(neighbor->neighbors, interface);
+    datamodelChanged();
+}
+
+/* If @a client is a client of @a ap, remove it from the clients. It remains a neighbor. */
+static void interfaceWifiForgetClient(struct interface *ap, struct interface *client)
+{
+    if (ap->type == interface_type_wifi && client->type == interface_type_wifi)
+    {
+        struct interfaceWifi *ifw = container_of(ap, struct interfaceWifi, i);
+        PTRARRAY_REMOVE_ELEMENT_UNORDERED(ifw->clients, container_of(client, struct interfaceWifi, i));
+    }
 }
 
 void interfaceRemoveNeighbor(struct interface *interface, struct interface *neighbor)
 {
-    PTRARRAY_REMOVE_ELEMENT(interface->neighbors, neighbor);
-    PTRARRAY_REMOVE_ELEMENT(neighbor->neighbors, interface);
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(interface->neighbors, neighbor);
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(neighbor->neighbors, interface);
+    /* Clients are also neighbors, so they can't remain clients when they're no longer neighbors. */
+    interfaceWifiForgetClient(interface, neighbor);
+    interfaceWifiForgetClient(neighbor, interface);
     if (neighbor->owner == NULL && neighbor->neighbors.length == 0)
     {
         /* No more references to the neighbor interface. */
-        free(neighbor);
+        pool_free(neighbor);
     }
+    datamodelChanged();
 }
 
 /* 'interfaceWifi' related functions
  */
 struct interfaceWifi *interfaceWifiAlloc(const mac_address addr, struct alDevice *owner)
 {
-    struct interfaceWifi *ifw = zmemalloc(sizeof(*ifw));
+    struct interfaceWifi *ifw = pool_alloc(&interface_wifi_pool);
     interfaceInit(&ifw->i, addr, owner);
     ifw->i.type = interface_type_wifi;
     return ifw;
@@ -241,6 +305,72 @@ void    interfaceWifiRemove(struct interfaceWifi *ifw)
     interfaceDelete(&ifw->i); /* This also frees interfaceWifi itself. */
 }
 
+struct interfaceWifi *interfaceWifiAddClient(struct interfaceWifi *ap, const mac_address addr)
+{
+    struct interfaceWifi *client = NULL;
+    struct interface *neighbor;
+    unsigned i;
+
+    for (i = 0; i < ap->clients.length; i++)
+    {
+        if (memcmp(ap->clients.data[i]->i.addr, addr, 6) == 0)
+        {
+            return ap->clients.data[i];
+        }
+    }
+
+    /* The station may already be known, either as the interface of a 1905 device or as a non-1905 neighbor. */
+    neighbor = findDeviceInterface(addr);
+    for (i = 0; neighbor == NULL && i < ap->i.neighbors.length; i++)
+    {
+        if (memcmp(ap->i.neighbors.data[i]->addr, addr, 6) == 0)
+        {
+            neighbor = ap->i.neighbors.data[i];
+        }
+    }
+
+    if (neighbor == NULL)
+    {
+        client = interfaceWifiAlloc(addr, NULL);
+        client->role = interface_wifi_role_sta;
+        memcpy(client->bssInfo.bssid, ap->bssInfo.bssid, sizeof(mac_address));
+        client->bssInfo.ssid = ap->bssInfo.ssid;
+        neighbor = &client->i;
+    }
+    else if (neighbor->type == interface_type_wifi)
+    {
+        client = container_of(neighbor, struct interfaceWifi, i);
+    }
+    /* else it was seen as a non-Wi-Fi interface, e.g. in a non-1905 neighbor TLV. Just make sure it is a neighbor. */
+
+    if (PTRARRAY_FIND(ap->i.neighbors, neighbor) == ap->i.neighbors.length)
+    {
+        interfaceAddNeighbor(&ap->i, neighbor);
+    }
+    if (client != NULL)
+    {
+        PTRARRAY_ADD(ap->clients, client);
+        datamodelChanged();
+    }
+    return client;
+}
+
+bool interfaceWifiRemoveClient(struct interfaceWifi *ap, const mac_address addr)
+{
+    unsigned i;
+
+    for (i = 0; i < ap->clients.length; i++)
+    {
+        if (memcmp(ap->clients.data[i]->i.addr, addr, 6) == 0)
+        {
+            /* This also removes it from the clients, and deletes it if it isn't referenced anymore. */
+            interfaceRemoveNeighbor(&ap->i, &ap->clients.data[i]->i);
+            return true;
+        }
+    }
+    return false;
+}
+
 /* 'alDevice' related functions
  */
 void alDeviceAddInterface(struct alDevice *device, struct interface *interface)
@@ -248,6 +378,7 @@ void alDeviceAddInterface(struct alDevice *device, struct interface *interface)
     assert(interface->owner == NULL);
     dlist_add_tail(&device->interfaces, &interface->l);
     interface->owner = device;
+    datamodelChanged();
 }
 
 struct alDevice *alDeviceFind(const mac_address al_mac_addr)
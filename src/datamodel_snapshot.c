@@ -0,0 +1,594 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <platform.h>
+#include <utils.h>
+#include <datamodel.h>
+#include <datamodel_shm.h>
+
+#include <string.h>     // memcpy(), memset(), ...
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// Records are aligned on this boundary inside the snapshot
+//
+#define SNAPSHOT_ALIGN(x)       (((x) + 7) & ~((size_t)7))
+
+// Mapping from data model object to its index in the exported table. Kept
+// sorted on 'object' so lookups are a binary search.
+//
+struct _objectIndex
+{
+    const void *object;
+    uint32_t    index;
+};
+
+static struct _snapshotBuilder
+{
+    struct _objectIndex    *index_map;
+    unsigned                index_map_nr;
+    unsigned                index_map_size;
+
+    struct interface      **interfaces; // Exported interfaces, in index order
+    unsigned                interfaces_nr;
+    unsigned                interfaces_size;
+
+} builder;
+
+// Return the position in 'builder.index_map' where 'object' is or should be
+// inserted.
+//
+static unsigned _indexMapPosition(const void *object)
+{
+    unsigned lo = 0;
+    unsigned hi = builder.index_map_nr;
+
+    while (lo < hi)
+    {
+        unsigned mid = lo + (hi - lo) / 2;
+
+        if ((uintptr_t)builder.index_map[mid].object < (uintptr_t)object)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static uint32_t _indexMapFind(const void *object)
+{
+    unsigned pos;
+
+    if (NULL == object)
+    {
+        return DATAMODEL_SHM_NONE;
+    }
+
+    pos = _indexMapPosition(object);
+    if (pos < builder.index_map_nr && builder.index_map[pos].object == object)
+    {
+        return builder.index_map[pos].index;
+    }
+    return DATAMODEL_SHM_NONE;
+}
+
+// Add 'object' with 'index' to the map. Returns false if it was already there.
+//
+static bool _indexMapAdd(const void *object, uint32_t index)
+{
+    unsigned pos = _indexMapPosition(object);
+
+    if (pos < builder.index_map_nr && builder.index_map[pos].object == object)
+    {
+        return false;
+    }
+
+    if (builder.index_map_nr == builder.index_map_size)
+    {
+        builder.index_map_size = builder.index_map_size ? 2 * builder.index_map_size : 64;
+        builder.index_map      = memrealloc(builder.index_map, builder.index_map_size * sizeof(*builder.index_map));
+    }
+    memmove(&builder.index_map[pos + 1], &builder.index_map[pos], (builder.index_map_nr - pos) * sizeof(*builder.index_map));
+    builder.index_map[pos].object = object;
+    builder.index_map[pos].index  = index;
+    builder.index_map_nr++;
+
+    return true;
+}
+
+static void _addInterface(struct interface *interface)
+{
+    if (!_indexMapAdd(interface, builder.interfaces_nr))
+    {
+        return;
+    }
+    if (builder.interfaces_nr == builder.interfaces_size)
+    {
+        builder.interfaces_size = builder.interfaces_size ? 2 * builder.interfaces_size : 64;
+        builder.interfaces      = memrealloc(builder.interfaces, builder.interfaces_size * sizeof(*builder.interfaces));
+    }
+    builder.interfaces[builder.interfaces_nr++] = interface;
+}
+
+static void _copyName(char *dst, const char *src)
+{
+    if (NULL != src)
+    {
+        strncpy(dst, src, DATAMODEL_SHM_NAME_SZ - 1);
+    }
+}
+
+static void _setTable(struct datamodelShmTable *table, size_t *offset, uint32_t nr, size_t record_size)
+{
+    table->offset      = *offset;
+    table->nr          = nr;
+    table->record_size = record_size;
+    *offset            = SNAPSHOT_ALIGN(*offset + nr * record_size);
+}
+
+// Check that 'table' lies completely inside a snapshot of 'size' bytes and
+// that its records are at least 'record_size' long.
+//
+static bool _checkTable(const struct datamodelShmTable *table, size_t size, size_t record_size)
+{
+    if (0 == table->nr)
+    {
+        return true;
+    }
+    if (table->record_size < record_size || table->offset > size)
+    {
+        return false;
+    }
+    return (size - table->offset) / table->record_size >= table->nr;
+}
+
+// Check that a "first/nr" pair of indexes stays inside a table with 'nr'
+// records.
+//
+static bool _checkRange(uint32_t first, uint32_t range_nr, uint32_t nr)
+{
+    if (0 == range_nr)
+    {
+        return true;
+    }
+    return first < nr && nr - first >= range_nr;
+}
+
+// Validate everything datamodelSnapshotRestore() relies on, so that it
+// never has to care about a corrupted snapshot.
+//
+static bool _checkSnapshot(const struct datamodelShmHeader *header, size_t size)
+{
+    uint32_t i;
+
+    if (size < sizeof(struct datamodelShmHeader)                       ||
+        DATAMODEL_SHM_MAGIC   != header->magic                         ||
+        DATAMODEL_SHM_VERSION != header->version                       ||
+        header->size > size                                            ||
+        !_checkTable(&header->devices,    size, sizeof(struct datamodelShmDevice))    ||
+        !_checkTable(&header->interfaces, size, sizeof(struct datamodelShmInterface)) ||
+        !_checkTable(&header->links,      size, sizeof(struct datamodelShmLink))      ||
+        !_checkTable(&header->radios,     size, sizeof(struct datamodelShmRadio)))
+    {
+        return false;
+    }
+
+    for (i = 0; i < header->devices.nr; i++)
+    {
+        const struct datamodelShmDevice *d = datamodelShmRecord(header, &header->devices, i);
+
+        if (!_checkRange(d->interfaces_first, d->interfaces_nr, header->interfaces.nr) ||
+            !_checkRange(d->radios_first,     d->radios_nr,     header->radios.nr))
+        {
+            return false;
+        }
+    }
+    for (i = 0; i < header->interfaces.nr; i++)
+    {
+        const struct datamodelShmInterface *x = datamodelShmRecord(header, &header->interfaces, i);
+
+        if ((DATAMODEL_SHM_NONE != x->device && x->device >= header->devices.nr) ||
+            (DATAMODEL_SHM_NONE != x->radio  && x->radio  >= header->radios.nr)  ||
+            !_checkRange(x->links_first, x->links_nr, header->links.nr))
+        {
+            return false;
+        }
+    }
+    for (i = 0; i < header->links.nr; i++)
+    {
+        const struct datamodelShmLink *link = datamodelShmRecord(header, &header->links, i);
+
+        if (link->neighbor >= header->interfaces.nr)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Recreate the device described by record 'd' (which must not exist yet) and
+// fill in 'interfaces' with the objects created for its interfaces.
+//
+static struct alDevice *_restoreDevice(const struct datamodelShmHeader *header, const struct datamodelShmDevice *d,
+                                       struct interface **interfaces, uint32_t now)
+{
+    struct alDevice  *device;
+    struct radio    **radios;
+    uint32_t          i;
+
+    device = alDeviceAlloc(d->al_mac_addr);
+    device->is_map_agent      = 0 != (d->flags & DATAMODEL_SHM_DEVICE_MAP_AGENT);
+    device->is_map_controller = 0 != (d->flags & DATAMODEL_SHM_DEVICE_MAP_CONTROLLER);
+    device->stale             = true;
+
+    // The band/channel details of remote radios are not part of the
+    // snapshot; they are filled in again when the device is queried.
+    //
+    radios = zmemalloc((d->radios_nr + 1) * sizeof(*radios));
+    for (i = 0; i < d->radios_nr; i++)
+    {
+        const struct datamodelShmRadio *r = datamodelShmRecord(header, &header->radios, d->radios_first + i);
+
+        radios[i] = radioAlloc(device, r->uid);
+        memcpy(radios[i]->name, r->name, sizeof(radios[i]->name) - 1);
+        memcpy(radios[i]->confAnts, r->conf_ants, 2);
+        radios[i]->index         = r->index;
+        radios[i]->maxApStations = r->max_ap_stations;
+        radios[i]->maxBSS        = r->max_bss;
+        radios[i]->monitor       = r->monitor;
+    }
+
+    for (i = 0; i < d->interfaces_nr; i++)
+    {
+        const struct datamodelShmInterface *x = datamodelShmRecord(header, &header->interfaces, d->interfaces_first + i);
+        struct interface                   *interface;
+
+        if (interface_type_wifi == x->type)
+        {
+            struct interfaceWifi *ifw = interfaceWifiAlloc(x->addr, device);
+
+            ifw->role                   = x->wifi_role;
+            ifw->bssInfo.ssid.length    = x->ssid_length;
+            memcpy(ifw->bssInfo.bssid,     x->bssid, 6);
+            memcpy(ifw->bssInfo.ssid.ssid, x->ssid,  sizeof(x->ssid));
+            if (DATAMODEL_SHM_NONE != x->radio && x->radio - d->radios_first < d->radios_nr)
+            {
+                radioAddInterfaceWifi(radios[x->radio - d->radios_first], ifw);
+            }
+            interface = &ifw->i;
+        }
+        else
+        {
+            interface = interfaceAlloc(x->addr, device);
+            interface->type = x->type;
+        }
+        interface->media_type                 = x->media_type;
+        interface->power_state                = x->power_state;
+        interface->media_specific_info_length = x->media_specific_info_length;
+        memcpy(interface->media_specific_info, x->media_specific_info, sizeof(interface->media_specific_info));
+
+        // Timestamps of the previous run are meaningless. Pretend the
+        // interface was just discovered, without being bridged.
+        //
+        interface->last_topology_discovery_ts = now;
+        interface->last_bridge_discovery_ts   = now;
+
+        interfaces[d->interfaces_first + i] = interface;
+    }
+
+    free(radios);
+    return device;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions
+////////////////////////////////////////////////////////////////////////////////
+
+size_t datamodelSnapshotBuild(uint8_t **buffer, size_t *buffer_size)
+{
+    struct datamodelShmHeader *header;
+    struct alDevice           *device;
+    struct interface          *interface;
+    struct radio              *radio;
+
+    uint32_t devices_nr = 0;
+    uint32_t radios_nr  = 0;
+    uint32_t links_nr   = 0;
+    uint32_t owned_nr;
+    uint32_t i, j;
+    size_t   size;
+
+    builder.index_map_nr  = 0;
+    builder.interfaces_nr = 0;
+
+    // First, assign indexes. Devices and radios are numbered in list order and
+    // only need to be counted. The interfaces of a device get consecutive
+    // indexes; the non-1905 neighbors (which don't belong to any device) are
+    // added at the end.
+    //
+    dlist_for_each(device, network, l)
+    {
+        _indexMapAdd(device, devices_nr++);
+        dlist_for_each(interface, device->interfaces, l)
+        {
+            _addInterface(interface);
+        }
+        dlist_for_each(radio, device->radios, l)
+        {
+            _indexMapAdd(radio, radios_nr++);
+        }
+    }
+    owned_nr = builder.interfaces_nr;
+    for (i = 0; i < owned_nr; i++)
+    {
+        interface = builder.interfaces[i];
+        for (j = 0; j < interface->neighbors.length; j++)
+        {
+            if (NULL == interface->neighbors.data[j]->owner)
+            {
+                _addInterface(interface->neighbors.data[j]);
+            }
+        }
+    }
+    for (i = 0; i < builder.interfaces_nr; i++)
+    {
+        links_nr += builder.interfaces[i]->neighbors.length;
+    }
+
+    // Now we know the size of each table
+    //
+    size = SNAPSHOT_ALIGN(sizeof(struct datamodelShmHeader));
+    {
+        struct datamodelShmHeader layout;
+
+        _setTable(&layout.devices,    &size, devices_nr,           sizeof(struct datamodelShmDevice));
+        _setTable(&layout.interfaces, &size, builder.interfaces_nr, sizeof(struct datamodelShmInterface));
+        _setTable(&layout.radios,     &size, radios_nr,            sizeof(struct datamodelShmRadio));
+        _setTable(&layout.links,      &size, links_nr,             sizeof(struct datamodelShmLink));
+
+        if (size > *buffer_size)
+        {
+            *buffer_size = size;
+            *buffer      = memrealloc(*buffer, size);
+        }
+        memset(*buffer, 0, size);
+
+        header = (struct datamodelShmHeader *)*buffer;
+        header->devices    = layout.devices;
+        header->interfaces = layout.interfaces;
+        header->radios     = layout.radios;
+        header->links      = layout.links;
+    }
+
+    header->magic       = DATAMODEL_SHM_MAGIC;
+    header->version     = DATAMODEL_SHM_VERSION;
+    header->header_size = sizeof(struct datamodelShmHeader);
+    header->generation  = datamodel_generation;
+    header->timestamp   = PLATFORM_GET_TIMESTAMP();
+    header->size        = size;
+    if (NULL != local_device)
+    {
+        memcpy(header->local_al_mac, local_device->al_mac_addr, 6);
+    }
+    if (NULL != registrar.d)
+    {
+        memcpy(header->registrar_al_mac, registrar.d->al_mac_addr, 6);
+    }
+
+    // Devices and radios
+    //
+    i = 0;
+    j = 0;
+    dlist_for_each(device, network, l)
+    {
+        struct datamodelShmDevice *d = (struct datamodelShmDevice *)datamodelShmRecord(header, &header->devices, i++);
+
+        memcpy(d->al_mac_addr, device->al_mac_addr, 6);
+        d->flags = (device == local_device        ? DATAMODEL_SHM_DEVICE_LOCAL          : 0) |
+                   (device->is_map_agent          ? DATAMODEL_SHM_DEVICE_MAP_AGENT      : 0) |
+                   (device->is_map_controller     ? DATAMODEL_SHM_DEVICE_MAP_CONTROLLER : 0) |
+                   (device == registrar.d         ? DATAMODEL_SHM_DEVICE_REGISTRAR      : 0) |
+                   (device->stale                 ? DATAMODEL_SHM_DEVICE_STALE          : 0);
+
+        d->interfaces_nr    = dlist_count(&device->interfaces);
+        d->interfaces_first = d->interfaces_nr > 0 ?
+                              _indexMapFind(container_of(dlist_get_first(&device->interfaces), struct interface, l)) :
+                              DATAMODEL_SHM_NONE;
+        d->radios_first     = j;
+
+        dlist_for_each(radio, device->radios, l)
+        {
+            struct datamodelShmRadio *r = (struct datamodelShmRadio *)datamodelShmRecord(header, &header->radios, j++);
+            unsigned b;
+
+            memcpy(r->uid, radio->uid, 6);
+            memcpy(r->conf_ants, radio->confAnts, 2);
+            _copyName(r->name, radio->name);
+            r->index               = radio->index;
+            r->device              = i - 1;
+            r->max_ap_stations     = radio->maxApStations;
+            r->max_bss             = radio->maxBSS;
+            r->monitor             = radio->monitor;
+            r->configured_bsses_nr = radio->configured_bsses.length;
+            for (b = 0; b < radio->bands.length; b++)
+            {
+                r->bands |= 1 << radio->bands.data[b]->id;
+            }
+            d->radios_nr++;
+        }
+        if (0 == d->radios_nr)
+        {
+            d->radios_first = DATAMODEL_SHM_NONE;
+        }
+    }
+
+    // Interfaces and their links
+    //
+    links_nr = 0;
+    for (i = 0; i < builder.interfaces_nr; i++)
+    {
+        struct datamodelShmInterface *x = (struct datamodelShmInterface *)datamodelShmRecord(header, &header->interfaces, i);
+
+        interface = builder.interfaces[i];
+
+        memcpy(x->addr, interface->addr, 6);
+        _copyName(x->name, interface->name);
+        x->media_type  = interface->media_type;
+        x->device      = _indexMapFind(interface->owner);
+        x->radio       = DATAMODEL_SHM_NONE;
+        x->type        = interface->type;
+        x->power_state = interface->power_state;
+        x->media_specific_info_length = interface->media_specific_info_length;
+        memcpy(x->media_specific_info, interface->media_specific_info, sizeof(x->media_specific_info));
+
+        if (interface_type_wifi == interface->type)
+        {
+            struct interfaceWifi *ifw = container_of(interface, struct interfaceWifi, i);
+
+            x->radio       = _indexMapFind(ifw->radio);
+            x->wifi_role   = ifw->role;
+            x->ssid_length = ifw->bssInfo.ssid.length;
+            memcpy(x->bssid, ifw->bssInfo.bssid, 6);
+            memcpy(x->ssid, ifw->bssInfo.ssid.ssid, sizeof(x->ssid));
+        }
+
+        x->links_first = links_nr;
+        for (j = 0; j < interface->neighbors.length; j++)
+        {
+            struct interface        *neighbor = interface->neighbors.data[j];
+            struct datamodelShmLink *link;
+            uint32_t                 neighbor_index = _indexMapFind(neighbor);
+
+            if (DATAMODEL_SHM_NONE == neighbor_index)
+            {
+                // Neighbor of a non-1905 neighbor which isn't reachable from
+                // any device. Nothing to export.
+                //
+                continue;
+            }
+            link = (struct datamodelShmLink *)datamodelShmRecord(header, &header->links, links_nr++);
+            link->neighbor                   = neighbor_index;
+            link->last_topology_discovery_ts = neighbor->last_topology_discovery_ts;
+            link->last_bridge_discovery_ts   = neighbor->last_bridge_discovery_ts;
+            x->links_nr++;
+        }
+    }
+    header->links.nr = links_nr;
+
+    return size;
+}
+
+
+unsigned datamodelSnapshotRestore(const struct datamodelShmHeader *header, size_t size)
+{
+    struct interface **interfaces;
+    uint32_t           now;
+    uint32_t           i, j;
+    unsigned           restored = 0;
+
+    if (!_checkSnapshot(header, size))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Invalid data model snapshot. Ignoring it.\n");
+        return 0;
+    }
+
+    now        = PLATFORM_GET_TIMESTAMP();
+    interfaces = zmemalloc((header->interfaces.nr + 1) * sizeof(*interfaces));
+
+    // Create the devices we don't know about yet. The interfaces of the local
+    // device are mapped on the current local interfaces, so that its links
+    // can be restored too. Devices that already exist are left alone.
+    //
+    for (i = 0; i < header->devices.nr; i++)
+    {
+        const struct datamodelShmDevice *d = datamodelShmRecord(header, &header->devices, i);
+
+        if (NULL != local_device && 0 == memcmp(d->al_mac_addr, local_device->al_mac_addr, 6))
+        {
+            for (j = 0; j < d->interfaces_nr; j++)
+            {
+                const struct datamodelShmInterface *x = datamodelShmRecord(header, &header->interfaces,
+                                                                           d->interfaces_first + j);
+
+                interfaces[d->interfaces_first + j] = alDeviceFindInterface(local_device, x->addr);
+            }
+        }
+        else if (NULL == alDeviceFind(d->al_mac_addr))
+        {
+            _restoreDevice(header, d, interfaces, now);
+            restored++;
+        }
+    }
+
+    // Links of the restored devices. Each link appears twice in the snapshot
+    // (once from each side), so only add the ones that don't exist yet.
+    // Non-1905 neighbors are created on demand, so that only the ones
+    // attached to a restored device come back.
+    //
+    for (i = 0; i < header->interfaces.nr; i++)
+    {
+        const struct datamodelShmInterface *x = datamodelShmRecord(header, &header->interfaces, i);
+        bool                                restored_interface;
+
+        if (NULL == interfaces[i])
+        {
+            continue;
+        }
+        restored_interface = NULL != interfaces[i]->owner && interfaces[i]->owner->stale;
+
+        for (j = 0; j < x->links_nr; j++)
+        {
+            const struct datamodelShmLink *link = datamodelShmRecord(header, &header->links, x->links_first + j);
+            struct interface              *neighbor;
+
+            neighbor = interfaces[link->neighbor];
+            if (NULL == neighbor)
+            {
+                const struct datamodelShmInterface *n = datamodelShmRecord(header, &header->interfaces, link->neighbor);
+
+                if (!restored_interface || DATAMODEL_SHM_NONE != n->device)
+                {
+                    continue;
+                }
+                neighbor = interfaceAlloc(n->addr, NULL);
+                neighbor->type       = n->type;
+                neighbor->media_type = n->media_type;
+                interfaces[link->neighbor] = neighbor;
+            }
+            else if (!restored_interface && (NULL == neighbor->owner || !neighbor->owner->stale))
+            {
+                // Link between two objects that were not restored
+                //
+                continue;
+            }
+            if (PTRARRAY_FIND(interfaces[i]->neighbors, neighbor) == interfaces[i]->neighbors.length)
+            {
+                interfaceAddNeighbor(interfaces[i], neighbor);
+            }
+        }
+    }
+
+    free(interfaces);
+    return restored;
+}
@@ -17,13 +17,11 @@
  */
 
 #include <hlist.h>
-#include <utils.h> /* memalloc() */
-#include <string.h> /* memset() */
+#include <pool.h>
 
 struct hlist_item *hlist_alloc(size_t size, dlist_head *parent)
 {
-    hlist_item *ret = memalloc(size);
-    memset(ret, 0, size);
+    hlist_item *ret = pool_alloc(pool_get_sized(size));
     dlist_head_init(&ret->l);
     dlist_head_init(&ret->children[0]);
     dlist_head_init(&ret->children[1]);
@@ -57,5 +55,5 @@ void hlist_delete_item(hlist_item *item)
     assert(dlist_empty(&item->l));
     hlist_delete(&item->children[0]);
     hlist_delete(&item->children[1]);
-    free(item);
+    pool_free(item);
 }
@@ -23,7 +23,11 @@
 #include "../platform_interfaces_ghnspirit_priv.h"  // registerGhnSpiritInterfaceType
 #include "../platform_interfaces_simulated_priv.h"  // registerSimulatedInterfaceType
 #include "../platform_alme_server_priv.h"           // almeServerPortSet()
+#include "../platform_capture_priv.h"                // capturePathSet()
 #include "../../al.h"                                  // start1905AL
+#include "../../topology_snapshot.h"                    // topologySnapshotPathSet()
+#include "../../al_link_metrics.h"                      // linkMetricsCacheValiditySet()
+#include "../../al_cmdu_stats.h"                        // cmduStatsPeriodSet()
 
 #include <stdio.h>   // printf
 #include <unistd.h>  // getopt
@@ -74,7 +78,7 @@ static void _printUsage(char *program_name)
 {
     printf("AL entity (build %s)\n", _BUILD_NUMBER_);
     printf("\n");
-    printf("Usage: %s -m <al_mac_address> -i <interfaces_list> [-w] [-r <registrar_interface>] [-v] [-p <alme_port_number>]\n", program_name);
+    printf("Usage: %s -m <al_mac_address> -i <interfaces_list> [-w] [-r <registrar_interface>] [-v] [-p <alme_port_number>] [-s <snapshot_file>] [-c <capture_file>] [-M <metrics_validity_ms>] [-S <stats_period_ms>]\n", program_name);
     printf("\n");
     printf("  ...where:\n");
     printf("       '<al_mac_address>' is the AL MAC address that this AL entity will receive\n");
@@ -96,6 +100,23 @@ static void _printUsage(char *program_name)
     printf("       '<alme_port_number>', is the port number where a TCP socket will be opened to receive\n");
     printf("       ALME messages. If this argument is not given, a default value of '8888' is used.\n");
     printf("\n");
+    printf("       '<snapshot_file>', if present, is the file where the AL entity periodically saves (and\n");
+    printf("       also saves when terminated) its view of the network. At startup, a recent enough\n");
+    printf("       snapshot is loaded from it, and then revalidated in the background.\n");
+    printf("\n");
+    printf("       '<capture_file>', if present, is the file where all received and transmitted 1905 and\n");
+    printf("       LLDP frames are saved, in pcap format. The file is rotated when it reaches %d KiB, and\n", CAPTURE_MAX_FILE_SIZE / 1024);
+    printf("       up to %d files are kept ('<capture_file>.1', ...).\n", CAPTURE_MAX_FILES);
+    printf("\n");
+    printf("       '<metrics_validity_ms>' is the time (in milliseconds) during which link metrics are\n");
+    printf("       reused instead of being read again from the platform. '0' disables this cache. Other\n");
+    printf("       values below '%d' are raised to it. If this argument is not given, a default value of\n", LINK_METRICS_CACHE_MIN_VALIDITY);
+    printf("       '%d' is used.\n", LINK_METRICS_CACHE_DEFAULT_VALIDITY);
+    printf("\n");
+    printf("       '<stats_period_ms>', if present, enables the per message type statistics (counters,\n");
+    printf("       processing times and allocations) and prints them every '<stats_period_ms>'\n");
+    printf("       milliseconds. They can also be retrieved with the 'dcs' ALME custom command.\n");
+    printf("\n");
 
     return;
 }
@@ -115,13 +136,17 @@ int main(int argc, char *argv[])
     char *al_interfaces       = NULL;
     int  alme_port_number     = 0;
     char *registrar_interface = NULL;
+    char *snapshot_file       = NULL;
+    char *capture_file        = NULL;
+    int  metrics_validity     = LINK_METRICS_CACHE_DEFAULT_VALIDITY;
+    int  stats_period         = 0;
 
     int verbosity_counter = 1; // Only ERROR and WARNING messages
 
     registerGhnSpiritInterfaceType();
     registerSimulatedInterfaceType();
 
-    while ((c = getopt (argc, argv, "m:i:wr:vh:p:")) != -1)
+    while ((c = getopt (argc, argv, "m:i:wr:vh:p:s:c:M:S:")) != -1)
     {
         switch (c)
         {
@@ -179,6 +204,39 @@ int main(int argc, char *argv[])
                 break;
             }
 
+            case 's':
+            {
+                // File where the view of the network is saved, so that it
+                // survives restarts
+                //
+                snapshot_file = optarg;
+                break;
+            }
+
+            case 'c':
+            {
+                // File where the 1905 and LLDP traffic is captured
+                //
+                capture_file = optarg;
+                break;
+            }
+
+            case 'M':
+            {
+                // Validity of the cached link metrics
+                //
+                metrics_validity = atoi(optarg);
+                break;
+            }
+
+            case 'S':
+            {
+                // Period of the per message type statistics
+                //
+                stats_period = atoi(optarg);
+                break;
+            }
+
             case 'h':
             {
                 _printUsage(argv[0]);
@@ -205,6 +263,10 @@ int main(int argc, char *argv[])
     asciiToMac(al_mac, &al_mac_address);
 
     almeServerPortSet(alme_port_number);
+    topologySnapshotPathSet(snapshot_file);
+    capturePathSet(capture_file);
+    linkMetricsCacheValiditySet(metrics_validity < 0 ? 0 : metrics_validity);
+    cmduStatsPeriodSet(stats_period < 0 ? 0 : stats_period);
 
     start1905AL(al_mac_address, map_whole_network, registrar_interface);
 
@@ -0,0 +1,312 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <platform.h>
+#include <utils.h>
+#include <datamodel.h>
+#include <datamodel_shm.h>
+
+#include <errno.h>      // errno
+#include <fcntl.h>      // O_* constants
+#include <stdlib.h>     // free()
+#include <string.h>     // memcpy(), strerror(), ...
+#include <sys/mman.h>   // shm_open(), mmap(), ...
+#include <sys/stat.h>   // fstat()
+#include <unistd.h>     // ftruncate(), close()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// The segment is grown in steps of this size, so that it doesn't need to be
+// remapped every time a device is added.
+//
+#define SHM_SIZE_STEP      (64 * 1024)
+
+// Number of times a reader retries when it races with the writer before giving
+// up.
+//
+#define SHM_READER_RETRIES (1000)
+
+static struct _shmWriter
+{
+    int                     fd;
+    struct datamodelShmHeader *header;  // Start of the mapping
+    size_t                  map_size;
+
+    bool                    published;  // 'generation' is valid
+    uint32_t                generation; // Generation of the last snapshot
+
+    // Scratch space for building the snapshot, reused between snapshots
+    //
+    uint8_t                *buffer;
+    size_t                  buffer_size;
+
+} writer = { .fd = -1 };
+
+// Make sure the segment is at least 'size' bytes long
+//
+static bool _growSegment(size_t size)
+{
+    void   *map;
+    size_t  new_size;
+
+    if (size <= writer.map_size)
+    {
+        return true;
+    }
+
+    new_size = (size + SHM_SIZE_STEP - 1) / SHM_SIZE_STEP * SHM_SIZE_STEP;
+    if (-1 == ftruncate(writer.fd, new_size))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] ftruncate() failed with errno=%d (%s)\n", errno, strerror(errno));
+        return false;
+    }
+    map = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, writer.fd, 0);
+    if (MAP_FAILED == map)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] mmap() failed with errno=%d (%s)\n", errno, strerror(errno));
+        return false;
+    }
+    if (NULL != writer.header)
+    {
+        munmap(writer.header, writer.map_size);
+    }
+    writer.header   = map;
+    writer.map_size = new_size;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (writer)
+////////////////////////////////////////////////////////////////////////////////
+
+bool datamodelShmInit(void)
+{
+    struct stat st;
+    uint32_t    sequence = 0;
+
+    writer.fd = shm_open(DATAMODEL_SHM_NAME, O_RDWR | O_CREAT, 0644);
+    if (-1 == writer.fd)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] shm_open(%s) failed with errno=%d (%s)\n", DATAMODEL_SHM_NAME, errno, strerror(errno));
+        return false;
+    }
+
+    if (0 == fstat(writer.fd, &st) && (size_t)st.st_size >= sizeof(struct datamodelShmHeader))
+    {
+        // Segment left behind by a previous instance. Keep it (readers may
+        // still have it mapped), but make sure its sequence keeps increasing.
+        //
+        writer.header   = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, writer.fd, 0);
+        writer.map_size = st.st_size;
+        if (MAP_FAILED == writer.header)
+        {
+            writer.header   = NULL;
+            writer.map_size = 0;
+        }
+        else if (DATAMODEL_SHM_MAGIC == writer.header->magic && DATAMODEL_SHM_VERSION == writer.header->version)
+        {
+            sequence = (writer.header->sequence + 1) & ~1U;
+        }
+    }
+
+    if (!_growSegment(SHM_SIZE_STEP))
+    {
+        close(writer.fd);
+        writer.fd = -1;
+        return false;
+    }
+
+    __atomic_store_n(&writer.header->sequence, sequence, __ATOMIC_RELEASE);
+    writer.header->magic       = DATAMODEL_SHM_MAGIC;
+    writer.header->version     = DATAMODEL_SHM_VERSION;
+    writer.header->header_size = sizeof(struct datamodelShmHeader);
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("[DM SHM] Data model exported in shared memory segment %s\n", DATAMODEL_SHM_NAME);
+    return true;
+}
+
+void datamodelShmPublish(bool force)
+{
+    size_t   size;
+    uint32_t sequence;
+
+    if (-1 == writer.fd)
+    {
+        return;
+    }
+    if (!force && writer.published && writer.generation == datamodel_generation)
+    {
+        return;
+    }
+
+    // Build the snapshot outside of the segment, so that readers are blocked
+    // only for the time it takes to copy it.
+    //
+    size = datamodelSnapshotBuild(&writer.buffer, &writer.buffer_size);
+    if (!_growSegment(size))
+    {
+        return;
+    }
+
+    // The fields before 'generation' never change after datamodelShmInit()
+    //
+    sequence = writer.header->sequence;
+    __atomic_store_n(&writer.header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy((uint8_t *)writer.header + offsetof(struct datamodelShmHeader, generation),
+           writer.buffer            + offsetof(struct datamodelShmHeader, generation),
+           size - offsetof(struct datamodelShmHeader, generation));
+
+    __atomic_store_n(&writer.header->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    writer.published  = true;
+    writer.generation = datamodel_generation;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions (reader)
+////////////////////////////////////////////////////////////////////////////////
+
+static bool _readerMap(struct datamodelShmReader *reader)
+{
+    struct stat st;
+    void       *map;
+
+    if (-1 == fstat(reader->fd, &st) || (size_t)st.st_size < sizeof(struct datamodelShmHeader))
+    {
+        return false;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (MAP_FAILED == map)
+    {
+        return false;
+    }
+    if (NULL != reader->map)
+    {
+        munmap(reader->map, reader->map_size);
+    }
+    reader->map      = map;
+    reader->map_size = st.st_size;
+
+    return true;
+}
+
+bool datamodelShmReaderOpen(struct datamodelShmReader *reader)
+{
+    reader->fd = shm_open(DATAMODEL_SHM_NAME, O_RDONLY, 0);
+    if (-1 == reader->fd)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] shm_open(%s) failed with errno=%d (%s)\n", DATAMODEL_SHM_NAME, errno, strerror(errno));
+        return false;
+    }
+    if (!_readerMap(reader))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] Could not map %s\n", DATAMODEL_SHM_NAME);
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+    reader->sequence = 1; // Odd, so never matches a valid snapshot
+
+    return true;
+}
+
+const struct datamodelShmHeader *datamodelShmReaderGet(struct datamodelShmReader *reader)
+{
+    const struct datamodelShmHeader *shared = reader->map;
+    unsigned                         retries;
+
+    for (retries = 0; retries < SHM_READER_RETRIES; retries++)
+    {
+        uint32_t sequence;
+        uint32_t size;
+
+        sequence = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1)
+        {
+            // Writer is busy
+            //
+            continue;
+        }
+        if (sequence == reader->sequence)
+        {
+            return (const struct datamodelShmHeader *)reader->copy;
+        }
+
+        size = __atomic_load_n(&shared->size, __ATOMIC_RELAXED);
+        if (size < sizeof(struct datamodelShmHeader))
+        {
+            // Nothing published yet
+            //
+            return NULL;
+        }
+        if (size > reader->map_size)
+        {
+            if (!_readerMap(reader))
+            {
+                return NULL;
+            }
+            shared = reader->map;
+            continue;
+        }
+
+        if (size > reader->copy_size)
+        {
+            reader->copy      = memrealloc(reader->copy, size);
+            reader->copy_size = size;
+        }
+        memcpy(reader->copy, shared, size);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (sequence == __atomic_load_n(&shared->sequence, __ATOMIC_RELAXED))
+        {
+            const struct datamodelShmHeader *header = (const struct datamodelShmHeader *)reader->copy;
+
+            if (DATAMODEL_SHM_MAGIC != header->magic || DATAMODEL_SHM_VERSION != header->version)
+            {
+                PLATFORM_PRINTF_DEBUG_ERROR("[DM SHM] Incompatible segment (magic 0x%08x, version %u)\n",
+                                            header->magic, header->version);
+                return NULL;
+            }
+            reader->sequence = sequence;
+            return header;
+        }
+    }
+
+    PLATFORM_PRINTF_DEBUG_WARNING("[DM SHM] Could not get a consistent snapshot\n");
+    return NULL;
+}
+
+void datamodelShmReaderClose(struct datamodelShmReader *reader)
+{
+    if (NULL != reader->map)
+    {
+        munmap(reader->map, reader->map_size);
+    }
+    if (-1 != reader->fd)
+    {
+        close(reader->fd);
+    }
+    free(reader->copy);
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+}
@@ -19,6 +19,7 @@
 #include <platform.h>
 #include <utils.h>
 #include <1905_alme.h>
+#include <datamodel_shm.h>
 
 #include <stdio.h>   // printf
 #include <unistd.h>  // getopt
@@ -193,6 +194,10 @@ uint8_t *_build_alme_request(char *alme_request_type, int argc, char **argv)
         {
             p->command = CUSTOM_COMMAND_DUMP_NETWORK_DEVICES;
         }
+        else if (0 == strcmp(argv[optind], "dcs"))
+        {
+            p->command = CUSTOM_COMMAND_DUMP_CMDU_STATS;
+        }
         else
         {
             PLATFORM_PRINTF_DEBUG_ERROR("Invalid arguments for 'ALME-CUSTOM-COMMAND' message\n");
@@ -220,19 +225,18 @@ uint8_t *_build_alme_request(char *alme_request_type, int argc, char **argv)
 //
 //   - 'alme_request_len' is the number of bytes of 'alme_request'
 //
-//   - 'alme_reply' is a pointer to a buffer which is 'alme_reply_len' bytes
-//      long where the response from the AL entity (either an ALME RESPONSE or
-//      an ALME CONFIRMATION message) will be placed.
+//   - 'alme_reply' is an output argument that will point to a buffer
+//      containing the response from the AL entity (either an ALME RESPONSE or
+//      an ALME CONFIRMATION message, or a sequence of them for replies that
+//      don't fit in a single message).
 //
-//   - 'alme_request_len' is the capacity of the 'alme_reply' buffer. It is also
-//     used as an output argument that will contain the actual length of the
-//     reply.
+//   - 'alme_reply_len' is an output argument that will contain the length of
+//     the reply.
 //
 // Note that the caller is responsible for freeing both 'alme_request' and
-// 'alme_response' after they are no longer needed (ie. this function does not
-// allocate/free memory at all).
+// 'alme_reply' (with "free()") after they are no longer needed.
 //
-int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_request, int alme_request_len, uint8_t *alme_reply, int *alme_reply_len)
+int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_request, int alme_request_len, uint8_t **alme_reply, int *alme_reply_len)
 {
     int sock;
 
@@ -242,6 +246,7 @@ int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_requ
 
     ssize_t received;
     ssize_t total_received;
+    ssize_t reply_size;
 
     char *aux;
     char *ip;
@@ -323,23 +328,22 @@ int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_requ
         return 0;
     }
 
-    // Receive a reply from the server
+    // Receive a reply from the server. Its size is not known in advance, so
+    // the buffer grows as needed.
     //
     PLATFORM_PRINTF_DEBUG_INFO("Waiting for the ALME reply...\n");
+    #define REPLY_SIZE_STEP (16*MAX_NETWORK_SEGMENT_SIZE)
+    reply_size     = REPLY_SIZE_STEP;
+    *alme_reply    = (uint8_t *)memalloc(reply_size);
     total_received = 0;
 #ifndef _FLAVOUR_X86_WINDOWS_MINGW_
-    while( (received = recv(sock, alme_reply + total_received, *alme_reply_len - total_received, 0)) > 0 )
+    while( (received = recv(sock, *alme_reply + total_received, reply_size - total_received, 0)) > 0 )
 #else
-    while( (received = recv(sock, (char *)(alme_reply + total_received), *alme_reply_len - total_received, 0)) > 0 )
+    while( (received = recv(sock, (char *)(*alme_reply + total_received), reply_size - total_received, 0)) > 0 )
 #endif
     {
         // Keep reading until the server closes the connection
         //
-        if (-1 == received)
-        {
-            PLATFORM_PRINTF_DEBUG_ERROR("recv() failed with errno=%d (%s)\n", errno, strerror(errno));
-            return 0;
-        }
 #ifndef _FLAVOUR_X86_WINDOWS_MINGW_
         PLATFORM_PRINTF_DEBUG_INFO("%zd byte(s) received\n", received);
 #else
@@ -348,14 +352,19 @@ int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_requ
 
         total_received += received;
 
-        if (total_received >= *alme_reply_len)
+        if (total_received == reply_size)
         {
-            // This message is too big.
-            //
-            PLATFORM_PRINTF_DEBUG_ERROR("Error! Received message is too big\n");
-            return 0;
+            reply_size  += REPLY_SIZE_STEP;
+            *alme_reply  = (uint8_t *)memrealloc(*alme_reply, reply_size);
         }
     }
+    if (-1 == received)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("recv() failed with errno=%d (%s)\n", errno, strerror(errno));
+        free(*alme_reply);
+        *alme_reply = NULL;
+        return 0;
+    }
 
 #ifndef _FLAVOUR_X86_WINDOWS_MINGW_
     PLATFORM_PRINTF_DEBUG_INFO("ALME reply received (%zd bytes in total). Closing socket...\n", total_received);
@@ -378,6 +387,71 @@ int _sendAlmeRequestAndWaitForReply(char *server_ip_and_port, uint8_t *alme_requ
     return 1;
 }
 
+// Print the topology exported by a local AL entity in shared memory (see
+// "datamodel_shm.h").
+// Returns '0' if there was a problem, '1' otherwise.
+//
+static int _dumpSharedMemoryDatamodel(void)
+{
+    struct datamodelShmReader        reader = {0};
+    const struct datamodelShmHeader *header;
+    uint32_t i, j;
+
+    if (!datamodelShmReaderOpen(&reader))
+    {
+        return 0;
+    }
+    header = datamodelShmReaderGet(&reader);
+    if (NULL == header)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("No data model snapshot available\n");
+        datamodelShmReaderClose(&reader);
+        return 0;
+    }
+
+    PLATFORM_PRINTF("Snapshot generation %u (timestamp %u ms), %u device(s)\n", header->generation, header->timestamp, header->devices.nr);
+    for (i = 0; i < header->devices.nr; i++)
+    {
+        const struct datamodelShmDevice *d = datamodelShmRecord(header, &header->devices, i);
+
+        PLATFORM_PRINTF("Device %02x:%02x:%02x:%02x:%02x:%02x%s%s%s%s\n",
+                        d->al_mac_addr[0], d->al_mac_addr[1], d->al_mac_addr[2], d->al_mac_addr[3], d->al_mac_addr[4], d->al_mac_addr[5],
+                        d->flags & DATAMODEL_SHM_DEVICE_LOCAL          ? " (local)"      : "",
+                        d->flags & DATAMODEL_SHM_DEVICE_REGISTRAR      ? " (registrar)"  : "",
+                        d->flags & DATAMODEL_SHM_DEVICE_MAP_AGENT      ? " (agent)"      : "",
+                        d->flags & DATAMODEL_SHM_DEVICE_MAP_CONTROLLER ? " (controller)" : "");
+
+        for (j = 0; j < d->radios_nr; j++)
+        {
+            const struct datamodelShmRadio *r = datamodelShmRecord(header, &header->radios, d->radios_first + j);
+
+            PLATFORM_PRINTF("  Radio %02x:%02x:%02x:%02x:%02x:%02x %s: %u BSS(es) configured\n",
+                            r->uid[0], r->uid[1], r->uid[2], r->uid[3], r->uid[4], r->uid[5], r->name, r->configured_bsses_nr);
+        }
+
+        for (j = 0; j < d->interfaces_nr; j++)
+        {
+            const struct datamodelShmInterface *x = datamodelShmRecord(header, &header->interfaces, d->interfaces_first + j);
+            uint32_t k;
+
+            PLATFORM_PRINTF("  Interface %02x:%02x:%02x:%02x:%02x:%02x %s (media type 0x%04x): %u neighbor(s)\n",
+                            x->addr[0], x->addr[1], x->addr[2], x->addr[3], x->addr[4], x->addr[5], x->name, x->media_type, x->links_nr);
+
+            for (k = 0; k < x->links_nr; k++)
+            {
+                const struct datamodelShmLink      *link     = datamodelShmRecord(header, &header->links, x->links_first + k);
+                const struct datamodelShmInterface *neighbor = datamodelShmRecord(header, &header->interfaces, link->neighbor);
+
+                PLATFORM_PRINTF("    -> %02x:%02x:%02x:%02x:%02x:%02x%s\n",
+                                neighbor->addr[0], neighbor->addr[1], neighbor->addr[2], neighbor->addr[3], neighbor->addr[4], neighbor->addr[5],
+                                DATAMODEL_SHM_NONE == neighbor->device ? " (non-1905)" : "");
+            }
+        }
+    }
+
+    datamodelShmReaderClose(&reader);
+    return 1;
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -396,13 +470,12 @@ int main(int argc, char *argv[])
 
     int verbosity_counter = 1; // Only ERROR and WARNING messages
 
-    #define MAX_REPLY_SIZE (100*MAX_NETWORK_SEGMENT_SIZE)
-
     uint8_t  *alme_reply_structure;
-    uint8_t   alme_reply_payload[MAX_REPLY_SIZE];
-    int     alme_reply_payload_len = MAX_REPLY_SIZE;
+    uint8_t  *alme_reply_payload;
+    int     alme_reply_payload_len;
 
     char aux[300*1024];
+    int  aux_len;
 
     int i;
 
@@ -414,7 +487,7 @@ int main(int argc, char *argv[])
     WSAStartup(versionWanted, &wsaData);
 #endif
 
-    while ((c = getopt (argc, argv, "va:m:h")) != -1)
+    while ((c = getopt (argc, argv, "va:m:sh")) != -1)
     {
         switch (c)
         {
@@ -443,6 +516,14 @@ int main(int argc, char *argv[])
                 alme_request_type = optarg;
                 break;
             }
+            case 's':
+            {
+                // Read the topology from the shared memory segment exported
+                // by a local AL entity instead of sending an ALME request.
+                //
+                PLATFORM_PRINTF_DEBUG_SET_VERBOSITY_LEVEL(verbosity_counter);
+                exit(_dumpSharedMemoryDatamodel() ? 0 : 1);
+            }
             case 'h':
             {
                 // Help
@@ -450,12 +531,15 @@ int main(int argc, char *argv[])
                 PLATFORM_PRINTF("HLE entity (build %s)\n", _BUILD_NUMBER_);
                 PLATFORM_PRINTF("\n");
                 PLATFORM_PRINTF("Usage:  %s  [-v] -a <ip address>:<tcp port> -m <ALME request type> [ALME arguments]\n", argv[0]);
+                PLATFORM_PRINTF("        %s  [-v] -s\n", argv[0]);
                 PLATFORM_PRINTF("\n");
                 PLATFORM_PRINTF("  where...\n");
                 PLATFORM_PRINTF("\n");
                 PLATFORM_PRINTF("    *  '-v', if present, will increase the verbosity level. Can be present more than once,\n");
                 PLATFORM_PRINTF("       making the HLE entity even more verbose each time.\n");
                 PLATFORM_PRINTF("\n");
+                PLATFORM_PRINTF("    *  '-s' dumps the topology exported in shared memory by the AL running on this host.\n");
+                PLATFORM_PRINTF("\n");
                 PLATFORM_PRINTF("    * <ip address>:<tcp port> are used to identify the ALME listening socket used by the AL we want to query/control\n");
                 PLATFORM_PRINTF("\n");
                 PLATFORM_PRINTF("    * <ALME request type> can be any of the following (some of them use extra arguments):\n");
@@ -464,6 +548,7 @@ int main(int argc, char *argv[])
                 PLATFORM_PRINTF("        - ALME-GET-METRIC.request xx:xx:xx:xx:xx:xx  <--- Get metrics between the queried AL and the neighbor whose AL MAC address matches the provided one\n");
                 PLATFORM_PRINTF("        - ALME-CUSTOM-COMMAND.request <command>      <--- Custom (non-standard) commands. Possible values and their effect:\n");
                 PLATFORM_PRINTF("                                                            - dnd : dump network devices. Returns a text dump of the AL internal devices database\n");
+                PLATFORM_PRINTF("                                                            - dcs : dump CMDU statistics. Returns the per message type counters and processing times of the AL\n");
                 PLATFORM_PRINTF("\n");
                 exit(0);
             }
@@ -517,32 +602,57 @@ int main(int argc, char *argv[])
     // Send that bit stream to the AL entity and wait for a response
     //
     PLATFORM_PRINTF_DEBUG_INFO("Sending bit stream to %s (len = %d)...\n", al_ip_address_and_tcp_port, alme_request_payload_len);
-    if (0 == _sendAlmeRequestAndWaitForReply(al_ip_address_and_tcp_port, alme_request_payload, alme_request_payload_len, alme_reply_payload, &alme_reply_payload_len))
+    if (0 == _sendAlmeRequestAndWaitForReply(al_ip_address_and_tcp_port, alme_request_payload, alme_request_payload_len, &alme_reply_payload, &alme_reply_payload_len))
     {
         PLATFORM_PRINTF_DEBUG_ERROR("ERROR: AL communication problem\n");
         exit(1);
     }
     free_1905_ALME_packet(alme_request_payload);
 
+    // The reply can be arbitrarily long, so only its first bytes are displayed
+    //
     PLATFORM_PRINTF_DEBUG_INFO("Displaying bit stream associated to the ALME RESPONSE/CONFIRMATION structure (%d byte(s) long):\n", alme_reply_payload_len);
-    aux[0] = 0;
-    for (i=0; i<alme_reply_payload_len; i++)
+    aux[0]  = 0;
+    aux_len = 0;
+    for (i=0; i<alme_reply_payload_len && aux_len + 6 < (int)sizeof(aux); i++)
     {
-        char item[10];
-
-        sprintf(item, "0x%02x ", alme_reply_payload[i]);
-        strcat(aux, item);
+        aux_len += sprintf(aux + aux_len, "0x%02x ", alme_reply_payload[i]);
     }
-    PLATFORM_PRINTF_DEBUG_INFO("%s\n", aux);
+    PLATFORM_PRINTF_DEBUG_INFO("%s%s\n", aux, i < alme_reply_payload_len ? "..." : "");
 
-    // Convert the response back into a structure and print it to stdout
-    //
-    alme_reply_structure = parse_1905_ALME_from_packet(alme_reply_payload);
-    if (NULL == alme_reply_structure)
+    if (alme_reply_payload_len > 0 && ALME_TYPE_CUSTOM_COMMAND_RESPONSE == alme_reply_payload[0])
+    {
+        // Custom command responses can be split into several consecutive
+        // messages (see "struct customCommandResponseALME"). Print the text
+        // they contain as it is.
+        //
+        i = 0;
+        while (i + 3 <= alme_reply_payload_len && ALME_TYPE_CUSTOM_COMMAND_RESPONSE == alme_reply_payload[i])
+        {
+            int bytes_nr = (alme_reply_payload[i+1] << 8) | alme_reply_payload[i+2];
+
+            if (i + 3 + bytes_nr > alme_reply_payload_len)
+            {
+                PLATFORM_PRINTF_DEBUG_ERROR("ERROR: Truncated ALME RESPONSE\n");
+                break;
+            }
+            PLATFORM_PRINTF("%.*s", bytes_nr, (const char *)&alme_reply_payload[i+3]);
+
+            i += 3 + bytes_nr;
+        }
+    }
+    else
     {
-        PLATFORM_PRINTF_DEBUG_ERROR("ERROR: Cannot parse ALME RESPONSE/CONFIRMATION\n");
+        // Convert the response back into a structure and print it to stdout
+        //
+        alme_reply_structure = parse_1905_ALME_from_packet(alme_reply_payload, (uint16_t)alme_reply_payload_len);
+        if (NULL == alme_reply_structure)
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("ERROR: Cannot parse ALME RESPONSE/CONFIRMATION\n");
+        }
+        visit_1905_ALME_structure(alme_reply_structure, print_callback, PLATFORM_PRINTF, "");
     }
-    visit_1905_ALME_structure(alme_reply_structure, print_callback, PLATFORM_PRINTF, "");
+    free(alme_reply_payload);
 
     return 0;
 }
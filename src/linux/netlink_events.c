@@ -0,0 +1,245 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/** @file
+ *
+ *  Live nl80211 notifications.
+ *
+ *  A single netlink socket is joined to the nl80211 multicast groups and kept open for the lifetime of the AL. Each
+ *  notification that affects the data model is translated to a PLATFORM_QUEUE_EVENT_RADIO_CHANGE message, so that the
+ *  data model itself is only ever updated from the AL thread.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <net/if.h>             // if_indextoname()
+#include <sys/ioctl.h>          // ioctl(SIOCGIFHWADDR)
+#include <sys/socket.h>
+
+#include <netlink/attr.h>       // nla_parse()
+#include <netlink/errno.h>      // nl_geterror()
+#include <netlink/genl/ctrl.h>  // genl_ctrl_resolve_grp()
+#include <netlink/genl/genl.h>  // genlmsg_attr*()
+
+#include "netlink_funcs.h"
+#include "nl80211.h"
+#include "platform.h"
+#include "../platform_interfaces.h"
+#include "../platform_os.h"
+#include "platform_os_priv.h"
+
+#define RADIO_CHANGE_MSG_LEN    (20)
+
+/* Multicast groups we listen to. "config" reports interfaces, "mlme" reports stations and channel switches. "scan" is
+ * joined so that the end of a scan doesn't go unnoticed once scan results are part of the data model.
+ */
+static const char *nl80211_mcgroups[] = { "config", "mlme", "scan" };
+
+struct netlink_events {
+    struct nl80211_state    nlstate;
+    uint8_t                 queue_id;
+};
+
+/** @brief  Get the MAC address of interface @a ifindex
+ *  @return 0:success, <0:error (e.g. the interface doesn't exist anymore)
+ */
+static int ifindex_to_addr(uint32_t ifindex, mac_address addr)
+{
+    struct ifreq    ifr;
+    int             fd, ret = 0;
+
+    memset(&ifr, 0, sizeof(ifr));
+    if ( ! if_indextoname(ifindex, ifr.ifr_name) )
+        return -ENODEV;
+
+    if ( (fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 )
+        return -errno;
+
+    if ( ioctl(fd, SIOCGIFHWADDR, &ifr) < 0 )
+        ret = -errno;
+    else
+        memcpy(addr, ifr.ifr_hwaddr.sa_data, sizeof(mac_address));
+
+    close(fd);
+    return ret;
+}
+
+static uint8_t iftype_to_role(uint32_t iftype)
+{
+    switch ( iftype ) {
+        case NL80211_IFTYPE_AP:         return IEEE80211_ROLE_AP;
+        case NL80211_IFTYPE_STATION:    return IEEE80211_ROLE_NON_AP_NON_PCP_STA;
+        case NL80211_IFTYPE_P2P_CLIENT: return IEEE80211_ROLE_WIFI_P2P_CLIENT;
+        case NL80211_IFTYPE_P2P_GO:     return IEEE80211_ROLE_WIFI_P2P_GROUP_OWNER;
+        default:                        return 0xff;
+    }
+}
+
+/** @brief  callback to translate one nl80211 notification to a queue message
+ *
+ *  Notifications that don't concern the data model are silently dropped.
+ */
+static int process_event(struct nl_msg *msg, void *arg)
+{
+    struct netlink_events *ev = arg;
+    struct genlmsghdr     *gnlh = nlmsg_data(nlmsg_hdr(msg));
+    struct nlattr         *tb_msg[NL80211_ATTR_MAX + 1];
+    uint8_t                message[3 + RADIO_CHANGE_MSG_LEN];
+    uint8_t                type;
+    uint32_t               index = 0;
+    uint32_t               freq = 0;
+    uint8_t                role = 0;
+    mac_address            if_addr;
+    mac_address            sta_addr;
+
+    nla_parse(tb_msg, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), NULL);
+
+    memset(if_addr,  0, sizeof(if_addr));
+    memset(sta_addr, 0, sizeof(sta_addr));
+
+    switch ( gnlh->cmd ) {
+        case NL80211_CMD_NEW_STATION:
+        case NL80211_CMD_DEL_STATION:
+            if ( ! tb_msg[NL80211_ATTR_IFINDEX] || ! tb_msg[NL80211_ATTR_MAC] )
+                return NL_SKIP;
+            type = gnlh->cmd == NL80211_CMD_NEW_STATION ? PLATFORM_RADIO_CHANGE_STATION_ADDED
+                                                        : PLATFORM_RADIO_CHANGE_STATION_REMOVED;
+            memcpy(sta_addr, nla_data(tb_msg[NL80211_ATTR_MAC]), sizeof(mac_address));
+            if ( ifindex_to_addr(nla_get_u32(tb_msg[NL80211_ATTR_IFINDEX]), if_addr) < 0 )
+                return NL_SKIP;
+            break;
+
+        case NL80211_CMD_CH_SWITCH_NOTIFY:
+            if ( ! tb_msg[NL80211_ATTR_IFINDEX] || ! tb_msg[NL80211_ATTR_WIPHY_FREQ] )
+                return NL_SKIP;
+            type = PLATFORM_RADIO_CHANGE_CHANNEL_SWITCH;
+            freq = nla_get_u32(tb_msg[NL80211_ATTR_WIPHY_FREQ]);
+            if ( ifindex_to_addr(nla_get_u32(tb_msg[NL80211_ATTR_IFINDEX]), if_addr) < 0 )
+                return NL_SKIP;
+            break;
+
+        case NL80211_CMD_NEW_INTERFACE:
+        case NL80211_CMD_DEL_INTERFACE:
+            /* The interface may already be gone, so take its address from the notification itself. */
+            if ( ! tb_msg[NL80211_ATTR_MAC] || ! tb_msg[NL80211_ATTR_WIPHY] )
+                return NL_SKIP;
+            type = gnlh->cmd == NL80211_CMD_NEW_INTERFACE ? PLATFORM_RADIO_CHANGE_INTERFACE_ADDED
+                                                          : PLATFORM_RADIO_CHANGE_INTERFACE_REMOVED;
+            memcpy(if_addr, nla_data(tb_msg[NL80211_ATTR_MAC]), sizeof(mac_address));
+            if ( type == PLATFORM_RADIO_CHANGE_INTERFACE_ADDED ) {
+                index = nla_get_u32(tb_msg[NL80211_ATTR_WIPHY]);
+                if ( tb_msg[NL80211_ATTR_IFTYPE] )
+                    role = iftype_to_role(nla_get_u32(tb_msg[NL80211_ATTR_IFTYPE]));
+            }
+            break;
+
+        default:
+            return NL_SKIP;
+    }
+
+    message[0]  = PLATFORM_QUEUE_EVENT_RADIO_CHANGE;
+    message[1]  = 0x0;
+    message[2]  = RADIO_CHANGE_MSG_LEN;
+    message[3]  = type;
+    message[4]  = (uint8_t)(index >> 24);
+    message[5]  = (uint8_t)(index >> 16);
+    message[6]  = (uint8_t)(index >>  8);
+    message[7]  = (uint8_t)(index);
+    memcpy(&message[8],  if_addr,  sizeof(mac_address));
+    memcpy(&message[14], sta_addr, sizeof(mac_address));
+    message[20] = (uint8_t)(freq >> 8);
+    message[21] = (uint8_t)(freq);
+    message[22] = role;
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *nl80211 events thread* Radio change %u on " MACSTR "\n",
+                                 type, MAC2STR(if_addr));
+
+    if ( 0 == sendMessageToAlQueue(ev->queue_id, message, sizeof(message)) )
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *nl80211 events thread* Error sending message to queue\n");
+
+    return NL_SKIP;
+}
+
+static void *netlink_events_thread(void *arg)
+{
+    struct netlink_events *ev = arg;
+    int                    err;
+
+    while ( 1 ) {
+        /* Blocks until the next batch of notifications. */
+        if ( (err = nl_recvmsgs_default(ev->nlstate.nl_sock)) < 0 ) {
+            /* -NLE_NOMEM means the socket buffer overflowed and notifications were lost. They can't be recovered, so
+             * just report it and go on. */
+            PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] *nl80211 events thread* nl_recvmsgs() failed: %s\n",
+                                          nl_geterror(err));
+            if ( err != -NLE_NOMEM && err != -NLE_AGAIN && err != -NLE_INTR )
+                break;
+        }
+    }
+
+    PLATFORM_PRINTF_DEBUG_INFO("[PLATFORM] *nl80211 events thread* Exiting...\n");
+    netlink_close(&ev->nlstate);
+    free(ev);
+    return NULL;
+}
+
+int netlink_events_start(uint8_t queue_id)
+{
+    struct netlink_events  *ev;
+    pthread_t               thread;
+    unsigned                i;
+    int                     grp;
+
+    ev = zmemalloc(sizeof(*ev));
+    ev->queue_id = queue_id;
+
+    if ( netlink_open(&ev->nlstate) < 0 ) {
+        free(ev);
+        return -1;
+    }
+
+    for ( i = 0; i < sizeof(nl80211_mcgroups) / sizeof(nl80211_mcgroups[0]); i++ ) {
+        if ( (grp = genl_ctrl_resolve_grp(ev->nlstate.nl_sock, "nl80211", nl80211_mcgroups[i])) < 0
+        ||   nl_socket_add_membership(ev->nlstate.nl_sock, grp) < 0 ) {
+            PLATFORM_PRINTF_DEBUG_ERROR("Failed to join nl80211 multicast group '%s'\n", nl80211_mcgroups[i]);
+            goto err;
+        }
+    }
+
+    /* Give room for bursts, e.g. when many stations associate at once. */
+    nl_socket_set_buffer_size(ev->nlstate.nl_sock, 262144, 8192);
+    /* Notifications are not answers to our requests, so they don't have a valid sequence number. */
+    nl_socket_disable_seq_check(ev->nlstate.nl_sock);
+    nl_socket_modify_cb(ev->nlstate.nl_sock, NL_CB_VALID, NL_CB_CUSTOM, process_event, ev);
+
+    if ( pthread_create(&thread, NULL, netlink_events_thread, ev) ) {
+        PLATFORM_PRINTF_DEBUG_ERROR("Failed to create the nl80211 events thread\n");
+        goto err;
+    }
+    pthread_detach(thread);
+    return 0;
+
+ err:
+    netlink_close(&ev->nlstate);
+    free(ev);
+    return -1;
+}
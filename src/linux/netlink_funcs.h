@@ -53,6 +53,17 @@ extern int  phy_lookup(const char *basedir, char *name, mac_address *mac, int *i
  */
 extern int  netlink_collect_local_infos(void);
 
+/** @brief  Start listening to nl80211 notifications
+ *
+ *  Stations, channel switches and interfaces changes are posted to the AL
+ *  queue @a queue_id as PLATFORM_QUEUE_EVENT_RADIO_CHANGE messages.
+ *
+ *  @param  queue_id    AL queue to post the messages to
+ *
+ *  @return 0:success, <0:error
+ */
+extern int  netlink_events_start(uint8_t queue_id);
+
 /** @brief  Open the netlink socket and prepare for commands
  *
  *  @param  out_nlstate Output structure
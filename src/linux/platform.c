@@ -228,6 +228,15 @@ uint32_t PLATFORM_GET_TIMESTAMP(void)
     return diff;
 }
 
+uint32_t PLATFORM_GET_TIMESTAMP_US(void)
+{
+    struct timeval tv_end;
+
+    gettimeofday(&tv_end, NULL);
+
+    return (uint32_t)(tv_end.tv_usec - tv_begin.tv_usec) + (uint32_t)(tv_end.tv_sec - tv_begin.tv_sec) * 1000000;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Platform API: Initialization functions
@@ -17,6 +17,7 @@
  */
 
 #include <platform.h>
+#include <utils.h>
 #include "../platform_alme_server.h"
 #include "platform_alme_server_priv.h"
 #include "../platform_os.h"
@@ -29,6 +30,8 @@
 #include <string.h>     // strerror()
 #include <stdio.h>      // snprintf(), ...
 #include <stdlib.h>     // free(), malloc(), ...
+#include <sys/time.h>   // struct timeval
+#include <time.h>       // clock_gettime()
 #include <unistd.h>     // close(), ...
 
 // Each platform/implementation decides how ALME messages are received by the AL
@@ -67,12 +70,90 @@
 // These global variables and mutex are used to send information from the AL
 // main thread (the one running "start1905AL()") to the ALME TCP server thread
 //
-static pthread_mutex_t tcp_server_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t  tcp_server_cond  = PTHREAD_COND_INITIALIZER;
-static int             tcp_server_flag  = 0;
+// The reply to an ALME REQUEST is made of one or more parts. The AL main thread
+// appends them to the "alme_reply_parts" list and the ALME TCP server thread
+// removes them (in order) and sends them through the socket, until the part
+// marked as 'last' has been sent.
+//
+// At most ALME_REPLY_MAX_PENDING_PARTS parts can be waiting in the list. When
+// the list is full, the AL main thread waits for the ALME TCP server thread to
+// catch up (this way big replies don't need to be held in memory as a whole)
+//
+// An HLE that stops reading must not block the AL main thread, so neither
+// thread waits more than ALME_REPLY_TIMEOUT seconds: the socket has a send
+// timeout and the AL main thread gives up waiting for space in the list. In
+// both cases, the client is considered gone and the rest of the reply is
+// dropped.
+//
+#define ALME_REPLY_MAX_PENDING_PARTS  (4)
+#define ALME_REPLY_TIMEOUT            (5)
+
+struct _almeReplyPart
+{
+    struct _almeReplyPart *next;
+    uint8_t                last;
+    uint16_t               len;
+    uint8_t                data[];
+};
+
+static pthread_mutex_t tcp_server_mutex      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  tcp_server_cond       = PTHREAD_COND_INITIALIZER; // A part was added
+static pthread_cond_t  tcp_server_space_cond = PTHREAD_COND_INITIALIZER; // A part was removed
+
+static struct _almeReplyPart  *alme_reply_parts         = NULL;
+static struct _almeReplyPart **alme_reply_parts_tail    = &alme_reply_parts;
+static unsigned                alme_reply_parts_pending = 0;
+static int                     alme_reply_client_gone   = 0;
+
+// Wait for the next part of the ALME reply and remove it from the list
+//
+static struct _almeReplyPart *_getAlmeReplyPart(void)
+{
+    struct _almeReplyPart *part;
+
+    pthread_mutex_lock(&tcp_server_mutex);
+    while (NULL == alme_reply_parts)
+    {
+        pthread_cond_wait(&tcp_server_cond, &tcp_server_mutex);
+    }
+    part             = alme_reply_parts;
+    alme_reply_parts = part->next;
+    if (NULL == alme_reply_parts)
+    {
+        alme_reply_parts_tail = &alme_reply_parts;
+    }
+    alme_reply_parts_pending--;
+    pthread_cond_signal(&tcp_server_space_cond);
+    pthread_mutex_unlock(&tcp_server_mutex);
 
-static uint8_t  *alme_response;
-static uint16_t  alme_response_len;
+    return part;
+}
+
+// Send 'len' bytes from 'data' through the socket. Returns '0' if there was a
+// problem, '1' otherwise.
+//
+static uint8_t _sendAll(int socketfd, const uint8_t *data, uint16_t len, uint32_t *total_sent)
+{
+    uint16_t sent_len = 0;
+
+    while (sent_len < len)
+    {
+        ssize_t sent;
+
+        sent = send(socketfd, data + sent_len, len - sent_len, MSG_NOSIGNAL);
+
+        if (-1 == sent)
+        {
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* send() failed with errno=%d (%s)\n", errno, strerror(errno));
+            return 0;
+        }
+
+        sent_len    += sent;
+        *total_sent += sent;
+    }
+
+    return 1;
+}
 
 // This variable holds the number of the port number the server will use
 //
@@ -177,6 +258,11 @@ void *almeServerThread(void *p)
         }
         PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* New connection established from HLE.\n");
 
+        if (setsockopt(new_socketfd, SOL_SOCKET, SO_SNDTIMEO, &(struct timeval){ .tv_sec = ALME_REPLY_TIMEOUT }, sizeof(struct timeval)) < 0)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] *ALME server thread* setsockopt() failed with errno=%d (%s)\n", errno, strerror(errno));
+        }
+
         // Receive a message from client
         //
         total_size = 0;
@@ -223,7 +309,7 @@ void *almeServerThread(void *p)
             PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* Sending %d bytes to queue (%02x, %02x, %02x, ...)\n", 3+message_len, queue_message[0], queue_message[1], queue_message[2]);
 
             pthread_mutex_lock(&tcp_server_mutex);
-            tcp_server_flag = 0;
+            alme_reply_client_gone = 0;
             pthread_mutex_unlock(&tcp_server_mutex);
 
             if (0 == sendMessageToAlQueue(((struct almeServerThreadData *)p)->queue_id, queue_message, 3+message_len))
@@ -233,45 +319,38 @@ void *almeServerThread(void *p)
             else
             {
                 uint32_t total_sent;
+                uint8_t  last;
 
-                // Wait for response
+                // Wait for the response parts and send them to the HLE as
+                // soon as they are available
                 //
                 PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* Waiting for the AL response...\n");
 
-                pthread_mutex_lock(&tcp_server_mutex);
-                while (0 == tcp_server_flag)
+                total_sent = 0;
+                last       = 0;
+                while (0 == last)
                 {
-                    pthread_cond_wait(&tcp_server_cond, &tcp_server_mutex);
-                }
-                pthread_mutex_unlock(&tcp_server_mutex);
+                    struct _almeReplyPart *part;
 
-                // Once the mutex is unlocked it means the ALME response is
-                // contained in global var "alme_response" (which is
-                // "alme_response_len" bytes long)
-                //
-                PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* Sending ALME reply to HLE...\n");
+                    part = _getAlmeReplyPart();
+                    last = part->last;
 
-                total_sent = 0;
-                if (NULL != alme_response && 0 != alme_response_len)
-                {
-                    do
+                    if (0 != part->len && 0 == alme_reply_client_gone)
                     {
-                        ssize_t sent;
+                        PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* Sending ALME reply to HLE...\n");
 
-                        sent = send(new_socketfd, alme_response, alme_response_len, MSG_NOSIGNAL);
-
-                        if (-1 == sent)
+                        if (0 == _sendAll(new_socketfd, part->data, part->len, &total_sent))
                         {
-                            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* send() failed with errno=%d (%s)\n", errno, strerror(errno));
-                            break;
+                            // Tell the AL main thread not to bother sending
+                            // any more parts of this reply
+                            //
+                            pthread_mutex_lock(&tcp_server_mutex);
+                            alme_reply_client_gone = 1;
+                            pthread_cond_signal(&tcp_server_space_cond);
+                            pthread_mutex_unlock(&tcp_server_mutex);
                         }
-
-                        total_sent += sent;
-                    } while (total_sent < alme_response_len);
-
-                    free(alme_response);
-                    alme_response     = NULL;
-                    alme_response_len = 0;
+                    }
+                    free(part);
                 }
                 PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *ALME server thread* ALME reply sent (total %d bytes)\n", total_sent);
             }
@@ -298,11 +377,18 @@ void almeServerPortSet(int port_number)
 ////////////////////////////////////////////////////////////////////////////////
 
 uint8_t PLATFORM_SEND_ALME_REPLY(uint8_t alme_client_id, uint8_t *alme_message, uint16_t alme_message_len)
+{
+    return PLATFORM_SEND_ALME_REPLY_PART(alme_client_id, alme_message, alme_message_len, 1);
+}
+
+uint8_t PLATFORM_SEND_ALME_REPLY_PART(uint8_t alme_client_id, uint8_t *alme_message, uint16_t alme_message_len, uint8_t last)
 {
     int i, first_time;
     char aux1[200];
     char aux2[10];
 
+    uint8_t ret = 1;
+
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] Payload of ALME bit stream to send:\n");
     aux1[0]    = 0x0;
     aux2[0]    = 0x0;
@@ -342,32 +428,55 @@ uint8_t PLATFORM_SEND_ALME_REPLY(uint8_t alme_client_id, uint8_t *alme_message,
             // Send the ALME RESPONSE/CONFIRMATION through the same socket where
             // the REQUEST was originally received
             //
+            struct _almeReplyPart *part;
+            struct timespec        deadline;
+
             if (0 == alme_message_len || NULL == alme_message)
             {
                 PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Refuse to send an *invalid* ALME reply\n");
-                alme_response     = NULL;
-                alme_response_len = 0;
+                alme_message_len = 0;
+                ret              = 0;
             }
-            else
+
+            part       = (struct _almeReplyPart *)memalloc(sizeof(struct _almeReplyPart) + alme_message_len);
+            part->next = NULL;
+            part->last = last;
+            part->len  = alme_message_len;
+            if (0 != alme_message_len)
             {
-                alme_response = (uint8_t *)malloc(alme_message_len);
-                if (NULL == alme_response)
-                {
-                    PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Cannot allocate memory for the ALME RESPONSE/CONFIRMATION message\n");
+                memcpy(part->data, alme_message, alme_message_len);
+            }
 
-                    alme_response     = NULL;
-                    alme_response_len = 0;
-                }
-                else
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += ALME_REPLY_TIMEOUT;
+
+            pthread_mutex_lock(&tcp_server_mutex);
+            while (alme_reply_parts_pending >= ALME_REPLY_MAX_PENDING_PARTS && 0 == alme_reply_client_gone)
+            {
+                if (ETIMEDOUT == pthread_cond_timedwait(&tcp_server_space_cond, &tcp_server_mutex, &deadline))
                 {
-                    memcpy(alme_response, alme_message, alme_message_len);
-                    alme_response_len = alme_message_len;
+                    PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] HLE is not reading the ALME reply. Dropping it.\n");
+                    alme_reply_client_gone = 1;
                 }
             }
-
-            pthread_mutex_lock(&tcp_server_mutex);
-            tcp_server_flag = 1;
-            pthread_cond_signal(&tcp_server_cond);
+            if (alme_reply_client_gone)
+            {
+                ret = 0;
+            }
+            if (alme_reply_client_gone && 0 == last)
+            {
+                // Nobody will read it. Only the last part must still be
+                // queued, so that the server thread knows the reply is done.
+                //
+                free(part);
+            }
+            else
+            {
+                *alme_reply_parts_tail = part;
+                alme_reply_parts_tail  = &part->next;
+                alme_reply_parts_pending++;
+                pthread_cond_signal(&tcp_server_cond);
+            }
             pthread_mutex_unlock(&tcp_server_mutex);
 
             break;
@@ -386,5 +495,5 @@ uint8_t PLATFORM_SEND_ALME_REPLY(uint8_t alme_client_id, uint8_t *alme_message,
         }
     }
 
-    return 1;
+    return ret;
 }
@@ -0,0 +1,210 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <platform.h>
+#include <utils.h>
+
+#include "platform_capture_priv.h"
+
+#include <errno.h>      // errno
+#include <pthread.h>    // pthread_mutex_*()
+#include <stdio.h>      // fopen(), fwrite(), rename()
+#include <stdlib.h>     // free()
+#include <string.h>     // strdup(), strerror()
+#include <sys/time.h>   // gettimeofday()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+// pcap file format (see "pcap-savefile(5)"). All values are written in host
+// byte order: readers detect it from the magic number.
+//
+#define PCAP_MAGIC           (0xa1b2c3d4)
+#define PCAP_VERSION_MAJOR   (2)
+#define PCAP_VERSION_MINOR   (4)
+#define PCAP_LINKTYPE_ETHER  (1)
+
+struct _pcapFileHeader
+{
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t  thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct _pcapRecordHeader
+{
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+// Frames are captured from the receive threads of all interfaces and from the
+// AL thread, so everything below is protected by 'capture_mutex'.
+//
+static pthread_mutex_t  capture_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char            *capture_path  = NULL;
+static FILE            *capture_file  = NULL;
+static size_t           capture_size  = 0;
+
+// Shift "<path>.1" ... "<path>.(CAPTURE_MAX_FILES-2)" one position up and move
+// "<path>" to "<path>.1". The oldest file is overwritten.
+//
+static void _rotate(void)
+{
+    char from[256];
+    char to[256];
+    int  i;
+
+    for (i = CAPTURE_MAX_FILES - 1; i > 0; i--)
+    {
+        if (1 == i)
+        {
+            snprintf(from, sizeof(from), "%s", capture_path);
+        }
+        else
+        {
+            snprintf(from, sizeof(from), "%s.%d", capture_path, i - 1);
+        }
+        snprintf(to, sizeof(to), "%s.%d", capture_path, i);
+
+        // Missing files (the first rotations) are not an error
+        //
+        rename(from, to);
+    }
+}
+
+// Open a new capture file and write its header. Returns "0" on error.
+//
+static uint8_t _open(void)
+{
+    struct _pcapFileHeader header;
+
+    capture_file = fopen(capture_path, "w");
+    if (NULL == capture_file)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not open capture file %s: %s\n", capture_path, strerror(errno));
+        return 0;
+    }
+
+    header.magic         = PCAP_MAGIC;
+    header.version_major = PCAP_VERSION_MAJOR;
+    header.version_minor = PCAP_VERSION_MINOR;
+    header.thiszone      = 0;
+    header.sigfigs       = 0;
+    header.snaplen       = MAX_NETWORK_SEGMENT_SIZE;
+    header.linktype      = PCAP_LINKTYPE_ETHER;
+
+    if (1 != fwrite(&header, sizeof(header), 1, capture_file))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not write to capture file %s\n", capture_path);
+        fclose(capture_file);
+        capture_file = NULL;
+        return 0;
+    }
+    capture_size = sizeof(header);
+
+    return 1;
+}
+
+// Give up capturing (after an I/O error, so that the log is not flooded)
+//
+static void _disable(void)
+{
+    if (NULL != capture_file)
+    {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+    free(capture_path);
+    capture_path = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Internal API: to be used by other platform-specific files (functions
+// declaration is found in "./platform_capture_priv.h")
+////////////////////////////////////////////////////////////////////////////////
+
+void capturePathSet(const char *path)
+{
+    pthread_mutex_lock(&capture_mutex);
+
+    _disable();
+    if (NULL != path)
+    {
+        capture_path = strdup(path);
+    }
+
+    pthread_mutex_unlock(&capture_mutex);
+}
+
+void captureFrame(const uint8_t *frame, size_t frame_len)
+{
+    struct _pcapRecordHeader record;
+    struct timeval           tv;
+
+    // Unlocked check: the path is only set once, at startup
+    //
+    if (NULL == capture_path)
+    {
+        return;
+    }
+
+    gettimeofday(&tv, NULL);
+
+    record.ts_sec   = tv.tv_sec;
+    record.ts_usec  = tv.tv_usec;
+    record.incl_len = frame_len > MAX_NETWORK_SEGMENT_SIZE ? MAX_NETWORK_SEGMENT_SIZE : frame_len;
+    record.orig_len = frame_len;
+
+    pthread_mutex_lock(&capture_mutex);
+
+    if (NULL != capture_path && NULL != capture_file &&
+        capture_size + sizeof(record) + record.incl_len > CAPTURE_MAX_FILE_SIZE)
+    {
+        fclose(capture_file);
+        capture_file = NULL;
+        _rotate();
+    }
+
+    if (NULL != capture_path && (NULL != capture_file || _open()))
+    {
+        if (1 != fwrite(&record, sizeof(record), 1, capture_file) ||
+            1 != fwrite(frame, record.incl_len, 1, capture_file)  ||
+            0 != fflush(capture_file))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not write to capture file %s. Capture stopped.\n", capture_path);
+            _disable();
+        }
+        else
+        {
+            capture_size += sizeof(record) + record.incl_len;
+        }
+    }
+    else if (NULL != capture_path)
+    {
+        _disable();
+    }
+
+    pthread_mutex_unlock(&capture_mutex);
+}
@@ -0,0 +1,51 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _PLATFORM_CAPTURE_PRIV_H_
+#define _PLATFORM_CAPTURE_PRIV_H_
+
+#include <platform.h>
+
+#include <stddef.h> // size_t
+
+// The AL entity can write every 1905 and LLDP frame it receives (see
+// "recvLoopThread()") and transmits (see "PLATFORM_SEND_RAW_PACKET()") to a
+// capture file in pcap format (link type "Ethernet"), which can be opened with
+// the usual tools or replayed with "benchmarks/pcap_replay.c".
+//
+// The capture rotates: when the file reaches CAPTURE_MAX_FILE_SIZE bytes it is
+// renamed to "<path>.1" (the previous "<path>.1" to "<path>.2", and so on) and
+// a new one is started. At most CAPTURE_MAX_FILES files are kept.
+//
+#define CAPTURE_MAX_FILE_SIZE  (1024 * 1024)
+#define CAPTURE_MAX_FILES      (4)
+
+// Set the file where frames are captured.
+//
+// If this function is never called (or called with NULL), the capture is
+// disabled and "captureFrame()" does nothing.
+//
+void capturePathSet(const char *path);
+
+// Append a frame to the capture. 'frame' starts with the Ethernet header.
+//
+// This function can be called from any thread.
+//
+void captureFrame(const uint8_t *frame, size_t frame_len);
+
+#endif
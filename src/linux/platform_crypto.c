@@ -16,14 +16,24 @@
  *  limitations under the License.
  */
 
+#define _GNU_SOURCE       // SCHED_IDLE
 #include <platform.h>
 
+#include <pthread.h>      // pthread_*()
+#include <sched.h>        // SCHED_IDLE
+#include <stdbool.h>      // bool
+#include <stdlib.h>       // malloc(), free()
+#include <string.h>       // memset()
+
 #include <openssl/dh.h>   // Diffie Hellman stuff
 #include <openssl/bn.h>   // "Big numbers" stuff
 #include <openssl/evp.h>  // SHA digest and AES stuff
 #include <openssl/hmac.h> // HMAC stuff
 
 #include "../platform_crypto.h"
+#include "../platform_os.h"
+#include "platform_crypto_priv.h"
+#include "platform_os_priv.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private data and functions
@@ -87,6 +97,286 @@ static int DH_set0_key(DH *dh, BIGNUM *pub_key, BIGNUM *priv_key)
 
 #endif
 
+// The group parameters are converted to BIGNUM format only once (the first
+// time they are needed) and then copied into each new DH structure.
+//
+static DH             *dh1536_params      = NULL;
+static pthread_once_t  dh1536_params_once = PTHREAD_ONCE_INIT;
+
+static void _dhParamsInit(void)
+{
+    DH     *dh;
+    BIGNUM *p;
+    BIGNUM *g;
+
+    dh = DH_new();
+    p  = BN_bin2bn(dh1536_p, sizeof(dh1536_p), NULL);
+    g  = BN_bin2bn(dh1536_g, sizeof(dh1536_g), NULL);
+
+    if (NULL == dh || NULL == p || NULL == g || 0 == DH_set0_pqg(dh, p, NULL, g))
+    {
+        BN_free(p);
+        BN_free(g);
+        DH_free(dh);
+        return;
+    }
+
+    dh1536_params = dh;
+}
+
+// Return a new DH structure with the "1536-bit MODP" group parameters already
+// set (and no keys), or NULL if there was a problem.
+//
+static DH *_dhNew(void)
+{
+    pthread_once(&dh1536_params_once, _dhParamsInit);
+
+    if (NULL == dh1536_params)
+    {
+        return NULL;
+    }
+    return DHparams_dup(dh1536_params);
+}
+
+// Generate a new key pair. Same arguments and return value as
+// "PLATFORM_GENERATE_DH_KEY_PAIR()".
+//
+static uint8_t _dhGenerateKeyPair(uint8_t **priv, uint16_t *priv_len, uint8_t **pub, uint16_t *pub_len)
+{
+    DH *dh;
+    const BIGNUM *priv_key = NULL;
+    const BIGNUM *pub_key = NULL;
+
+    if (NULL == (dh = _dhNew()))
+    {
+        return 0;
+    }
+
+    // Obtain key pair
+    //
+    if (0 == DH_generate_key(dh))
+    {
+        DH_free(dh);
+        return 0;
+    }
+
+    DH_get0_key(dh, &pub_key, &priv_key);
+    *priv_len = BN_num_bytes(priv_key);
+    *priv     = (uint8_t *)malloc(*priv_len);
+    BN_bn2bin(priv_key, *priv);
+
+    *pub_len = BN_num_bytes(pub_key);
+    *pub     = (uint8_t *)malloc(*pub_len);
+    BN_bn2bin(pub_key, *pub);
+
+    DH_free(dh);
+      // NOTE: This internally frees the group parameters and the keys, thus no
+      // need for us to do anything else.
+
+    return 1;
+}
+
+// Pool of key pairs generated in advance by a background thread (see
+// "PLATFORM_PREGENERATE_DH_KEY_PAIRS()").
+//
+// Generating a key pair is by far the most expensive step of building a WSC
+// message, so when many agents want to be configured at the same time (ex:
+// after a power outage) the registrar can answer the first
+// DH_KEY_POOL_SIZE of them without waiting for it.
+//
+#define DH_KEY_POOL_SIZE (8)
+
+struct _dhKeyPair
+{
+    uint8_t  *priv;
+    uint16_t  priv_len;
+    uint8_t  *pub;
+    uint16_t  pub_len;
+};
+
+static struct _dhKeyPool
+{
+    pthread_mutex_t    mutex;
+    pthread_cond_t     not_full;   // Signaled when a key pair is taken
+    bool               started;    // The background thread is running
+    unsigned           nr;         // Number of valid entries in 'keys'
+    struct _dhKeyPair  keys[DH_KEY_POOL_SIZE];
+
+} dh_key_pool = { .mutex = PTHREAD_MUTEX_INITIALIZER, .not_full = PTHREAD_COND_INITIALIZER };
+
+static void *_dhKeyPoolThread(void *p)
+{
+    struct _dhKeyPair  key;
+    struct sched_param param = { .sched_priority = 0 };
+
+    (void)p;
+
+    // Only use CPU time nobody else wants: on a single core device, refilling
+    // the pool while a burst of M1 messages is being answered would just slow
+    // the answers down.
+    //
+    if (0 != pthread_setschedparam(pthread_self(), SCHED_IDLE, &param))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] Could not lower the priority of the DH key pool thread\n");
+    }
+
+    while (1)
+    {
+        pthread_mutex_lock(&dh_key_pool.mutex);
+        while (DH_KEY_POOL_SIZE == dh_key_pool.nr)
+        {
+            pthread_cond_wait(&dh_key_pool.not_full, &dh_key_pool.mutex);
+        }
+        pthread_mutex_unlock(&dh_key_pool.mutex);
+
+        // This thread is the only one that adds entries, so there is still
+        // room when we are done.
+        //
+        if (0 == _dhGenerateKeyPair(&key.priv, &key.priv_len, &key.pub, &key.pub_len))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not pre-generate DH key pair. Stopping DH key pool.\n");
+
+            pthread_mutex_lock(&dh_key_pool.mutex);
+            dh_key_pool.started = false;
+            pthread_mutex_unlock(&dh_key_pool.mutex);
+            return NULL;
+        }
+
+        pthread_mutex_lock(&dh_key_pool.mutex);
+        dh_key_pool.keys[dh_key_pool.nr++] = key;
+        pthread_mutex_unlock(&dh_key_pool.mutex);
+    }
+
+    return NULL;
+}
+
+// Take a key pair out of the pool. Returns "0" if the pool is empty.
+//
+static uint8_t _dhKeyPoolGet(uint8_t **priv, uint16_t *priv_len, uint8_t **pub, uint16_t *pub_len)
+{
+    struct _dhKeyPair *key;
+    uint8_t            ret = 0;
+
+    pthread_mutex_lock(&dh_key_pool.mutex);
+    if (dh_key_pool.nr > 0)
+    {
+        key       = &dh_key_pool.keys[--dh_key_pool.nr];
+        *priv     = key->priv;
+        *priv_len = key->priv_len;
+        *pub      = key->pub;
+        *pub_len  = key->pub_len;
+        memset(key, 0, sizeof(*key));
+
+        pthread_cond_signal(&dh_key_pool.not_full);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&dh_key_pool.mutex);
+
+    return ret;
+}
+
+// Worker threads for "PLATFORM_SUBMIT_CRYPTO_JOB()"
+//
+// Two workers are enough to keep the AL entity responsive (which is what they
+// are for) while still making use of a second core when there is one.
+//
+#define CRYPTO_WORKERS_NR (2)
+
+static struct _cryptoWorkers
+{
+    pthread_mutex_t  mutex;
+    pthread_cond_t   not_empty;    // Signaled when a job is submitted
+    bool             started;
+    uint8_t          queue_id;     // Where to send the "job done" messages
+    dlist_head       jobs;         // Submitted jobs not yet picked by a worker
+
+} crypto_workers = { .mutex = PTHREAD_MUTEX_INITIALIZER, .not_empty = PTHREAD_COND_INITIALIZER };
+
+static void *_cryptoWorkerThread(void *p)
+{
+    struct cryptoJob *job;
+    uint8_t           message[3 + sizeof(struct cryptoJob *)];
+
+    (void)p;
+
+    while (1)
+    {
+        pthread_mutex_lock(&crypto_workers.mutex);
+        while (dlist_empty(&crypto_workers.jobs))
+        {
+            pthread_cond_wait(&crypto_workers.not_empty, &crypto_workers.mutex);
+        }
+        job = container_of(dlist_get_first(&crypto_workers.jobs), struct cryptoJob, l);
+        dlist_remove(&job->l);
+        pthread_mutex_unlock(&crypto_workers.mutex);
+
+        job->run(job);
+
+        message[0] = PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE;
+        message[1] = 0x0;
+        message[2] = sizeof(struct cryptoJob *);
+        memcpy(&message[3], &job, sizeof(struct cryptoJob *));
+
+        if (0 == sendMessageToAlQueue(crypto_workers.queue_id, message, sizeof(message)))
+        {
+            // The job (and whatever it holds) is lost, but there is nothing
+            // else we can do with it from here.
+            //
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Crypto worker* Error sending message to queue\n");
+        }
+    }
+
+    return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Internal API: to be used by other platform-specific files (functions
+// declaration is found in "./platform_crypto_priv.h")
+////////////////////////////////////////////////////////////////////////////////
+
+uint8_t cryptoWorkersStart(uint8_t queue_id)
+{
+    pthread_t      thread;
+    pthread_attr_t attr;
+    unsigned       i;
+    uint8_t        ret = 1;
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    // See "PLATFORM_PREGENERATE_DH_KEY_PAIRS()"
+    //
+    PLATFORM_PRINTF_DEBUG_INFO("[PLATFORM] Crypto jobs cannot be run in parallel with this OpenSSL version\n");
+    return 0;
+#endif
+
+    pthread_mutex_lock(&crypto_workers.mutex);
+    if (!crypto_workers.started)
+    {
+        dlist_head_init(&crypto_workers.jobs);
+        crypto_workers.queue_id = queue_id;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        for (i = 0; i < CRYPTO_WORKERS_NR; i++)
+        {
+            if (0 != pthread_create(&thread, &attr, _cryptoWorkerThread, NULL))
+            {
+                PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not create crypto worker thread\n");
+                break;
+            }
+            // Jobs can be accepted as soon as one worker runs
+            //
+            crypto_workers.started = true;
+        }
+        pthread_attr_destroy(&attr);
+
+        ret = crypto_workers.started ? 1 : 0;
+    }
+    pthread_mutex_unlock(&crypto_workers.mutex);
+
+    return ret;
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Platform API: Interface related functions to be used by platform-independent
@@ -121,12 +411,43 @@ uint8_t PLATFORM_GET_RANDOM_BYTES(uint8_t *p, uint16_t len)
     }
 }
 
-uint8_t PLATFORM_GENERATE_DH_KEY_PAIR(uint8_t **priv, uint16_t *priv_len, uint8_t **pub, uint16_t *pub_len)
+uint8_t PLATFORM_PREGENERATE_DH_KEY_PAIRS(void)
 {
-    DH *dh;
-    const BIGNUM *priv_key = NULL;
-    const BIGNUM *pub_key = NULL;
+    pthread_t      thread;
+    pthread_attr_t attr;
+    uint8_t        ret = 1;
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    // Older versions of OpenSSL can only be used from several threads if the
+    // application installs locking callbacks, which we don't.
+    //
+    PLATFORM_PRINTF_DEBUG_INFO("[PLATFORM] DH key pairs cannot be pre-generated with this OpenSSL version\n");
+    return 0;
+#endif
+
+    pthread_mutex_lock(&dh_key_pool.mutex);
+    if (!dh_key_pool.started)
+    {
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (0 != pthread_create(&thread, &attr, _dhKeyPoolThread, NULL))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not create DH key pool thread\n");
+            ret = 0;
+        }
+        else
+        {
+            dh_key_pool.started = true;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_mutex_unlock(&dh_key_pool.mutex);
 
+    return ret;
+}
+
+uint8_t PLATFORM_GENERATE_DH_KEY_PAIR(uint8_t **priv, uint16_t *priv_len, uint8_t **pub, uint16_t *pub_len)
+{
     if (
          NULL == priv     ||
          NULL == priv_len ||
@@ -137,43 +458,15 @@ uint8_t PLATFORM_GENERATE_DH_KEY_PAIR(uint8_t **priv, uint16_t *priv_len, uint8_
         return 0;
     }
 
-    if (NULL == (dh = DH_new()))
-    {
-        return 0;
-    }
-
-    // Convert binary to BIGNUM format
-    //
-    if (0 == DH_set0_pqg(dh,
-                         BN_bin2bn(dh1536_p,sizeof(dh1536_p),NULL),
-                         NULL, BN_bin2bn(dh1536_g,sizeof(dh1536_g),NULL)))
-    {
-        DH_free(dh);
-        return 0;
-    }
-
-    // Obtain key pair
+    // Use a pre-generated key pair if there is one. Otherwise (pool not
+    // started or exhausted) generate it now.
     //
-    if (0 == DH_generate_key(dh))
+    if (1 == _dhKeyPoolGet(priv, priv_len, pub, pub_len))
     {
-        DH_free(dh);
-        return 0;
+        return 1;
     }
 
-    DH_get0_key(dh, &pub_key, &priv_key);
-    *priv_len = BN_num_bytes(priv_key);
-    *priv     = (uint8_t *)malloc(*priv_len);
-    BN_bn2bin(priv_key, *priv);
-
-    *pub_len = BN_num_bytes(pub_key);
-    *pub     = (uint8_t *)malloc(*pub_len);
-    BN_bn2bin(pub_key, *pub);
-
-    DH_free(dh);
-      // NOTE: This internally frees "dh->p" and "dh->q", thus no need for us
-      // to do anything else.
-
-    return 1;
+    return _dhGenerateKeyPair(priv, priv_len, pub, pub_len);
 }
 
 uint8_t PLATFORM_COMPUTE_DH_SHARED_SECRET(uint8_t **shared_secret, uint16_t *shared_secret_len,
@@ -198,22 +491,11 @@ uint8_t PLATFORM_COMPUTE_DH_SHARED_SECRET(uint8_t **shared_secret, uint16_t *sha
         return 0;
     }
 
-    if (NULL == (dh = DH_new()))
+    if (NULL == (dh = _dhNew()))
     {
         return 0;
     }
 
-    // Convert binary to BIGNUM format
-    //
-    if (0 == DH_set0_pqg(dh,
-                         BN_bin2bn(dh1536_p,sizeof(dh1536_p),NULL),
-                         NULL,
-                         BN_bin2bn(dh1536_g,sizeof(dh1536_g),NULL)))
-    {
-        DH_free(dh);
-        return 0;
-    }
-
     if (NULL == (pub_key = BN_bin2bn(remote_pub, remote_pub_len, NULL)))
     {
         DH_free(dh);
@@ -424,3 +706,24 @@ uint8_t PLATFORM_AES_DECRYPT(const uint8_t *key, const uint8_t *iv, uint8_t *dat
 
     return 1;
 }
+
+uint8_t PLATFORM_SUBMIT_CRYPTO_JOB(struct cryptoJob *job)
+{
+    uint8_t ret = 0;
+
+    if (NULL == job || NULL == job->run || NULL == job->done)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&crypto_workers.mutex);
+    if (crypto_workers.started)
+    {
+        dlist_add_tail(&crypto_workers.jobs, &job->l);
+        pthread_cond_signal(&crypto_workers.not_empty);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&crypto_workers.mutex);
+
+    return ret;
+}
@@ -0,0 +1,38 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _PLATFORM_CRYPTO_PRIV_H_
+#define _PLATFORM_CRYPTO_PRIV_H_
+
+#include <platform.h>
+
+// When the AL calls "PLATFORM_REGISTER_QUEUE_EVENT()" with 'event_type' set to
+// "PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE", this function must be called to
+// create the threads that run the jobs submitted with
+// "PLATFORM_SUBMIT_CRYPTO_JOB()".
+//
+// Once a job has been run, a message is sent to the queue whose ID is
+// 'queue_id'.
+//
+// Calling it more than once has no effect.
+//
+// Return "0" if there was a problem, "1" otherwise
+//
+uint8_t cryptoWorkersStart(uint8_t queue_id);
+
+#endif
@@ -21,6 +21,7 @@
 #include "platform_interfaces_priv.h"
 #include "../platform_os.h"
 #include "platform_os_priv.h"
+#include "platform_capture_priv.h"
 
 #ifdef OPENWRT
 #include "platform_interfaces_openwrt_priv.h"
@@ -1435,6 +1436,8 @@ uint8_t PLATFORM_SEND_RAW_PACKET(const char *interface_name, const uint8_t *dst_
     }
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] Data sent!\n");
 
+    captureFrame(buffer, sizeof(*eh) + payload_len);
+
     close(s);
     return 1;
 }
@@ -17,6 +17,7 @@
  */
 
 #include <platform.h>
+#include <utils.h>
 #include "platform_interfaces_priv.h"           // registerInterfaceStub
 #include "platform_interfaces_ghnspirit_priv.h"
 
@@ -27,6 +28,8 @@
 #include <pthread.h> // mutex functions
 #include <unistd.h>  // sleep()
 
+#include <dlist.h>
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private data and functions
@@ -105,6 +108,275 @@ int _extractMacAndPassword(char *ghnspirit_extended_params, char **ghn_mac_addre
     return 1;
 }
 
+// Running the LCMP tool is slow (it has to talk to the modem), and the AL asks
+// for the same parameters over and over again (ex: each time a topology or
+// link metrics query is received). Because of this, the output of each "GET"
+// command is kept in memory and reused:
+//
+//   - Each type of query has its own "time to live": device information
+//     barely changes (LCMP_INFO_TTL_MS), metrics do (LCMP_METRICS_TTL_MS).
+//
+//   - When a cached output is older than its TTL it is still returned, but the
+//     "LCMP refresh" thread is asked to run the tool again in the background.
+//     Callers do not wait for it.
+//
+//   - The first time a command is used there is nothing to return yet. The
+//     caller gets no data (as if the tool had failed) and the tool is run in
+//     the background, before any other pending refresh, so that the next call
+//     finds it.
+//
+// This way the AL thread never waits for the tool.
+//
+// "SET" commands (ex: start the pairing process) are never cached. They are
+// run in their own thread, which then asks for a refresh of all cached outputs
+// of the same interface, so that the change is seen as soon as possible.
+//
+#define LCMP_INFO_TTL_MS     (30000)
+#define LCMP_METRICS_TTL_MS  (5000)
+
+struct _lcmpCacheEntry
+{
+    dlist_item  l;
+
+    char       *interface_name;
+    char       *command;
+    uint32_t    ttl;              // In milliseconds
+
+    char       *output;           // NULL until the tool has run once
+    size_t      output_len;
+    uint32_t    timestamp;        // When the tool was last run
+    uint8_t     fetched;          // Set once the tool has run (even if it
+                                  // failed)
+
+    uint8_t     refresh_pending;  // Set when the "LCMP refresh" thread must
+                                  // run the tool again
+};
+
+// 'lcmp_cache_mutex' protects the cache itself. 'lcmp_mutex' is only held
+// while the tool is running.
+//
+static pthread_mutex_t lcmp_cache_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  lcmp_pending_cond  = PTHREAD_COND_INITIALIZER; // An entry must be refreshed
+static uint8_t         lcmp_thread_running = 0;
+
+static DEFINE_DLIST_HEAD(lcmp_cache);
+
+// Run 'command' and return everything it writes to its standard output (the
+// caller is responsible for freeing it), or NULL if the tool could not be
+// executed.
+//
+static char *_runLcmpTool(const char *command, size_t *output_len)
+{
+    FILE   *pipe;
+    char   *output = NULL;
+    size_t  size   = 0;
+    size_t  len    = 0;
+    size_t  n;
+
+    pthread_mutex_lock(&lcmp_mutex);
+    pipe = popen(command, "r");
+
+    if (!pipe)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] popen() returned with errno=%d (%s)\n", errno, strerror(errno));
+        pthread_mutex_unlock(&lcmp_mutex);
+        return NULL;
+    }
+
+    do
+    {
+        if (len == size)
+        {
+            size   = 0 == size ? 1024 : 2 * size;
+            output = (char *)memrealloc(output, size);
+        }
+        n    = fread(output + len, 1, size - len, pipe);
+        len += n;
+    }
+    while (n > 0);
+
+    pclose(pipe);
+    pthread_mutex_unlock(&lcmp_mutex);
+
+    *output_len = len;
+    return output;
+}
+
+// Thread that runs the LCMP tool for all entries with 'refresh_pending' set
+// (those which have no output yet go first)
+//
+static void *_lcmpRefreshThread(void *p)
+{
+    struct _lcmpCacheEntry *e;
+    struct _lcmpCacheEntry *pending;
+    char                   *output;
+    size_t                  output_len = 0;
+
+    pthread_mutex_lock(&lcmp_cache_mutex);
+
+    while (1)
+    {
+        pending = NULL;
+        dlist_for_each(e, lcmp_cache, l)
+        {
+            if (e->refresh_pending && (NULL == pending || NULL == e->output))
+            {
+                pending = e;
+                if (NULL == e->output)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (NULL == pending)
+        {
+            pthread_cond_wait(&lcmp_pending_cond, &lcmp_cache_mutex);
+            continue;
+        }
+
+        // Entries are never removed and their 'command' never changes, so it
+        // can be used without holding the lock
+        //
+        pthread_mutex_unlock(&lcmp_cache_mutex);
+        output = _runLcmpTool(pending->command, &output_len);
+        pthread_mutex_lock(&lcmp_cache_mutex);
+
+        // If the tool failed, keep the previous output (if any). The timestamp
+        // is updated anyway so that the tool is not run again right away.
+        //
+        if (NULL != output)
+        {
+            free(pending->output);
+            pending->output     = output;
+            pending->output_len = output_len;
+        }
+        pending->timestamp       = PLATFORM_GET_TIMESTAMP();
+        pending->fetched         = 1;
+        pending->refresh_pending = 0;
+    }
+
+    return NULL;
+}
+
+// Return a stream to read the output of the LCMP tool when running 'command'
+// (which queries interface 'interface_name'), served from the cache as
+// explained above. 'ttl' is the time (in milliseconds) the output is considered
+// fresh.
+//
+// Once done, the caller must "fclose()" the stream and "free()" '*output' (the
+// memory buffer the stream reads from).
+//
+// Returns NULL if there is no output available (yet). This function never waits
+// for the tool.
+//
+static FILE *_lcmpQuery(const char *interface_name, const char *command, uint32_t ttl, char **output)
+{
+    struct _lcmpCacheEntry *e;
+    struct _lcmpCacheEntry *entry = NULL;
+    size_t                  output_len = 0;
+    uint8_t                 first_time;
+    FILE                   *f;
+
+    *output = NULL;
+
+    pthread_mutex_lock(&lcmp_cache_mutex);
+
+    if (0 == lcmp_thread_running)
+    {
+        pthread_t thread;
+
+        if (0 != pthread_create(&thread, NULL, _lcmpRefreshThread, NULL))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not create the LCMP refresh thread\n");
+            pthread_mutex_unlock(&lcmp_cache_mutex);
+            return NULL;
+        }
+        pthread_detach(thread);
+        lcmp_thread_running = 1;
+    }
+
+    dlist_for_each(e, lcmp_cache, l)
+    {
+        if (0 == strcmp(e->command, command))
+        {
+            entry = e;
+            break;
+        }
+    }
+
+    if (NULL == entry)
+    {
+        entry = (struct _lcmpCacheEntry *)zmemalloc(sizeof(struct _lcmpCacheEntry));
+        entry->interface_name = strdup(interface_name);
+        entry->command        = strdup(command);
+        entry->ttl            = ttl;
+        dlist_add_tail(&lcmp_cache, &entry->l);
+    }
+
+    if (!entry->fetched || PLATFORM_GET_TIMESTAMP() - entry->timestamp >= entry->ttl)
+    {
+        if (0 == entry->refresh_pending)
+        {
+            entry->refresh_pending = 1;
+            pthread_cond_signal(&lcmp_pending_cond);
+        }
+    }
+
+    if (NULL != entry->output && 0 != entry->output_len)
+    {
+        output_len = entry->output_len;
+        *output    = (char *)memalloc(output_len);
+        memcpy(*output, entry->output, output_len);
+    }
+    first_time = !entry->fetched;
+
+    pthread_mutex_unlock(&lcmp_cache_mutex);
+
+    if (NULL == *output)
+    {
+        if (first_time)
+        {
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] LCMP tool output not available yet (it is being obtained in the background)\n");
+        }
+        else
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] No output from the LCMP tool\n");
+        }
+        return NULL;
+    }
+
+    f = fmemopen(*output, output_len, "r");
+    if (NULL == f)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] fmemopen() returned with errno=%d (%s)\n", errno, strerror(errno));
+        free(*output);
+        *output = NULL;
+    }
+
+    return f;
+}
+
+// Ask for a refresh of all cached outputs of interface 'interface_name'
+//
+static void _lcmpRefreshInterface(const char *interface_name)
+{
+    struct _lcmpCacheEntry *e;
+
+    pthread_mutex_lock(&lcmp_cache_mutex);
+
+    dlist_for_each(e, lcmp_cache, l)
+    {
+        if (0 == strcmp(e->interface_name, interface_name))
+        {
+            e->refresh_pending = 1;
+        }
+    }
+    pthread_cond_signal(&lcmp_pending_cond);
+
+    pthread_mutex_unlock(&lcmp_cache_mutex);
+}
+
 // Obtain information from the G.hn/Spirit device connected to interface
 // 'interface_name' and fill the 'm' structure.
 //
@@ -142,7 +414,8 @@ void _getInterfaceInfoFromGhnSpiritDevice(char *interface_name, char *ghnspirit_
                                              "-p DIDMNG.GENERAL.MACS "                  \
                                              "-w %s"
 
-    FILE* pipe ;
+    FILE *stream;
+    char *output;
 
     char command[MAX_COMMAND_SIZE];
 
@@ -200,22 +473,19 @@ void _getInterfaceInfoFromGhnSpiritDevice(char *interface_name, char *ghnspirit_
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] Querying G.hn device using the LCMP tool:\n");
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > %s\n", command);
 
-    // Execute the LCMP query tool.
+    // Obtain the output of the LCMP query tool (it might come from the cache)
     //
-    pthread_mutex_lock(&lcmp_mutex);
-    pipe = popen(command, "r");
+    stream = _lcmpQuery(interface_name, command, LCMP_INFO_TTL_MS, &output);
 
-    if (!pipe)
+    if (NULL == stream)
     {
-        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] popen() returned with errno=%d (%s)\n", errno, strerror(errno));
-        pthread_mutex_unlock(&lcmp_mutex);
         return;
     }
 
     // Next read/fill the rest of parameters
     //
     line = NULL;
-    while (-1 != (read = getline(&line, &len, pipe)))
+    while (-1 != (read = getline(&line, &len, stream)))
     {
         char *value;
 
@@ -582,8 +852,8 @@ void _getInterfaceInfoFromGhnSpiritDevice(char *interface_name, char *ghnspirit_
         free(dhcp_server);
     }
 
-    pclose(pipe);
-    pthread_mutex_unlock(&lcmp_mutex);
+    fclose(stream);
+    free(output);
 
     return;
 }
@@ -596,7 +866,8 @@ void _getMetricsFromGhnSpiritDevice(char *interface_name, char *ghnspirit_extend
 {
     #define LCMP_CONFIGLAYER_GETMETRICS_COMMAND "configlayer -i %s -m %s -o GET -p QOS.STATS.G9962 -p BFT.GENERAL.MACS_INFO_DESC -p BFT.GENERAL.MACS_INFO -p DIDMNG.GENERAL.DIDS -p DIDMNG.GENERAL.TX_BPS -w %s"
 
-    FILE* pipe ;
+    FILE *stream;
+    char *output;
 
     char command[200];
 
@@ -632,22 +903,19 @@ void _getMetricsFromGhnSpiritDevice(char *interface_name, char *ghnspirit_extend
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] Querying G.hn device using the LCMP tool:\n");
     PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > %s\n", command);
 
-    // Execute the LCMP query tool.
+    // Obtain the output of the LCMP query tool (it might come from the cache)
     //
-    pthread_mutex_lock(&lcmp_mutex);
-    pipe = popen(command, "r");
+    stream = _lcmpQuery(interface_name, command, LCMP_METRICS_TTL_MS, &output);
 
-    if (!pipe)
+    if (NULL == stream)
     {
-        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] popen() returned with errno=%d (%s)\n", errno, strerror(errno));
-        pthread_mutex_unlock(&lcmp_mutex);
         return;
     }
 
     // Next read/fill the rest of parameters
     //
     line = NULL;
-    while (-1 != (read = getline(&line, &len, pipe)))
+    while (-1 != (read = getline(&line, &len, stream)))
     {
         char *value;
 
@@ -932,12 +1200,19 @@ void _getMetricsFromGhnSpiritDevice(char *interface_name, char *ghnspirit_extend
         free(line);
     }
 
-    pclose(pipe);
-    pthread_mutex_unlock(&lcmp_mutex);
+    fclose(stream);
+    free(output);
 
     return;
 }
 
+// Start the pairing process of the G.hn/Spirit device connected to interface
+// 'interface_name'.
+//
+// This is only called from the "push button configuration" thread (see
+// "_pushButtonConfigurationThread()"), never from the AL thread, so it can
+// afford to run the tool and wait for the modem.
+//
 void _startPushButtonOnGhnSpiritDevice(char *interface_name, char *ghnspirit_extended_params)
 {
     #define LCMP_CONFIGLAYER_START_PAIRING_COMMAND "configlayer -i %s -m %s -o SET -p PAIRING.GENERAL.PROCESS_START=1 -w %s"
@@ -986,6 +1261,10 @@ void _startPushButtonOnGhnSpiritDevice(char *interface_name, char *ghnspirit_ext
     pclose(pipe);
     pthread_mutex_unlock(&lcmp_mutex);
 
+    // Cached parameters (ex: "PAIRING.GENERAL.PROCESS_START") are now outdated
+    //
+    _lcmpRefreshInterface(interface_name);
+
     // The G.hn modem might need a few seconds to actually start the pairing
     // process. In order to be sure that the process has started before this
     // function returns we need to pause for a while.
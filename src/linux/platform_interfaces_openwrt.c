@@ -25,6 +25,12 @@
 #include <string.h>     // strdup()
 #include <errno.h>      // errno
 #include <pthread.h>    // mutex functions
+#include <sys/stat.h>   // stat()
+#include <time.h>       // time_t
+
+#include <uci.h>
+#include <libubox/blobmsg.h>
+#include <libubus.h>
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -51,77 +57,223 @@
 //
 //   https://wiki.openwrt.org/doc/uci
 //
-// In order to obtain information of the UCI subsytem of apply a desired
-// configuration setting we will use the following functions than simply
-// execute the "uci" command and wait for a response.
-
-// Mutex to avoid concurrent UCI access
+// Instead of executing the "uci" command (which means one fork()/exec() for
+// each parameter), we link against "libuci" (the library the "uci" command is
+// built on) and keep the "wireless" package loaded in memory, so that queries
+// are served without touching the file system.
+//
+// The in-memory copy is dropped (and loaded again on the next access) when
+// the file in "/etc/config" is modified by someone else (ex: the "uci"
+// command or the web interface). Changes made by us are accumulated with
+// "_set_uci_parameter_value()" and written in one go with
+// "_commit_uci_package()".
+
+// Mutex to avoid concurrent UCI access (it also protects all the variables
+// below)
 //
 pthread_mutex_t uci_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static char * _read_uci_parameter_value(char * parameter)
+#define UCI_WIRELESS_PACKAGE "wireless"
+
+static struct uci_context *uci_ctx = NULL;
+
+// Modification time of the "wireless" file when it was last loaded (or
+// committed by us)
+//
+static time_t uci_wireless_mtime = 0;
+
+// Return the modification time of the file that contains package
+// 'package_name' (or "0" if it cannot be obtained)
+//
+static time_t _uci_package_mtime(const char *package_name)
 {
-    FILE    *pipe ;
-    char    *line;
-    size_t   len;
-    char command[200] = "";
+    char        path[256];
+    struct stat st;
 
-    strcat(command,"uci get ");
-    strcat(command, parameter);
+    snprintf(path, sizeof(path), "%s/%s", uci_ctx->confdir, package_name);
+    if (0 != stat(path, &st))
+    {
+        return 0;
+    }
 
-    // Execute the UCI query command.
-    //
-    pthread_mutex_lock(&uci_mutex);
-    pipe = popen(command, "r");
+    return st.st_mtime;
+}
 
-    if (!pipe)
+// Return the UCI context (it is created the first time this function is
+// called) after making sure the cached "wireless" package is up to date.
+//
+// Must be called with 'uci_mutex' locked.
+//
+static struct uci_context *_get_uci_context(void)
+{
+    struct uci_package *p;
+    time_t              mtime;
+
+    if (NULL == uci_ctx)
     {
-        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] popen() returned with errno=%d (%s)\n", errno, strerror(errno));
-        pthread_mutex_unlock(&uci_mutex);
-        return NULL;
+        uci_ctx = uci_alloc_context();
+        if (NULL == uci_ctx)
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] uci_alloc_context() failed\n");
+            return NULL;
+        }
     }
 
-    // Next read/fill the rest of parameters
-    //
-    line = NULL;
-    if (-1 != getline(&line, &len, pipe))
+    mtime = _uci_package_mtime(UCI_WIRELESS_PACKAGE);
+    if (mtime != uci_wireless_mtime)
     {
-        // Remove the last "\n"
+        // Someone else modified the file. "uci_lookup_ptr()" will load it
+        // again the next time it is needed.
         //
-        line[strlen(line)-1] = 0x00;
+        p = uci_lookup_package(uci_ctx, UCI_WIRELESS_PACKAGE);
+        if (NULL != p)
+        {
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] UCI package '%s' modified. Reloading it.\n", UCI_WIRELESS_PACKAGE);
+            uci_unload(uci_ctx, p);
+        }
+        uci_wireless_mtime = mtime;
+    }
+
+    return uci_ctx;
+}
+
+// Look for 'parameter' (ex: "wireless.@wifi-iface[0].ssid") and fill 'ptr'
+// with the result. The package is loaded (and cached) if it was not already.
+//
+// 'buffer' is where the lookup string is copied (libuci modifies it and 'ptr'
+// points into it), so it must outlive 'ptr'.
+//
+// Must be called with 'uci_mutex' locked. Returns "0" on error.
+//
+static uint8_t _lookup_uci_parameter(const char *parameter, struct uci_ptr *ptr, char *buffer, size_t buffer_len)
+{
+    struct uci_context *ctx;
+
+    ctx = _get_uci_context();
+    if (NULL == ctx)
+    {
+        return 0;
+    }
+
+    if (strlen(parameter) >= buffer_len)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] UCI parameter too long: %s\n", parameter);
+        return 0;
+    }
+    strcpy(buffer, parameter);
+
+    memset(ptr, 0, sizeof(*ptr));
+    if (UCI_OK != uci_lookup_ptr(ctx, ptr, buffer, true))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] Could not find UCI parameter %s\n", parameter);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Copy the value of 'parameter' into 'value' (a buffer of 'value_len' bytes,
+// the value is truncated if needed). Returns "0" if the parameter does not
+// exist.
+//
+static uint8_t _read_uci_parameter_value(const char *parameter, char *value, size_t value_len)
+{
+    struct uci_ptr  ptr;
+    char            buffer[200];
+    uint8_t         ret = 0;
+
+    pthread_mutex_lock(&uci_mutex);
+
+    if (_lookup_uci_parameter(parameter, &ptr, buffer, sizeof(buffer)) &&
+        (ptr.flags & UCI_LOOKUP_COMPLETE)                             &&
+        NULL != ptr.o && UCI_TYPE_STRING == ptr.o->type)
+    {
+        snprintf(value, value_len, "%s", ptr.o->v.string);
+        ret = 1;
     }
 
-    pclose(pipe);
     pthread_mutex_unlock(&uci_mutex);
 
-    return line;
+    return ret;
 }
 
-static void _set_uci_parameter_value(char * parameter, uint8_t *value)
+// Change the value of 'parameter' in the in-memory copy of its package. The
+// change is not written to "/etc/config" until "_commit_uci_package()" is
+// called.
+//
+// Must be called with 'uci_mutex' locked. Returns "0" on error.
+//
+static uint8_t _set_uci_parameter_value(const char *parameter, const char *value)
 {
-    FILE *pipe ;
-    char command[200] = "";
+    struct uci_ptr  ptr;
+    char            buffer[200];
 
-    strcat(command,"uci set ");
-    strcat(command,parameter);
-    strcat(command, (char *)value);
+    if (0 == _lookup_uci_parameter(parameter, &ptr, buffer, sizeof(buffer)))
+    {
+        return 0;
+    }
 
-    // Execute the UCI query command.
+    ptr.value = value;
+    if (UCI_OK != uci_set(uci_ctx, &ptr))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] uci_set() failed for %s\n", parameter);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Write all pending changes of package 'package_name' to "/etc/config" and ask
+// "netifd" (through ubus) to reload the configuration, so that they take
+// effect.
+//
+// Must be called with 'uci_mutex' locked. Returns "0" on error.
+//
+static uint8_t _commit_uci_package(const char *package_name)
+{
+    struct uci_package  *p;
+    struct ubus_context *ubus_ctx;
+    struct blob_buf      b;
+    uint32_t             id;
+    uint8_t              ret = 1;
+
+    p = uci_lookup_package(uci_ctx, package_name);
+    if (NULL == p || UCI_OK != uci_commit(uci_ctx, &p, false))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Could not commit UCI package '%s'\n", package_name);
+        return 0;
+    }
+
+    // "uci_commit()" leaves the new contents loaded, there is no need to read
+    // the file again
     //
-    pthread_mutex_lock(&uci_mutex);
-    pipe = popen(command, "r");
+    if (0 == strcmp(package_name, UCI_WIRELESS_PACKAGE))
+    {
+        uci_wireless_mtime = _uci_package_mtime(UCI_WIRELESS_PACKAGE);
+    }
 
-    if (!pipe)
+    // This is what "wifi reload" does
+    //
+    ubus_ctx = ubus_connect(NULL);
+    if (NULL == ubus_ctx)
     {
-        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] popen() returned with errno=%d (%s)\n", errno, strerror(errno));
-        pthread_mutex_unlock(&uci_mutex);
-        return;
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Failed to connect to ubus\n");
+        return 0;
     }
 
-    pclose(pipe);
-    pthread_mutex_unlock(&uci_mutex);
+    memset(&b, 0, sizeof(b));
+    blob_buf_init(&b, 0);
+    if (ubus_lookup_id(ubus_ctx, "network", &id) ||
+        ubus_invoke(ubus_ctx, id, "reload", b.head, NULL, NULL, 3000))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] ubus call network reload failed\n");
+        ret = 0;
+    }
 
-    return;
+    blob_buf_free(&b);
+    ubus_free(ubus_ctx);
+
+    return ret;
 }
 
 static void _get_wifi_connected_devices(char *interface_name, struct interfaceInfo *m)
@@ -194,20 +346,19 @@ uint8_t openwrt_get_interface_info(char *interface_name, struct interfaceInfo *m
     //
     if (strstr(interface_name, "wlan") != NULL)
     {
-        char  *line = NULL;
-        char command[200];
+        char  value[64];
+        char  command[200];
         char *interface_id = interface_name + 4;
 
         // Find out if device is configured as AP or EP
         //
         sprintf(command, "wireless.@wifi-iface[%c].mode",*interface_id);
 
-        line = _read_uci_parameter_value(command);
-        if (line != NULL)
+        if (_read_uci_parameter_value(command, value, sizeof(value)))
         {
-            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI mode: %s\n", line);
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI mode: %s\n", value);
 
-            if (strstr(line, "ap") != NULL)
+            if (strstr(value, "ap") != NULL)
             {
                 m->interface_type_data.ieee80211.role = IEEE80211_ROLE_AP;
             }
@@ -221,27 +372,20 @@ uint8_t openwrt_get_interface_info(char *interface_name, struct interfaceInfo *m
         //
         sprintf(command, "wireless.@wifi-iface[%c].ssid",*interface_id);
 
-        line = _read_uci_parameter_value(command);
-        if (line != NULL)
+        if (_read_uci_parameter_value(command, m->interface_type_data.ieee80211.ssid, sizeof(m->interface_type_data.ieee80211.ssid)))
         {
-            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI SSID: %s\n", line);
-            memcpy(m->interface_type_data.ieee80211.ssid, line, strlen(line)+1);
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI SSID: %s\n", m->interface_type_data.ieee80211.ssid);
         }
 
         // Retrieve Network key information
         //
         sprintf(command, "wireless.@wifi-iface[%c].key",*interface_id);
 
-        line = _read_uci_parameter_value(command);
-        if (line != NULL)
+        if (_read_uci_parameter_value(command, m->interface_type_data.ieee80211.network_key, sizeof(m->interface_type_data.ieee80211.network_key)))
         {
-            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI key: %s\n", line);
-            memcpy(m->interface_type_data.ieee80211.network_key, line, strlen(line)+1);
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM]   > UCI key: %s\n", m->interface_type_data.ieee80211.network_key);
         }
 
-        // Relases 'getline' resources
-        free(line);
-
         // TODO: Add full support of WIFI parameters. For now, use static
         // values.
         //
@@ -284,13 +428,35 @@ uint8_t openwrt_get_interface_info(char *interface_name, struct interfaceInfo *m
 
 uint8_t openwrt_apply_80211_configuration(char *interface_name, uint8_t *ssid, uint8_t *network_key)
 {
-    _set_uci_parameter_value("wireless.@wifi-iface[1].ssid=",ssid);
-    _set_uci_parameter_value("wireless.@wifi-iface[1].key=",network_key);
-    _set_uci_parameter_value("wireless.@wifi-iface[1].network_key=",network_key);
-    _set_uci_parameter_value("wireless.@wifi-iface[1].encryption=",(uint8_t *)"psk2");
+    uint8_t ret;
 
-    system("wifi reload");
+    // All parameters are changed in memory and then written (and applied) at
+    // once
+    //
+    pthread_mutex_lock(&uci_mutex);
 
-    return 1;
-}
+    ret = _set_uci_parameter_value("wireless.@wifi-iface[1].ssid",        (char *)ssid)        &&
+          _set_uci_parameter_value("wireless.@wifi-iface[1].key",         (char *)network_key) &&
+          _set_uci_parameter_value("wireless.@wifi-iface[1].network_key", (char *)network_key) &&
+          _set_uci_parameter_value("wireless.@wifi-iface[1].encryption",  "psk2");
 
+    if (ret)
+    {
+        ret = _commit_uci_package(UCI_WIRELESS_PACKAGE);
+    }
+    else if (NULL != uci_ctx)
+    {
+        // Discard the changes that were already made in memory
+        //
+        struct uci_package *p = uci_lookup_package(uci_ctx, UCI_WIRELESS_PACKAGE);
+
+        if (NULL != p)
+        {
+            uci_unload(uci_ctx, p);
+        }
+    }
+
+    pthread_mutex_unlock(&uci_mutex);
+
+    return ret;
+}
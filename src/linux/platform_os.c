@@ -19,8 +19,12 @@
 #include <datamodel.h>
 #include <platform.h>
 #include "../platform_os.h"
+#include "../platform_interfaces.h"
 #include "platform_os_priv.h"
 #include "platform_alme_server_priv.h"
+#include "platform_capture_priv.h"
+#include "platform_crypto_priv.h"
+#include "netlink_funcs.h"
 #include <platform_linux.h>
 #include <utils.h>
 #include <1905_l2.h>
@@ -38,6 +42,9 @@
 #include <sys/types.h>   // recv(), setsockopt()
 #include <sys/socket.h>  // recv(), setsockopt()
 #include <linux/if_packet.h> // packet_mreq
+#include <linux/rtnetlink.h> // RTMGRP_*, struct ifinfomsg, struct ndmsg
+#include <linux/neighbour.h> // NDA_MASTER
+#include <linux/if.h>        // IFF_*
 
 ////////////////////////////////////////////////////////////////////////////////
 // Private functions, structures and macros
@@ -73,6 +80,35 @@ struct linux_interface_info {
 static mqd_t           queues_id[MAX_QUEUE_IDS] = {[ 0 ... MAX_QUEUE_IDS-1 ] = (mqd_t) -1};
 static pthread_mutex_t queues_id_mutex          = PTHREAD_MUTEX_INITIALIZER;
 
+// Maximum number of messages waiting in a queue. When a queue is full, senders
+// block until the AL reads the next message.
+//
+#define QUEUE_MAX_MESSAGES  100
+
+// Statistics of each queue (see "PLATFORM_GET_QUEUE_STATS()"), only kept
+// when 'enabled' (see "PLATFORM_ENABLE_QUEUE_STATS()").
+//
+// To know how long each message has been waiting, the time at which it was
+// inserted is appended to the message itself (QUEUE_TIMESTAMP_LEN bytes that
+// "PLATFORM_READ_QUEUE()" removes before returning the message). Messages are
+// TLVs, so the reader knows there is a timestamp when the message is
+// QUEUE_TIMESTAMP_LEN bytes longer than the TLV.
+//
+// 'mutex' only protects 'stats': it is never held while blocked in
+// "mq_send()" or "mq_receive()".
+//
+#define QUEUE_TIMESTAMP_LEN  (sizeof(uint32_t))
+#define QUEUE_MESSAGE_SIZE   (MAX_NETWORK_SEGMENT_SIZE+3+QUEUE_TIMESTAMP_LEN)
+
+struct _queueInfo
+{
+    pthread_mutex_t    mutex;
+    struct queueStats  stats;
+    uint8_t            enabled;
+};
+
+static struct _queueInfo *queues_info[MAX_QUEUE_IDS];
+
 
 // *********** Receiving packets ********************************************
 
@@ -91,6 +127,8 @@ static void handlePacket(uint8_t queue_id, const uint8_t *packet, size_t packet_
         return;
     }
 
+    captureFrame(packet, packet_len);
+
     // In order to build the message that will be inserted into the queue, we
     // need to follow the "message format" defines in the documentation of
     // function 'PLATFORM_REGISTER_QUEUE_EVENT()'
@@ -606,6 +644,37 @@ static void *_pushButtonThread(void *p)
 //
 #define TOPOLOGY_CHANGE_NOTIFICATION_FILENAME  "/tmp/topology_change"
 
+// Besides the "virtual" notification above, the kernel reports (through a
+// NETLINK_ROUTE socket) every change in the state of the network interfaces
+// and in the bridge forwarding databases.
+//
+// A single event (such as a cable pull) usually results in several of these
+// kernel notifications (link down, carrier off, forwarding entries flushed,
+// ...). All changes detected within this time (in milliseconds) of the first
+// one are coalesced into a single message to the AL entity.
+//
+#define TOPOLOGY_CHANGE_DEBOUNCE_MS  (200)
+
+// Sequence number of the RTM_GETLINK dump request used to learn the initial
+// state of the interfaces (so that the answers can be told apart from real
+// notifications, which always have sequence number 0)
+//
+#define TOPOLOGY_CHANGE_DUMP_SEQ     (1)
+
+// Link flags whose change is a topology change
+//
+#define TOPOLOGY_CHANGE_LINK_FLAGS   (IFF_UP | IFF_RUNNING | IFF_LOWER_UP)
+
+// Kernel state of a 1905 interface, as last reported by the kernel
+//
+struct _monitoredInterface
+{
+    const char  *name;
+    int          ifindex;   // 0 if the interface does not exist (yet)
+    unsigned     flags;     // TOPOLOGY_CHANGE_LINK_FLAGS subset
+    int          master;    // ifindex of the bridge it is a port of, or 0
+};
+
 // The only information that needs to be sent to the new thread is the "queue
 // id" to later post messages to the queue.
 //
@@ -614,16 +683,241 @@ struct _topologyMonitorThreadData
     uint8_t     queue_id;
 };
 
+// Open a NETLINK_ROUTE socket subscribed to link and neighbor (which includes
+// bridge forwarding database) changes, and ask the kernel for the current
+// state of all links.
+//
+// Returns the socket, or "-1" if there was a problem.
+//
+static int _rtnetlinkOpen(void)
+{
+    struct sockaddr_nl  addr;
+    int                 fd;
+
+    struct
+    {
+        struct nlmsghdr   nlh;
+        struct ifinfomsg  ifi;
+    } request;
+
+    if (-1 == (fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Topology change monitor thread* socket() returned with errno=%d (%s)\n", errno, strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_NEIGH;
+    if (-1 == bind(fd, (struct sockaddr *)&addr, sizeof(addr)))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Topology change monitor thread* bind() returned with errno=%d (%s)\n", errno, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    memset(&request, 0, sizeof(request));
+    request.nlh.nlmsg_len   = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.nlh.nlmsg_type  = RTM_GETLINK;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq   = TOPOLOGY_CHANGE_DUMP_SEQ;
+    request.ifi.ifi_family  = AF_UNSPEC;
+    if (-1 == send(fd, &request, request.nlh.nlmsg_len, 0))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Topology change monitor thread* send() returned with errno=%d (%s)\n", errno, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Update 'ifs' with a RTM_NEWLINK/RTM_DELLINK message.
+//
+// Returns "1" if the state of one of the 'ifs' changed, "0" otherwise.
+//
+static uint8_t _rtnetlinkProcessLink(struct nlmsghdr *nlh, struct _monitoredInterface *ifs, uint8_t ifs_nr)
+{
+    struct ifinfomsg  *ifi = NLMSG_DATA(nlh);
+    struct rtattr     *rta;
+    int                len = IFLA_PAYLOAD(nlh);
+    const char        *name   = NULL;
+    int                master = 0;
+    unsigned           flags;
+    uint8_t            i;
+
+    for (rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if (IFLA_IFNAME == rta->rta_type)
+        {
+            name = RTA_DATA(rta);
+        }
+        else if (IFLA_MASTER == rta->rta_type)
+        {
+            master = *(int *)RTA_DATA(rta);
+        }
+    }
+
+    // Interfaces are identified by name, as their index changes every time
+    // they are re-created
+    //
+    for (i = 0; i < ifs_nr; i++)
+    {
+        if ((NULL != name && 0 == strcmp(ifs[i].name, name)) || (NULL == name && ifs[i].ifindex == ifi->ifi_index))
+        {
+            break;
+        }
+    }
+    if (i == ifs_nr)
+    {
+        return 0;
+    }
+
+    if (RTM_DELLINK == nlh->nlmsg_type)
+    {
+        flags  = 0;
+        master = 0;
+        ifs[i].ifindex = 0;
+    }
+    else
+    {
+        flags = ifi->ifi_flags & TOPOLOGY_CHANGE_LINK_FLAGS;
+        ifs[i].ifindex = ifi->ifi_index;
+    }
+
+    if (flags == ifs[i].flags && master == ifs[i].master)
+    {
+        // Something else changed (statistics, addresses, ...)
+        //
+        return 0;
+    }
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *Topology change monitor thread* %s: flags 0x%x -> 0x%x, master %d -> %d\n",
+                                 ifs[i].name, ifs[i].flags, flags, ifs[i].master, master);
+    ifs[i].flags  = flags;
+    ifs[i].master = master;
+
+    return 1;
+}
+
+// Check if a RTM_NEWNEIGH/RTM_DELNEIGH message is a change in the forwarding
+// database of one of the 'ifs' (either because it is a bridge port or because
+// it is the bridge itself).
+//
+// Returns "1" if that is the case, "0" otherwise.
+//
+static uint8_t _rtnetlinkProcessNeigh(struct nlmsghdr *nlh, struct _monitoredInterface *ifs, uint8_t ifs_nr)
+{
+    struct ndmsg   *ndm = NLMSG_DATA(nlh);
+    struct rtattr  *rta;
+    int             len = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ndm));
+    int             master = 0;
+    uint8_t         i;
+
+    // ARP/NDP neighbors come and go all the time and they do not affect the
+    // L2 topology
+    //
+    if (AF_BRIDGE != ndm->ndm_family)
+    {
+        return 0;
+    }
+
+    for (rta = (struct rtattr *)((uint8_t *)ndm + NLMSG_ALIGN(sizeof(*ndm))); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if (NDA_MASTER == rta->rta_type)
+        {
+            master = *(int *)RTA_DATA(rta);
+        }
+    }
+
+    for (i = 0; i < ifs_nr; i++)
+    {
+        if (0 != ifs[i].ifindex && (ifs[i].ifindex == ndm->ndm_ifindex || ifs[i].ifindex == master))
+        {
+            PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *Topology change monitor thread* Forwarding database of %s changed\n", ifs[i].name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// Read all pending messages from the NETLINK_ROUTE socket.
+//
+// Returns "1" if (at least) one of them was a change in one of the 'ifs', "0"
+// otherwise.
+//
+static uint8_t _rtnetlinkProcess(int fd, struct _monitoredInterface *ifs, uint8_t ifs_nr)
+{
+    uint8_t   buffer[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    ssize_t   len;
+    uint8_t   changed = 0;
+
+    while (0 < (len = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)))
+    {
+        struct nlmsghdr *nlh;
+
+        for (nlh = (struct nlmsghdr *)buffer; NLMSG_OK(nlh, (size_t)len); nlh = NLMSG_NEXT(nlh, len))
+        {
+            uint8_t c;
+
+            switch (nlh->nlmsg_type)
+            {
+                case RTM_NEWLINK:
+                case RTM_DELLINK:
+                    c = _rtnetlinkProcessLink(nlh, ifs, ifs_nr);
+                    break;
+
+                case RTM_NEWNEIGH:
+                case RTM_DELNEIGH:
+                    c = _rtnetlinkProcessNeigh(nlh, ifs, ifs_nr);
+                    break;
+
+                default:
+                    c = 0;
+                    break;
+            }
+
+            // The answers to the initial dump only tell us where we start from
+            //
+            if (TOPOLOGY_CHANGE_DUMP_SEQ != nlh->nlmsg_seq)
+            {
+                changed |= c;
+            }
+        }
+    }
+
+    if (-1 == len && ENOBUFS == errno)
+    {
+        // The kernel had to drop notifications: we don't know what changed,
+        // so assume the worst.
+        //
+        PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] *Topology change monitor thread* Netlink notifications lost\n");
+        changed = 1;
+    }
+
+    return changed;
+}
+
 static void *_topologyMonitorThread(void *p)
 {
     FILE  *fd_tmp;
 
     int  fdraw_tmp;
+    int  fdraw_rtnl;
 
     struct pollfd fdset[2];
 
     uint8_t  queue_id;
 
+    struct _monitoredInterface  *ifs;
+    char                       **ifs_names;
+    uint8_t                      ifs_nr;
+    uint8_t                      i;
+
+    uint8_t   notification_pending = 0;
+    uint32_t  notification_deadline = 0;
+
     queue_id = ((struct _topologyMonitorThreadData *)p)->queue_id;
 
     // Regarding the "virtual" notification system, first create the "tmp" file
@@ -650,9 +944,28 @@ static void *_topologyMonitorThread(void *p)
         return NULL;
     }
 
+    // Regarding the kernel notifications, we are only interested in the 1905
+    // interfaces. Their state is filled in as soon as the answer to the
+    // initial dump is received.
+    //
+    // If the socket cannot be opened, we can still work with the "virtual"
+    // notification alone.
+    //
+    ifs_names = PLATFORM_GET_LIST_OF_1905_INTERFACES(&ifs_nr);
+    ifs       = (struct _monitoredInterface *)zmemalloc(sizeof(struct _monitoredInterface) * (ifs_nr + 1));
+    for (i = 0; i < ifs_nr; i++)
+    {
+        ifs[i].name = ifs_names[i];
+    }
+    if (-1 == (fdraw_rtnl = _rtnetlinkOpen()))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[PLATFORM] *Topology change monitor thread* Kernel topology changes will not be detected\n");
+    }
+
     while (1)
     {
         int   nfds;
+        int   timeout;
         uint8_t notification_activated;
 
         memset((void*)fdset, 0, sizeof(fdset));
@@ -661,19 +974,30 @@ static void *_topologyMonitorThread(void *p)
         fdset[0].events = POLLIN;
         nfds            = 1;
 
-        // TODO: Other fd's to detect topoly changes would be initialized here.
-        // One good idea would be to use a NETLINK socket that is notified by
-        // the Linux kernel when network "stuff" (routes, IPs, ...) change.
-        //
-        //fdset[0].fd     = ...;
-        //fdset[0].events = POLLIN;
-        //nfds            = 2;
+        if (-1 != fdraw_rtnl)
+        {
+            fdset[1].fd     = fdraw_rtnl;
+            fdset[1].events = POLLIN;
+            nfds            = 2;
+        }
 
-        // The thread will block here (forever, timeout = -1), until there is
-        // a change in one of the previous file descriptors .
+        // The thread will block here until there is a change in one of the
+        // previous file descriptors (or, if a notification is pending, until
+        // the end of the debounce window).
         //
-        if (0 > poll(fdset, nfds, -1))
+        timeout = -1;
+        if (notification_pending)
+        {
+            int32_t remaining = (int32_t)(notification_deadline - PLATFORM_GET_TIMESTAMP());
+
+            timeout = remaining > 0 ? remaining : 0;
+        }
+        if (0 > poll(fdset, nfds, timeout))
         {
+            if (EINTR == errno)
+            {
+                continue;
+            }
             PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Topology change monitor thread* poll() returned with errno=%d (%s)\n", errno, strerror(errno));
             break;
         }
@@ -693,10 +1017,27 @@ static void *_topologyMonitorThread(void *p)
             read(fdraw_tmp, &event, sizeof(event));
         }
 
-        if (1 == notification_activated)
+        if (nfds > 1 && (fdset[1].revents & POLLIN))
+        {
+            if (1 == _rtnetlinkProcess(fdraw_rtnl, ifs, ifs_nr))
+            {
+                PLATFORM_PRINTF_DEBUG_DETAIL("[PLATFORM] *Topology change monitor thread* Kernel notification received!\n");
+                notification_activated = 1;
+            }
+        }
+
+        if (1 == notification_activated && !notification_pending)
+        {
+            notification_pending  = 1;
+            notification_deadline = PLATFORM_GET_TIMESTAMP() + TOPOLOGY_CHANGE_DEBOUNCE_MS;
+        }
+
+        if (notification_pending && (int32_t)(notification_deadline - PLATFORM_GET_TIMESTAMP()) <= 0)
         {
             uint8_t  message[3];
 
+            notification_pending = 0;
+
             message[0] = PLATFORM_QUEUE_EVENT_TOPOLOGY_CHANGE_NOTIFICATION;
             message[1] = 0x0;
             message[2] = 0x0;
@@ -712,6 +1053,71 @@ static void *_topologyMonitorThread(void *p)
 
     PLATFORM_PRINTF_DEBUG_INFO("[PLATFORM] *Topology change monitor thread* Exiting...\n");
 
+    if (-1 != fdraw_rtnl)
+    {
+        close(fdraw_rtnl);
+    }
+    free(ifs);
+    free_LIST_OF_1905_INTERFACES(ifs_names, ifs_nr);
+    free(p);
+    return NULL;
+}
+
+// *********** Shutdown stuff **************************************************
+
+// Signals that make the AL entity terminate
+//
+static const int shutdown_signals[] = {SIGTERM, SIGINT};
+
+// The only information that needs to be sent to the new thread is the "queue
+// id" to later post messages to the queue.
+//
+struct _shutdownThreadData
+{
+    uint8_t     queue_id;
+};
+
+static void _shutdownSignalSet(sigset_t *set)
+{
+    unsigned i;
+
+    sigemptyset(set);
+    for (i = 0; i < sizeof(shutdown_signals)/sizeof(shutdown_signals[0]); i++)
+    {
+        sigaddset(set, shutdown_signals[i]);
+    }
+}
+
+static void *_shutdownThread(void *p)
+{
+    sigset_t  set;
+    int       sig;
+    uint8_t   message[3];
+
+    _shutdownSignalSet(&set);
+
+    // The signals are blocked in all threads (see the
+    // "PLATFORM_QUEUE_EVENT_SHUTDOWN" case in "PLATFORM_REGISTER_QUEUE_EVENT()"),
+    // so they stay pending until we pick them up here.
+    //
+    if (0 != sigwait(&set, &sig))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Shutdown thread* sigwait() failed\n");
+        free(p);
+        return NULL;
+    }
+
+    PLATFORM_PRINTF_DEBUG_INFO("[PLATFORM] *Shutdown thread* Signal %d received\n", sig);
+
+    message[0] = PLATFORM_QUEUE_EVENT_SHUTDOWN;
+    message[1] = 0x0;
+    message[2] = 0x0;
+
+    if (0 == sendMessageToAlQueue(((struct _shutdownThreadData *)p)->queue_id, message, 3))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] *Shutdown thread* Error sending message to queue\n");
+    }
+
     free(p);
     return NULL;
 }
@@ -726,8 +1132,13 @@ uint8_t sendMessageToAlQueue(uint8_t queue_id, uint8_t *message, uint16_t messag
 {
     mqd_t   mqdes;
 
+    struct _queueInfo *info;
+    uint8_t            buffer[QUEUE_MESSAGE_SIZE];
+    uint32_t           now;
+
     mqdes = queues_id[queue_id];
-    if ((mqd_t) -1 == mqdes)
+    info  = queues_info[queue_id];
+    if ((mqd_t) -1 == mqdes || NULL == info)
     {
         PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Invalid queue ID\n");
         return 0;
@@ -739,12 +1150,67 @@ uint8_t sendMessageToAlQueue(uint8_t queue_id, uint8_t *message, uint16_t messag
         return 0;
     }
 
-    if (0 !=  mq_send(mqdes, (const char *)message, message_len, 0))
+    if (message_len > MAX_NETWORK_SEGMENT_SIZE+3)
+    {
+        // "mq_send()" would fail with EMSGSIZE
+        //
+        PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] Message for queue '%d' too long (%d bytes)\n", queue_id, message_len);
+
+        pthread_mutex_lock(&info->mutex);
+        info->stats.dropped++;
+        pthread_mutex_unlock(&info->mutex);
+        return 0;
+    }
+
+    if (!info->enabled)
+    {
+        if (0 !=  mq_send(mqdes, (const char *)message, message_len, 0))
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] mq_send('%d') returned with errno=%d (%s)\n", queue_id, errno, strerror(errno));
+
+            pthread_mutex_lock(&info->mutex);
+            info->stats.dropped++;
+            pthread_mutex_unlock(&info->mutex);
+            return 0;
+        }
+        return 1;
+    }
+
+    // Time spent blocked below (because the queue is full) also counts as
+    // waiting time
+    //
+    now = PLATFORM_GET_TIMESTAMP_US();
+    memcpy(buffer, message, message_len);
+    memcpy(buffer + message_len, &now, QUEUE_TIMESTAMP_LEN);
+
+    // The message is accounted for before it is inserted, so that 'depth'
+    // never goes below zero if the AL thread reads it before we take the
+    // mutex again. Senders blocked because the queue is full are thus also
+    // part of 'depth'.
+    //
+    pthread_mutex_lock(&info->mutex);
+    info->stats.depth++;
+    if (info->stats.depth > info->stats.peak_depth)
+    {
+        info->stats.peak_depth = info->stats.depth;
+    }
+    pthread_mutex_unlock(&info->mutex);
+
+    if (0 !=  mq_send(mqdes, (const char *)buffer, message_len + QUEUE_TIMESTAMP_LEN, 0))
     {
         PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] mq_send('%d') returned with errno=%d (%s)\n", queue_id, errno, strerror(errno));
+
+        pthread_mutex_lock(&info->mutex);
+        info->stats.depth--;
+        info->stats.dropped++;
+        pthread_mutex_unlock(&info->mutex);
         return 0;
     }
 
+    pthread_mutex_lock(&info->mutex);
+    info->stats.enqueued++;
+    pthread_mutex_unlock(&info->mutex);
+
     return 1;
 }
 
@@ -820,12 +1286,14 @@ uint8_t PLATFORM_CREATE_QUEUE(const char *name)
     mq_unlink(name);
 
     attr.mq_flags   = 0;
-    attr.mq_maxmsg  = 100;
+    attr.mq_maxmsg  = QUEUE_MAX_MESSAGES;
     attr.mq_curmsgs = 0;
-    attr.mq_msgsize = MAX_NETWORK_SEGMENT_SIZE+3;
+    attr.mq_msgsize = QUEUE_MESSAGE_SIZE;
       //
       // NOTE: The biggest value in the queue is going to be a message from the
-      // "new packet" event, which is MAX_NETWORK_SEGMENT_SIZE+3 bytes long.
+      // "new packet" event, which is MAX_NETWORK_SEGMENT_SIZE+3 bytes long
+      // (plus the timestamp appended by "sendMessageToAlQueue()" when the
+      // statistics of the queue are enabled).
       // The "PLATFORM_CREATE_QUEUE()" documentation mentions
 
     if ((mqd_t) -1 == (mqdes = mq_open(name, O_RDWR | O_CREAT, 0666, &attr)))
@@ -839,6 +1307,14 @@ uint8_t PLATFORM_CREATE_QUEUE(const char *name)
 
     queues_id[i] = mqdes;
 
+    if (NULL == queues_info[i])
+    {
+        queues_info[i] = (struct _queueInfo *)memalloc(sizeof(struct _queueInfo));
+        pthread_mutex_init(&queues_info[i]->mutex, NULL);
+    }
+    memset(&queues_info[i]->stats, 0, sizeof(queues_info[i]->stats));
+    queues_info[i]->enabled = 0;
+
     pthread_mutex_unlock(&queues_id_mutex);
     return i;
 }
@@ -1053,6 +1529,66 @@ uint8_t PLATFORM_REGISTER_QUEUE_EVENT(uint8_t queue_id, uint8_t event_type, void
             break;
         }
 
+        case PLATFORM_QUEUE_EVENT_SHUTDOWN:
+        {
+            // The AL entity is telling us that it wants to be notified when
+            // it has to terminate.
+            //
+            // Block the termination signals in this thread (and, as the mask
+            // is inherited, in all threads created from now on) and create
+            // a thread that waits for them.
+            //
+            pthread_t                    thread;
+            struct _shutdownThreadData  *p;
+            sigset_t                     set;
+
+            p = (struct _shutdownThreadData *)malloc(sizeof(struct _shutdownThreadData));
+            if (NULL == p)
+            {
+                // Out of memory
+                //
+                return 0;
+            }
+
+            p->queue_id = queue_id;
+
+            _shutdownSignalSet(&set);
+            if (0 != pthread_sigmask(SIG_BLOCK, &set, NULL))
+            {
+                free(p);
+                return 0;
+            }
+
+            pthread_create(&thread, NULL, _shutdownThread, (void *)p);
+
+            break;
+        }
+
+        case PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE:
+        {
+            // The AL entity is telling us that it is capable of processing
+            // the results of crypto jobs, so we can start running them in
+            // the background.
+            //
+            return cryptoWorkersStart(queue_id);
+        }
+
+        case PLATFORM_QUEUE_EVENT_RADIO_CHANGE:
+        {
+            // The AL entity is telling us that it is capable of processing
+            // radio changes.
+            //
+            // A new thread is created by the nl80211 code to wait for the
+            // driver notifications.
+            //
+            if (netlink_events_start(queue_id) < 0)
+            {
+                return 0;
+            }
+
+            break;
+        }
+
         default:
         {
             // Unknown event type!!
@@ -1069,6 +1605,10 @@ uint8_t PLATFORM_READ_QUEUE(uint8_t queue_id, uint8_t *message_buffer)
     mqd_t    mqdes;
     ssize_t  len;
 
+    struct _queueInfo *info;
+    uint8_t            buffer[QUEUE_MESSAGE_SIZE];
+    uint32_t           timestamp;
+
     mqdes = queues_id[queue_id];
     if ((mqd_t) -1 == mqdes)
     {
@@ -1076,7 +1616,7 @@ uint8_t PLATFORM_READ_QUEUE(uint8_t queue_id, uint8_t *message_buffer)
         return 1;
     }
 
-    len = mq_receive(mqdes, (char *)message_buffer, MAX_NETWORK_SEGMENT_SIZE+3, NULL);
+    len = mq_receive(mqdes, (char *)buffer, sizeof(buffer), NULL);
 
     if (-1 == len)
     {
@@ -1084,10 +1624,33 @@ uint8_t PLATFORM_READ_QUEUE(uint8_t queue_id, uint8_t *message_buffer)
         return 0;
     }
 
+    // Remove the timestamp appended by "sendMessageToAlQueue()" (when the
+    // statistics of the queue are enabled)
+    //
+    if (len >= (ssize_t)(3 + QUEUE_TIMESTAMP_LEN) &&
+        (size_t)len == 3 + QUEUE_TIMESTAMP_LEN + (size_t)(buffer[1] * 256 + buffer[2]))
+    {
+        len -= QUEUE_TIMESTAMP_LEN;
+        memcpy(&timestamp, buffer + len, QUEUE_TIMESTAMP_LEN);
+
+        info = queues_info[queue_id];
+        if (NULL != info)
+        {
+            pthread_mutex_lock(&info->mutex);
+            info->stats.last_wait_us = PLATFORM_GET_TIMESTAMP_US() - timestamp;
+            info->stats.depth--;
+            pthread_mutex_unlock(&info->mutex);
+        }
+    }
+    if (len > 0)
+    {
+        memcpy(message_buffer, buffer, len);
+    }
+
     // All messages are TLVs where the second and third bytes indicate the
     // total length of the payload. This value *must* match "len-3"
     //
-    if ( len < 0 )
+    if ( len < 3 )
     {
         PLATFORM_PRINTF_DEBUG_ERROR("[PLATFORM] mq_receive() returned than 3 bytes (minimum TLV size)\n");
         return 0;
@@ -1110,4 +1673,36 @@ uint8_t PLATFORM_READ_QUEUE(uint8_t queue_id, uint8_t *message_buffer)
     return 1;
 }
 
+uint8_t PLATFORM_ENABLE_QUEUE_STATS(uint8_t queue_id)
+{
+    struct _queueInfo *info;
+
+    info = queues_info[queue_id];
+    if (NULL == info)
+    {
+        return 0;
+    }
+
+    info->enabled = 1;
+
+    return 1;
+}
+
+uint8_t PLATFORM_GET_QUEUE_STATS(uint8_t queue_id, struct queueStats *stats)
+{
+    struct _queueInfo *info;
+
+    info = queues_info[queue_id];
+    if (NULL == info)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&info->mutex);
+    *stats = info->stats;
+    pthread_mutex_unlock(&info->mutex);
+
+    return 1;
+}
+
 
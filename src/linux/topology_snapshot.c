@@ -0,0 +1,316 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <platform.h>
+#include <utils.h>
+#include <datamodel.h>
+#include <datamodel_shm.h>
+
+#include "../al_datamodel.h"
+#include "../topology_snapshot.h"
+
+#include <errno.h>      // errno
+#include <fcntl.h>      // open()
+#include <stdio.h>      // snprintf(), rename()
+#include <stdlib.h>     // free()
+#include <string.h>     // memcpy(), strerror(), ...
+#include <sys/mman.h>   // mmap()
+#include <sys/stat.h>   // fstat()
+#include <time.h>       // time()
+#include <unistd.h>     // write(), fsync(), close()
+
+////////////////////////////////////////////////////////////////////////////////
+// Private functions and data
+////////////////////////////////////////////////////////////////////////////////
+
+#define SNAPSHOT_MAGIC     (0x504d5453) // "PMTS"
+#define SNAPSHOT_VERSION   (1)
+
+// Sections are aligned on this boundary inside the file, so that the mapped
+// data model section can be accessed directly.
+//
+#define SNAPSHOT_ALIGN(x)  (((x) + 7) & ~((size_t)7))
+
+// Header at the start of the file. All values are in host byte order: the file
+// is only meant to be read back by the same device.
+//
+struct _snapshotHeader
+{
+    uint32_t magic;             // SNAPSHOT_MAGIC
+    uint16_t version;           // SNAPSHOT_VERSION
+    uint16_t header_size;       // sizeof(struct _snapshotHeader) of the writer
+    uint64_t saved_at;          // Wall clock time (in seconds) of the save
+    uint8_t  al_mac_address[6]; // Of the AL entity that saved it
+    uint8_t  reserved[2];
+
+    uint32_t datamodel_offset;  // Data model graph ("datamodel_shm.h" layout)
+    uint32_t datamodel_size;
+    uint32_t devices_offset;    // "DMnetworkDevicesSave()" output
+    uint32_t devices_size;
+
+    uint32_t checksum;          // FNV-1a of both sections
+};
+
+static char *snapshot_path = NULL;
+
+// Scratch space for the data model section, reused between snapshots
+//
+static uint8_t *datamodel_buffer      = NULL;
+static size_t   datamodel_buffer_size = 0;
+
+#define CHECKSUM_INIT (2166136261U)
+
+static uint32_t _checksum(uint32_t checksum, const uint8_t *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        checksum ^= data[i];
+        checksum *= 16777619U;
+    }
+    return checksum;
+}
+
+static bool _writeAll(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0)
+    {
+        ssize_t written = write(fd, p, len);
+
+        if (written < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return false;
+        }
+        p   += written;
+        len -= written;
+    }
+    return true;
+}
+
+// Check that 'header' describes a snapshot of this AL entity which fits in a
+// file of 'size' bytes.
+//
+static bool _checkHeader(const struct _snapshotHeader *header, size_t size)
+{
+    if (
+         (SNAPSHOT_MAGIC   != header->magic)                                 ||
+         (SNAPSHOT_VERSION != header->version)                               ||
+         (header->header_size < sizeof(struct _snapshotHeader))              ||
+         (header->datamodel_offset > size)                                   ||
+         (header->datamodel_size   > size - header->datamodel_offset)        ||
+         (header->devices_offset   > size)                                   ||
+         (header->devices_size     > size - header->devices_offset)          ||
+         (0 != (header->datamodel_offset & 7))
+       )
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] Unsupported or truncated snapshot\n");
+        return false;
+    }
+
+    if (0 != memcmp(header->al_mac_address, DMalMacGet(), 6))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] Snapshot was saved by another AL entity (" MACSTR ")\n",
+                                      MAC2STR(header->al_mac_address));
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Public functions
+////////////////////////////////////////////////////////////////////////////////
+
+void topologySnapshotPathSet(const char *path)
+{
+    free(snapshot_path);
+    snapshot_path = NULL;
+
+    if (NULL != path)
+    {
+        snapshot_path = strdup(path);
+    }
+}
+
+const char *topologySnapshotPathGet(void)
+{
+    return snapshot_path;
+}
+
+uint8_t topologySnapshotLoad(void)
+{
+    const struct _snapshotHeader *header;
+    const uint8_t                *map;
+    struct stat                   st;
+    int                           fd;
+    time_t                        now;
+    uint32_t                      checksum;
+    unsigned                      devices_nr;
+    uint8_t                       ret = 0;
+
+    if (NULL == snapshot_path)
+    {
+        return 0;
+    }
+
+    fd = open(snapshot_path, O_RDONLY);
+    if (-1 == fd)
+    {
+        if (ENOENT == errno)
+        {
+            PLATFORM_PRINTF_DEBUG_INFO("[SNAPSHOT] No snapshot in %s\n", snapshot_path);
+        }
+        else
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] Could not open %s: errno=%d (%s)\n", snapshot_path, errno, strerror(errno));
+        }
+        return 0;
+    }
+    if (-1 == fstat(fd, &st) || (size_t)st.st_size < sizeof(struct _snapshotHeader))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] %s is not a valid snapshot\n", snapshot_path);
+        close(fd);
+        return 0;
+    }
+
+    // The file is never modified in place (a new snapshot replaces it), so we
+    // can work directly on the mapping without copying it first.
+    //
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == map)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] mmap() failed with errno=%d (%s)\n", errno, strerror(errno));
+        return 0;
+    }
+    header = (const struct _snapshotHeader *)map;
+
+    if (!_checkHeader(header, st.st_size))
+    {
+        goto out;
+    }
+
+    checksum = _checksum(CHECKSUM_INIT, map + header->datamodel_offset, header->datamodel_size);
+    checksum = _checksum(checksum,      map + header->devices_offset,   header->devices_size);
+    if (checksum != header->checksum)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("[SNAPSHOT] Checksum mismatch in %s\n", snapshot_path);
+        goto out;
+    }
+
+    now = time(NULL);
+    if ((uint64_t)now < header->saved_at || (uint64_t)now - header->saved_at > TOPOLOGY_SNAPSHOT_MAX_AGE)
+    {
+        PLATFORM_PRINTF_DEBUG_INFO("[SNAPSHOT] Snapshot in %s is too old. Ignoring it.\n", snapshot_path);
+        goto out;
+    }
+
+    devices_nr = datamodelSnapshotRestore((const struct datamodelShmHeader *)(map + header->datamodel_offset),
+                                          header->datamodel_size);
+    DMnetworkDevicesRestore(map + header->devices_offset, header->devices_size);
+
+    PLATFORM_PRINTF_DEBUG_INFO("[SNAPSHOT] Restored %u devices from %s (saved %us ago)\n",
+                               devices_nr, snapshot_path, (unsigned)(now - header->saved_at));
+    ret = 1;
+
+out:
+    munmap((void *)map, st.st_size);
+    return ret;
+}
+
+uint8_t topologySnapshotSave(void)
+{
+    struct _snapshotHeader  header;
+    uint8_t                 padding[8] = {0};
+    uint8_t                *devices;
+    uint32_t                devices_size;
+    size_t                  datamodel_size;
+    char                   *tmp_path;
+    size_t                  tmp_path_len;
+    int                     fd;
+    bool                    ok;
+
+    if (NULL == snapshot_path)
+    {
+        return 1;
+    }
+
+    datamodel_size = datamodelSnapshotBuild(&datamodel_buffer, &datamodel_buffer_size);
+    devices        = DMnetworkDevicesSave(&devices_size);
+
+    memset(&header, 0, sizeof(header));
+    header.magic            = SNAPSHOT_MAGIC;
+    header.version          = SNAPSHOT_VERSION;
+    header.header_size      = sizeof(header);
+    header.saved_at         = time(NULL);
+    memcpy(header.al_mac_address, DMalMacGet(), 6);
+    header.datamodel_offset = SNAPSHOT_ALIGN(sizeof(header));
+    header.datamodel_size   = datamodel_size;
+    header.devices_offset   = header.datamodel_offset + datamodel_size;
+    header.devices_size     = devices_size;
+    header.checksum         = _checksum(_checksum(CHECKSUM_INIT, datamodel_buffer, datamodel_size), devices, devices_size);
+
+    // Write a temporary file and rename it over the old one once it is safely
+    // on disk.
+    //
+    tmp_path_len = strlen(snapshot_path) + sizeof(".tmp");
+    tmp_path     = memalloc(tmp_path_len);
+    snprintf(tmp_path, tmp_path_len, "%s.tmp", snapshot_path);
+
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (-1 == fd)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[SNAPSHOT] Could not create %s: errno=%d (%s)\n", tmp_path, errno, strerror(errno));
+        free(devices);
+        free(tmp_path);
+        return 0;
+    }
+
+    ok = _writeAll(fd, &header, sizeof(header))                                         &&
+         _writeAll(fd, padding, header.datamodel_offset - sizeof(header))               &&
+         _writeAll(fd, datamodel_buffer, datamodel_size)                                &&
+         _writeAll(fd, devices, devices_size)                                           &&
+         0 == fsync(fd);
+    if (0 != close(fd))
+    {
+        ok = false;
+    }
+
+    if (!ok || 0 != rename(tmp_path, snapshot_path))
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("[SNAPSHOT] Could not save %s: errno=%d (%s)\n", snapshot_path, errno, strerror(errno));
+        unlink(tmp_path);
+        free(devices);
+        free(tmp_path);
+        return 0;
+    }
+
+    PLATFORM_PRINTF_DEBUG_DETAIL("[SNAPSHOT] Saved %u bytes to %s\n",
+                                 (unsigned)(header.devices_offset + devices_size), snapshot_path);
+
+    free(devices);
+    free(tmp_path);
+    return 1;
+}
@@ -39,4 +39,24 @@
 //
 uint8_t PLATFORM_SEND_ALME_REPLY(uint8_t alme_client_id, uint8_t *alme_message, uint16_t alme_message_len);
 
+// Same as "PLATFORM_SEND_ALME_REPLY()", but the reply is made of several ALME
+// messages that are sent one after the other (this is used by replies that
+// do not fit in a single ALME message, such as the response to the
+// "CUSTOM_COMMAND_DUMP_NETWORK_DEVICES" custom command).
+//
+// The HLE receives the messages in the same order they were provided, and the
+// reply is only considered complete after a call with 'last' set to '1'.
+// There must always be such a call (even if a previous one failed) so that
+// the platform code knows when the reply is done.
+//
+// In order to keep memory usage bounded, this function might block until the
+// HLE has consumed the previous parts of the reply. This wait is bounded: an
+// HLE that stops reading is considered gone after a few seconds.
+//
+// Return '0' if the message could not be delivered (for example, because the
+// HLE went away or stopped reading), "1" otherwise. Once this happens, the
+// rest of the reply should not be generated.
+//
+uint8_t PLATFORM_SEND_ALME_REPLY_PART(uint8_t alme_client_id, uint8_t *alme_message, uint16_t alme_message_len, uint8_t last);
+
 #endif
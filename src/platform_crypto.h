@@ -23,6 +23,7 @@
 #define AES_BLOCK_SIZE 16
 
 #include "platform.h"
+#include <dlist.h>
 
 
 // Fill the buffer of length 'len' pointed by 'p' with random bytes.
@@ -46,6 +47,22 @@ uint8_t PLATFORM_GET_RANDOM_BYTES(uint8_t *p, uint16_t len);
 //
 uint8_t PLATFORM_GENERATE_DH_KEY_PAIR(uint8_t **priv, uint16_t *priv_len, uint8_t **pub, uint16_t *pub_len);
 
+// Start generating Diffie Hellman key pairs in the background, so that the
+// next calls to "PLATFORM_GENERATE_DH_KEY_PAIR()" can return one immediately
+// instead of having to compute it.
+//
+// A small number of key pairs is kept ready. Each time one is used, a new one
+// is generated to replace it. When there are none left (or if this function
+// was never called), "PLATFORM_GENERATE_DH_KEY_PAIR()" generates the key pair
+// itself, as usual.
+//
+// Calling this function more than once has no effect.
+//
+// Return "0" if there was a problem (key pairs are then always generated on
+// demand), "1" otherwise
+//
+uint8_t PLATFORM_PREGENERATE_DH_KEY_PAIRS(void);
+
 // Return the Diffie Hell shared secret (in output argument "shared_secret"
 // which is "shared_secret_len" bytes long) associated to a remote public key
 // ("remote_pub", which is "remote_pub_len" bytes long") and a local private
@@ -104,4 +121,46 @@ uint8_t PLATFORM_AES_ENCRYPT(uint8_t *key, uint8_t *iv, uint8_t *data, uint32_t
 // unencrypted data.
 uint8_t PLATFORM_AES_DECRYPT(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len);
 
+// Asynchronous crypto jobs
+//
+// Some operations (ex: building an M2 message, which involves a Diffie Hellman
+// exchange) are too slow to be run from the AL entity event loop when many of
+// them arrive at the same time: all other messages would have to wait. Such
+// operations can be handed to a pool of worker threads instead:
+//
+//   1. The AL entity embeds a "struct cryptoJob" in a structure that contains
+//      all the inputs of the operation, fills the 'run' and 'done' callbacks and
+//      calls "PLATFORM_SUBMIT_CRYPTO_JOB()".
+//
+//   2. A worker thread calls 'run'. This callback must only use the job
+//      structure and the functions in this file: it runs at the same time as
+//      the AL entity, so it must *not* touch the data model or send packets.
+//
+//   3. Once 'run' returns, a "PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE" message
+//      (see "platform_os.h") is inserted in the AL queue. When the AL entity
+//      receives it, it calls 'done', which uses the results (and typically
+//      frees the job).
+//
+// Jobs are run in the order they are submitted, but as there are several
+// workers, they might complete in a different order.
+//
+struct cryptoJob
+{
+    dlist_item  l;                                // Private to the platform
+
+    void      (*run)(struct cryptoJob *job);      // Called from a worker thread
+    void      (*done)(struct cryptoJob *job);     // Called from the AL entity
+};
+
+// Hand 'job' to the worker threads.
+//
+// The workers are created when the "PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE"
+// event is registered. Before that (or if the platform doesn't support it)
+// this function returns "0" and does nothing: the caller is then expected to
+// call 'run' and 'done' itself.
+//
+// Return "0" if the job was not submitted, "1" otherwise
+//
+uint8_t PLATFORM_SUBMIT_CRYPTO_JOB(struct cryptoJob *job);
+
 #endif
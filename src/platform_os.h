@@ -362,6 +362,93 @@ uint8_t PLATFORM_CREATE_QUEUE(const char *name);
 //         byte 0x01 - 0x00
 //         byte 0x02 - 0x00
 //
+//   - PLATFORM_QUEUE_EVENT_SHUTDOWN:
+//
+//       A new event is generated when the platform asks the AL entity to
+//       terminate (for example, because a SIGTERM signal was received), so
+//       that it can save its state before exiting.
+//
+//       'data' can be set to NULL (it is not used for anything).
+//
+//       When the event takes place, the message that is inserted in the queue
+//       has the following format:
+//
+//         byte 0x00 - PLATFORM_QUEUE_EVENT_SHUTDOWN
+//         byte 0x01 - 0x00
+//         byte 0x02 - 0x00
+//
+//       [PLATFORM PORTING NOTE]
+//         This event should be registered right after creating the queue: on
+//         platforms where the termination request is delivered as a signal,
+//         registering it may change how the signal is handled by the threads
+//         created later on.
+//
+//   - PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE:
+//
+//       A new event is generated every time a job submitted with
+//       "PLATFORM_SUBMIT_CRYPTO_JOB()" (see "platform_crypto.h") has been run.
+//
+//       'data' can be set to NULL (it is not used for anything).
+//
+//       Jobs can only be submitted once this event has been registered.
+//
+//       When the event takes place, the message that is inserted in the queue
+//       has the following format:
+//
+//         byte 0x00 - PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE
+//         byte 0x01 - Message length MSB (0x00)
+//         byte 0x02 - Message length LSB (sizeof(struct cryptoJob *))
+//         byte 0x03... Value of the "struct cryptoJob *" pointer that was
+//                      passed to "PLATFORM_SUBMIT_CRYPTO_JOB()", in host
+//                      memory layout
+//
+//       [PLATFORM PORTING NOTE]
+//         Passing the pointer itself only works because the queue and the
+//         workers live in the same process as the AL entity.
+//
+//   - PLATFORM_QUEUE_EVENT_RADIO_CHANGE:
+//
+//       A new event is generated every time the Wi-Fi driver reports a change
+//       in one of the local radios: a station associated to or disassociated
+//       from a local AP, a local interface switched channel, or a Wi-Fi
+//       interface was created or destroyed.
+//
+//       'data' can be set to NULL (it is not used for anything).
+//
+//       When the event takes place, the message that is inserted in the queue
+//       has the following format:
+//
+//         byte 0x00 - PLATFORM_QUEUE_EVENT_RADIO_CHANGE
+//         byte 0x01 - Message length MSB (0x00)
+//         byte 0x02 - Message length LSB (0x14)
+//         byte 0x03 - Type of change: one of the "PLATFORM_RADIO_CHANGE_*"
+//                     values below
+//         byte 0x04 - "radio::index" of the radio, MSB (only valid for
+//                     "PLATFORM_RADIO_CHANGE_INTERFACE_ADDED")
+//         byte 0x05 - "radio::index" of the radio
+//         byte 0x06 - "radio::index" of the radio
+//         byte 0x07 - "radio::index" of the radio, LSB
+//         byte 0x08 - MAC address of the local Wi-Fi interface, byte #1
+//         ...
+//         byte 0x0d - MAC address of the local Wi-Fi interface, byte #6
+//         byte 0x0e - MAC address of the station, byte #1 (only valid for
+//                     "PLATFORM_RADIO_CHANGE_STATION_*")
+//         ...
+//         byte 0x13 - MAC address of the station, byte #6
+//         byte 0x14 - New frequency (in MHz), MSB (only valid for
+//                     "PLATFORM_RADIO_CHANGE_CHANNEL_SWITCH")
+//         byte 0x15 - New frequency (in MHz), LSB
+//         byte 0x16 - Role of the interface: one of the "IEEE80211_ROLE_*"
+//                     values of "platform_interfaces.h" (only valid for
+//                     "PLATFORM_RADIO_CHANGE_INTERFACE_ADDED")
+//
+//       Fields that are not valid for a given type of change are set to 0.
+//
+//       [PLATFORM PORTING NOTE]
+//         These changes should be reported as they happen (for example,
+//         through driver notifications), so that the AL entity never has to
+//         query the driver to keep its data model up to date.
+//
 //
 // In all cases, if there is a problem registering the event, this function
 // returns "0", otherwise it returns "1"
@@ -373,6 +460,15 @@ uint8_t PLATFORM_CREATE_QUEUE(const char *name);
 #define PLATFORM_QUEUE_EVENT_PUSH_BUTTON                  (0x04)
 #define PLATFORM_QUEUE_EVENT_AUTHENTICATED_LINK           (0x05)
 #define PLATFORM_QUEUE_EVENT_TOPOLOGY_CHANGE_NOTIFICATION (0x06)
+#define PLATFORM_QUEUE_EVENT_SHUTDOWN                     (0x07)
+#define PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE              (0x08)
+#define PLATFORM_QUEUE_EVENT_RADIO_CHANGE                 (0x09)
+
+#define PLATFORM_RADIO_CHANGE_STATION_ADDED               (0x01)
+#define PLATFORM_RADIO_CHANGE_STATION_REMOVED             (0x02)
+#define PLATFORM_RADIO_CHANGE_CHANNEL_SWITCH              (0x03)
+#define PLATFORM_RADIO_CHANGE_INTERFACE_ADDED             (0x04)
+#define PLATFORM_RADIO_CHANGE_INTERFACE_REMOVED           (0x05)
 
 #define MAX_TIMER_TOKEN (1000)
 
@@ -399,4 +495,40 @@ uint8_t PLATFORM_REGISTER_QUEUE_EVENT(uint8_t queue_id, uint8_t event_type, void
 //
 uint8_t PLATFORM_READ_QUEUE(uint8_t queue_id, uint8_t *message_buffer);
 
+// Statistics of a queue (see "PLATFORM_GET_QUEUE_STATS()")
+//
+struct queueStats
+{
+    uint32_t  enqueued;      // Messages inserted in the queue
+    uint32_t  dropped;       // Messages that could not be inserted
+    uint32_t  depth;         // Messages currently waiting in the queue (or
+                             // waiting to enter it, when it is full)
+    uint32_t  peak_depth;    // Highest value 'depth' has ever had
+    uint32_t  last_wait_us;  // Time (in microseconds) that the message last
+                             // returned by "PLATFORM_READ_QUEUE()" spent
+                             // waiting in the queue
+};
+
+// Start keeping the statistics of the queue represented by 'queue_id'.
+//
+// They are not kept by default: then, inserting a message in the queue costs
+// nothing more than the insertion itself.
+//
+// Must be called before any event is registered in the queue (see
+// "PLATFORM_REGISTER_QUEUE_EVENT()").
+//
+// If there is a problem this function returns "0", otherwise it returns "1"
+//
+uint8_t PLATFORM_ENABLE_QUEUE_STATS(uint8_t queue_id);
+
+// Fill 'stats' with the statistics of the queue represented by 'queue_id'.
+//
+// Once enabled (see "PLATFORM_ENABLE_QUEUE_STATS()"), keeping them up to date
+// must not be noticeably slower than inserting a message in the queue.
+// 'dropped' is counted even when they are not enabled.
+//
+// If there is a problem this function returns "0", otherwise it returns "1"
+//
+uint8_t PLATFORM_GET_QUEUE_STATS(uint8_t queue_id, struct queueStats *stats);
+
 #endif
@@ -0,0 +1,228 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <pool.h>
+#include "platform.h"
+#include "utils.h" /* memalloc() */
+
+#include <stdint.h>
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* abort() */
+#include <string.h> /* memset() */
+
+/* Each object is preceded by a header pointing back to its pool, so that pool_free() can find it. The union makes sure
+ * that objects are 8-byte aligned, also on 32-bit targets. */
+union pool_header {
+    struct pool *pool;
+    uint64_t align;
+};
+
+/* Objects sizes are rounded up to a multiple of this. */
+#define POOL_ALIGN 8
+
+/* Size of the slabs. Objects bigger than this get a slab each. */
+#define POOL_SLAB_SIZE 4096
+
+/* Granularity and size limit of the pools returned by pool_get_sized(). Bigger sizes are kept in an (unsorted) list. */
+#define POOL_SIZED_GRANULARITY 16
+#define POOL_SIZED_MAX 1024
+
+#ifdef POOL_DEBUG
+/* Header value of deleted objects. */
+#define POOL_FREED ((struct pool *)1)
+#endif
+
+/* Pools that have been used, in order of first use. */
+static struct pool *pools = NULL;
+static struct pool **pools_tail = &pools;
+
+struct sized_pool {
+    struct pool pool;
+    char name[24];
+    struct sized_pool *next;
+};
+
+/* The last slot is the list of pools bigger than POOL_SIZED_MAX. */
+static struct sized_pool *sized_pools[POOL_SIZED_MAX / POOL_SIZED_GRANULARITY + 1];
+
+/* Distance between two consecutive objects in a slab. The object must be big enough to hold the free list link. */
+static size_t pool_stride(const struct pool *pool)
+{
+    size_t size = pool->size < sizeof(void *) ? sizeof(void *) : pool->size;
+    return sizeof(union pool_header) + ((size + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1));
+}
+
+static union pool_header *pool_header(void *object)
+{
+    return (union pool_header *)object - 1;
+}
+
+#ifdef POOL_DEBUG
+static void pool_poison(struct pool *pool, void *object)
+{
+    pool_header(object)->pool = POOL_FREED;
+    if (pool->size > sizeof(void *))
+    {
+        memset((uint8_t *)object + sizeof(void *), POOL_POISON, pool->size - sizeof(void *));
+    }
+}
+
+static void pool_check_poison(const struct pool *pool, void *object)
+{
+    const uint8_t *bytes = object;
+    size_t i;
+
+    if (pool_header(object)->pool != POOL_FREED)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("Pool %s: header of deleted object %p overwritten\n", pool->name, object);
+        abort();
+    }
+    for (i = sizeof(void *); i < pool->size; i++)
+    {
+        if (bytes[i] != POOL_POISON)
+        {
+            PLATFORM_PRINTF_DEBUG_ERROR("Pool %s: object %p modified at offset %u after being deleted\n",
+                                        pool->name, object, (unsigned)i);
+            abort();
+        }
+    }
+}
+#endif
+
+/* Add a new slab to the free list of @a pool. */
+static void pool_grow(struct pool *pool)
+{
+    size_t stride = pool_stride(pool);
+    size_t count = stride < POOL_SLAB_SIZE ? POOL_SLAB_SIZE / stride : 1;
+    uint8_t *slab = memalloc(count * stride);
+    size_t i;
+
+    pool->stats.allocated_bytes += count * stride;
+
+    /* Push them in reverse order, so that they are handed out in address order. */
+    for (i = count; i > 0; i--)
+    {
+        void *object = slab + (i - 1) * stride + sizeof(union pool_header);
+        pool_header(object)->pool = pool;
+#ifdef POOL_DEBUG
+        pool_poison(pool, object);
+#endif
+        *(void **)object = pool->free_list;
+        pool->free_list = object;
+    }
+}
+
+void *pool_alloc(struct pool *pool)
+{
+    void *ret;
+
+    if (!pool->registered)
+    {
+        pool->registered = true;
+        *pools_tail = pool;
+        pools_tail = &pool->next;
+    }
+
+    if (pool->free_list == NULL)
+    {
+        pool_grow(pool);
+    }
+
+    memalloc_count++;
+
+    ret = pool->free_list;
+#ifdef POOL_DEBUG
+    pool_check_poison(pool, ret);
+#endif
+    pool->free_list = *(void **)ret;
+    pool_header(ret)->pool = pool;
+    memset(ret, 0, pool->size);
+
+    pool->stats.live++;
+    if (pool->stats.live > pool->stats.peak)
+    {
+        pool->stats.peak = pool->stats.live;
+    }
+    return ret;
+}
+
+void pool_free(void *object)
+{
+    struct pool *pool;
+
+    if (object == NULL)
+    {
+        return;
+    }
+
+    pool = pool_header(object)->pool;
+#ifdef POOL_DEBUG
+    if (pool == POOL_FREED)
+    {
+        PLATFORM_PRINTF_DEBUG_ERROR("Pool: object %p deleted twice\n", object);
+        abort();
+    }
+    pool_poison(pool, object);
+#endif
+    *(void **)object = pool->free_list;
+    pool->free_list = object;
+    pool->stats.live--;
+}
+
+struct pool *pool_get_sized(size_t size)
+{
+    size_t rounded = size == 0 ? POOL_SIZED_GRANULARITY :
+                     (size + POOL_SIZED_GRANULARITY - 1) / POOL_SIZED_GRANULARITY * POOL_SIZED_GRANULARITY;
+    struct sized_pool **slot;
+    struct sized_pool *sized;
+
+    if (rounded <= POOL_SIZED_MAX)
+    {
+        slot = &sized_pools[rounded / POOL_SIZED_GRANULARITY - 1];
+    }
+    else
+    {
+        slot = &sized_pools[ARRAY_SIZE(sized_pools) - 1];
+    }
+
+    for (sized = *slot; sized != NULL; sized = sized->next)
+    {
+        if (sized->pool.size == rounded)
+        {
+            return &sized->pool;
+        }
+    }
+
+    sized = zmemalloc(sizeof(*sized));
+    snprintf(sized->name, sizeof(sized->name), "size-%u", (unsigned)rounded);
+    sized->pool.name = sized->name;
+    sized->pool.size = rounded;
+    sized->next = *slot;
+    *slot = sized;
+    return &sized->pool;
+}
+
+void pool_for_each(void (*callback)(const struct pool *pool, void *ctx), void *ctx)
+{
+    struct pool *pool;
+
+    for (pool = pools; pool != NULL; pool = pool->next)
+    {
+        callback(pool, ctx);
+    }
+}
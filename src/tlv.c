@@ -49,28 +49,121 @@ bool tlv_struct_parse_field(struct tlv_struct *item, const struct tlv_struct_fie
     }
 }
 
+/* The fields of a TLV (sub)structure are always serialised in full, so their total length is known from the
+ * description alone. Both parse and forge check it once against the remaining buffer, after which the fields are
+ * copied without checking the remaining length each time.
+ */
+static size_t tlv_struct_fields_length(const struct tlv_struct_description *desc)
+{
+    size_t length = 0;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(desc->fields) && desc->fields[i].name != NULL; i++)
+    {
+        length += desc->fields[i].size;
+    }
+    return length;
+}
+
+/* Minimal serialised length of a TLV (sub)structure: its fields plus one count byte per list of children (which may
+ * be empty). Returns 0 if it can't be known because the serialisation is overridden by a virtual function.
+ */
+static size_t tlv_struct_min_length(const struct tlv_struct_description *desc)
+{
+    size_t length;
+    size_t i;
+
+    if (desc->length != NULL)
+        return 0;
+
+    length = tlv_struct_fields_length(desc);
+    for (i = 0; i < ARRAY_SIZE(desc->children) && desc->children[i] != NULL; i++)
+    {
+        length += 1;
+    }
+    return length;
+}
+
+static void tlv_struct_parse_fields(struct tlv_struct *item, const uint8_t **buffer)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(item->desc->fields) && item->desc->fields[i].name != NULL; i++)
+    {
+        const struct tlv_struct_field_description *desc = &item->desc->fields[i];
+        char *pfield = (char*)item + desc->offset;
+        switch (desc->size)
+        {
+            case 1:
+                _E1B(buffer, (uint8_t*)pfield);
+                break;
+            case 2:
+                _E2B(buffer, (uint16_t*)pfield);
+                break;
+            case 4:
+                _E4B(buffer, (uint32_t*)pfield);
+                break;
+            default:
+                _EnB(buffer, pfield, desc->size);
+                break;
+        }
+    }
+}
+
+static void tlv_struct_forge_fields(const struct tlv_struct *item, uint8_t **buffer)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(item->desc->fields) && item->desc->fields[i].name != NULL; i++)
+    {
+        const struct tlv_struct_field_description *desc = &item->desc->fields[i];
+        const char *pfield = (const char*)item + desc->offset;
+        switch (desc->size)
+        {
+            case 1:
+                _I1B((const uint8_t*)pfield, buffer);
+                break;
+            case 2:
+                _I2B((const uint16_t*)pfield, buffer);
+                break;
+            case 4:
+                _I4B((const uint32_t*)pfield, buffer);
+                break;
+            default:
+                _InB(pfield, buffer, desc->size);
+                break;
+        }
+    }
+}
+
 static struct tlv_struct *tlv_struct_parse_single(const struct tlv_struct_description *desc, dlist_head *parent,
                                                   const uint8_t **buffer, size_t *length)
 {
+    struct tlv_struct *item;
+    size_t fields_length;
     size_t i;
 
     if (desc->parse != NULL)
         return desc->parse(desc, parent, buffer, length);
 
-    struct tlv_struct *item = container_of(hlist_alloc(desc->size, parent), struct tlv_struct, h);
+    fields_length = tlv_struct_fields_length(desc);
+    if (*length < fields_length)
+        return NULL;
+
+    item = container_of(hlist_alloc(desc->size, parent), struct tlv_struct, h);
     item->desc = desc;
-    for (i = 0; i < ARRAY_SIZE(item->desc->fields) && item->desc->fields[i].name != NULL; i++)
-    {
-        if (!tlv_struct_parse_field(item, &item->desc->fields[i], buffer, length))
-            goto err_out;
-    }
+    tlv_struct_parse_fields(item, buffer);
+    *length -= fields_length;
+
     for (i = 0; i < ARRAY_SIZE(item->h.children) && item->desc->children[i] != NULL; i++)
     {
-        tlv_struct_parse_list(item->desc->children[i], &item->h.children[i], buffer, length);
+        if (!tlv_struct_parse_list(item->desc->children[i], &item->h.children[i], buffer, length))
+            goto err_out;
     }
     return item;
 
 err_out:
+    dlist_remove(&item->h.l);
     hlist_delete_item(&item->h);
     return NULL;
 }
@@ -81,7 +174,13 @@ bool tlv_struct_parse_list(const struct tlv_struct_description *desc, dlist_head
     uint8_t children_nr;
     uint8_t j;
 
-    _E1BL(buffer, &children_nr, length);
+    if (!_E1BL(buffer, &children_nr, length))
+        return false;
+
+    /* Reject a count that can't possibly fit before allocating anything. */
+    if ((size_t)children_nr * tlv_struct_min_length(desc) > *length)
+        return false;
+
     for (j = 0; j < children_nr; j++)
     {
         const struct tlv_struct *child = tlv_struct_parse_single(desc, parent, buffer, length);
@@ -117,7 +216,7 @@ bool tlv_parse(tlv_defs_t defs, dlist_head *tlvs, const uint8_t *buffer, size_t
             struct tlv_unknown *tlv;
             PLATFORM_PRINTF_DEBUG_WARNING("Unknown TLV type %u of length %u\n",
                                           (unsigned)tlv_type, (unsigned)tlv_length);
-            tlv = memalloc(sizeof(struct tlv_unknown));
+            tlv = container_of(hlist_alloc(sizeof(struct tlv_unknown), NULL), struct tlv_unknown, tlv.s.h);
             tlv->value = memalloc(tlv_length);
             tlv->length = tlv_length_uint16;
             memcpy(tlv->value, buffer, tlv_length);
@@ -128,10 +227,20 @@ bool tlv_parse(tlv_defs_t defs, dlist_head *tlvs, const uint8_t *buffer, size_t
             /* Special case for 0-length TLVs */
             if (tlv_length == 0)
             {
-                tlv_new = memalloc(sizeof(struct tlv));
+                tlv_new = container_of(hlist_alloc(sizeof(struct tlv), NULL), struct tlv, s.h);
             }
             else
             {
+                /* Check the declared length once against what the description needs at least, so that the
+                 * structure parsers only have to check the variable parts. */
+                size_t min_length = tlv_struct_min_length(&tlv_def->desc);
+                if (tlv_length < min_length)
+                {
+                    PLATFORM_PRINTF_DEBUG_ERROR("TLV %s of length %u but at least %u bytes needed\n",
+                                                tlv_def->desc.name, (unsigned)tlv_length, (unsigned)min_length);
+                    goto err_out;
+                }
+
                 /* @todo clean this up */
                 length -= tlv_length;
                 struct tlv_struct *tlv_new_item = tlv_struct_parse_single(&tlv_def->desc, NULL, &buffer, &tlv_length);
@@ -189,18 +298,21 @@ bool tlv_struct_forge_field(const struct tlv_struct *item, const struct tlv_stru
 
 static bool tlv_struct_forge_single(const struct tlv_struct *item, uint8_t **buffer, size_t *length)
 {
+    size_t fields_length;
     size_t i;
     if (item->desc->forge != NULL)
         return item->desc->forge(item, buffer, length);
 
-    for (i = 0; i < ARRAY_SIZE(item->desc->fields) && item->desc->fields[i].name != NULL; i++)
-    {
-        if (!tlv_struct_forge_field(item, &item->desc->fields[i], buffer, length))
-            return false;
-    }
+    fields_length = tlv_struct_fields_length(item->desc);
+    if (*length < fields_length)
+        return false;
+    tlv_struct_forge_fields(item, buffer);
+    *length -= fields_length;
+
     for (i = 0; i < ARRAY_SIZE(item->h.children) && item->desc->children[i] != NULL; i++)
     {
-        tlv_struct_forge_list(&item->h.children[i], buffer, length);
+        if (!tlv_struct_forge_list(&item->h.children[i], buffer, length))
+            return false;
     }
     return true;
 }
@@ -216,7 +328,8 @@ bool tlv_struct_forge_list(const dlist_head *parent, uint8_t **buffer, size_t *l
         return false;
     }
     children_nr_uint8 = (uint8_t)children_nr;
-    _I1BL(&children_nr_uint8, buffer, length);
+    if (!_I1BL(&children_nr_uint8, buffer, length))
+        return false;
     hlist_for_each(child, *parent, const struct tlv_struct, h)
     {
         if (!tlv_struct_forge_single(child, buffer, length))
@@ -0,0 +1,85 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _TOPOLOGY_SNAPSHOT_H_
+#define _TOPOLOGY_SNAPSHOT_H_
+
+#include <platform.h>
+
+// The AL entity can save its view of the network to a file, so that after a
+// restart it doesn't have to wait for the whole network to be rediscovered
+// before it can answer queries about it.
+//
+// The file contains:
+//
+//   - The data model graph (devices, interfaces, links and radios), in the
+//     layout described in "datamodel_shm.h".
+//
+//   - The "devices" database of "al_datamodel.h" (including the last link
+//     metrics), as a sequence of forged TLVs (see "DMnetworkDevicesSave()").
+//
+// ...preceded by a small versioned header with a checksum of both sections.
+//
+// Everything that is restored from the file is marked as "stale" and
+// revalidated in the background: stale devices are queried again as soon as
+// they are discovered, and they are removed by the garbage collector if they
+// don't show up.
+
+// Snapshots older than this (in seconds) are not loaded: the network has
+// probably changed too much since then for them to be of any use.
+//
+#define TOPOLOGY_SNAPSHOT_MAX_AGE  (600)
+
+// Period (in milliseconds) with which the snapshot is saved while the AL
+// entity runs. It is also saved when the AL entity terminates.
+//
+#define TOPOLOGY_SNAPSHOT_PERIOD   (120000)
+
+// Set the file where the snapshot is saved/loaded.
+//
+// If this function is never called (or called with NULL), snapshots are
+// disabled and the other functions in this file do nothing.
+//
+void topologySnapshotPathSet(const char *path);
+
+// Return the file set with "topologySnapshotPathSet()", or NULL if snapshots
+// are disabled.
+//
+const char *topologySnapshotPathGet(void);
+
+// Load the snapshot (if there is a valid and recent enough one) into the data
+// model.
+//
+// Must be called once the local device and its interfaces have been added to
+// the data model, so that the links between them and the restored devices can
+// be recreated.
+//
+// Returns "0" if nothing was loaded, "1" otherwise.
+//
+uint8_t topologySnapshotLoad(void);
+
+// Save the current data model to the snapshot file.
+//
+// The file is replaced atomically: it is either the previous snapshot or the
+// new one, even if the AL entity (or the whole device) dies in the middle.
+//
+// Returns "0" if there was a problem, "1" otherwise.
+//
+uint8_t topologySnapshotSave(void);
+
+#endif
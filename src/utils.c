@@ -29,6 +29,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 //
 
+unsigned long memalloc_count = 0;
+
 void copyLengthString(uint8_t *dest, uint8_t *length, const char *src, size_t size)
 {
     size_t src_len = strlen(src);
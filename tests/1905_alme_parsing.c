@@ -28,12 +28,12 @@
 #include "1905_alme.h"
 #include "1905_alme_test_vectors.h"
 
-uint8_t _check(const char *test_description, uint8_t *input, uint8_t *expected_output)
+uint8_t _check(const char *test_description, uint8_t *input, uint16_t input_len, uint8_t *expected_output)
 {
     uint8_t  result;
     uint8_t *real_output;
 
-    real_output = parse_1905_ALME_from_packet(input);
+    real_output = parse_1905_ALME_from_packet(input, input_len);
 
     if (0 == compare_1905_ALME_structures(real_output, expected_output))
     {
@@ -59,79 +59,79 @@ int main(void)
     uint8_t result = 0;
 
     #define x1905ALMEPARSE001 "x1905ALMEPARSE001 - Parse ALME-GET-INTF-LIST.request (x1905_alme_structure_001)"
-    result += _check(x1905ALMEPARSE001, x1905_alme_stream_001, (uint8_t *)&x1905_alme_structure_001);
+    result += _check(x1905ALMEPARSE001, x1905_alme_stream_001, x1905_alme_stream_len_001, (uint8_t *)&x1905_alme_structure_001);
 
     #define x1905ALMEPARSE002 "x1905ALMEPARSE002 - Parse ALME-GET-INTF-LIST.response (x1905_alme_structure_002)"
-    result += _check(x1905ALMEPARSE002, x1905_alme_stream_002, (uint8_t *)&x1905_alme_structure_002);
+    result += _check(x1905ALMEPARSE002, x1905_alme_stream_002, x1905_alme_stream_len_002, (uint8_t *)&x1905_alme_structure_002);
 
     #define x1905ALMEPARSE003 "x1905ALMEPARSE003 - Parse ALME-GET-INTF-LIST.response (x1905_alme_structure_003)"
-    result += _check(x1905ALMEPARSE003, x1905_alme_stream_003, (uint8_t *)&x1905_alme_structure_003);
+    result += _check(x1905ALMEPARSE003, x1905_alme_stream_003, x1905_alme_stream_len_003, (uint8_t *)&x1905_alme_structure_003);
 
     #define x1905ALMEPARSE004 "x1905ALMEPARSE004 - Parse ALME-GET-INTF-LIST.response (x1905_alme_structure_004)"
-    result += _check(x1905ALMEPARSE004, x1905_alme_stream_004, (uint8_t *)&x1905_alme_structure_004);
+    result += _check(x1905ALMEPARSE004, x1905_alme_stream_004, x1905_alme_stream_len_004, (uint8_t *)&x1905_alme_structure_004);
 
     #define x1905ALMEPARSE005 "x1905ALMEPARSE005 - Parse ALME-SET-INTF-PWR-STATE.request (x1905_alme_structure_005)"
-    result += _check(x1905ALMEPARSE005, x1905_alme_stream_005, (uint8_t *)&x1905_alme_structure_005);
+    result += _check(x1905ALMEPARSE005, x1905_alme_stream_005, x1905_alme_stream_len_005, (uint8_t *)&x1905_alme_structure_005);
 
     #define x1905ALMEPARSE006 "x1905ALMEPARSE006 - Parse ALME-SET-INTF-PWR-STATE.request (x1905_alme_structure_006)"
-    result += _check(x1905ALMEPARSE006, x1905_alme_stream_006, (uint8_t *)&x1905_alme_structure_006);
+    result += _check(x1905ALMEPARSE006, x1905_alme_stream_006, x1905_alme_stream_len_006, (uint8_t *)&x1905_alme_structure_006);
 
     #define x1905ALMEPARSE007 "x1905ALMEPARSE007 - Parse ALME-SET-INTF-PWR-STATE.confirm (x1905_alme_structure_007)"
-    result += _check(x1905ALMEPARSE007, x1905_alme_stream_007, (uint8_t *)&x1905_alme_structure_007);
+    result += _check(x1905ALMEPARSE007, x1905_alme_stream_007, x1905_alme_stream_len_007, (uint8_t *)&x1905_alme_structure_007);
 
     #define x1905ALMEPARSE008 "x1905ALMEPARSE008 - Parse ALME-SET-INTF-PWR-STATE.confirm (x1905_alme_structure_008)"
-    result += _check(x1905ALMEPARSE008, x1905_alme_stream_008, (uint8_t *)&x1905_alme_structure_008);
+    result += _check(x1905ALMEPARSE008, x1905_alme_stream_008, x1905_alme_stream_len_008, (uint8_t *)&x1905_alme_structure_008);
 
     #define x1905ALMEPARSE009 "x1905ALMEPARSE009 - Parse ALME-GET-INTF-PWR-STATE.request (x1905_alme_structure_009)"
-    result += _check(x1905ALMEPARSE009, x1905_alme_stream_009, (uint8_t *)&x1905_alme_structure_009);
+    result += _check(x1905ALMEPARSE009, x1905_alme_stream_009, x1905_alme_stream_len_009, (uint8_t *)&x1905_alme_structure_009);
 
     #define x1905ALMEPARSE010 "x1905ALMEPARSE010 - Parse ALME-GET-INTF-PWR-STATE.response (x1905_alme_structure_010)"
-    result += _check(x1905ALMEPARSE010, x1905_alme_stream_010, (uint8_t *)&x1905_alme_structure_010);
+    result += _check(x1905ALMEPARSE010, x1905_alme_stream_010, x1905_alme_stream_len_010, (uint8_t *)&x1905_alme_structure_010);
 
     #define x1905ALMEPARSE011 "x1905ALMEPARSE011 - Parse ALME-SET-FWD-RULE.request (x1905_alme_structure_011)"
-    result += _check(x1905ALMEPARSE011, x1905_alme_stream_011, (uint8_t *)&x1905_alme_structure_011);
+    result += _check(x1905ALMEPARSE011, x1905_alme_stream_011, x1905_alme_stream_len_011, (uint8_t *)&x1905_alme_structure_011);
 
     #define x1905ALMEPARSE012 "x1905ALMEPARSE012 - Parse ALME-SET-FWD-RULE.request (x1905_alme_structure_012)"
-    result += _check(x1905ALMEPARSE012, x1905_alme_stream_012, (uint8_t *)&x1905_alme_structure_012);
+    result += _check(x1905ALMEPARSE012, x1905_alme_stream_012, x1905_alme_stream_len_012, (uint8_t *)&x1905_alme_structure_012);
 
     #define x1905ALMEPARSE013 "x1905ALMEPARSE013 - Parse ALME-SET-FWD-RULE.confirm (x1905_alme_structure_013)"
-    result += _check(x1905ALMEPARSE013, x1905_alme_stream_013, (uint8_t *)&x1905_alme_structure_013);
+    result += _check(x1905ALMEPARSE013, x1905_alme_stream_013, x1905_alme_stream_len_013, (uint8_t *)&x1905_alme_structure_013);
 
     #define x1905ALMEPARSE014 "x1905ALMEPARSE014 - Parse ALME-GET-FWD-RULES.request (x1905_alme_structure_014)"
-    result += _check(x1905ALMEPARSE014, x1905_alme_stream_014, (uint8_t *)&x1905_alme_structure_014);
+    result += _check(x1905ALMEPARSE014, x1905_alme_stream_014, x1905_alme_stream_len_014, (uint8_t *)&x1905_alme_structure_014);
 
     #define x1905ALMEPARSE015 "x1905ALMEPARSE015 - Parse ALME-GET-FWD-RULES.response (x1905_alme_structure_015)"
-    result += _check(x1905ALMEPARSE015, x1905_alme_stream_015, (uint8_t *)&x1905_alme_structure_015);
+    result += _check(x1905ALMEPARSE015, x1905_alme_stream_015, x1905_alme_stream_len_015, (uint8_t *)&x1905_alme_structure_015);
 
     #define x1905ALMEPARSE016 "x1905ALMEPARSE016 - Parse ALME-GET-FWD-RULES.response (x1905_alme_structure_016)"
-    result += _check(x1905ALMEPARSE016, x1905_alme_stream_016, (uint8_t *)&x1905_alme_structure_016);
+    result += _check(x1905ALMEPARSE016, x1905_alme_stream_016, x1905_alme_stream_len_016, (uint8_t *)&x1905_alme_structure_016);
 
     #define x1905ALMEPARSE017 "x1905ALMEPARSE017 - Parse ALME-GET-FWD-RULES.response (x1905_alme_structure_017)"
-    result += _check(x1905ALMEPARSE017, x1905_alme_stream_017, (uint8_t *)&x1905_alme_structure_017);
+    result += _check(x1905ALMEPARSE017, x1905_alme_stream_017, x1905_alme_stream_len_017, (uint8_t *)&x1905_alme_structure_017);
 
     #define x1905ALMEPARSE018 "x1905ALMEPARSE018 - Parse ALME-MODIFY-FWD-RULE.request (x1905_alme_structure_018)"
-    result += _check(x1905ALMEPARSE018, x1905_alme_stream_018, (uint8_t *)&x1905_alme_structure_018);
+    result += _check(x1905ALMEPARSE018, x1905_alme_stream_018, x1905_alme_stream_len_018, (uint8_t *)&x1905_alme_structure_018);
 
     #define x1905ALMEPARSE019 "x1905ALMEPARSE019 - Parse ALME-MODIFY-FWD-RULE.confirm (x1905_alme_structure_019)"
-    result += _check(x1905ALMEPARSE019, x1905_alme_stream_019, (uint8_t *)&x1905_alme_structure_019);
+    result += _check(x1905ALMEPARSE019, x1905_alme_stream_019, x1905_alme_stream_len_019, (uint8_t *)&x1905_alme_structure_019);
 
     #define x1905ALMEPARSE020 "x1905ALMEPARSE020 - Parse ALME-MODIFY-FWD-RULE.confirm (x1905_alme_structure_020)"
-    result += _check(x1905ALMEPARSE020, x1905_alme_stream_020, (uint8_t *)&x1905_alme_structure_020);
+    result += _check(x1905ALMEPARSE020, x1905_alme_stream_020, x1905_alme_stream_len_020, (uint8_t *)&x1905_alme_structure_020);
 
     #define x1905ALMEPARSE021 "x1905ALMEPARSE021 - Parse ALME-REMOVE-FWD-RULE.request (x1905_alme_structure_021)"
-    result += _check(x1905ALMEPARSE021, x1905_alme_stream_021, (uint8_t *)&x1905_alme_structure_021);
+    result += _check(x1905ALMEPARSE021, x1905_alme_stream_021, x1905_alme_stream_len_021, (uint8_t *)&x1905_alme_structure_021);
 
     #define x1905ALMEPARSE022 "x1905ALMEPARSE022 - Parse ALME-REMOVE-FWD-RULE.confirm (x1905_alme_structure_022)"
-    result += _check(x1905ALMEPARSE022, x1905_alme_stream_022, (uint8_t *)&x1905_alme_structure_022);
+    result += _check(x1905ALMEPARSE022, x1905_alme_stream_022, x1905_alme_stream_len_022, (uint8_t *)&x1905_alme_structure_022);
 
     #define x1905ALMEPARSE023 "x1905ALMEPARSE023 - Parse ALME-GET-METRIC.request (x1905_alme_structure_023)"
-    result += _check(x1905ALMEPARSE023, x1905_alme_stream_023, (uint8_t *)&x1905_alme_structure_023);
+    result += _check(x1905ALMEPARSE023, x1905_alme_stream_023, x1905_alme_stream_len_023, (uint8_t *)&x1905_alme_structure_023);
 
     #define x1905ALMEPARSE024 "x1905ALMEPARSE024 - Parse ALME-GET-METRIC.response (x1905_alme_structure_024)"
-    result += _check(x1905ALMEPARSE024, x1905_alme_stream_024, (uint8_t *)&x1905_alme_structure_024);
+    result += _check(x1905ALMEPARSE024, x1905_alme_stream_024, x1905_alme_stream_len_024, (uint8_t *)&x1905_alme_structure_024);
 
     #define x1905ALMEPARSE025 "x1905ALMEPARSE025 - Parse ALME-GET-METRIC.response (x1905_alme_structure_025)"
-    result += _check(x1905ALMEPARSE025, x1905_alme_stream_025, (uint8_t *)&x1905_alme_structure_025);
+    result += _check(x1905ALMEPARSE025, x1905_alme_stream_025, x1905_alme_stream_len_025, (uint8_t *)&x1905_alme_structure_025);
 
 
     // Return the number of test cases that failed
@@ -17,8 +17,9 @@
  */
 
 //
-// This file tests the "parse_1905_CMDU_from_packets()" function by providing
-// some test input streams and checking the generated output structure.
+// This file tests the "parse_1905_CMDU_from_packets()" and
+// "parse_1905_CMDU_view_from_packets()" functions by providing some test input
+// streams and checking the generated output structure.
 //
 
 #include "platform.h"
@@ -30,6 +31,48 @@
 
 #include <string.h> // memcmp
 
+// Check that the TLV index of 'c' (and the lookup without index) agree with
+// 'expected_output'
+//
+static int check_1905_cmdu_index(struct CMDU *c, struct CMDU *expected_output)
+{
+    int result = 0;
+    uint16_t expected_count[TLV_TYPE_NUM];
+    unsigned pass;
+    unsigned i;
+
+    for (pass = 0; pass < 2; pass++)
+    {
+        memset(expected_count, 0, sizeof(expected_count));
+        for (i = 0; NULL != expected_output->list_of_TLVs[i]; i++)
+        {
+            uint8_t type = expected_output->list_of_TLVs[i]->type;
+
+            if (get_1905_CMDU_TLV(c, type, expected_count[type]) != c->list_of_TLVs[i])
+            {
+                PLATFORM_PRINTF("  TLV %u not found%s\n", i, pass ? " without index" : "");
+                result = 1;
+            }
+            expected_count[type]++;
+        }
+        for (i = 0; i < TLV_TYPE_NUM; i++)
+        {
+            if (count_1905_CMDU_TLVs(c, i) != expected_count[i] || NULL != get_1905_CMDU_TLV(c, i, expected_count[i]))
+            {
+                PLATFORM_PRINTF("  Wrong number of TLVs of type %u%s\n", i, pass ? " without index" : "");
+                result = 1;
+            }
+        }
+
+        // Second pass: same thing, for a CMDU that is not indexed
+        //
+        free(c->tlv_index);
+        c->tlv_index = NULL;
+    }
+
+    return result;
+}
+
 static int check_parse_1905_cmdu(const char *test_description, uint8_t **input, struct CMDU *expected_output)
 {
     int result;
@@ -37,7 +80,8 @@ static int check_parse_1905_cmdu(const char *test_description, uint8_t **input,
 
     real_output = parse_1905_CMDU_from_packets(input);
 
-    if (0 == compare_1905_CMDU_structures(real_output, expected_output))
+    if (0 == compare_1905_CMDU_structures(real_output, expected_output) &&
+        (NULL == real_output || 0 == check_1905_cmdu_index(real_output, expected_output)))
     {
         result = 0;
         PLATFORM_PRINTF("%-100s: OK\n", test_description);
@@ -55,6 +99,75 @@ static int check_parse_1905_cmdu(const char *test_description, uint8_t **input,
     return result;
 }
 
+static int check_parse_1905_cmdu_view(const char *test_description, uint8_t **input, struct CMDU *expected_output)
+{
+    int result = 0;
+    struct CMDU_view *view;
+    uint16_t expected_count[TLV_TYPE_NUM];
+    unsigned i;
+
+    view = parse_1905_CMDU_view_from_packets(input);
+    if (NULL == view)
+    {
+        PLATFORM_PRINTF("%-100s: KO !!!\n", test_description);
+        PLATFORM_PRINTF("  Could not parse view\n");
+        return 1;
+    }
+
+    if (view->message_version != expected_output->message_version ||
+        view->message_type    != expected_output->message_type    ||
+        view->message_id      != expected_output->message_id      ||
+        view->relay_indicator != expected_output->relay_indicator)
+    {
+        PLATFORM_PRINTF("  Header mismatch\n");
+        result = 1;
+    }
+
+    // Each TLV must be found at its position among the TLVs of the same type,
+    // both raw and decoded
+    //
+    memset(expected_count, 0, sizeof(expected_count));
+    for (i = 0; NULL != expected_output->list_of_TLVs[i]; i++)
+    {
+        struct tlv *expected_tlv = expected_output->list_of_TLVs[i];
+        struct tlv *decoded;
+        uint16_t    length;
+
+        if (NULL == get_1905_CMDU_view_TLV(view, expected_tlv->type, expected_count[expected_tlv->type], &length))
+        {
+            PLATFORM_PRINTF("  TLV %u not found\n", i);
+            result = 1;
+        }
+
+        decoded = decode_1905_CMDU_view_TLV(view, expected_tlv->type, expected_count[expected_tlv->type]);
+        if (NULL == decoded || 0 != compare_1905_TLV_structures(decoded, expected_tlv))
+        {
+            PLATFORM_PRINTF("  TLV %u decoded differently\n", i);
+            result = 1;
+        }
+        free_1905_TLV_structure(decoded);
+
+        expected_count[expected_tlv->type]++;
+    }
+
+    for (i = 0; i < TLV_TYPE_NUM; i++)
+    {
+        uint16_t length;
+
+        if (count_1905_CMDU_view_TLVs(view, i) != expected_count[i] ||
+            NULL != get_1905_CMDU_view_TLV(view, i, expected_count[i], &length))
+        {
+            PLATFORM_PRINTF("  Wrong number of TLVs of type %u\n", i);
+            result = 1;
+        }
+    }
+
+    free_1905_CMDU_view(view);
+
+    PLATFORM_PRINTF("%-100s: %s\n", test_description, 0 == result ? "OK" : "KO !!!");
+    return result;
+}
+
 static int check_parse_1905_cmdu_header(const char *test_description, uint8_t *input, size_t input_len,
                                         struct CMDU_header *expected_output)
 {
@@ -123,6 +236,15 @@ int main(void)
     #define x1905CMDUPARSE004 "x1905CMDUPARSE004 - Parse topology query CMDU (x1905_cmdu_streams_005)"
     result += check_parse_1905_cmdu(x1905CMDUPARSE004, x1905_cmdu_streams_005, &x1905_cmdu_structure_005);
 
+    #define x1905CMDUPARSEVIEW001 "x1905CMDUPARSEVIEW001 - Parse link metric query CMDU view (x1905_cmdu_streams_001)"
+    result += check_parse_1905_cmdu_view(x1905CMDUPARSEVIEW001, x1905_cmdu_streams_001, &x1905_cmdu_structure_001);
+
+    #define x1905CMDUPARSEVIEW002 "x1905CMDUPARSEVIEW002 - Parse link metric query CMDU view (x1905_cmdu_streams_004)"
+    result += check_parse_1905_cmdu_view(x1905CMDUPARSEVIEW002, x1905_cmdu_streams_004, &x1905_cmdu_structure_004);
+
+    #define x1905CMDUPARSEVIEW003 "x1905CMDUPARSEVIEW003 - Parse topology query CMDU view (x1905_cmdu_streams_005)"
+    result += check_parse_1905_cmdu_view(x1905CMDUPARSEVIEW003, x1905_cmdu_streams_005, &x1905_cmdu_structure_005);
+
     result += check_parse_1905_cmdu_header("x1905CMDUPARSEHDR001 - Parse CMDU packet last fragment",
                                            x1905_cmdu_packet_001, x1905_cmdu_packet_len_001, &x1905_cmdu_header_001);
 
@@ -28,14 +28,29 @@
 #include "1905_tlvs.h"
 #include "1905_tlv_test_vectors.h"
 
-static uint8_t _check(const char *test_description, const uint8_t *input, struct tlv *expected_output)
+static uint8_t _check(const char *test_description, const uint8_t *input, uint16_t input_len,
+                      struct tlv *expected_output)
 {
     uint8_t  result;
     struct tlv *real_output;
 
-    real_output = parse_1905_TLV_from_packet(input);
+    real_output = parse_1905_TLV_from_packet(input, input_len);
 
-    if (real_output == NULL)
+    if (expected_output == NULL)
+    {
+        if (real_output == NULL)
+        {
+            result = 0;
+            PLATFORM_PRINTF("Parse %-100s: OK\n", test_description);
+        }
+        else
+        {
+            result = 1;
+            PLATFORM_PRINTF("Parse %-100s: KO !!!\n", test_description);
+            PLATFORM_PRINTF("  Malformed stream was accepted\n");
+        }
+    }
+    else if (real_output == NULL)
     {
         result = 1;
         PLATFORM_PRINTF("Parse %-100s: KO !!!\n", test_description);
@@ -72,7 +87,8 @@ int main(void)
     hlist_for_each(t, test_vectors, struct x1905_tlv_test_vector, h)
     {
         if (t->parse)
-            result += _check(t->description, t->stream, container_of(t->h.children[0].next, struct tlv, s.h.l));
+            result += _check(t->description, t->stream, t->stream_len, dlist_empty(&t->h.children[0]) ? NULL :
+                             container_of(t->h.children[0].next, struct tlv, s.h.l));
     }
     // @todo currently the test vectors still point to statically allocated TLVs
     // hlist_delete(&test_vectors);
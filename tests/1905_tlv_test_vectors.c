@@ -629,182 +629,6 @@ static uint8_t x1905_tlv_stream_019[] =
 static uint16_t x1905_tlv_stream_len_019 = 4;
 
 
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 020 (TLV <--> packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct searchedRoleTLV x1905_tlv_structure_020 =
-{
-    .tlv.type                    = TLV_TYPE_SEARCHED_ROLE,
-    .role                        = IEEE80211_ROLE_REGISTRAR,
-};
-
-static uint8_t x1905_tlv_stream_020[] =
-{
-    0x0d,
-    0x00, 0x01,
-    0x00,
-};
-
-static uint16_t x1905_tlv_stream_len_020 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 021 (TLV <-- packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct searchedRoleTLV x1905_tlv_structure_021 =
-{
-    .tlv.type                    = TLV_TYPE_SEARCHED_ROLE,
-    .role                        = 0xff,
-};
-
-static uint8_t x1905_tlv_stream_021[] =
-{
-    0x0d,
-    0x00, 0x01,
-    0xff,
-};
-
-static uint16_t x1905_tlv_stream_len_021 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 022 (TLV <--> packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct autoconfigFreqBandTLV x1905_tlv_structure_022 =
-{
-    .tlv.type                    = TLV_TYPE_AUTOCONFIG_FREQ_BAND,
-    .freq_band                   = IEEE80211_FREQUENCY_BAND_2_4_GHZ,
-};
-
-static uint8_t x1905_tlv_stream_022[] =
-{
-    0x0e,
-    0x00, 0x01,
-    0x00,
-};
-
-static uint16_t x1905_tlv_stream_len_022 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 023 (TLV <-- packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct autoconfigFreqBandTLV x1905_tlv_structure_023 =
-{
-    .tlv.type                    = TLV_TYPE_AUTOCONFIG_FREQ_BAND,
-    .freq_band                   = 0x1a,
-};
-
-static uint8_t x1905_tlv_stream_023[] =
-{
-    0x0e,
-    0x00, 0x01,
-    0x1a,
-};
-
-static uint16_t x1905_tlv_stream_len_023 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 024 (TLV <--> packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct supportedRoleTLV x1905_tlv_structure_024 =
-{
-    .tlv.type                    = TLV_TYPE_SUPPORTED_ROLE,
-    .role                        = IEEE80211_ROLE_REGISTRAR,
-};
-
-static uint8_t x1905_tlv_stream_024[] =
-{
-    0x0f,
-    0x00, 0x01,
-    0x00,
-};
-
-static uint16_t x1905_tlv_stream_len_024 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 025 (TLV <-- packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct supportedRoleTLV x1905_tlv_structure_025 =
-{
-    .tlv.type                    = TLV_TYPE_SUPPORTED_ROLE,
-    .role                        = 0x02,
-};
-
-static uint8_t x1905_tlv_stream_025[] =
-{
-    0x0f,
-    0x00, 0x01,
-    0x02,
-};
-
-static uint16_t x1905_tlv_stream_len_025 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 026 (TLV <--> packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct supportedFreqBandTLV x1905_tlv_structure_026 =
-{
-    .tlv.type                    = TLV_TYPE_SUPPORTED_FREQ_BAND,
-    .freq_band                   = IEEE80211_FREQUENCY_BAND_5_GHZ,
-};
-
-static uint8_t x1905_tlv_stream_026[] =
-{
-    0x10,
-    0x00, 0x01,
-    0x01,
-};
-
-static uint16_t x1905_tlv_stream_len_026 = 4;
-
-
-////////////////////////////////////////////////////////////////////////////////
-////
-//// Test vector 027 (TLV <-- packet)
-////
-////////////////////////////////////////////////////////////////////////////////
-
-static struct supportedFreqBandTLV x1905_tlv_structure_027 =
-{
-    .tlv.type                    = TLV_TYPE_SUPPORTED_FREQ_BAND,
-    .freq_band                   = 0x07,
-};
-
-static uint8_t x1905_tlv_stream_027[] =
-{
-    0x10,
-    0x00, 0x01,
-    0x07,
-};
-
-static uint16_t x1905_tlv_stream_len_027 = 4;
-
-
 ////////////////////////////////////////////////////////////////////////////////
 ////
 //// Test vector 028 (TLV <--> packet)
@@ -1456,30 +1280,138 @@ void get_1905_tlv_test_vectors(dlist_head *test_vectors)
     mac_address local_mac_address = {0xff, 0xf2, 0x04, 0xfa, 0x00, 0xab};
     memcpy(mac_address_type->mac_address, local_mac_address, 6);
 
+    INIT_TEST_VECTOR("AL MAC address type TLV shorter than its fields",
+        0x01,
+        0x00, 0x03,
+        0x01, 0x02, 0xf2,
+    );
+    v->forge = false; /* Malformed */
+
+    INIT_TEST_VECTOR("AL MAC address type TLV longer than the received frame",
+        0x01,
+        0x00, 0x06,
+        0x01, 0x02, 0xf2,
+    );
+    v->forge = false; /* Malformed */
+
     ADD_TEST_VECTOR(010, "device information type TLV");
+    INIT_TEST_VECTOR("device information type TLV with more interfaces than fit in its length",
+        0x03,
+        0x00, 0x07,
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+        0xff,
+    );
+    v->forge = false; /* Malformed */
+
     ADD_TEST_VECTOR(011, "device bridging capability TLV");
     ADD_TEST_VECTOR(012, "device bridging capability TLV");
     ADD_TEST_VECTOR(013, "device bridging capability TLV");
     ADD_TEST_VECTOR(014, "non 1905 neighbor device list TLV");
     ADD_TEST_VECTOR(015, "non 1905 neighbor device list TLV");
+    INIT_TEST_VECTOR("non 1905 neighbor device list TLV without local MAC address",
+        0x06,
+        0x00, 0x00,
+    );
+    v->forge = false; /* Malformed */
+
     ADD_TEST_VECTOR(016, "neighbor device list TLV");
     ADD_TEST_VECTOR(017, "neighbor device list TLV");
     ADD_TEST_VECTOR(018, "link metric result code TLV");
     ADD_TEST_VECTOR(019, "link metric result code TLV");
     v->forge = false; /* Unknown result code, can't be forged. */
-    ADD_TEST_VECTOR(020, "searched role TLV");
-    ADD_TEST_VECTOR(021, "searched role TLV");
+
+    INIT_TEST_VECTOR("searched role TLV",
+        0x0d,
+        0x00, 0x01,
+        0x00,
+    );
+    struct searchedRoleTLV *searched_role =
+            X1905_TLV_ALLOC(searchedRole, TLV_TYPE_SEARCHED_ROLE, &v->h.children[0]);
+    searched_role->role = IEEE80211_ROLE_REGISTRAR;
+
+    INIT_TEST_VECTOR("searched role TLV with unknown role",
+        0x0d,
+        0x00, 0x01,
+        0xff,
+    );
+    searched_role = X1905_TLV_ALLOC(searchedRole, TLV_TYPE_SEARCHED_ROLE, &v->h.children[0]);
+    searched_role->role = 0xff;
     v->forge = false; /* Unknown role, can't be forged. */
-    ADD_TEST_VECTOR(022, "autoconfig freq band TLV");
-    ADD_TEST_VECTOR(023, "autoconfig freq band TLV");
+
+    INIT_TEST_VECTOR("autoconfig freq band TLV",
+        0x0e,
+        0x00, 0x01,
+        0x00,
+    );
+    struct autoconfigFreqBandTLV *autoconfig_freq_band =
+            X1905_TLV_ALLOC(autoconfigFreqBand, TLV_TYPE_AUTOCONFIG_FREQ_BAND, &v->h.children[0]);
+    autoconfig_freq_band->freq_band = IEEE80211_FREQUENCY_BAND_2_4_GHZ;
+
+    INIT_TEST_VECTOR("autoconfig freq band TLV with unknown freq band",
+        0x0e,
+        0x00, 0x01,
+        0x1a,
+    );
+    autoconfig_freq_band = X1905_TLV_ALLOC(autoconfigFreqBand, TLV_TYPE_AUTOCONFIG_FREQ_BAND, &v->h.children[0]);
+    autoconfig_freq_band->freq_band = 0x1a;
     v->forge = false; /* Unknown freq band, can't be forged. */
-    ADD_TEST_VECTOR(024, "supported role TLV");
-    ADD_TEST_VECTOR(025, "supported role TLV");
+
+    INIT_TEST_VECTOR("supported role TLV",
+        0x0f,
+        0x00, 0x01,
+        0x00,
+    );
+    struct supportedRoleTLV *supported_role =
+            X1905_TLV_ALLOC(supportedRole, TLV_TYPE_SUPPORTED_ROLE, &v->h.children[0]);
+    supported_role->role = IEEE80211_ROLE_REGISTRAR;
+
+    INIT_TEST_VECTOR("supported role TLV with unknown role",
+        0x0f,
+        0x00, 0x01,
+        0x02,
+    );
+    supported_role = X1905_TLV_ALLOC(supportedRole, TLV_TYPE_SUPPORTED_ROLE, &v->h.children[0]);
+    supported_role->role = 0x02;
     v->forge = false; /* Unknown role, can't be forged. */
-    ADD_TEST_VECTOR(026, "supported freq band TLV");
-    ADD_TEST_VECTOR(027, "supported freq band TLV");
+
+    INIT_TEST_VECTOR("supported freq band TLV",
+        0x10,
+        0x00, 0x01,
+        0x01,
+    );
+    struct supportedFreqBandTLV *supported_freq_band =
+            X1905_TLV_ALLOC(supportedFreqBand, TLV_TYPE_SUPPORTED_FREQ_BAND, &v->h.children[0]);
+    supported_freq_band->freq_band = IEEE80211_FREQUENCY_BAND_5_GHZ;
+
+    INIT_TEST_VECTOR("supported freq band TLV with unknown freq band",
+        0x10,
+        0x00, 0x01,
+        0x07,
+    );
+    supported_freq_band = X1905_TLV_ALLOC(supportedFreqBand, TLV_TYPE_SUPPORTED_FREQ_BAND, &v->h.children[0]);
+    supported_freq_band->freq_band = 0x07;
     v->forge = false; /* Unknown freq band, can't be forged. */
+
     ADD_TEST_VECTOR(028, "push button event notification TLV");
+
+    INIT_TEST_VECTOR("push button join notification TLV",
+        0x13,
+        0x00, 0x14,
+        0x02, 0xaa, 0xbb, 0xcc, 0xdd, 0x01,
+        0x12, 0x34,
+        0x02, 0xaa, 0xbb, 0xcc, 0xdd, 0x11,
+        0x00, 0x16, 0x03, 0x00, 0x00, 0x42,
+    );
+    struct pushButtonJoinNotificationTLV *push_button_join =
+            X1905_TLV_ALLOC(pushButtonJoinNotification, TLV_TYPE_PUSH_BUTTON_JOIN_NOTIFICATION, &v->h.children[0]);
+    mac_address pb_al_mac_address  = {0x02, 0xaa, 0xbb, 0xcc, 0xdd, 0x01};
+    mac_address pb_mac_address     = {0x02, 0xaa, 0xbb, 0xcc, 0xdd, 0x11};
+    mac_address pb_new_mac_address = {0x00, 0x16, 0x03, 0x00, 0x00, 0x42};
+    memcpy(push_button_join->al_mac_address, pb_al_mac_address, 6);
+    push_button_join->message_identifier = 0x1234;
+    memcpy(push_button_join->mac_address, pb_mac_address, 6);
+    memcpy(push_button_join->new_mac_address, pb_new_mac_address, 6);
+
     ADD_TEST_VECTOR(029, "power off interface TLV");
     ADD_TEST_VECTOR(030, "power off interface TLV");
     ADD_TEST_VECTOR(031, "generic PHY device information type TLV");
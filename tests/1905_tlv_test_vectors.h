@@ -22,6 +22,7 @@
 #include <hlist.h>
 #include <stdint.h>
 
+/* A test vector without a TLV structure (i.e. without children) holds a malformed stream, which must fail to parse. */
 struct x1905_tlv_test_vector {
     hlist_item h;
     const uint8_t *stream;
@@ -0,0 +1,155 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "1905_cmdus.h"
+#include "../src/al_cmdu_stats.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static char output[4096];
+static size_t output_len;
+
+static void write_output(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    output_len += vsnprintf(output + output_len, sizeof(output) - output_len, fmt, ap);
+    va_end(ap);
+}
+
+static void dump(void)
+{
+    output[0] = '\0';
+    output_len = 0;
+    cmduStatsDump(write_output);
+}
+
+/* Check that the line of type @a type contains @a expected. */
+static int check_line(const char *type, const char *expected)
+{
+    char key[32];
+    const char *line;
+    const char *end;
+
+    snprintf(key, sizeof(key), " type=%s ", type);
+    line = strstr(output, key);
+    if (line == NULL)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No line for type %s in:\n%s", type, output);
+        return 1;
+    }
+    end = strchr(line, '\n');
+    if (end == NULL || strstr(line, expected) == NULL || strstr(line, expected) > end)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Expected '%s' for type %s in:\n%s", expected, type, output);
+        return 1;
+    }
+    return 0;
+}
+
+/* Check whether the last dump contains @a text. */
+static int check_output(const char *text, bool expected)
+{
+    if ((NULL != strstr(output, text)) != expected)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Expected '%s' %sin:\n%s", text, expected ? "" : "not ", output);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_disabled(void)
+{
+    int ret = 0;
+
+    /* Nothing is recorded while disabled. */
+    cmduStatsSample(CMDU_TYPE_TOPOLOGY_QUERY, CMDU_STATS_STAGE_PARSE, 10);
+    cmduStatsFrame(CMDU_TYPE_TOPOLOGY_QUERY, CMDU_STATS_RX, 100);
+    if (0 != cmduStatsClock())
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("clock read while disabled\n");
+        ret++;
+    }
+
+    dump();
+    ret += check_output(" disabled\n", true);
+
+    return ret;
+}
+
+static int test_histogram(void)
+{
+    int ret = 0;
+    unsigned i;
+
+    cmduStatsPeriodSet(1000);
+
+    for (i = 1; i <= 100; i++)
+    {
+        cmduStatsSample(CMDU_TYPE_TOPOLOGY_RESPONSE, CMDU_STATS_STAGE_PARSE, i);
+    }
+    cmduStatsSample(CMDU_TYPE_TOPOLOGY_RESPONSE, CMDU_STATS_STAGE_PROCESS, 3000000);
+
+    dump();
+    ret += check_output("type=0x0002", false);
+
+    /* Percentiles are the upper bound of their bucket: 50 is in [48, 51], 90 in [88, 95], 99 in [96, 103]. */
+    ret += check_line("0x0003", " parse=100/51/95/100/100 ");
+    ret += check_line("0x0003", " process=1/3000000/3000000/3000000/3000000 ");
+    ret += check_line("0x0003", " queue=0/0/0/0/0 ");
+
+    return ret;
+}
+
+static int test_counters(void)
+{
+    int ret = 0;
+
+    cmduStatsFrame(CMDU_TYPE_TOPOLOGY_QUERY, CMDU_STATS_RX, 60);
+    cmduStatsFrame(CMDU_TYPE_TOPOLOGY_QUERY, CMDU_STATS_RX, 64);
+    cmduStatsFrame(CMDU_TYPE_TOPOLOGY_QUERY, CMDU_STATS_TX, 1500);
+    cmduStatsAllocations(CMDU_TYPE_TOPOLOGY_QUERY, 10);
+    cmduStatsAllocations(CMDU_TYPE_TOPOLOGY_QUERY, 20);
+    cmduStatsFrame(CMDU_STATS_TYPE_LLDP, CMDU_STATS_RX, 64);
+    cmduStatsFrame(0x8001, CMDU_STATS_TX, 100);
+
+    dump();
+    ret += check_line("0x0002", " rx_frames=2 rx_bytes=124 tx_frames=1 tx_bytes=1500 messages=2 allocs_avg=15 allocs_max=20 ");
+    ret += check_line("lldp", " rx_frames=1 rx_bytes=64 ");
+    ret += check_line("other", " tx_frames=1 tx_bytes=100 ");
+
+    return ret;
+}
+
+int main()
+{
+    int ret = 0;
+
+    PLATFORM_INIT();
+
+    ret += test_disabled();
+    ret += test_histogram();
+    ret += test_counters();
+
+    return ret;
+}
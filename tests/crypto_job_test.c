@@ -0,0 +1,251 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/* Asynchronous M2: an M1 received by the registrar is answered by a crypto job, whose completion arrives through the AL
+ * queue like in the AL entity. The M2 is checked by the enrollee, and a job that completes after the local device
+ * stopped being the registrar must be released without sending anything.
+ */
+
+#include "platform.h"
+#include "utils.h"
+#include "1905_cmdus.h"
+#include "1905_tlvs.h"
+#include <datamodel.h>
+#include "../src/al_datamodel.h"
+#include "../src/al_recv.h"
+#include "../src/al_wsc.h"
+#include "../src/platform_crypto.h"
+#include "../src/platform_os.h"
+#include "fake_platform.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const mac_address local_al_mac = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const mac_address local_if_mac = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const mac_address peer_al_mac  = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+static uint8_t queue_id;
+
+/* Jobs are freed by their 'done' callback. free() is replaced at link time (see "-Wl,--wrap" in CMakeLists.txt) to
+ * see it happen. */
+static void *watched_job;
+static bool  watched_job_freed;
+
+void __real_free(void *p);
+
+void __wrap_free(void *p)
+{
+    if (NULL != p && p == watched_job)
+    {
+        watched_job_freed = true;
+    }
+    __real_free(p);
+}
+
+static struct bssInfo configured_bss;
+static unsigned       configured_nr;
+
+static bool addAP(struct radio *radio, struct bssInfo bss_info)
+{
+    (void)radio;
+    configured_bss = bss_info;
+    configured_nr++;
+    return true;
+}
+
+/* Make the registrar receive an M1 built by @a radio, as the AL entity does. */
+static int receive_m1(struct radio *radio)
+{
+    struct wscTLV m1_tlv;
+    struct tlv   *tlvs[2] = {&m1_tlv.tlv, NULL};
+    struct CMDU   c;
+
+    if (!wscBuildM1(radio, &radio->device_data))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not build M1\n");
+        return 1;
+    }
+
+    memset(&m1_tlv, 0, sizeof(m1_tlv));
+    m1_tlv.tlv.type = TLV_TYPE_WSC;
+    m1_tlv.wsc_frame_size = radio->wsc_info->m1_len;
+    m1_tlv.wsc_frame = radio->wsc_info->m1;
+
+    memset(&c, 0, sizeof(c));
+    c.message_version = CMDU_MESSAGE_VERSION_1905_1_2013;
+    c.message_type = CMDU_TYPE_AP_AUTOCONFIGURATION_WSC;
+    c.message_id = 0x1234;
+    c.list_of_TLVs = tlvs;
+
+    sent_nr = 0;
+    process1905Cmdu(&c, (uint8_t *)local_if_mac, (uint8_t *)peer_al_mac, queue_id);
+    return 0;
+}
+
+/* Wait for the "job done" message of the crypto job and call its 'done' callback, as the AL entity does. */
+static int complete_job(void)
+{
+    uint8_t           message[3 + MAX_NETWORK_SEGMENT_SIZE];
+    struct cryptoJob *job;
+
+    if (0 == PLATFORM_READ_QUEUE(queue_id, message) || PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE != message[0] ||
+        sizeof(job) != ((message[1] << 8) | message[2]))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No crypto job completion in the queue\n");
+        return 1;
+    }
+    memcpy(&job, &message[3], sizeof(job));
+
+    watched_job = job;
+    watched_job_freed = false;
+    job->done(job);
+    drain();
+
+    if (!watched_job_freed)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Crypto job not freed when done\n");
+        watched_job = NULL;
+        return 1;
+    }
+    watched_job = NULL;
+    return 0;
+}
+
+/* Check that the last frame sent is an M2 that configures @a radio with @a expected. */
+static int check_m2(struct radio *radio, const struct bssInfo *expected)
+{
+    uint8_t     *streams[2] = {last_payload, NULL};
+    struct CMDU *c;
+    struct tlv  *p;
+    unsigned     i;
+    int          ret = 1;
+
+    c = parse_1905_CMDU_from_packets(streams);
+    if (NULL == c || CMDU_TYPE_AP_AUTOCONFIGURATION_WSC != c->message_type)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No WSC CMDU sent\n");
+        free_1905_CMDU_structure(c);
+        return 1;
+    }
+
+    configured_nr = 0;
+    for (i = 0; NULL != (p = c->list_of_TLVs[i]); i++)
+    {
+        if (TLV_TYPE_WSC == p->type)
+        {
+            struct wscTLV *m2_tlv = container_of(p, struct wscTLV, tlv);
+
+            if (WSC_TYPE_M2 == wscGetType(m2_tlv->wsc_frame, m2_tlv->wsc_frame_size) &&
+                wscProcessM2(radio, m2_tlv->wsc_frame, m2_tlv->wsc_frame_size) && 1 == configured_nr &&
+                configured_bss.ssid.length == expected->ssid.length &&
+                0 == memcmp(configured_bss.ssid.ssid, expected->ssid.ssid, expected->ssid.length))
+            {
+                ret = 0;
+            }
+            break;
+        }
+    }
+    if (0 != ret)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("M2 not accepted by the enrollee\n");
+    }
+
+    free_1905_CMDU_structure(c);
+    return ret;
+}
+
+static int test_m2(struct radio *radio, const struct bssInfo *expected)
+{
+    int ret = 0;
+
+    if (0 != receive_m1(radio))
+    {
+        return 1;
+    }
+    ret += complete_job();
+    ret += check_sent_nr(1);
+    ret += check_m2(radio, expected);
+
+    wscInfoFree(radio);
+    return ret;
+}
+
+static int test_registrar_gone(struct radio *radio)
+{
+    int ret = 0;
+
+    if (0 != receive_m1(radio))
+    {
+        return 1;
+    }
+
+    /* Another controller takes over while the M2 is being built. */
+    registrar.d = NULL;
+    ret += complete_job();
+    ret += check_sent_nr(0);
+    registrar.d = local_device;
+
+    wscInfoFree(radio);
+    return ret;
+}
+
+int main()
+{
+    struct wscRegistrarInfo *wsc_info;
+    struct interface        *interface;
+    struct alDevice         *peer;
+    struct radio            *radio;
+    int                      ret = 0;
+
+    DMinit();
+    DMalMacSet((uint8_t *)local_al_mac);
+    interface = interfaceAlloc(local_if_mac, local_device);
+    interface->name = "eth0";
+    interface->type = interface_type_ethernet;
+
+    wsc_info = zmemalloc(sizeof(*wsc_info));
+    memcpy(wsc_info->bss_info.bssid, local_al_mac, sizeof(mac_address));
+    wsc_info->bss_info.ssid.length = strlen("prplMesh");
+    memcpy(wsc_info->bss_info.ssid.ssid, "prplMesh", wsc_info->bss_info.ssid.length);
+    wsc_info->bss_info.auth_mode = auth_mode_wpa2psk;
+    wsc_info->bss_info.key_len = strlen("prplMeshKey");
+    memcpy(wsc_info->bss_info.key, "prplMeshKey", wsc_info->bss_info.key_len);
+    wsc_info->rf_bands = WPS_RF_24GHZ;
+    registrarAddWsc(wsc_info);
+    registrar.d = local_device;
+
+    peer = alDeviceAlloc(peer_al_mac);
+    radio = radioAlloc(peer, peer_al_mac);
+    radio->addAP = addAP;
+
+    queue_id = PLATFORM_CREATE_QUEUE("crypto_job_test");
+    if (0 == queue_id || 0 == PLATFORM_REGISTER_QUEUE_EVENT(queue_id, PLATFORM_QUEUE_EVENT_CRYPTO_JOB_DONE, NULL))
+    {
+        /* M2 messages are then built synchronously (see tests/wsc_test.c). */
+        PLATFORM_PRINTF("Crypto jobs not supported: skipped\n");
+        return 0;
+    }
+
+    ret += test_m2(radio, &wsc_info->bss_info);
+    ret += test_registrar_gone(radio);
+
+    return ret;
+}
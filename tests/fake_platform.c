@@ -0,0 +1,102 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fake_platform.h"
+
+#include "platform.h"
+#include "../src/al_requests.h"
+#include "../src/al_tx_scheduler.h"
+
+#include <string.h>
+
+uint32_t now_ms = 1000;
+
+struct sent_frame sent[SENT_FRAMES_MAX];
+unsigned sent_nr;
+
+uint8_t last_payload[MAX_NETWORK_SEGMENT_SIZE];
+uint16_t last_payload_len;
+
+uint32_t __wrap_PLATFORM_GET_TIMESTAMP(void)
+{
+    return now_ms;
+}
+
+uint8_t __wrap_PLATFORM_SEND_RAW_PACKET(const char *interface_name, const uint8_t *dst_mac, const uint8_t *src_mac,
+                                        uint16_t eth_type, const uint8_t *payload, uint16_t payload_len)
+{
+    (void)interface_name;
+    (void)src_mac;
+    (void)eth_type;
+    if (payload_len <= sizeof(last_payload))
+    {
+        memcpy(last_payload, payload, payload_len);
+        last_payload_len = payload_len;
+    }
+
+    if (sent_nr < SENT_FRAMES_MAX)
+    {
+        sent[sent_nr].dst = dst_mac[5];
+        sent[sent_nr].message_type = (payload[2] << 8) | payload[3];
+        sent[sent_nr].mid = (payload[4] << 8) | payload[5];
+    }
+    sent_nr++;
+    return 1;
+}
+
+void drain(void)
+{
+    uint32_t wait;
+    uint32_t tx_wait;
+
+    for (;;)
+    {
+        wait = requestTimeoutsRun();
+        tx_wait = txSchedulerRun();
+        if (0 == wait || (0 != tx_wait && tx_wait < wait))
+        {
+            wait = tx_wait;
+        }
+        if (0 == wait)
+        {
+            break;
+        }
+        now_ms += wait;
+    }
+}
+
+int check_sent_nr(unsigned expected_nr)
+{
+    if (sent_nr != expected_nr)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u frames sent but expected %u\n", sent_nr, expected_nr);
+        return 1;
+    }
+    return 0;
+}
+
+int check_sent(unsigned index, uint8_t dst, uint16_t message_type, uint16_t mid)
+{
+    if (index >= sent_nr || index >= SENT_FRAMES_MAX || sent[index].dst != dst ||
+        sent[index].message_type != message_type || sent[index].mid != mid)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Frame %u: expected type 0x%04x MID %u to %u\n", index, message_type, mid, dst);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef _FAKE_PLATFORM_H_
+#define _FAKE_PLATFORM_H_
+
+#include <platform.h> /* MAX_NETWORK_SEGMENT_SIZE */
+
+#include <stdint.h>
+
+/* Fake clock and transmissions for the unit tests of the AL timers and transmit path.
+ *
+ * Tests that use them are linked with "-Wl,--wrap=PLATFORM_SEND_RAW_PACKET -Wl,--wrap=PLATFORM_GET_TIMESTAMP" (see
+ * CMakeLists.txt): the clock only advances when the test changes @a now_ms, and the frames are recorded in @a sent
+ * instead of being transmitted.
+ */
+
+/** Current time returned by PLATFORM_GET_TIMESTAMP(). */
+extern uint32_t now_ms;
+
+struct sent_frame {
+    uint8_t dst;            /* Last byte of the destination MAC address */
+    uint16_t message_type;
+    uint16_t mid;
+};
+
+#define SENT_FRAMES_MAX (512)
+
+/** Frames sent since the test last reset @a sent_nr. @a sent_nr keeps counting beyond SENT_FRAMES_MAX, but only the
+ * first SENT_FRAMES_MAX frames are recorded. */
+extern struct sent_frame sent[SENT_FRAMES_MAX];
+extern unsigned sent_nr;
+
+/** Copy of the payload (starting with the CMDU header) of the last frame sent. */
+extern uint8_t last_payload[MAX_NETWORK_SEGMENT_SIZE];
+extern uint16_t last_payload_len;
+
+/** Let time pass until nothing is pending, running the request tracker and the transmit scheduler when they ask to. */
+void drain(void);
+
+/** Check that @a expected_nr frames were sent. If not, print a warning and return 1, else return 0. */
+int check_sent_nr(unsigned expected_nr);
+
+/** Check that frame @a index is of type @a message_type with MID @a mid and was sent to a MAC address ending in
+ * @a dst. If not, print a warning and return 1, else return 0. */
+int check_sent(unsigned index, uint8_t dst, uint16_t message_type, uint16_t mid);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "../src/al_link_metrics.h"
+#include "fake_platform.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The platform reads are replaced at link time (see "-Wl,--wrap" in CMakeLists.txt) and counted. */
+static unsigned reads_nr;
+
+struct linkMetrics *__wrap_PLATFORM_GET_LINK_METRICS(char *local_interface_name, uint8_t *neighbor_interface_address)
+{
+    struct linkMetrics *m;
+
+    (void)local_interface_name;
+
+    m = (struct linkMetrics *)calloc(1, sizeof(*m));
+    memcpy(m->neighbor_interface_address, neighbor_interface_address, 6);
+    m->tx_packet_ok = reads_nr;
+    reads_nr++;
+    return m;
+}
+
+static int check_reads(unsigned expected_reads)
+{
+    if (reads_nr != expected_reads)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u platform reads but expected %u\n", reads_nr, expected_reads);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_get(const uint8_t *neighbor)
+{
+    if (NULL == linkMetricsGet("eth0", neighbor))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("No metrics for neighbor %u\n", neighbor[5]);
+        return 1;
+    }
+    return 0;
+}
+
+/* A link asked for once per window is read at most once per window: the background refresh does not add a read. */
+static int test_polled_once(void)
+{
+    static const uint8_t neighbor[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    unsigned window;
+    int ret = 0;
+
+    reads_nr = 0;
+    for (window = 0; window < 10; window++)
+    {
+        unsigned before = reads_nr;
+
+        now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY / 2;
+        ret += check_get(neighbor);
+        now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY / 2;
+        linkMetricsCacheRefresh();
+
+        if (reads_nr - before > 1)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("%u platform reads in window %u\n", reads_nr - before, window);
+            ret++;
+        }
+    }
+
+    /* Forgotten once it is no longer asked for. */
+    now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY;
+    linkMetricsCacheRefresh();
+    reads_nr = 0;
+    ret += check_get(neighbor);
+    ret += check_reads(1);
+    now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY;
+    linkMetricsCacheRefresh();
+    linkMetricsCacheRefresh();
+
+    return ret;
+}
+
+/* A link asked for several times per window is refreshed in the background, and its requests never read the
+ * platform after the first one. */
+static int test_polled_often(void)
+{
+    static const uint8_t neighbor[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    struct linkMetricsCacheStats before;
+    struct linkMetricsCacheStats after;
+    unsigned window;
+    unsigned i;
+    int ret = 0;
+
+    reads_nr = 0;
+    linkMetricsCacheStatsGet(&before);
+    for (window = 0; window < 10; window++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY / 4;
+            ret += check_get(neighbor);
+        }
+        now_ms += LINK_METRICS_CACHE_DEFAULT_VALIDITY / 4;
+        linkMetricsCacheRefresh();
+    }
+    linkMetricsCacheStatsGet(&after);
+
+    /* The first request and one refresh per window. */
+    ret += check_reads(1 + 10);
+    if (after.misses - before.misses != 1 || after.refreshes - before.refreshes != 10)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u misses and %u refreshes but expected 1 and 10\n",
+                                      after.misses - before.misses, after.refreshes - before.refreshes);
+        ret++;
+    }
+
+    return ret;
+}
+
+int main()
+{
+    int ret = 0;
+
+    linkMetricsCacheValiditySet(LINK_METRICS_CACHE_DEFAULT_VALIDITY);
+
+    ret += test_polled_once();
+    ret += test_polled_often();
+
+    return ret;
+}
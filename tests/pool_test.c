@@ -0,0 +1,136 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <pool.h>
+#include "platform.h"
+#include "utils.h"
+#include <stdint.h>
+#include <string.h>
+
+struct ptest {
+    uint32_t data[5];
+};
+
+static DEFINE_POOL(ptest_pool, struct ptest);
+
+static int check_live(unsigned expected_live, unsigned expected_peak)
+{
+    if (ptest_pool.stats.live != expected_live || ptest_pool.stats.peak != expected_peak)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("pool live/peak %u/%u but expected %u/%u\n", (unsigned)ptest_pool.stats.live,
+                                      (unsigned)ptest_pool.stats.peak, expected_live, expected_peak);
+        return 1;
+    }
+    return 0;
+}
+
+static void count_pools(const struct pool *pool, void *ctx)
+{
+    if (pool == &ptest_pool)
+    {
+        (*(unsigned *)ctx)++;
+    }
+}
+
+int main()
+{
+    int ret = 0;
+    struct ptest *p1;
+    struct ptest *p2;
+    struct ptest *p3;
+    unsigned found = 0;
+    unsigned i;
+    size_t allocated_bytes;
+
+    p1 = pool_alloc(&ptest_pool);
+    if (((uintptr_t)p1 & 7) != 0)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("object %p not aligned\n", (void *)p1);
+        ret++;
+    }
+    memset(p1, 0xff, sizeof(*p1));
+    p2 = pool_alloc(&ptest_pool);
+    if (p2 == p1)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("same object allocated twice\n");
+        ret++;
+    }
+    ret += check_live(2, 2);
+    if (ptest_pool.stats.allocated_bytes == 0)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("no allocated bytes\n");
+        ret++;
+    }
+
+    /* The most recently freed object is reused first, and it is zeroed. */
+    pool_free(p1);
+    ret += check_live(1, 2);
+    p3 = pool_alloc(&ptest_pool);
+    if (p3 != p1)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("freed object not reused\n");
+        ret++;
+    }
+    for (i = 0; i < ARRAY_SIZE(p3->data); i++)
+    {
+        if (p3->data[i] != 0)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("reused object word %u is 0x%08x\n", i, p3->data[i]);
+            ret++;
+        }
+    }
+    pool_free(p2);
+    pool_free(p3);
+    pool_free(NULL);
+
+    /* Memory is allocated in slabs, not for each object. */
+    allocated_bytes = ptest_pool.stats.allocated_bytes;
+    p1 = pool_alloc(&ptest_pool);
+    p2 = pool_alloc(&ptest_pool);
+    if (ptest_pool.stats.allocated_bytes != allocated_bytes)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("slab not reused\n");
+        ret++;
+    }
+    pool_free(p1);
+    pool_free(p2);
+    ret += check_live(0, 2);
+
+    /* Similar sizes share a generic pool. */
+    if (pool_get_sized(20) != pool_get_sized(24) || pool_get_sized(20) == pool_get_sized(40))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("wrong sized pools for 20, 24 and 40 bytes\n");
+        ret++;
+    }
+    if (pool_get_sized(100000) != pool_get_sized(100000) || pool_get_sized(100000)->size < 100000)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("wrong sized pool for 100000 bytes\n");
+        ret++;
+    }
+    p1 = pool_alloc(pool_get_sized(100000));
+    pool_free(p1);
+
+    pool_for_each(count_pools, &found);
+    if (found != 1)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("pool registered %u times\n", found);
+        ret++;
+    }
+
+    return ret;
+}
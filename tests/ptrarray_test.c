@@ -55,6 +55,136 @@ static int check_values(const unsigned values[])
     return 0;
 }
 
+static int test_growth(void)
+{
+    int ret = 0;
+    unsigned i;
+
+    for (i = 0; i < 100; i++)
+    {
+        PTRARRAY_ADD(ptrarray, i + 1);
+    }
+    ret += check_count(100);
+    if (ptrarray.capacity < 100 || ptrarray.capacity >= 200)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("ptrarray capacity %u for 100 elements\n", ptrarray.capacity);
+        ret++;
+    }
+    for (i = 0; i < 100; i++)
+    {
+        if (ptrarray.data[i] != i + 1)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("ptrarray element %u is %u\n", i, ptrarray.data[i]);
+            ret++;
+            break;
+        }
+    }
+
+    /* Removing doesn't shrink, except when the array becomes empty. */
+    PTRARRAY_REMOVE(ptrarray, 0);
+    if (ptrarray.capacity < 100)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("ptrarray capacity %u after remove\n", ptrarray.capacity);
+        ret++;
+    }
+    PTRARRAY_CLEAR(ptrarray);
+    if (ptrarray.capacity != 0 || ptrarray.data != NULL)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("ptrarray not released after clear\n");
+        ret++;
+    }
+
+    PTRARRAY_RESERVE(ptrarray, 10);
+    if (ptrarray.capacity < 10 || ptrarray.length != 0)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("ptrarray capacity %u after reserve\n", ptrarray.capacity);
+        ret++;
+    }
+    PTRARRAY_CLEAR(ptrarray);
+    return ret;
+}
+
+static int test_remove_unordered(void)
+{
+    int ret = 0;
+
+    PTRARRAY_ADD(ptrarray, 1);
+    PTRARRAY_ADD(ptrarray, 2);
+    PTRARRAY_ADD(ptrarray, 3);
+    PTRARRAY_ADD(ptrarray, 4);
+
+    /* The last element takes the place of the removed one. */
+    PTRARRAY_REMOVE_UNORDERED(ptrarray, 1);
+    ret += check_count(3);
+    ret += check_values((unsigned[]){1, 4, 3, 0});
+
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(ptrarray, 5);
+    ret += check_count(3);
+
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(ptrarray, 3);
+    ret += check_count(2);
+    ret += check_values((unsigned[]){1, 4, 0});
+
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(ptrarray, 1);
+    PTRARRAY_REMOVE_ELEMENT_UNORDERED(ptrarray, 4);
+    ret += check_count(0);
+    if (ptrarray.data != NULL)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("ptrarray not released after removing all elements\n");
+        ret++;
+    }
+    return ret;
+}
+
+static int test_inline(void)
+{
+    PTRARRAY_INLINE(unsigned, 2) inline_array;
+    int ret = 0;
+    unsigned i;
+
+    memset(&inline_array, 0, sizeof(inline_array));
+
+    PTRARRAY_ADD(inline_array, 1);
+    PTRARRAY_ADD(inline_array, 2);
+    if (inline_array.data != inline_array.inline_data || inline_array.capacity != 2)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("inline ptrarray does not use inline storage\n");
+        ret++;
+    }
+
+    /* Third element moves everything to the heap. */
+    PTRARRAY_ADD(inline_array, 3);
+    if (inline_array.data == inline_array.inline_data || inline_array.length != 3)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("inline ptrarray did not move to the heap\n");
+        ret++;
+    }
+    for (i = 0; i < inline_array.length; i++)
+    {
+        if (inline_array.data[i] != i + 1)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("inline ptrarray element %u is %u\n", i, inline_array.data[i]);
+            ret++;
+        }
+    }
+
+    /* Once empty, it goes back to inline storage. */
+    PTRARRAY_CLEAR(inline_array);
+    PTRARRAY_ADD(inline_array, 4);
+    if (inline_array.data != inline_array.inline_data || inline_array.data[0] != 4)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("inline ptrarray does not use inline storage after clear\n");
+        ret++;
+    }
+    PTRARRAY_REMOVE(inline_array, 0);
+    if (inline_array.data != NULL || inline_array.length != 0)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("inline ptrarray not reset after removing all elements\n");
+        ret++;
+    }
+    return ret;
+}
+
 int main()
 {
     int ret = 0;
@@ -108,5 +238,9 @@ int main()
 
     PTRARRAY_CLEAR(ptrarray);
 
+    ret += test_growth();
+    ret += test_remove_unordered();
+    ret += test_inline();
+
     return ret;
 }
@@ -0,0 +1,241 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "1905_cmdus.h"
+#include "../src/al_datamodel.h"
+#include "../src/al_requests.h"
+#include "../src/al_tx_scheduler.h"
+#include "fake_platform.h"
+
+#include <stdint.h>
+
+static uint8_t local_al_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+static void peer(uint8_t al_mac[6], uint8_t last)
+{
+    al_mac[0] = 0x02;
+    al_mac[1] = al_mac[2] = al_mac[3] = al_mac[4] = 0x00;
+    al_mac[5] = last;
+}
+
+static int check_send(uint8_t al_mac[6], uint16_t message_type)
+{
+    if (1 != requestSend("eth0", al_mac, message_type))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Sending type 0x%04x to %u failed\n", message_type, al_mac[5]);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_response(uint8_t al_mac[6], uint16_t message_type, uint16_t mid, uint8_t expected)
+{
+    uint8_t result = requestResponseReceived(al_mac, message_type, mid);
+
+    if (result != expected)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Response type 0x%04x MID %u from %u is %u but expected %u\n", message_type, mid,
+                                      al_mac[5], result, expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_outstanding(uint32_t expected_outstanding)
+{
+    struct requestStats stats;
+
+    requestStatsGet(&stats);
+    if (stats.outstanding != expected_outstanding)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u requests outstanding but expected %u\n", stats.outstanding,
+                                      expected_outstanding);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_answered(void)
+{
+    struct requestStats stats;
+    uint8_t al_mac[6];
+    uint16_t mid;
+    int ret = 0;
+
+    peer(al_mac, 5);
+    sent_nr = 0;
+
+    ret += check_send(al_mac, CMDU_TYPE_TOPOLOGY_QUERY);
+    ret += check_sent_nr(1);
+    mid = sent[0].mid;
+    ret += check_sent(0, 5, CMDU_TYPE_TOPOLOGY_QUERY, mid);
+
+    requestStatsGet(&stats);
+    if (1 != stats.sent)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u queries sent but expected 1\n", stats.sent);
+        ret++;
+    }
+    ret += check_outstanding(1);
+
+    now_ms += 10;
+    ret += check_response(al_mac, CMDU_TYPE_TOPOLOGY_RESPONSE, mid, REQUEST_RESPONSE_MATCHED);
+    ret += check_response(al_mac, CMDU_TYPE_TOPOLOGY_RESPONSE, mid, REQUEST_RESPONSE_DUPLICATE);
+
+    requestStatsGet(&stats);
+    if (1 != stats.answered || 1 != stats.duplicates)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u queries answered and %u duplicates but expected 1 and 1\n", stats.answered,
+                                      stats.duplicates);
+        ret++;
+    }
+    ret += check_outstanding(0);
+
+    /* Once the duplicate window is over, the same MID is no longer known. */
+    drain();
+    ret += check_sent_nr(1);
+    ret += check_response(al_mac, CMDU_TYPE_TOPOLOGY_RESPONSE, mid, REQUEST_RESPONSE_UNSOLICITED);
+
+    return ret;
+}
+
+static int test_retransmissions(void)
+{
+    struct requestStats stats;
+    uint8_t al_mac[6];
+    unsigned i;
+    int ret = 0;
+
+    peer(al_mac, 6);
+    sent_nr = 0;
+
+    ret += check_send(al_mac, CMDU_TYPE_LINK_METRIC_QUERY);
+    drain();
+
+    ret += check_sent_nr(1 + REQUEST_MAX_RETRIES);
+    for (i = 1; i < sent_nr && i < SENT_FRAMES_MAX; i++)
+    {
+        if (sent[i].mid == sent[i - 1].mid)
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Retransmission %u with the same MID %u\n", i, sent[i].mid);
+            ret++;
+        }
+        ret += check_sent(i, 6, CMDU_TYPE_LINK_METRIC_QUERY, sent[i].mid);
+    }
+
+    requestStatsGet(&stats);
+    if (REQUEST_MAX_RETRIES != stats.retries || 1 != stats.timeouts)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u retries and %u timeouts but expected %u and 1\n", stats.retries,
+                                      stats.timeouts, REQUEST_MAX_RETRIES);
+        ret++;
+    }
+    ret += check_outstanding(0);
+
+    return ret;
+}
+
+static int test_late_response(void)
+{
+    uint8_t al_mac[6];
+    uint16_t first_mid;
+    int ret = 0;
+
+    peer(al_mac, 7);
+    sent_nr = 0;
+
+    ret += check_send(al_mac, CMDU_TYPE_HIGHER_LAYER_QUERY);
+    first_mid = sent[0].mid;
+
+    /* Wait for the first retransmission. */
+    while (sent_nr < 2)
+    {
+        now_ms += requestTimeoutsRun();
+        txSchedulerRun();
+    }
+
+    /* The response to the first transmission still answers the query. */
+    ret += check_response(al_mac, CMDU_TYPE_HIGHER_LAYER_RESPONSE, first_mid, REQUEST_RESPONSE_UNSOLICITED);
+    ret += check_outstanding(0);
+
+    drain();
+    ret += check_sent_nr(2);
+
+    return ret;
+}
+
+static int test_merged(void)
+{
+    struct requestStats stats;
+    struct requestStats before;
+    uint8_t al_mac[6];
+    int ret = 0;
+
+    peer(al_mac, 8);
+    sent_nr = 0;
+    requestStatsGet(&before);
+
+    /* The second query is not sent (nor tracked) while the first one is outstanding. */
+    ret += check_send(al_mac, CMDU_TYPE_TOPOLOGY_QUERY);
+    ret += check_send(al_mac, CMDU_TYPE_TOPOLOGY_QUERY);
+    ret += check_sent_nr(1);
+
+    requestStatsGet(&stats);
+    if (before.sent + 1 != stats.sent || before.merged + 1 != stats.merged)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u queries sent and %u merged but expected 1 and 1\n", stats.sent - before.sent,
+                                      stats.merged - before.merged);
+        ret++;
+    }
+    ret += check_outstanding(1);
+
+    /* A single response answers it and nothing is retransmitted. */
+    ret += check_response(al_mac, CMDU_TYPE_TOPOLOGY_RESPONSE, sent[0].mid, REQUEST_RESPONSE_MATCHED);
+    drain();
+    requestStatsGet(&stats);
+    ret += check_sent_nr(1);
+    if (before.retries != stats.retries || before.timeouts != stats.timeouts)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Merged query retransmitted\n");
+        ret++;
+    }
+
+    /* Once answered, the same query can be sent again. */
+    ret += check_send(al_mac, CMDU_TYPE_TOPOLOGY_QUERY);
+    ret += check_sent_nr(2);
+    ret += check_response(al_mac, CMDU_TYPE_TOPOLOGY_RESPONSE, sent[1].mid, REQUEST_RESPONSE_MATCHED);
+    drain();
+
+    return ret;
+}
+
+int main()
+{
+    int ret = 0;
+
+    DMinit();
+    DMalMacSet(local_al_mac);
+
+    ret += test_answered();
+    ret += test_retransmissions();
+    ret += test_late_response();
+    ret += test_merged();
+
+    return ret;
+}
@@ -0,0 +1,282 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "platform.h"
+#include "1905_cmdus.h"
+#include "1905_l2.h"
+#include "../src/al_tx_scheduler.h"
+#include "fake_platform.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const uint8_t src_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+/* Send a single fragment CMDU of type @a message_type to 02:00:00:00:00:@a dst. @a payload makes the CMDU different
+ * from other CMDUs of the same type. */
+static uint8_t send_cmdu(uint8_t dst, uint16_t message_type, uint16_t mid, uint16_t payload)
+{
+    uint8_t dst_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, dst};
+    uint8_t frame[11] = {0x00, 0x00, message_type >> 8, message_type & 0xff, mid >> 8, mid & 0xff, 0x00, 0x80,
+                         payload >> 8, payload & 0xff, 0x00};
+    uint8_t *streams[2] = {frame, NULL};
+    uint16_t lens[1] = {sizeof(frame)};
+
+    return txSchedulerSend("eth0", dst_mac, src_mac, ETHERTYPE_1905, streams, lens);
+}
+
+/* Send a CMDU with send_cmdu() and check that txSchedulerSend() returns @a expected. */
+static int check_send(uint8_t dst, uint16_t message_type, uint16_t mid, uint16_t payload, uint8_t expected)
+{
+    uint8_t result = send_cmdu(dst, message_type, mid, payload);
+
+    if (result != expected)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Sending type 0x%04x MID %u to %u returned %u but expected %u\n", message_type, mid,
+                                      dst, result, expected);
+        return 1;
+    }
+    return 0;
+}
+
+/* Run the scheduler and check that it asks to be run again after @a expected_wait ms. */
+static int check_wait(uint32_t expected_wait)
+{
+    uint32_t wait = txSchedulerRun();
+
+    if (wait != expected_wait)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Scheduler wait %u ms but expected %u\n", wait, expected_wait);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_pending(unsigned priority, uint32_t expected_pending)
+{
+    struct txSchedulerStats stats;
+
+    txSchedulerStatsGet(&stats);
+    if (stats.pending[priority] != expected_pending)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u CMDUs pending at priority %u but expected %u\n", stats.pending[priority],
+                                      priority, expected_pending);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_pacing(void)
+{
+    int ret = 0;
+    unsigned i;
+
+    sent_nr = 0;
+
+    /* A burst goes out immediately, the rest waits. */
+    for (i = 0; i < TX_SCHEDULER_BURST + 3; i++)
+    {
+        ret += check_send(1, CMDU_TYPE_LINK_METRIC_QUERY, i, i, 1);
+    }
+    ret += check_sent_nr(TX_SCHEDULER_BURST);
+
+    /* Other destinations are not affected. */
+    ret += check_send(2, CMDU_TYPE_LINK_METRIC_QUERY, 100, 0, 1);
+    ret += check_sent_nr(TX_SCHEDULER_BURST + 1);
+
+    ret += check_wait(TX_SCHEDULER_INTERVAL_MS);
+    ret += check_sent_nr(TX_SCHEDULER_BURST + 1);
+
+    /* One CMDU per interval, in order. */
+    now_ms += TX_SCHEDULER_INTERVAL_MS;
+    ret += check_wait(TX_SCHEDULER_INTERVAL_MS);
+    ret += check_sent(TX_SCHEDULER_BURST + 1, 1, CMDU_TYPE_LINK_METRIC_QUERY, TX_SCHEDULER_BURST);
+    ret += check_sent_nr(TX_SCHEDULER_BURST + 2);
+
+    now_ms += 2 * TX_SCHEDULER_INTERVAL_MS;
+    ret += check_wait(0);
+    ret += check_sent(TX_SCHEDULER_BURST + 2, 1, CMDU_TYPE_LINK_METRIC_QUERY, TX_SCHEDULER_BURST + 1);
+    ret += check_sent(TX_SCHEDULER_BURST + 3, 1, CMDU_TYPE_LINK_METRIC_QUERY, TX_SCHEDULER_BURST + 2);
+
+    /* The budget is recovered over time. */
+    now_ms += TX_SCHEDULER_BURST * TX_SCHEDULER_INTERVAL_MS;
+    txSchedulerRun();
+    sent_nr = 0;
+    for (i = 0; i < TX_SCHEDULER_BURST; i++)
+    {
+        send_cmdu(1, CMDU_TYPE_LINK_METRIC_QUERY, i, i);
+    }
+    ret += check_sent_nr(TX_SCHEDULER_BURST);
+
+    now_ms += TX_SCHEDULER_BURST * TX_SCHEDULER_INTERVAL_MS;
+    drain();
+    return ret;
+}
+
+static int test_priority_and_coalescing(void)
+{
+    struct txSchedulerStats stats;
+    uint32_t coalesced;
+    int ret = 0;
+    unsigned i;
+
+    txSchedulerStatsGet(&stats);
+    coalesced = stats.coalesced;
+
+    /* Use up the budget of the destination. */
+    for (i = 0; i < TX_SCHEDULER_BURST; i++)
+    {
+        send_cmdu(3, CMDU_TYPE_TOPOLOGY_NOTIFICATION, i, i);
+    }
+    sent_nr = 0;
+
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_DISCOVERY, 200, 0);
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_QUERY, 201, 0);
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_QUERY, 202, 0);        /* Same query: not queued */
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_DISCOVERY, 203, 0);    /* Same discovery: not queued */
+    send_cmdu(3, CMDU_TYPE_LINK_METRIC_QUERY, 204, 0);
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_RESPONSE, 205, 0);
+    send_cmdu(3, CMDU_TYPE_TOPOLOGY_RESPONSE, 206, 0);     /* Responses are never coalesced */
+    send_cmdu(3, CMDU_TYPE_AP_AUTOCONFIGURATION_WSC, 207, 0);
+
+    txSchedulerStatsGet(&stats);
+    if (stats.coalesced != coalesced + 2)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u CMDUs coalesced but expected 2\n", stats.coalesced - coalesced);
+        ret++;
+    }
+    ret += check_pending(TX_PRIORITY_CONTROL, 3);
+    ret += check_pending(TX_PRIORITY_QUERY, 2);
+    ret += check_pending(TX_PRIORITY_DISCOVERY, 1);
+
+    drain();
+    ret += check_sent_nr(6);
+    ret += check_sent(0, 3, CMDU_TYPE_TOPOLOGY_RESPONSE, 205);
+    ret += check_sent(1, 3, CMDU_TYPE_TOPOLOGY_RESPONSE, 206);
+    ret += check_sent(2, 3, CMDU_TYPE_AP_AUTOCONFIGURATION_WSC, 207);
+    ret += check_sent(3, 3, CMDU_TYPE_TOPOLOGY_QUERY, 201);
+    ret += check_sent(4, 3, CMDU_TYPE_LINK_METRIC_QUERY, 204);
+    ret += check_sent(5, 3, CMDU_TYPE_TOPOLOGY_DISCOVERY, 200);
+
+    now_ms += TX_SCHEDULER_BURST * TX_SCHEDULER_INTERVAL_MS;
+    drain();
+    return ret;
+}
+
+static int test_queue_full(void)
+{
+    struct txSchedulerStats stats;
+    uint32_t dropped;
+    int ret = 0;
+    unsigned i;
+
+    txSchedulerStatsGet(&stats);
+    dropped = stats.dropped;
+
+    for (i = 0; i < TX_SCHEDULER_BURST; i++)
+    {
+        send_cmdu(4, CMDU_TYPE_TOPOLOGY_RESPONSE, i, i);
+    }
+    for (i = 0; i < TX_SCHEDULER_MAX_PENDING; i++)
+    {
+        ret += check_send(4, CMDU_TYPE_TOPOLOGY_DISCOVERY, 1000 + i, i, 1);
+    }
+    txSchedulerStatsGet(&stats);
+    if (stats.peak_pending < TX_SCHEDULER_MAX_PENDING)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Peak of %u pending CMDUs but expected at least %u\n", stats.peak_pending,
+                                      TX_SCHEDULER_MAX_PENDING);
+        ret++;
+    }
+
+    /* No room for another discovery... */
+    ret += check_send(4, CMDU_TYPE_TOPOLOGY_DISCOVERY, 2000, 0xffff, 0);
+
+    /* ...but a response takes the place of the newest discovery. */
+    ret += check_send(4, CMDU_TYPE_TOPOLOGY_RESPONSE, 2001, 0, 1);
+
+    txSchedulerStatsGet(&stats);
+    if (stats.dropped != dropped + 2)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u CMDUs dropped but expected 2\n", stats.dropped - dropped);
+        ret++;
+    }
+    ret += check_pending(TX_PRIORITY_CONTROL, 1);
+    ret += check_pending(TX_PRIORITY_DISCOVERY, TX_SCHEDULER_MAX_PENDING - 1);
+
+    sent_nr = 0;
+    drain();
+    ret += check_sent_nr(TX_SCHEDULER_MAX_PENDING);
+    ret += check_sent(0, 4, CMDU_TYPE_TOPOLOGY_RESPONSE, 2001);
+    ret += check_sent(TX_SCHEDULER_MAX_PENDING - 1, 4, CMDU_TYPE_TOPOLOGY_DISCOVERY, 1000 + TX_SCHEDULER_MAX_PENDING - 2);
+
+    return ret;
+}
+
+static int test_multicast_fan_out(void)
+{
+    static const uint8_t mcast_mac[6] = {0x01, 0x80, 0xc2, 0x00, 0x00, 0x13};
+    struct txSchedulerStats stats;
+    uint32_t deferred;
+    char interface_name[16];
+    int ret = 0;
+    unsigned i;
+
+    txSchedulerStatsGet(&stats);
+    deferred = stats.deferred;
+    sent_nr = 0;
+
+    /* One copy per interface, more interfaces than the budget of a destination: none of them waits. */
+    for (i = 0; i < 2 * TX_SCHEDULER_BURST; i++)
+    {
+        uint8_t frame[8] = {0x00, 0x00, CMDU_TYPE_TOPOLOGY_DISCOVERY >> 8, CMDU_TYPE_TOPOLOGY_DISCOVERY & 0xff,
+                            0x01, 0x00, 0x80, 0x00};
+        uint8_t *streams[2] = {frame, NULL};
+        uint16_t lens[1] = {sizeof(frame)};
+
+        snprintf(interface_name, sizeof(interface_name), "eth%u", i);
+        if (1 != txSchedulerSend(interface_name, mcast_mac, src_mac, ETHERTYPE_1905, streams, lens))
+        {
+            PLATFORM_PRINTF_DEBUG_WARNING("Sending discovery on %s failed\n", interface_name);
+            ret++;
+        }
+    }
+
+    txSchedulerStatsGet(&stats);
+    ret += check_sent_nr(2 * TX_SCHEDULER_BURST);
+    if (stats.deferred != deferred)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("%u multicast copies deferred\n", stats.deferred - deferred);
+        ret++;
+    }
+
+    return ret;
+}
+
+int main()
+{
+    int ret = 0;
+
+    ret += test_pacing();
+    ret += test_priority_and_coalescing();
+    ret += test_queue_full();
+    ret += test_multicast_fan_out();
+
+    return ret;
+}
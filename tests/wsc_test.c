@@ -0,0 +1,133 @@
+/*
+ *  prplMesh Wi-Fi Multi-AP
+ *
+ *  Copyright (c) 2018, prpl Foundation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/* M1/M2 round trip: the enrollee builds M1, the registrar answers with M2 and the enrollee applies the settings.
+ *
+ * It is done with DH key pairs generated on demand and with pre-generated ones (see benchmarks/wsc_m2_benchmark.c for
+ * the throughput of both).
+ */
+
+#include <platform.h>
+#include <utils.h>
+#include <datamodel.h>
+#include "../src/al_wsc.h"
+#include "../src/platform_crypto.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+static const mac_address al_mac = {0x02, 0x01, 0x02, 0x03, 0x04, 0x05};
+
+static struct bssInfo configured_bss;
+static unsigned       configured_nr;
+
+static bool addAP(struct radio *radio, struct bssInfo bss_info)
+{
+    (void)radio;
+    configured_bss = bss_info;
+    configured_nr++;
+    return true;
+}
+
+static int check_bss(const struct bssInfo *expected)
+{
+    if (configured_bss.ssid.length != expected->ssid.length ||
+        0 != memcmp(configured_bss.ssid.ssid, expected->ssid.ssid, configured_bss.ssid.length))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("SSID '%.*s' received but expected '%.*s'\n", configured_bss.ssid.length,
+                                      configured_bss.ssid.ssid, expected->ssid.length, expected->ssid.ssid);
+        return 1;
+    }
+    if (configured_bss.key_len != expected->key_len ||
+        0 != memcmp(configured_bss.key, expected->key, configured_bss.key_len))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Wrong key received\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int round_trip(struct radio *radio, const struct wscRegistrarInfo *wsc_info)
+{
+    struct wscM1Info m1_info;
+    struct wscM2Buf  m2;
+    int              ret = 0;
+
+    if (!wscBuildM1(radio, &radio->device_data) ||
+        WSC_TYPE_M1 != wscGetType(radio->wsc_info->m1, radio->wsc_info->m1_len) ||
+        !wscParseM1(radio->wsc_info->m1, radio->wsc_info->m1_len, &m1_info) ||
+        !wscBuildM2(&m1_info, wsc_info, &m2))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("Could not build M1 and answer it with M2\n");
+        wscInfoFree(radio);
+        return 1;
+    }
+
+    if (WSC_TYPE_M2 != wscGetType(m2.m2, m2.m2_size))
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("M2 has the wrong type\n");
+        ret++;
+    }
+
+    configured_nr = 0;
+    if (!wscProcessM2(radio, m2.m2, m2.m2_size) || 1 != configured_nr)
+    {
+        PLATFORM_PRINTF_DEBUG_WARNING("M2 settings were not applied\n");
+        ret++;
+    }
+    else
+    {
+        ret += check_bss(&wsc_info->bss_info);
+    }
+
+    free(m2.m2);
+    wscInfoFree(radio);
+    return ret;
+}
+
+int main()
+{
+    struct wscRegistrarInfo wsc_info;
+    struct radio           *radio;
+    int                     ret = 0;
+
+    local_device = alDeviceAlloc(al_mac);
+
+    memset(&wsc_info, 0, sizeof(wsc_info));
+    memcpy(wsc_info.bss_info.bssid, al_mac, sizeof(mac_address));
+    wsc_info.bss_info.ssid.length = strlen("prplMesh");
+    memcpy(wsc_info.bss_info.ssid.ssid, "prplMesh", wsc_info.bss_info.ssid.length);
+    wsc_info.bss_info.auth_mode = auth_mode_wpa2psk;
+    wsc_info.bss_info.key_len = strlen("prplMeshKey");
+    memcpy(wsc_info.bss_info.key, "prplMeshKey", wsc_info.bss_info.key_len);
+    wsc_info.rf_bands = WPS_RF_24GHZ;
+
+    radio = radioAlloc(local_device, al_mac);
+    radio->addAP = addAP;
+
+    ret += round_trip(radio, &wsc_info);
+
+    if (0 != PLATFORM_PREGENERATE_DH_KEY_PAIRS())
+    {
+        ret += round_trip(radio, &wsc_info);
+        ret += round_trip(radio, &wsc_info);
+    }
+
+    alDeviceDelete(local_device);
+    return ret;
+}